@@ -23,6 +23,13 @@ struct Cuepoint {
 struct AdCueGeneratorParams {
   /// List of cuepoints.
   std::vector<Cuepoint> cue_points;
+
+  /// Insert the cues exactly at the cuepoint start times instead of at the
+  /// first video key frame at or after them. Every video stream must have a
+  /// key frame at each cuepoint, e.g. content conditioned by the encoder.
+  /// Streams do not need to wait for each other or buffer samples in this
+  /// mode.
+  bool frame_accurate_cue_points = false;
 };
 
 }  // namespace shaka
@@ -154,6 +154,14 @@ class SHAKA_EXPORT File {
   /// @return true if `file_name` is a local and regular file.
   static bool IsLocalRegularFile(const char* file_name);
 
+  /// @param file_name is the name of a local file.
+  /// @param time[out] is set to the last modification time of the file, in
+  ///        an unspecified unit and epoch. It is only meant to be compared
+  ///        with other times returned by this function.
+  /// @return true on success, false if `file_name` is not a local file or
+  ///         its status cannot be read.
+  static bool GetLastModificationTime(const char* file_name, int64_t* time);
+
   /// Generate callback file name.
   /// NOTE: THE GENERATED NAME IS ONLY VAID WHILE @a callback_params IS VALID.
   /// @param callback_params references BufferCallbackParams, which will be
@@ -44,6 +44,13 @@ struct MpdParams {
   /// accessible as they may still be accessed by the player. The segments are
   /// not removed if the value is zero.
   size_t preserved_segments_outside_live_window = 0;
+  /// Live session checkpoint file. For dynamic MPD only. If set, the state of
+  /// the SegmentTimelines is written to this file every time the MPD is
+  /// written, and is restored from it on startup, so that a restarted packager
+  /// continues the existing live session without dropping the DVR window.
+  /// The `$Number$` of the segments continues after the restored segments.
+  /// HLS playlists and MPEG-2 TS continuity counters are not restored.
+  std::string live_state_file;
   /// UTCTimings. For dynamic MPD only.
   struct UtcTiming {
     std::string scheme_id_uri;
@@ -53,6 +53,13 @@ struct PackagingParams {
 
   /// Chunking (segmentation) related parameters.
   ChunkingParams chunking_params;
+  /// If non-zero, only the segment with this 1-based number, as in
+  /// `$Number$`, and the init segment are generated for each stream, the same
+  /// as in a full run. The segment is located using the sample index of the
+  /// input, so the cost is proportional to the size of the segment. Requires
+  /// MP4 outputs with segment templates, a sample index for each input and no
+  /// manifests.
+  uint32_t segment_number = 0;
 
   /// Out of band cuepoint parameters.
   AdCueGeneratorParams ad_cue_generator_params;
@@ -60,9 +67,20 @@ struct PackagingParams {
   /// Create a human readable format of MediaInfo. The output file name will be
   /// the name specified by output flag, suffixed with `.media_info`.
   bool output_media_info = false;
+  /// Generate the manifests from inputs which are already fragmented MP4
+  /// files with a single track, e.g. CMAF track files, without writing any
+  /// media. The segments are the fragments of the inputs, or the subsegments
+  /// of their `sidx` boxes, and are addressed with byte ranges. The stream
+  /// `output` is the name of the media file in the manifests.
+  bool manifest_only = false;
   /// Only use a single thread to generate output.  This is useful in tests to
   /// avoid non-deterministic outputs.
   bool single_threaded = false;
+  /// Dispatch to the outputs of each stream, e.g. muxers for different output
+  /// formats and trick play streams, on separate threads, so that the outputs
+  /// of a single input are not all generated on one thread. Ignored if
+  /// `single_threaded` is set.
+  bool parallel_outputs = false;
 
   /// DASH MPD related parameters.
   MpdParams mpd_params;
@@ -157,6 +175,13 @@ struct StreamDescriptor {
   /// its initial header.
   std::string input_format;
 
+  /// Optional path of a sample index sidecar for the input. If it contains a
+  /// valid index for the input, the samples are read using the index instead
+  /// of parsing the container. Otherwise, the index is built and written to
+  /// this path. Only unencrypted local MP4 inputs are supported. If several
+  /// streams use the same input, the value of the first stream is used.
+  std::string sample_index;
+
   /// Optional, indicates if this is a Forced Narrative subtitle stream.
   bool forced_subtitle = false;
 
@@ -18,3 +18,10 @@ ABSL_FLAG(std::string,
           "{start_time}[,{duration}][;{start_time}[,{duration}]]..."
           "The start_time represents the start of the cue marker in "
           "seconds relative to the start of the program.");
+ABSL_FLAG(bool,
+          frame_accurate_ad_cues,
+          false,
+          "Insert the ad cues exactly at the --ad_cues start times instead of "
+          "at the next video key frame. Every video stream must have a key "
+          "frame at each start time, e.g. content conditioned by the "
+          "encoder. Samples do not need to be buffered in this mode.");
@@ -11,5 +11,6 @@
 #include <absl/flags/flag.h>
 
 ABSL_DECLARE_FLAG(std::string, ad_cues);
+ABSL_DECLARE_FLAG(bool, frame_accurate_ad_cues);
 
 #endif  // PACKAGER_APP_AD_CUE_GENERATOR_FLAGS_H_
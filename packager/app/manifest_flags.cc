@@ -42,3 +42,12 @@ ABSL_FLAG(bool,
           true,
           "True forces the muxer to order streams in the order given "
           "on the command-line. False uses the previous unordered behavior.");
+ABSL_FLAG(bool,
+          manifest_only,
+          false,
+          "Generate the manifests from inputs which are already fragmented "
+          "MP4 files with a single track, e.g. CMAF track files, without "
+          "writing any media. The segments are the fragments of the inputs, "
+          "or the subsegments of their 'sidx' boxes, addressed with byte "
+          "ranges. The stream 'output' is the name of the media file in the "
+          "manifests.");
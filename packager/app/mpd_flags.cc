@@ -24,6 +24,15 @@ ABSL_FLAG(bool,
           "will be the name specified by output flag, suffixed with "
           "'.media_info'.");
 ABSL_FLAG(std::string, mpd_output, "", "MPD output file name.");
+ABSL_FLAG(std::string,
+          mpd_live_state_file,
+          "",
+          "Live session checkpoint file. If specified, the state needed to "
+          "continue the live MPD (SegmentTimelines, segment numbers and "
+          "availabilityStartTime) is saved to this file every time the MPD is "
+          "updated, and restored from it when the packager restarts. This "
+          "value is used for dynamic MPD only; HLS playlists are not "
+          "restored.");
 ABSL_FLAG(std::string,
           base_urls,
           "",
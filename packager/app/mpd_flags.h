@@ -15,6 +15,7 @@
 ABSL_DECLARE_FLAG(bool, generate_static_live_mpd);
 ABSL_DECLARE_FLAG(bool, output_media_info);
 ABSL_DECLARE_FLAG(std::string, mpd_output);
+ABSL_DECLARE_FLAG(std::string, mpd_live_state_file);
 ABSL_DECLARE_FLAG(std::string, base_urls);
 ABSL_DECLARE_FLAG(double, minimum_update_period);
 ABSL_DECLARE_FLAG(double, min_buffer_time);
@@ -35,6 +35,10 @@ std::shared_ptr<Muxer> MuxerFactory::CreateMuxer(
   options.output_file_name = stream.output;
   options.segment_template = stream.segment_template;
   options.bandwidth = stream.bandwidth;
+  auto num_previous_segments =
+      num_previous_segments_.find(stream.segment_template);
+  if (num_previous_segments != num_previous_segments_.end())
+    options.num_previous_segments = num_previous_segments->second;
 
   std::shared_ptr<Muxer> muxer;
 
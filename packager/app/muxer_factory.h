@@ -7,6 +7,8 @@
 #ifndef PACKAGER_APP_MUXER_FACTORY_H_
 #define PACKAGER_APP_MUXER_FACTORY_H_
 
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -43,6 +45,15 @@ class MuxerFactory {
     transport_stream_timestamp_offset_ms_ = offset_ms;
   }
 
+  /// Continues the segment numbering of a resumed live session, see
+  /// MuxerOptions::num_previous_segments.
+  /// @param num_previous_segments is the number of segments generated before,
+  ///        keyed by segment template.
+  void SetNumPreviousSegments(
+      const std::map<std::string, uint32_t>& num_previous_segments) {
+    num_previous_segments_ = num_previous_segments;
+  }
+
  private:
   MuxerFactory(const MuxerFactory&) = delete;
   MuxerFactory& operator=(const MuxerFactory&) = delete;
@@ -51,6 +62,7 @@ class MuxerFactory {
   const std::string temp_dir_;
   int32_t transport_stream_timestamp_offset_ms_ = 0;
   std::shared_ptr<Clock> clock_ = nullptr;
+  std::map<std::string, uint32_t> num_previous_segments_;
 };
 
 }  // namespace media
@@ -39,6 +39,14 @@ ABSL_FLAG(bool,
           true,
           "Force fragments to begin with stream access points. This flag "
           "implies segment_sap_aligned.");
+ABSL_FLAG(uint32_t,
+          segment_number,
+          0,
+          "If non-zero, only generate the segment with this 1-based number, "
+          "as in $Number$, and the init segment of each stream, from the "
+          "sample index of the input. The segment is the same as in a full "
+          "run. Requires MP4 outputs with segment_template, a sample_index "
+          "for each stream and no manifest.");
 ABSL_FLAG(bool,
           generate_sidx_in_media_segments,
           true,
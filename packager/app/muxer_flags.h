@@ -17,6 +17,7 @@ ABSL_DECLARE_FLAG(double, segment_duration);
 ABSL_DECLARE_FLAG(bool, segment_sap_aligned);
 ABSL_DECLARE_FLAG(double, fragment_duration);
 ABSL_DECLARE_FLAG(bool, fragment_sap_aligned);
+ABSL_DECLARE_FLAG(uint32_t, segment_number);
 ABSL_DECLARE_FLAG(bool, generate_sidx_in_media_segments);
 ABSL_DECLARE_FLAG(std::string, temp_dir);
 ABSL_DECLARE_FLAG(bool, mp4_include_pssh_in_stream);
@@ -0,0 +1,462 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/app/packager_daemon.h>
+
+#if !defined(OS_WIN)
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif  // !defined(OS_WIN)
+
+#include <cerrno>
+#include <cstring>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+#include <nlohmann/json.hpp>
+
+#include <packager/macros/compiler.h>
+#include <packager/macros/status.h>
+
+namespace shaka {
+namespace {
+
+// The number of finished jobs whose state is kept for status requests.
+const size_t kMaxFinishedJobs = 1000;
+// Requests are expected to be small. Connections sending longer lines are
+// closed.
+const size_t kMaxRequestSize = 1 << 20;
+
+#if !defined(OS_WIN)
+// Removes the socket at |socket_path|, if any. Fails if |socket_path| is not
+// a socket, so that a wrong path does not delete an unrelated file.
+Status RemoveSocket(const std::string& socket_path) {
+  struct stat info;
+  if (lstat(socket_path.c_str(), &info) != 0) {
+    if (errno == ENOENT)
+      return Status::OK;
+    return Status(error::FILE_FAILURE, "Failed to stat " + socket_path + ": " +
+                                           std::string(strerror(errno)));
+  }
+  if (!S_ISSOCK(info.st_mode)) {
+    return Status(error::INVALID_ARGUMENT,
+                  socket_path + " exists and is not a socket.");
+  }
+  if (unlink(socket_path.c_str()) != 0) {
+    return Status(error::FILE_FAILURE, "Failed to remove " + socket_path +
+                                           ": " + std::string(strerror(errno)));
+  }
+  return Status::OK;
+}
+#endif  // !defined(OS_WIN)
+
+const char* JobStateToString(PackagerDaemon::JobState state) {
+  switch (state) {
+    case PackagerDaemon::JobState::kQueued:
+      return "queued";
+    case PackagerDaemon::JobState::kRunning:
+      return "running";
+    case PackagerDaemon::JobState::kSucceeded:
+      return "succeeded";
+    case PackagerDaemon::JobState::kFailed:
+      return "failed";
+    case PackagerDaemon::JobState::kCancelled:
+      return "cancelled";
+  }
+  return "unknown";
+}
+
+std::string ErrorResponse(const std::string& error) {
+  nlohmann::json response;
+  response["ok"] = false;
+  response["error"] = error;
+  return response.dump();
+}
+
+bool GetJobId(const nlohmann::json& request, uint64_t* job_id) {
+  auto iter = request.find("job_id");
+  if (iter == request.end() || !iter->is_number_unsigned())
+    return false;
+  *job_id = iter->get<uint64_t>();
+  return true;
+}
+
+#if !defined(OS_WIN)
+bool WriteFully(int fd, const std::string& data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    const ssize_t result =
+        send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+    if (result < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    written += result;
+  }
+  return true;
+}
+#endif  // !defined(OS_WIN)
+
+}  // namespace
+
+PackagerDaemon::PackagerDaemon(JobArgsParser job_args_parser,
+                               size_t max_concurrent_jobs)
+    : job_args_parser_(std::move(job_args_parser)) {
+  DCHECK(job_args_parser_);
+  DCHECK_GT(max_concurrent_jobs, 0u);
+  for (size_t i = 0; i < max_concurrent_jobs; ++i)
+    workers_.emplace_back(&PackagerDaemon::WorkerMain, this);
+}
+
+PackagerDaemon::~PackagerDaemon() {
+  Shutdown();
+  for (std::thread& worker : workers_)
+    worker.join();
+}
+
+Status PackagerDaemon::Run(const std::string& socket_path) {
+#if defined(OS_WIN)
+  UNUSED(socket_path);
+  return Status(error::UNIMPLEMENTED,
+                "Daemon mode is not supported on Windows.");
+#else
+  sockaddr_un address = {};
+  if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Invalid daemon socket path: " + socket_path);
+  }
+  address.sun_family = AF_UNIX;
+  memcpy(address.sun_path, socket_path.data(), socket_path.size());
+  // Remove the socket left behind by a previous daemon, if any.
+  RETURN_IF_ERROR(RemoveSocket(socket_path));
+
+  const int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0) {
+    return Status(error::FILE_FAILURE,
+                  "Failed to create socket: " + std::string(strerror(errno)));
+  }
+  if (bind(listen_fd, reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      listen(listen_fd, SOMAXCONN) != 0) {
+    const std::string error = strerror(errno);
+    close(listen_fd);
+    return Status(error::FILE_FAILURE,
+                  "Failed to listen on " + socket_path + ": " + error);
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    listen_fd_ = listen_fd;
+    if (shutting_down_)
+      shutdown(listen_fd_, SHUT_RDWR);
+  }
+  LOG(INFO) << "Accepting packaging jobs on " << socket_path;
+
+  Status status;
+  while (true) {
+    const int fd = accept(listen_fd, nullptr, nullptr);
+    absl::MutexLock lock(&mutex_);
+    if (shutting_down_) {
+      if (fd >= 0)
+        close(fd);
+      break;
+    }
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      status = Status(error::FILE_FAILURE, "Failed to accept connection: " +
+                                               std::string(strerror(errno)));
+      break;
+    }
+    connection_fds_.insert(fd);
+    // Connection threads are detached so that the threads of the connections
+    // served so far are not kept around. |connection_fds_| tracks the live
+    // ones.
+    std::thread(&PackagerDaemon::ServeConnection, this, fd).detach();
+  }
+
+  {
+    absl::MutexLock lock(&mutex_);
+    listen_fd_ = -1;
+  }
+  close(listen_fd);
+  Status remove_status = RemoveSocket(socket_path);
+  if (!remove_status.ok())
+    LOG(WARNING) << remove_status.ToString();
+
+  // Connected clients may still query the state of their jobs.
+  Shutdown();
+  WaitForJobs();
+
+  {
+    absl::MutexLock lock(&mutex_);
+    // Wake up the connections waiting for requests. Responses being written
+    // are not affected.
+    for (int fd : connection_fds_)
+      shutdown(fd, SHUT_RD);
+    mutex_.Await(absl::Condition(
+        +[](PackagerDaemon* daemon) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+          return daemon->connection_fds_.empty();
+        },
+        this));
+  }
+  return status;
+#endif  // defined(OS_WIN)
+}
+
+std::string PackagerDaemon::HandleRequest(const std::string& request) {
+  const nlohmann::json json = nlohmann::json::parse(request, nullptr, false);
+  if (json.is_discarded() || !json.is_object())
+    return ErrorResponse("Request is not a JSON object.");
+  auto command_iter = json.find("command");
+  if (command_iter == json.end() || !command_iter->is_string())
+    return ErrorResponse("Missing command.");
+  const std::string command = command_iter->get<std::string>();
+
+  nlohmann::json response;
+  response["ok"] = true;
+  if (command == "submit") {
+    auto args_iter = json.find("args");
+    if (args_iter == json.end() || !args_iter->is_array())
+      return ErrorResponse("Missing args.");
+    std::vector<std::string> args;
+    for (const nlohmann::json& arg : *args_iter) {
+      if (!arg.is_string())
+        return ErrorResponse("Job arguments must be strings.");
+      args.push_back(arg.get<std::string>());
+    }
+
+    PackagingParams packaging_params;
+    std::vector<StreamDescriptor> descriptors;
+    Status status = job_args_parser_(args, &packaging_params, &descriptors);
+    if (!status.ok())
+      return ErrorResponse(status.ToString());
+    uint64_t job_id = 0;
+    if (!SubmitJob(packaging_params, descriptors, &job_id))
+      return ErrorResponse("The daemon is shutting down.");
+    response["job_id"] = job_id;
+  } else if (command == "status" || command == "cancel") {
+    uint64_t job_id = 0;
+    if (!GetJobId(json, &job_id))
+      return ErrorResponse("Missing job_id.");
+    if (command == "cancel" && !CancelJob(job_id))
+      return ErrorResponse("Unknown job " + std::to_string(job_id) + ".");
+
+    JobState state;
+    Status status;
+    if (!GetJobState(job_id, &state, &status))
+      return ErrorResponse("Unknown job " + std::to_string(job_id) + ".");
+    response["job_id"] = job_id;
+    response["state"] = JobStateToString(state);
+    if (state == JobState::kFailed)
+      response["error"] = status.ToString();
+  } else if (command == "shutdown") {
+    Shutdown();
+  } else {
+    return ErrorResponse("Unknown command '" + command + "'.");
+  }
+  return response.dump();
+}
+
+bool PackagerDaemon::SubmitJob(const PackagingParams& packaging_params,
+                               const std::vector<StreamDescriptor>& descriptors,
+                               uint64_t* job_id) {
+  DCHECK(job_id);
+
+  std::unique_ptr<Job> job(new Job);
+  job->packaging_params = packaging_params;
+  job->descriptors = descriptors;
+
+  absl::MutexLock lock(&mutex_);
+  if (shutting_down_)
+    return false;
+  job->id = next_job_id_++;
+  *job_id = job->id;
+  queued_jobs_.push_back(job.get());
+  jobs_[job->id] = std::move(job);
+  LOG(INFO) << "Job " << *job_id << " queued.";
+  return true;
+}
+
+bool PackagerDaemon::GetJobState(uint64_t job_id,
+                                 JobState* state,
+                                 Status* status) {
+  DCHECK(state);
+  DCHECK(status);
+
+  absl::MutexLock lock(&mutex_);
+  auto iter = jobs_.find(job_id);
+  if (iter == jobs_.end())
+    return false;
+  *state = iter->second->state;
+  *status = iter->second->status;
+  return true;
+}
+
+bool PackagerDaemon::CancelJob(uint64_t job_id) {
+  absl::MutexLock lock(&mutex_);
+  auto iter = jobs_.find(job_id);
+  if (iter == jobs_.end())
+    return false;
+  Job* job = iter->second.get();
+  switch (job->state) {
+    case JobState::kQueued:
+      for (auto it = queued_jobs_.begin(); it != queued_jobs_.end(); ++it) {
+        if (*it == job) {
+          queued_jobs_.erase(it);
+          break;
+        }
+      }
+      job->state = JobState::kCancelled;
+      job->status = Status(error::CANCELLED, "Job cancelled.");
+      OnJobFinished(job);
+      break;
+    case JobState::kRunning:
+      // The state is updated by the worker once Packager::Run returns.
+      job->cancel_requested = true;
+      if (job->packager)
+        job->packager->Cancel();
+      break;
+    case JobState::kSucceeded:
+    case JobState::kFailed:
+    case JobState::kCancelled:
+      break;
+  }
+  return true;
+}
+
+void PackagerDaemon::Shutdown() {
+  absl::MutexLock lock(&mutex_);
+  shutting_down_ = true;
+#if !defined(OS_WIN)
+  // Wakes up accept() in Run.
+  if (listen_fd_ >= 0)
+    shutdown(listen_fd_, SHUT_RDWR);
+#endif  // !defined(OS_WIN)
+}
+
+void PackagerDaemon::WaitForJobs() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(
+      +[](PackagerDaemon* daemon) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+        return daemon->queued_jobs_.empty() && daemon->num_active_jobs_ == 0;
+      },
+      this));
+}
+
+void PackagerDaemon::WorkerMain() {
+  while (true) {
+    Job* job = nullptr;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(
+          +[](PackagerDaemon* daemon) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+            return daemon->shutting_down_ || !daemon->queued_jobs_.empty();
+          },
+          this));
+      // The queue is drained before the workers exit.
+      if (queued_jobs_.empty())
+        return;
+      job = queued_jobs_.front();
+      queued_jobs_.pop_front();
+      job->state = JobState::kRunning;
+      ++num_active_jobs_;
+    }
+    RunJob(job);
+  }
+}
+
+void PackagerDaemon::RunJob(Job* job) {
+  LOG(INFO) << "Job " << job->id << " started.";
+
+  // |packaging_params| and |descriptors| are only accessed by this worker
+  // once the job is running.
+  Packager packager;
+  Status status = packager.Initialize(job->packaging_params, job->descriptors);
+  if (status.ok()) {
+    // Packager::Cancel is only safe to call once the packager is initialized.
+    absl::MutexLock lock(&mutex_);
+    if (job->cancel_requested)
+      status = Status(error::CANCELLED, "Job cancelled.");
+    else
+      job->packager = &packager;
+  }
+  if (status.ok())
+    status = packager.Run();
+
+  absl::MutexLock lock(&mutex_);
+  job->packager = nullptr;
+  --num_active_jobs_;
+  if (job->cancel_requested && !status.ok())
+    job->state = JobState::kCancelled;
+  else
+    job->state = status.ok() ? JobState::kSucceeded : JobState::kFailed;
+  job->status = status;
+  if (job->state == JobState::kFailed)
+    LOG(ERROR) << "Job " << job->id << " failed: " << status.ToString();
+  else
+    LOG(INFO) << "Job " << job->id << " " << JobStateToString(job->state)
+              << ".";
+  OnJobFinished(job);
+}
+
+void PackagerDaemon::ServeConnection(int fd) {
+#if !defined(OS_WIN)
+  std::string buffer;
+  char data[4096];
+  bool connected = true;
+  while (connected) {
+    const ssize_t size = recv(fd, data, sizeof(data), 0);
+    if (size < 0 && errno == EINTR)
+      continue;
+    if (size <= 0)
+      break;
+    buffer.append(data, size);
+
+    size_t line_start = 0;
+    size_t line_end = 0;
+    while ((line_end = buffer.find('\n', line_start)) != std::string::npos) {
+      const std::string response =
+          HandleRequest(buffer.substr(line_start, line_end - line_start));
+      if (!WriteFully(fd, response + "\n")) {
+        connected = false;
+        break;
+      }
+      line_start = line_end + 1;
+    }
+    buffer.erase(0, line_start);
+    if (buffer.size() > kMaxRequestSize) {
+      WriteFully(fd, ErrorResponse("Request is too long.") + "\n");
+      break;
+    }
+  }
+
+  absl::MutexLock lock(&mutex_);
+  // Closed while holding the lock so that Run never shuts down a reused
+  // descriptor. Run returns once |connection_fds_| is empty, so the daemon
+  // must not be accessed after the lock is released.
+  connection_fds_.erase(fd);
+  close(fd);
+#else
+  UNUSED(fd);
+#endif  // !defined(OS_WIN)
+}
+
+void PackagerDaemon::OnJobFinished(Job* job) {
+  // |packaging_params| may hold large data, e.g. keys and callbacks.
+  job->packaging_params = PackagingParams();
+  job->descriptors.clear();
+
+  finished_job_ids_.push_back(job->id);
+  while (finished_job_ids_.size() > kMaxFinishedJobs) {
+    jobs_.erase(finished_job_ids_.front());
+    finished_job_ids_.pop_front();
+  }
+}
+
+}  // namespace shaka
@@ -0,0 +1,131 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_APP_PACKAGER_DAEMON_H_
+#define PACKAGER_APP_PACKAGER_DAEMON_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <packager/macros/classes.h>
+#include <packager/packager.h>
+#include <packager/status.h>
+
+namespace shaka {
+
+/// A long-lived packager process which runs packaging jobs submitted over a
+/// local socket, so that jobs share the process, its threads and its HTTP
+/// connections instead of paying for them on every run.
+///
+/// Requests and responses are JSON objects, one per line:
+///   {"command": "submit", "args": ["--mpd_output=a.mpd", "in=a.mp4,..."]}
+///     -> {"ok": true, "job_id": 1}
+///   {"command": "status", "job_id": 1}
+///     -> {"ok": true, "job_id": 1, "state": "running"}
+///   {"command": "cancel", "job_id": 1}
+///     -> {"ok": true, "job_id": 1, "state": "cancelled"}
+///   {"command": "shutdown"}
+///     -> {"ok": true}
+/// Job states are "queued", "running", "succeeded", "failed" and
+/// "cancelled"; failed jobs also report an "error". Failed requests are
+/// answered with {"ok": false, "error": "..."}.
+class PackagerDaemon {
+ public:
+  /// Parses the arguments of a job, which are the packager command line
+  /// arguments without the program name.
+  typedef std::function<Status(const std::vector<std::string>& args,
+                               PackagingParams* packaging_params,
+                               std::vector<StreamDescriptor>* descriptors)>
+      JobArgsParser;
+
+  enum class JobState { kQueued, kRunning, kSucceeded, kFailed, kCancelled };
+
+  /// @param job_args_parser parses the arguments of submitted jobs.
+  /// @param max_concurrent_jobs is the number of jobs which may run at the
+  ///        same time. Other jobs are queued.
+  PackagerDaemon(JobArgsParser job_args_parser, size_t max_concurrent_jobs);
+  ~PackagerDaemon();
+
+  /// Serves requests on a Unix domain socket at @a socket_path until a
+  /// shutdown request is received, then waits for the submitted jobs to
+  /// complete.
+  Status Run(const std::string& socket_path);
+
+  /// Handles a single request.
+  /// @return the response, without the trailing newline.
+  std::string HandleRequest(const std::string& request);
+
+  /// Queues a job.
+  /// @param job_id receives the id of the job.
+  /// @return false if the daemon is shutting down.
+  bool SubmitJob(const PackagingParams& packaging_params,
+                 const std::vector<StreamDescriptor>& descriptors,
+                 uint64_t* job_id);
+
+  /// Gets the state of a job, and its error if it failed.
+  /// @return false if the job is unknown.
+  bool GetJobState(uint64_t job_id, JobState* state, Status* status);
+
+  /// Cancels a job. Queued jobs are dropped; running jobs are cancelled with
+  /// Packager::Cancel and complete asynchronously.
+  /// @return false if the job is unknown.
+  bool CancelJob(uint64_t job_id);
+
+  /// Stops accepting jobs. Run returns once the submitted jobs complete.
+  void Shutdown();
+
+  /// Waits for the submitted jobs to complete.
+  void WaitForJobs();
+
+ private:
+  struct Job {
+    uint64_t id = 0;
+    PackagingParams packaging_params;
+    std::vector<StreamDescriptor> descriptors;
+    JobState state = JobState::kQueued;
+    Status status;
+    bool cancel_requested = false;
+    // Set while the job is running and its packager is initialized.
+    Packager* packager = nullptr;
+  };
+
+  void WorkerMain();
+  void RunJob(Job* job);
+  void ServeConnection(int fd);
+  // Keeps the number of finished jobs bounded.
+  void OnJobFinished(Job* job) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const JobArgsParser job_args_parser_;
+
+  absl::Mutex mutex_;
+  std::map<uint64_t, std::unique_ptr<Job>> jobs_ ABSL_GUARDED_BY(mutex_);
+  std::deque<Job*> queued_jobs_ ABSL_GUARDED_BY(mutex_);
+  std::deque<uint64_t> finished_job_ids_ ABSL_GUARDED_BY(mutex_);
+  size_t num_active_jobs_ ABSL_GUARDED_BY(mutex_) = 0;
+  uint64_t next_job_id_ ABSL_GUARDED_BY(mutex_) = 1;
+  bool shutting_down_ ABSL_GUARDED_BY(mutex_) = false;
+  int listen_fd_ ABSL_GUARDED_BY(mutex_) = -1;
+  // Descriptors of the connections being served, each by a detached thread.
+  std::set<int> connection_fds_ ABSL_GUARDED_BY(mutex_);
+
+  std::vector<std::thread> workers_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackagerDaemon);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_APP_PACKAGER_DAEMON_H_
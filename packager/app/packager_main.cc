@@ -4,8 +4,10 @@
 // license that can be found in the LICENSE file or at
 // https://developers.google.com/open-source/licenses/bsd
 
+#include <algorithm>
 #include <iostream>
 #include <optional>
+#include <thread>
 
 #if defined(OS_WIN)
 #include <codecvt>
@@ -14,14 +16,18 @@
 
 #include <absl/flags/flag.h>
 #include <absl/flags/parse.h>
+#include <absl/flags/reflection.h>
 #include <absl/flags/usage.h>
 #include <absl/flags/usage_config.h>
 #include <absl/log/globals.h>
 #include <absl/log/initialize.h>
 #include <absl/log/log.h>
+#include <absl/strings/match.h>
 #include <absl/strings/numbers.h>
+#include <absl/strings/str_cat.h>
 #include <absl/strings/str_format.h>
 #include <absl/strings/str_split.h>
+#include <absl/synchronization/mutex.h>
 
 #include <packager/app/ad_cue_generator_flags.h>
 #include <packager/app/crypto_flags.h>
@@ -29,6 +35,7 @@
 #include <packager/app/manifest_flags.h>
 #include <packager/app/mpd_flags.h>
 #include <packager/app/muxer_flags.h>
+#include <packager/app/packager_daemon.h>
 #include <packager/app/playready_key_encryption_flags.h>
 #include <packager/app/protection_system_flags.h>
 #include <packager/app/raw_key_encryption_flags.h>
@@ -57,6 +64,24 @@ ABSL_FLAG(bool,
           single_threaded,
           false,
           "If enabled, only use one thread when generating content.");
+ABSL_FLAG(bool,
+          parallel_outputs,
+          false,
+          "If enabled, the outputs of each stream, e.g. muxers for different "
+          "output formats and trick play streams, are generated on separate "
+          "threads. Ignored if --single_threaded is set.");
+ABSL_FLAG(std::string,
+          daemon_socket,
+          "",
+          "If set, run as a daemon which accepts packaging jobs on this Unix "
+          "domain socket instead of packaging the streams on the command "
+          "line. Jobs are newline-delimited JSON requests. Flags given to the "
+          "daemon are the defaults of every job.");
+ABSL_FLAG(int32_t,
+          daemon_max_jobs,
+          0,
+          "The maximum number of jobs run concurrently in daemon mode. Other "
+          "jobs are queued. 0 means the number of CPU cores.");
 
 // From absl/log:
 ABSL_DECLARE_FLAG(int, stderrthreshold);
@@ -96,6 +121,10 @@ const char kUsage[] =
     "    of the input files or streams. If not specified, it will be\n"
     "    autodetected, which in some cases (such as live UDP webvtt) may\n"
     "    fail.\n"
+    "  - sample_index: Optional path of a sample index of the input. If it\n"
+    "    matches the input, the samples are read using the index instead of\n"
+    "    parsing the container, otherwise it is built and written. Only\n"
+    "    unencrypted local MP4 inputs are supported.\n"
     "  - skip_encryption=0|1: Optional. Defaults to 0 if not specified. If\n"
     "    it is set to 1, no encryption of the stream will be made.\n"
     "  - drm_label: Optional value for custom DRM label, which defines the\n"
@@ -340,6 +369,7 @@ std::optional<PackagingParams> GetPackagingParams() {
 
   packaging_params.temp_dir = absl::GetFlag(FLAGS_temp_dir);
   packaging_params.single_threaded = absl::GetFlag(FLAGS_single_threaded);
+  packaging_params.parallel_outputs = absl::GetFlag(FLAGS_parallel_outputs);
 
   AdCueGeneratorParams& ad_cue_generator_params =
       packaging_params.ad_cue_generator_params;
@@ -347,6 +377,8 @@ std::optional<PackagingParams> GetPackagingParams() {
                    &ad_cue_generator_params.cue_points)) {
     return std::nullopt;
   }
+  ad_cue_generator_params.frame_accurate_cue_points =
+      absl::GetFlag(FLAGS_frame_accurate_ad_cues);
 
   ChunkingParams& chunking_params = packaging_params.chunking_params;
   chunking_params.segment_duration_in_seconds =
@@ -359,6 +391,7 @@ std::optional<PackagingParams> GetPackagingParams() {
       absl::GetFlag(FLAGS_segment_sap_aligned);
   chunking_params.subsegment_sap_aligned =
       absl::GetFlag(FLAGS_fragment_sap_aligned);
+  packaging_params.segment_number = absl::GetFlag(FLAGS_segment_number);
 
   int num_key_providers = 0;
   EncryptionParams& encryption_params = packaging_params.encryption_params;
@@ -479,9 +512,11 @@ std::optional<PackagingParams> GetPackagingParams() {
       absl::GetFlag(FLAGS_default_text_zero_bias_ms);
 
   packaging_params.output_media_info = absl::GetFlag(FLAGS_output_media_info);
+  packaging_params.manifest_only = absl::GetFlag(FLAGS_manifest_only);
 
   MpdParams& mpd_params = packaging_params.mpd_params;
   mpd_params.mpd_output = absl::GetFlag(FLAGS_mpd_output);
+  mpd_params.live_state_file = absl::GetFlag(FLAGS_mpd_live_state_file);
 
   std::vector<std::string> base_urls =
       SplitAndTrimSkipEmpty(absl::GetFlag(FLAGS_base_urls), ',');
@@ -551,6 +586,145 @@ std::optional<PackagingParams> GetPackagingParams() {
   return packaging_params;
 }
 
+bool ValidateFlags() {
+  return ValidateWidevineCryptoFlags() && ValidateRawKeyCryptoFlags() &&
+         ValidatePRCryptoFlags() && ValidateCryptoFlags() &&
+         ValidateRetiredFlags();
+}
+
+bool GetStreamDescriptors(const std::vector<std::string>& args,
+                          std::vector<StreamDescriptor>* stream_descriptors) {
+  for (const std::string& arg : args) {
+    std::optional<StreamDescriptor> stream_descriptor =
+        ParseStreamDescriptor(arg);
+    if (!stream_descriptor)
+      return false;
+    stream_descriptors->push_back(stream_descriptor.value());
+  }
+
+  if (absl::GetFlag(FLAGS_force_cl_index)) {
+    int index = 0;
+    for (auto& descriptor : *stream_descriptors) {
+      descriptor.index = index++;
+    }
+  }
+  return true;
+}
+
+// Job arguments are parsed by temporarily setting the flags, so that jobs
+// accept the same flags as the command line.
+ABSL_CONST_INIT absl::Mutex g_job_args_mutex(absl::kConstInit);
+
+// Only the flags of the packager app, which are read when the arguments are
+// parsed, can be set per job. Other flags are read by the library while
+// packaging, and are shared by all the jobs of the daemon.
+bool IsJobFlag(const absl::CommandLineFlag& flag) {
+  return absl::StrContains(flag.Filename(), "packager/app/") &&
+         !absl::StartsWith(flag.Name(), "daemon_") &&
+         flag.Name() != "licenses";
+}
+
+Status ParseJobArgs(const std::vector<std::string>& args,
+                    PackagingParams* packaging_params,
+                    std::vector<StreamDescriptor>* stream_descriptors) {
+  absl::MutexLock lock(&g_job_args_mutex);
+  // Restores the daemon flags when done.
+  absl::FlagSaver flag_saver;
+
+  std::vector<std::string> descriptor_args;
+  for (size_t i = 0; i < args.size(); ++i) {
+    const std::string& arg = args[i];
+    if (arg.size() < 2 || arg[0] != '-') {
+      descriptor_args.push_back(arg);
+      continue;
+    }
+
+    absl::string_view flag_arg(arg);
+    absl::ConsumePrefix(&flag_arg, "-");
+    absl::ConsumePrefix(&flag_arg, "-");
+    const size_t equal_pos = flag_arg.find('=');
+    std::string name(flag_arg.substr(0, equal_pos));
+    std::optional<std::string> value;
+    if (equal_pos != absl::string_view::npos)
+      value = std::string(flag_arg.substr(equal_pos + 1));
+
+    absl::CommandLineFlag* flag = absl::FindCommandLineFlag(name);
+    if (!flag && !value && absl::StartsWith(name, "no")) {
+      flag = absl::FindCommandLineFlag(name.substr(2));
+      if (flag && flag->IsOfType<bool>())
+        value = "false";
+      else
+        flag = nullptr;
+    }
+    if (!flag)
+      return Status(error::INVALID_ARGUMENT, "Unknown flag " + arg);
+    if (!IsJobFlag(*flag)) {
+      return Status(
+          error::INVALID_ARGUMENT,
+          absl::StrCat("--", flag->Name(), " cannot be set per job."));
+    }
+    if (!value) {
+      if (flag->IsOfType<bool>()) {
+        value = "true";
+      } else if (i + 1 < args.size()) {
+        value = args[++i];
+      } else {
+        return Status(error::INVALID_ARGUMENT,
+                      absl::StrCat("Missing value for --", flag->Name()));
+      }
+    }
+    std::string error;
+    if (!flag->ParseFrom(value.value(), &error)) {
+      return Status(error::INVALID_ARGUMENT,
+                    absl::StrCat("Invalid --", flag->Name(), ": ", error));
+    }
+  }
+
+  if (descriptor_args.empty())
+    return Status(error::INVALID_ARGUMENT, "Missing stream descriptors.");
+  // Validation errors are logged by the functions below.
+  if (!ValidateFlags()) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Invalid job flags. See the daemon log for details.");
+  }
+  std::optional<PackagingParams> params = GetPackagingParams();
+  if (!params) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Invalid job flags. See the daemon log for details.");
+  }
+  *packaging_params = std::move(params.value());
+  if (!GetStreamDescriptors(descriptor_args, stream_descriptors)) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Invalid stream descriptors. See the daemon log for "
+                  "details.");
+  }
+  return Status::OK;
+}
+
+int RunDaemon(size_t num_stream_descriptors) {
+  if (num_stream_descriptors > 0) {
+    LOG(ERROR) << "Stream descriptors are submitted with the jobs in daemon "
+                  "mode, not on the command line.";
+    return kArgumentValidationFailed;
+  }
+  const int32_t daemon_max_jobs = absl::GetFlag(FLAGS_daemon_max_jobs);
+  if (daemon_max_jobs < 0) {
+    LOG(ERROR) << "--daemon_max_jobs should not be negative.";
+    return kArgumentValidationFailed;
+  }
+  size_t max_jobs = daemon_max_jobs;
+  if (max_jobs == 0)
+    max_jobs = std::max(1u, std::thread::hardware_concurrency());
+
+  PackagerDaemon daemon(&ParseJobArgs, max_jobs);
+  Status status = daemon.Run(absl::GetFlag(FLAGS_daemon_socket));
+  if (!status.ok()) {
+    LOG(ERROR) << "Daemon error: " << status.ToString();
+    return kPackagingFailed;
+  }
+  return kSuccess;
+}
+
 int PackagerMain(int argc, char** argv) {
   absl::FlagsUsageConfig flag_config;
   flag_config.version_string = []() -> std::string {
@@ -576,7 +750,8 @@ int PackagerMain(int argc, char** argv) {
     return kSuccess;
   }
 
-  if (remaining_args.size() < 2) {
+  const bool daemon_mode = !absl::GetFlag(FLAGS_daemon_socket).empty();
+  if (remaining_args.size() < 2 && !daemon_mode) {
     std::cerr << "Usage: " << absl::ProgramUsageMessage();
     return kSuccess;
   }
@@ -587,31 +762,21 @@ int PackagerMain(int argc, char** argv) {
 
   absl::InitializeLog();
 
-  if (!ValidateWidevineCryptoFlags() || !ValidateRawKeyCryptoFlags() ||
-      !ValidatePRCryptoFlags() || !ValidateCryptoFlags() ||
-      !ValidateRetiredFlags()) {
+  if (!ValidateFlags())
     return kArgumentValidationFailed;
-  }
+
+  if (daemon_mode)
+    return RunDaemon(remaining_args.size() - 1);
 
   std::optional<PackagingParams> packaging_params = GetPackagingParams();
   if (!packaging_params)
     return kArgumentValidationFailed;
 
+  const std::vector<std::string> descriptor_args(remaining_args.begin() + 1,
+                                                 remaining_args.end());
   std::vector<StreamDescriptor> stream_descriptors;
-  for (size_t i = 1; i < remaining_args.size(); ++i) {
-    std::optional<StreamDescriptor> stream_descriptor =
-        ParseStreamDescriptor(remaining_args[i]);
-    if (!stream_descriptor)
-      return kArgumentValidationFailed;
-    stream_descriptors.push_back(stream_descriptor.value());
-  }
-
-  if (absl::GetFlag(FLAGS_force_cl_index)) {
-    int index = 0;
-    for (auto& descriptor : stream_descriptors) {
-      descriptor.index = index++;
-    }
-  }
+  if (!GetStreamDescriptors(descriptor_args, &stream_descriptors))
+    return kArgumentValidationFailed;
 
   Packager packager;
   Status status =
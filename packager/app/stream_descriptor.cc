@@ -42,6 +42,7 @@ enum FieldType {
   kDashLabelField,
   kForcedSubtitleField,
   kInputFormatField,
+  kSampleIndexField,
 };
 
 struct FieldNameToTypeMapping {
@@ -92,6 +93,7 @@ const FieldNameToTypeMapping kFieldNameTypeMappings[] = {
     {"dash_label", kDashLabelField},
     {"forced_subtitle", kForcedSubtitleField},
     {"input_format", kInputFormatField},
+    {"sample_index", kSampleIndexField},
 };
 
 FieldType GetFieldType(const std::string& field_name) {
@@ -277,6 +279,9 @@ std::optional<StreamDescriptor> ParseStreamDescriptor(
         descriptor.input_format = pair.second;
         break;
       }
+      case kSampleIndexField:
+        descriptor.sample_index = pair.second;
+        break;
       default:
         LOG(ERROR) << "Unknown field in stream descriptor (\"" << pair.first
                    << "\").";
@@ -63,6 +63,13 @@ class PackagerApp(object):
       logging.error('%s returned non-0 status', self.packaging_command_line)
     return packaging_result
 
+  def StartDaemon(self, socket_path, flags=None):
+    """Starts packager in daemon mode. Returns the daemon process."""
+    cmd = [self.packager_binary, '--daemon_socket=' + socket_path]
+    if flags:
+      cmd.extend(flags)
+    return subprocess.Popen(cmd, env=self.GetEnv())
+
   def GetCommandLine(self):
     return self.packaging_command_line
 
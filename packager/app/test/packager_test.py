@@ -9,12 +9,16 @@
 
 import filecmp
 import glob
+import json
 import logging
 import os
+import platform
 import re
 import shutil
+import socket
 import subprocess
 import tempfile
+import time
 import unittest
 
 import packager_app
@@ -721,6 +725,69 @@ class PackagerFunctionalTest(PackagerAppTest):
         self._GetStreams(['audio', 'video']), self._GetFlags(output_dash=True))
     self._CheckTestResults('audio-video')
 
+  @unittest.skipIf(platform.system() == 'Windows',
+                   'Daemon mode is not supported on Windows.')
+  def testAudioVideoInDaemonMode(self):
+    socket_path = os.path.join(self.tmp_dir, 'packager.sock')
+    daemon = self.packager.StartDaemon(socket_path)
+    try:
+      for _ in range(100):
+        if os.path.exists(socket_path):
+          break
+        time.sleep(0.1)
+      connection = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+      connection.connect(socket_path)
+      responses = connection.makefile('r')
+
+      def Request(request):
+        connection.sendall((json.dumps(request) + '\n').encode())
+        return json.loads(responses.readline())
+
+      args = (self._GetStreams(['audio', 'video']) +
+              self._GetFlags(output_dash=True))
+      response = Request({'command': 'submit', 'args': args})
+      self.assertTrue(response['ok'], response)
+      job_id = response['job_id']
+
+      response = Request({'command': 'submit', 'args': ['--io_cache_size=1']})
+      self.assertFalse(response['ok'])
+
+      while True:
+        response = Request({'command': 'status', 'job_id': job_id})
+        self.assertTrue(response['ok'], response)
+        if response['state'] not in ('queued', 'running'):
+          break
+        time.sleep(0.1)
+      self.assertEqual(response['state'], 'succeeded', response)
+
+      self.assertTrue(Request({'command': 'shutdown'})['ok'])
+      connection.close()
+      self.assertEqual(daemon.wait(), 0)
+    finally:
+      if daemon.poll() is None:
+        daemon.kill()
+        daemon.wait()
+    self._CheckTestResults('audio-video')
+
+  def testAudioVideoManifestOnly(self):
+    # The outputs of testAudioVideo are fragmented already, so the same
+    # manifest is generated from them without rewriting the media.
+    streams = []
+    for stream_name in ['audio', 'video']:
+      file_name = 'bear-640x360-%s.mp4' % stream_name
+      file_path = os.path.join(self.tmp_dir, file_name)
+      shutil.copyfile(
+          os.path.join(self.golden_file_dir, 'audio-video', file_name),
+          file_path)
+      stream = StreamDescriptor(file_path)
+      stream.Append('stream', stream_name)
+      stream.Append('output', file_path)
+      streams.append(str(stream))
+
+    self.assertPackageSuccess(
+        streams, self._GetFlags(output_dash=True) + ['--manifest_only'])
+    self._CheckTestResults('audio-video')
+
   def testAudioVideoWithAccessibilitiesAndRoles(self):
     streams = [
         self._GetStream(
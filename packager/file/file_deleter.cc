@@ -0,0 +1,169 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/file/file_deleter.h>
+
+#include <functional>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <packager/file.h>
+#include <packager/file/thread_pool.h>
+#include <packager/macros/logging.h>
+
+namespace shaka {
+
+namespace {
+
+const size_t kMaxBacklog = 10000;
+const int kMaxAttempts = 5;
+const absl::Duration kRetryDelay = absl::Seconds(1);
+
+}  // namespace
+
+// static
+FileDeleter FileDeleter::instance(kMaxBacklog, kMaxAttempts, kRetryDelay);
+
+FileDeleter::FileDeleter(size_t max_backlog,
+                         int max_attempts,
+                         absl::Duration retry_delay)
+    : max_backlog_(max_backlog),
+      max_attempts_(max_attempts),
+      retry_delay_(retry_delay) {}
+
+FileDeleter::~FileDeleter() {
+  // Pending deletions are completed, but failed deletions are not retried.
+  absl::MutexLock lock(&mutex_);
+  shutting_down_ = true;
+  mutex_.Await(absl::Condition(
+      +[](bool* running) { return !*running; }, &running_));
+}
+
+FileDeleter::Group::Group(FileDeleter* deleter) : deleter_(deleter) {
+  DCHECK(deleter_);
+}
+
+FileDeleter::Group::~Group() {
+  Flush();
+}
+
+void FileDeleter::Group::Flush() {
+  absl::MutexLock lock(&deleter_->mutex_);
+  deleter_->mutex_.Await(absl::Condition(
+      +[](Group* group) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+        return group->num_scheduled_ == 0;
+      },
+      this));
+}
+
+void FileDeleter::Delete(const std::string& file_name, Group* group) {
+  DCHECK(!group || group->deleter_ == this);
+  absl::MutexLock lock(&mutex_);
+  if (scheduled_.size() >= max_backlog_) {
+    LOG(WARNING) << "Too many files waiting to be deleted. Waiting for "
+                 << file_name << " to be scheduled.";
+    mutex_.Await(absl::Condition(
+        +[](FileDeleter* deleter) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+          return deleter->scheduled_.size() < deleter->max_backlog_;
+        },
+        this));
+  }
+  if (!scheduled_.emplace(file_name, group).second)
+    return;
+  if (group)
+    ++group->num_scheduled_;
+  pending_.push_back(file_name);
+  if (!running_) {
+    running_ = true;
+    ThreadPool::instance.PostTask(std::bind(&FileDeleter::Run, this));
+  }
+}
+
+void FileDeleter::Flush() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(
+      +[](bool* running) { return !*running; }, &running_));
+}
+
+void FileDeleter::Run() {
+  while (true) {
+    std::vector<std::string> batch;
+    std::vector<Retry> batch_retries;
+    {
+      absl::MutexLock lock(&mutex_);
+      if (shutting_down_) {
+        for (const Retry& entry : retries_) {
+          LOG(WARNING) << "Failed to delete " << entry.file_name << ".";
+          Unschedule(entry.file_name);
+        }
+        retries_.clear();
+      }
+      if (!retries_.empty() && pending_.empty()) {
+        // Wait for the next retry, or for new files.
+        mutex_.AwaitWithDeadline(
+            absl::Condition(
+                +[](FileDeleter* deleter) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+                  return !deleter->pending_.empty() || deleter->shutting_down_;
+                },
+                this),
+            retries_.front().time);
+      }
+      if (pending_.empty() && retries_.empty()) {
+        DCHECK(scheduled_.empty());
+        running_ = false;
+        return;
+      }
+      batch.swap(pending_);
+      const absl::Time now = absl::Now();
+      while (!retries_.empty() && retries_.front().time <= now) {
+        batch_retries.push_back(std::move(retries_.front()));
+        retries_.pop_front();
+      }
+    }
+
+    for (const std::string& file_name : batch)
+      batch_retries.push_back({file_name, 0, absl::InfinitePast()});
+
+    std::vector<std::string> deleted;
+    std::vector<Retry> failed;
+    for (Retry& entry : batch_retries) {
+      VLOG(2) << "Deleting " << entry.file_name;
+      ++entry.attempts;
+      if (File::Delete(entry.file_name.c_str())) {
+        deleted.push_back(std::move(entry.file_name));
+      } else if (entry.attempts < max_attempts_) {
+        failed.push_back(std::move(entry));
+      } else {
+        LOG(WARNING) << "Failed to delete " << entry.file_name << " after "
+                     << entry.attempts << " attempts.";
+        deleted.push_back(std::move(entry.file_name));
+      }
+    }
+
+    absl::MutexLock lock(&mutex_);
+    for (const std::string& file_name : deleted)
+      Unschedule(file_name);
+    const absl::Time retry_time = absl::Now() + retry_delay_;
+    for (Retry& entry : failed) {
+      VLOG(1) << "Failed to delete " << entry.file_name << "; Will retry.";
+      entry.time = retry_time;
+      retries_.push_back(std::move(entry));
+    }
+  }
+}
+
+void FileDeleter::Unschedule(const std::string& file_name) {
+  auto it = scheduled_.find(file_name);
+  DCHECK(it != scheduled_.end());
+  if (it->second) {
+    DCHECK_GT(it->second->num_scheduled_, 0u);
+    --it->second->num_scheduled_;
+  }
+  scheduled_.erase(it);
+}
+
+}  // namespace shaka
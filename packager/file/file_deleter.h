@@ -0,0 +1,103 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_FILE_DELETER_H_
+#define PACKAGER_FILE_FILE_DELETER_H_
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+
+#include <packager/macros/classes.h>
+
+namespace shaka {
+
+/// Deletes files in the background, so that slow deletions, e.g. on network
+/// file systems or HTTP outputs, do not delay the caller. Deletions are
+/// batched on a thread from ThreadPool::instance, duplicate requests are
+/// ignored, and failed deletions are retried.
+class FileDeleter {
+ public:
+  /// Tracks the deletions scheduled by one packaging job, so that the job can
+  /// wait for its own deletions without waiting for the deletions of other
+  /// jobs in the process. Destroying a group waits for its deletions.
+  class Group {
+   public:
+    explicit Group(FileDeleter* deleter = &FileDeleter::instance);
+    ~Group();
+
+    /// Waits until the deletions scheduled with this group have completed or
+    /// failed for good.
+    void Flush();
+
+   private:
+    friend class FileDeleter;
+
+    FileDeleter* const deleter_;
+    // Number of files scheduled with this group, guarded by deleter_->mutex_.
+    size_t num_scheduled_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(Group);
+  };
+
+  /// @param max_backlog is the maximum number of files waiting to be deleted.
+  ///        Delete blocks while the backlog is full.
+  /// @param max_attempts is the maximum number of times a file deletion is
+  ///        attempted.
+  /// @param retry_delay is the delay before a failed deletion is retried.
+  FileDeleter(size_t max_backlog, int max_attempts, absl::Duration retry_delay);
+  ~FileDeleter();
+
+  /// Schedules the deletion of a file.
+  /// @param file_name is the name of the file, as passed to File::Delete.
+  /// @param group is the group the deletion belongs to, or null. It must be
+  ///        a group of this FileDeleter.
+  void Delete(const std::string& file_name, Group* group = nullptr);
+
+  /// Waits until all the scheduled deletions, of all groups, have completed
+  /// or failed for good.
+  void Flush();
+
+  static FileDeleter instance;
+
+ private:
+  struct Retry {
+    std::string file_name;
+    int attempts;
+    absl::Time time;
+  };
+
+  void Run();
+  // Removes |file_name| from |scheduled_| once it is deleted or given up.
+  void Unschedule(const std::string& file_name)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const size_t max_backlog_;
+  const int max_attempts_;
+  const absl::Duration retry_delay_;
+
+  absl::Mutex mutex_;
+  std::vector<std::string> pending_ ABSL_GUARDED_BY(mutex_);
+  // Retries are queued in increasing |time| order.
+  std::deque<Retry> retries_ ABSL_GUARDED_BY(mutex_);
+  // Files which are pending, being deleted or waiting for a retry, with the
+  // group they belong to.
+  std::map<std::string, Group*> scheduled_ ABSL_GUARDED_BY(mutex_);
+  bool running_ ABSL_GUARDED_BY(mutex_) = false;
+  bool shutting_down_ ABSL_GUARDED_BY(mutex_) = false;
+
+  DISALLOW_COPY_AND_ASSIGN(FileDeleter);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_FILE_DELETER_H_
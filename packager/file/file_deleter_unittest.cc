@@ -0,0 +1,111 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/file/file_deleter.h>
+
+#include <memory>
+#include <string>
+
+#include <absl/time/clock.h>
+#include <gtest/gtest.h>
+
+#include <packager/file.h>
+#include <packager/file/file_closer.h>
+#include <packager/file/file_test_util.h>
+#include <packager/file/memory_file.h>
+
+namespace shaka {
+namespace {
+
+const int kMaxAttempts = 3;
+
+bool FileExists(const std::string& file_name) {
+  std::unique_ptr<File, FileCloser> file(File::Open(file_name.c_str(), "r"));
+  return file != nullptr;
+}
+
+}  // namespace
+
+class FileDeleterTest : public testing::Test {
+ protected:
+  void TearDown() override { MemoryFile::DeleteAll(); }
+};
+
+TEST_F(FileDeleterTest, DeletesFiles) {
+  FileDeleter deleter(100, kMaxAttempts, absl::Milliseconds(1));
+  for (int i = 0; i < 10; ++i) {
+    const std::string file_name = "memory://file" + std::to_string(i);
+    ASSERT_TRUE(File::WriteStringToFile(file_name.c_str(), "content"));
+    deleter.Delete(file_name);
+    // Duplicates are ignored.
+    deleter.Delete(file_name);
+  }
+  deleter.Flush();
+
+  for (int i = 0; i < 10; ++i)
+    EXPECT_FALSE(FileExists("memory://file" + std::to_string(i)));
+}
+
+TEST_F(FileDeleterTest, BoundedBacklog) {
+  // Delete blocks while the backlog is full, so all the files are deleted
+  // eventually.
+  FileDeleter deleter(2, kMaxAttempts, absl::Milliseconds(1));
+  for (int i = 0; i < 20; ++i) {
+    const std::string file_name = "memory://file" + std::to_string(i);
+    ASSERT_TRUE(File::WriteStringToFile(file_name.c_str(), "content"));
+    deleter.Delete(file_name);
+  }
+  deleter.Flush();
+
+  for (int i = 0; i < 20; ++i)
+    EXPECT_FALSE(FileExists("memory://file" + std::to_string(i)));
+}
+
+TEST_F(FileDeleterTest, RetriesFailedDeletions) {
+  // Deleting a local file which does not exist fails, so the file is only
+  // deleted by a retry once it is created.
+  const std::string file_name = generate_unique_temp_path();
+  ASSERT_TRUE(File::Delete(file_name.c_str()));
+  FileDeleter deleter(100, kMaxAttempts, absl::Milliseconds(200));
+  deleter.Delete(file_name);
+  absl::SleepFor(absl::Milliseconds(50));
+  ASSERT_TRUE(File::WriteStringToFile(file_name.c_str(), "content"));
+  deleter.Flush();
+  EXPECT_FALSE(FileExists(file_name));
+}
+
+TEST_F(FileDeleterTest, GivesUpAfterMaxAttempts) {
+  const std::string file_name = generate_unique_temp_path();
+  ASSERT_TRUE(File::Delete(file_name.c_str()));
+  FileDeleter deleter(100, kMaxAttempts, absl::Milliseconds(1));
+  deleter.Delete(file_name);
+  // Returns once the deletion has failed |kMaxAttempts| times.
+  deleter.Flush();
+}
+
+TEST_F(FileDeleterTest, FlushesGroup) {
+  // The deletion of |other_group| fails, so waiting for it would take at
+  // least one retry delay.
+  const std::string failing_file_name = generate_unique_temp_path();
+  ASSERT_TRUE(File::Delete(failing_file_name.c_str()));
+  FileDeleter deleter(100, kMaxAttempts, absl::Seconds(2));
+  FileDeleter::Group group(&deleter);
+  FileDeleter::Group other_group(&deleter);
+  deleter.Delete(failing_file_name, &other_group);
+
+  const std::string file_name = "memory://file";
+  ASSERT_TRUE(File::WriteStringToFile(file_name.c_str(), "content"));
+  const absl::Time start = absl::Now();
+  deleter.Delete(file_name, &group);
+  group.Flush();
+  EXPECT_LT(absl::Now() - start, absl::Seconds(1));
+  EXPECT_FALSE(FileExists(file_name));
+
+  // Lets the retry of |other_group| succeed.
+  ASSERT_TRUE(File::WriteStringToFile(failing_file_name.c_str(), "content"));
+}
+
+}  // namespace shaka
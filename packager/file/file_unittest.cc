@@ -6,18 +6,32 @@
 
 #include <packager/file.h>
 
+#if !defined(OS_WIN)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // !defined(OS_WIN)
+
+#include <chrono>
+#include <csignal>
 #include <cstdio>
 #include <filesystem>
 #include <locale>
+#include <thread>
 
 #include <absl/flags/declare.h>
 #include <gtest/gtest.h>
 
 #include <packager/file/file_test_util.h>
+#include <packager/file/io_uring.h>
 #include <packager/flag_saver.h>
 
 ABSL_DECLARE_FLAG(uint64_t, io_cache_size);
 ABSL_DECLARE_FLAG(uint64_t, io_block_size);
+ABSL_DECLARE_FLAG(bool, io_uring);
+ABSL_DECLARE_FLAG(bool, io_uring_fsync);
+ABSL_DECLARE_FLAG(bool, io_drop_consumed_input);
 
 namespace {
 const int kDataSize = 1024;
@@ -243,11 +257,194 @@ TEST_F(LocalFileTest, WriteFlushCheckSize) {
   }
 }
 
+TEST_F(LocalFileTest, IoUringWriteRead) {
+  if (!IoUring::GetInstance())
+    GTEST_SKIP() << "io_uring is not available.";
+
+  FlagSaver local_backup_io_uring(&FLAGS_io_uring);
+  FlagSaver local_backup_io_block_size(&FLAGS_io_block_size);
+  absl::SetFlag(&FLAGS_io_uring, true);
+  // Use a block size smaller than the data so that there are several writes
+  // in flight.
+  absl::SetFlag(&FLAGS_io_block_size, 100);
+  absl::SetFlag(&FLAGS_io_cache_size, 300);
+
+  File* file = File::Open(local_file_name_.c_str(), "w");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_EQ(kDataSize, file->Write(data_.data(), kDataSize));
+  EXPECT_EQ(kDataSize, file->Size());
+  ASSERT_TRUE(file->Flush());
+  EXPECT_EQ(kDataSize, FileSize(local_file_name_no_prefix_));
+  EXPECT_EQ(kDataSize, file->Write(data_.data(), kDataSize));
+  ASSERT_TRUE(file->Close());
+
+  std::string read_data;
+  ASSERT_EQ(kDataSize * 2u,
+            ReadFile(local_file_name_no_prefix_, &read_data, kDataSize * 4));
+  EXPECT_EQ(data_ + data_, read_data);
+}
+
+#if defined(__linux__)
+TEST_F(LocalFileTest, IoUringWriteErrorWithWritesInFlight) {
+  if (!IoUring::GetInstance())
+    GTEST_SKIP() << "io_uring is not available.";
+
+  FlagSaver local_backup_io_uring(&FLAGS_io_uring);
+  FlagSaver local_backup_io_block_size(&FLAGS_io_block_size);
+  FlagSaver local_backup_io_cache_size(&FLAGS_io_cache_size);
+
+  // Writes to a pipe which is not read block once it is full, so that there
+  // are several writes in flight when the reader goes away and they fail.
+  signal(SIGPIPE, SIG_IGN);
+  DeleteFile(local_file_name_no_prefix_);
+  ASSERT_EQ(0, mkfifo(local_file_name_no_prefix_.c_str(), 0600));
+  const int reader =
+      open(local_file_name_no_prefix_.c_str(), O_RDONLY | O_NONBLOCK);
+  ASSERT_GE(reader, 0);
+  // Used to tell when the pipe is full.
+  const int probe =
+      open(local_file_name_no_prefix_.c_str(), O_WRONLY | O_NONBLOCK);
+  ASSERT_GE(probe, 0);
+  const int pipe_size = fcntl(reader, F_GETPIPE_SZ);
+  ASSERT_GT(pipe_size, 0);
+
+  // Leave room in the cache for all the writes, so that Write() never waits
+  // for the blocked ones.
+  const int kNumBlockedWrites = 8;
+  const int num_writes = pipe_size / kDataSize + kNumBlockedWrites;
+  absl::SetFlag(&FLAGS_io_uring, true);
+  absl::SetFlag(&FLAGS_io_block_size, kDataSize);
+  absl::SetFlag(&FLAGS_io_cache_size, num_writes * kDataSize);
+
+  File* file = File::Open(local_file_name_.c_str(), "w");
+  ASSERT_TRUE(file != NULL);
+  for (int i = 0; i < num_writes; ++i)
+    ASSERT_EQ(kDataSize, file->Write(data_.data(), kDataSize));
+
+  // Once the pipe is full, the remaining writes are blocked in the ring.
+  pollfd poll_fd = {probe, POLLOUT, 0};
+  while (poll(&poll_fd, 1, 0) != 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  close(probe);
+  close(reader);
+
+  // Flushing must wait for the writes still in flight and report their
+  // failure, which also fails the later writes.
+  EXPECT_FALSE(file->Flush());
+  EXPECT_EQ(-1, file->Write(data_.data(), kDataSize));
+  EXPECT_FALSE(file->Close());
+}
+#endif  // defined(__linux__)
+
+TEST_F(LocalFileTest, IoUringAtomicWriteRead) {
+  if (!IoUring::GetInstance())
+    GTEST_SKIP() << "io_uring is not available.";
+
+  FlagSaver local_backup_io_uring(&FLAGS_io_uring);
+  absl::SetFlag(&FLAGS_io_uring, true);
+
+  ASSERT_TRUE(
+      File::WriteFileAtomically(local_file_name_no_prefix_.c_str(), data_));
+  std::string read_data;
+  ASSERT_EQ(kDataSize,
+            ReadFile(local_file_name_no_prefix_, &read_data, kDataSize * 2));
+  EXPECT_EQ(data_, read_data);
+}
+
+TEST_F(LocalFileTest, IoUringFsync) {
+  if (!IoUring::GetInstance())
+    GTEST_SKIP() << "io_uring is not available.";
+
+  FlagSaver local_backup_io_uring(&FLAGS_io_uring);
+  FlagSaver local_backup_io_uring_fsync(&FLAGS_io_uring_fsync);
+  absl::SetFlag(&FLAGS_io_uring, true);
+  absl::SetFlag(&FLAGS_io_uring_fsync, true);
+
+  File* file = File::Open(local_file_name_.c_str(), "w");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_EQ(kDataSize, file->Write(data_.data(), kDataSize));
+  ASSERT_TRUE(file->Close());
+  std::string read_data;
+  ASSERT_EQ(kDataSize,
+            ReadFile(local_file_name_no_prefix_, &read_data, kDataSize * 2));
+  EXPECT_EQ(data_, read_data);
+
+  ASSERT_TRUE(
+      File::WriteFileAtomically(local_file_name_no_prefix_.c_str(), data_));
+  ASSERT_EQ(kDataSize,
+            ReadFile(local_file_name_no_prefix_, &read_data, kDataSize * 2));
+  EXPECT_EQ(data_, read_data);
+}
+
+TEST_F(LocalFileTest, SequentialReadWithSeek) {
+  // Large enough for the consumed pages to be dropped and for the threaded
+  // read size to grow to its maximum.
+  const uint64_t kFileSize = 20 << 20;
+  const uint64_t kReadSize = 100000;
+  const uint64_t kSeekPosition = 1234567;
+
+  std::string data(kFileSize, 0);
+  for (uint64_t i = 0; i < kFileSize; ++i)
+    data[i] = static_cast<char>(i * 7 + i / 256);
+  ASSERT_TRUE(File::WriteStringToFile(local_file_name_.c_str(), data));
+
+  FlagSaver local_backup_io_block_size(&FLAGS_io_block_size);
+  FlagSaver local_backup_io_cache_size(&FLAGS_io_cache_size);
+  FlagSaver local_backup_io_drop_consumed_input(&FLAGS_io_drop_consumed_input);
+  absl::SetFlag(&FLAGS_io_block_size, 4096);
+  absl::SetFlag(&FLAGS_io_drop_consumed_input, true);
+  // Without and with ThreadedIoFile.
+  for (uint64_t io_cache_size : {0ULL, 8ULL << 20}) {
+    SCOPED_TRACE(io_cache_size);
+    absl::SetFlag(&FLAGS_io_cache_size, io_cache_size);
+
+    File* file = File::Open(local_file_name_.c_str(), "r");
+    ASSERT_TRUE(file != nullptr);
+    std::string read_data;
+    std::vector<char> buffer(kReadSize);
+    int64_t bytes_read;
+    while ((bytes_read = file->Read(buffer.data(), buffer.size())) > 0)
+      read_data.append(buffer.data(), bytes_read);
+    EXPECT_EQ(0, bytes_read);
+    EXPECT_TRUE(read_data == data);
+
+    // Data before the dropped pages can still be read after seeking back.
+    ASSERT_TRUE(file->Seek(kSeekPosition));
+    read_data.clear();
+    while ((bytes_read = file->Read(buffer.data(), buffer.size())) > 0)
+      read_data.append(buffer.data(), bytes_read);
+    EXPECT_TRUE(read_data == data.substr(kSeekPosition));
+    EXPECT_TRUE(file->Close());
+  }
+}
+
 TEST_F(LocalFileTest, IsLocalRegular) {
   WriteFile(local_file_name_no_prefix_, data_);
   ASSERT_TRUE(File::IsLocalRegularFile(local_file_name_.c_str()));
 }
 
+TEST_F(LocalFileTest, LastModificationTime) {
+  DeleteFile(local_file_name_no_prefix_);
+  int64_t time = 0;
+  EXPECT_FALSE(File::GetLastModificationTime(local_file_name_.c_str(), &time));
+  EXPECT_FALSE(File::GetLastModificationTime("memory://file", &time));
+
+  WriteFile(local_file_name_no_prefix_, data_);
+  ASSERT_TRUE(File::GetLastModificationTime(local_file_name_.c_str(), &time));
+  int64_t same_time = 0;
+  ASSERT_TRUE(
+      File::GetLastModificationTime(local_file_name_.c_str(), &same_time));
+  EXPECT_EQ(time, same_time);
+
+  const auto path = std::filesystem::u8path(local_file_name_no_prefix_);
+  std::filesystem::last_write_time(
+      path, std::filesystem::last_write_time(path) + std::chrono::seconds(1));
+  int64_t new_time = 0;
+  ASSERT_TRUE(
+      File::GetLastModificationTime(local_file_name_.c_str(), &new_time));
+  EXPECT_NE(time, new_time);
+}
+
 TEST_F(LocalFileTest, UnicodePath) {
   // Delete the temp file already created.
   DeleteFile(local_file_name_no_prefix_);
@@ -6,12 +6,15 @@
 
 #include <packager/file/http_file.h>
 
+#include <vector>
+
 #include <absl/flags/declare.h>
 #include <absl/flags/flag.h>
 #include <absl/log/check.h>
 #include <absl/log/log.h>
 #include <absl/strings/escaping.h>
 #include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
 #include <curl/curl.h>
 
 #include <packager/file/thread_pool.h>
@@ -137,16 +140,101 @@ class LibCurlInitializer {
  public:
   LibCurlInitializer() {
     curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    // Share the DNS and TLS session caches between all requests in the
+    // process. The connection cache is not shared, as libcurl does not support
+    // using it from concurrent threads; connections are reused through the
+    // easy handles kept by AcquireHandle() and ReleaseHandle() instead.
+    share_ = curl_share_init();
+    if (share_) {
+      curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &LockShare);
+      curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &UnlockShare);
+      curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+      curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+      curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
   }
 
   ~LibCurlInitializer() {
+    for (CURL* curl : idle_handles_)
+      curl_easy_cleanup(curl);
+    if (share_)
+      curl_share_cleanup(share_);
     curl_global_cleanup();
   }
 
+  CURLSH* share() const { return share_; }
+
+  /// @return An easy handle for a request, which is only used by one request
+  ///         at a time. The handle may have been used by an earlier request,
+  ///         in which case it keeps the connections that request left open.
+  CURL* AcquireHandle() {
+    {
+      absl::MutexLock lock(&handles_mutex_);
+      if (!idle_handles_.empty()) {
+        CURL* curl = idle_handles_.back();
+        idle_handles_.pop_back();
+        return curl;
+      }
+    }
+    return curl_easy_init();
+  }
+
+  /// Returns a handle obtained from AcquireHandle() once its request is done.
+  void ReleaseHandle(CURL* curl) {
+    // Clears the options, which refer to the finished request, but keeps the
+    // open connections.
+    curl_easy_reset(curl);
+    {
+      absl::MutexLock lock(&handles_mutex_);
+      if (idle_handles_.size() < kMaxIdleHandles) {
+        idle_handles_.push_back(curl);
+        return;
+      }
+    }
+    curl_easy_cleanup(curl);
+  }
+
   LibCurlInitializer(const LibCurlInitializer&) = delete;
   LibCurlInitializer& operator=(const LibCurlInitializer&) = delete;
+
+ private:
+  static void LockShare(CURL* handle,
+                        curl_lock_data data,
+                        curl_lock_access access,
+                        void* user_data) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+    UNUSED(handle);
+    UNUSED(access);
+    static_cast<LibCurlInitializer*>(user_data)->MutexFor(data)->Lock();
+  }
+
+  static void UnlockShare(CURL* handle, curl_lock_data data, void* user_data)
+      ABSL_NO_THREAD_SAFETY_ANALYSIS {
+    UNUSED(handle);
+    static_cast<LibCurlInitializer*>(user_data)->MutexFor(data)->Unlock();
+  }
+
+  absl::Mutex* MutexFor(curl_lock_data data) {
+    const size_t index = static_cast<size_t>(data);
+    return &mutexes_[index < CURL_LOCK_DATA_LAST ? index : 0];
+  }
+
+  // The number of idle easy handles kept for reuse, each with its own
+  // connections.
+  static const size_t kMaxIdleHandles = 16;
+
+  CURLSH* share_ = nullptr;
+  absl::Mutex mutexes_[CURL_LOCK_DATA_LAST];
+
+  absl::Mutex handles_mutex_;
+  std::vector<CURL*> idle_handles_ ABSL_GUARDED_BY(handles_mutex_);
 };
 
+LibCurlInitializer* GetLibCurlInitializer() {
+  static LibCurlInitializer lib_curl_initializer;
+  return &lib_curl_initializer;
+}
+
 template <typename List>
 bool AppendHeader(const std::string& header, List* list) {
   auto* temp = curl_slist_append(list->get(), header.c_str());
@@ -176,7 +264,7 @@ HttpFile::HttpFile(HttpMethod method,
       method_(method),
       download_cache_(absl::GetFlag(FLAGS_io_cache_size)),
       upload_cache_(absl::GetFlag(FLAGS_io_cache_size)),
-      curl_(curl_easy_init()),
+      curl_(GetLibCurlInitializer()->AcquireHandle()),
       status_(Status::OK),
       user_agent_(absl::GetFlag(FLAGS_user_agent)),
       ca_file_(absl::GetFlag(FLAGS_ca_file)),
@@ -185,7 +273,7 @@ HttpFile::HttpFile(HttpMethod method,
           absl::GetFlag(FLAGS_client_cert_private_key_file)),
       client_cert_private_key_password_(
           absl::GetFlag(FLAGS_client_cert_private_key_password)) {
-  static LibCurlInitializer lib_curl_initializer;
+  GetLibCurlInitializer();
   if (user_agent_.empty()) {
     user_agent_ += "ShakaPackager/" + GetPackagerVersion();
   }
@@ -293,7 +381,7 @@ bool HttpFile::Tell(uint64_t* position) {
 }
 
 void HttpFile::CurlDelete::operator()(CURL* curl) {
-  curl_easy_cleanup(curl);
+  GetLibCurlInitializer()->ReleaseHandle(curl);
 }
 
 void HttpFile::CurlDelete::operator()(curl_slist* headers) {
@@ -315,6 +403,9 @@ void HttpFile::SetupRequest() {
       break;
   }
 
+  CURLSH* share = GetLibCurlInitializer()->share();
+  if (share)
+    curl_easy_setopt(curl, CURLOPT_SHARE, share);
   curl_easy_setopt(curl, CURLOPT_URL, url_.c_str());
   curl_easy_setopt(curl, CURLOPT_USERAGENT, user_agent_.c_str());
   curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_in_seconds_);
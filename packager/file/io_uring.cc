@@ -0,0 +1,489 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/file/io_uring.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SHAKA_HAS_IO_URING
+#endif
+#endif
+
+#if defined(SHAKA_HAS_IO_URING)
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#endif  // defined(SHAKA_HAS_IO_URING)
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+#include <absl/strings/str_join.h>
+
+#include <packager/file/thread_pool.h>
+#include <packager/macros/logging.h>
+
+namespace shaka {
+
+struct IoUring::Request {
+  uint8_t opcode = 0;
+  uint8_t sqe_flags = 0;
+  int fd = -1;
+  uint64_t offset = 0;
+  // The buffer to write. Points to |data| unless the caller keeps the buffer
+  // alive until completion.
+  const void* buffer = nullptr;
+  uint32_t length = 0;
+  std::vector<uint8_t> data;
+  std::string path;
+  std::string new_path;
+  Callback callback;
+};
+
+#if defined(SHAKA_HAS_IO_URING)
+
+namespace {
+
+// The number of submission queue entries. The completion queue is twice as
+// large.
+const unsigned kQueueDepth = 256;
+
+int IoUringSetup(unsigned entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd,
+                 unsigned to_submit,
+                 unsigned min_complete,
+                 unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+
+int IoUringRegister(int ring_fd, unsigned opcode, void* arg, unsigned nr_args) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+}  // namespace
+
+// static
+IoUring* IoUring::GetInstance() {
+  // The ring is never destroyed as the completion thread may still be waiting
+  // on it at exit.
+  static IoUring* const instance = []() -> IoUring* {
+    IoUring* io_uring = new IoUring;
+    if (!io_uring->Initialize()) {
+      delete io_uring;
+      return nullptr;
+    }
+    return io_uring;
+  }();
+  return instance;
+}
+
+IoUring::IoUring() {}
+
+IoUring::~IoUring() {
+  if (sqes_)
+    munmap(sqes_, sqes_size_);
+  if (cq_ring_ && cq_ring_ != sq_ring_)
+    munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_)
+    munmap(sq_ring_, sq_ring_size_);
+  if (ring_fd_ >= 0)
+    close(ring_fd_);
+}
+
+bool IoUring::Initialize() {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = IoUringSetup(kQueueDepth, &params);
+  if (ring_fd_ < 0) {
+    LOG(WARNING) << "io_uring is not available: " << strerror(errno);
+    return false;
+  }
+
+  // IORING_REGISTER_PROBE is available since Linux 5.6, which is also the
+  // first version supporting IORING_OP_WRITE.
+  const unsigned kMaxOps = 256;
+  std::vector<uint8_t> probe_buffer(sizeof(io_uring_probe) +
+                                    kMaxOps * sizeof(io_uring_probe_op));
+  io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(&probe_buffer[0]);
+  if (IoUringRegister(ring_fd_, IORING_REGISTER_PROBE, probe, kMaxOps) < 0) {
+    LOG(WARNING) << "io_uring is too old: " << strerror(errno);
+    return false;
+  }
+  auto op_supported = [probe](int op) {
+    return op <= probe->last_op &&
+           (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+  };
+  if (!op_supported(IORING_OP_WRITE)) {
+    LOG(WARNING) << "io_uring does not support writes.";
+    return false;
+  }
+  supports_atomic_write_ =
+      op_supported(IORING_OP_CLOSE) && op_supported(IORING_OP_RENAMEAT);
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap)
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+  void* sq_ring = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED) {
+    LOG(ERROR) << "Failed to map io_uring submission queue.";
+    return false;
+  }
+  sq_ring_ = sq_ring;
+
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    void* cq_ring =
+        mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED) {
+      LOG(ERROR) << "Failed to map io_uring completion queue.";
+      return false;
+    }
+    cq_ring_ = cq_ring;
+  }
+
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    LOG(ERROR) << "Failed to map io_uring submission queue entries.";
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+  uint8_t* sq_base = static_cast<uint8_t*>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned*>(sq_base + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq_base + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<unsigned*>(sq_base + params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  sq_array_ = reinterpret_cast<unsigned*>(sq_base + params.sq_off.array);
+
+  uint8_t* cq_base = static_cast<uint8_t*>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned*>(cq_base + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq_base + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<unsigned*>(cq_base + params.cq_off.ring_mask);
+  cq_entries_ = params.cq_entries;
+  cqes_ = reinterpret_cast<io_uring_cqe*>(cq_base + params.cq_off.cqes);
+
+  ThreadPool::instance.PostTask(std::bind(&IoUring::ReapCompletions, this));
+  VLOG(1) << "io_uring initialized with " << sq_entries_ << " entries.";
+  return true;
+}
+
+bool IoUring::Write(int fd,
+                    uint64_t offset,
+                    std::vector<uint8_t> data,
+                    Callback callback) {
+  Request* request = new Request;
+  request->opcode = IORING_OP_WRITE;
+  request->fd = fd;
+  request->offset = offset;
+  request->data = std::move(data);
+  request->buffer = request->data.data();
+  request->length = static_cast<uint32_t>(request->data.size());
+  request->callback = std::move(callback);
+  if (!Submit({request})) {
+    delete request;
+    return false;
+  }
+  return true;
+}
+
+bool IoUring::Sync(int fd) {
+  absl::Mutex mutex;
+  bool completed = false;
+  int32_t result = 0;
+  Request* request = new Request;
+  request->opcode = IORING_OP_FSYNC;
+  request->fd = fd;
+  request->callback = [&](int32_t fsync_result) {
+    absl::MutexLock lock(&mutex);
+    result = fsync_result;
+    completed = true;
+  };
+  if (!Submit({request})) {
+    delete request;
+    return false;
+  }
+
+  mutex.LockWhen(absl::Condition(&completed));
+  mutex.Unlock();
+  if (result < 0) {
+    LOG(ERROR) << "Failed to sync through io_uring: " << strerror(-result);
+    return false;
+  }
+  return true;
+}
+
+bool IoUring::WriteFileAtomically(const std::string& temp_file_name,
+                                  const std::string& file_name,
+                                  const std::string& contents,
+                                  bool sync) {
+  DCHECK(supports_atomic_write_);
+
+  const int fd = open(temp_file_name.c_str(),
+                      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (fd < 0) {
+    LOG(ERROR) << "Failed to open " << temp_file_name << ": "
+               << strerror(errno);
+    return false;
+  }
+
+  // Write, sync, close and rename are linked so that each one only starts
+  // once the previous one has succeeded; a failure cancels the rest of the
+  // chain.
+  std::vector<Request*> requests;
+
+  Request* write_request = new Request;
+  write_request->opcode = IORING_OP_WRITE;
+  write_request->sqe_flags = IOSQE_IO_LINK;
+  write_request->fd = fd;
+  write_request->buffer = contents.data();
+  write_request->length = static_cast<uint32_t>(contents.size());
+  requests.push_back(write_request);
+
+  if (sync) {
+    Request* fsync_request = new Request;
+    fsync_request->opcode = IORING_OP_FSYNC;
+    fsync_request->sqe_flags = IOSQE_IO_LINK;
+    fsync_request->fd = fd;
+    requests.push_back(fsync_request);
+  }
+
+  const size_t close_index = requests.size();
+  Request* close_request = new Request;
+  close_request->opcode = IORING_OP_CLOSE;
+  close_request->sqe_flags = IOSQE_IO_LINK;
+  close_request->fd = fd;
+  requests.push_back(close_request);
+
+  Request* rename_request = new Request;
+  rename_request->opcode = IORING_OP_RENAMEAT;
+  rename_request->path = temp_file_name;
+  rename_request->new_path = file_name;
+  requests.push_back(rename_request);
+
+  const size_t num_requests = requests.size();
+  absl::Mutex mutex;
+  size_t num_pending = num_requests;
+  std::vector<int32_t> results(num_requests);
+  for (size_t i = 0; i < num_requests; ++i) {
+    requests[i]->callback = [&, i](int32_t result) {
+      absl::MutexLock lock(&mutex);
+      results[i] = result;
+      --num_pending;
+    };
+  }
+
+  if (!Submit(requests)) {
+    for (Request* request : requests)
+      delete request;
+    close(fd);
+    return false;
+  }
+
+  mutex.LockWhen(absl::Condition(
+      +[](size_t* num_pending) { return *num_pending == 0; }, &num_pending));
+  mutex.Unlock();
+
+  if (results[close_index] == -ECANCELED)
+    close(fd);
+  bool succeeded = results[0] == static_cast<int32_t>(contents.size());
+  for (size_t i = 1; i < num_requests; ++i)
+    succeeded &= results[i] >= 0;
+  if (!succeeded) {
+    LOG(ERROR) << "Failed to write " << file_name << " through io_uring: "
+               << absl::StrJoin(results, ", ");
+    std::error_code ec;
+    std::filesystem::remove(std::filesystem::u8path(temp_file_name), ec);
+    return false;
+  }
+  return true;
+}
+
+bool IoUring::Submit(const std::vector<Request*>& requests) {
+  const unsigned num_requests = static_cast<unsigned>(requests.size());
+  DCHECK_LE(num_requests, sq_entries_);
+
+  unsigned num_submitted = 0;
+  {
+    absl::MutexLock lock(&mutex_);
+    num_submitted = SubmitLocked(requests);
+  }
+  if (num_submitted == 0)
+    return false;
+
+  // Only part of a chain was submitted. The rest is completed as the kernel
+  // would complete the operations of a broken chain.
+  for (unsigned i = num_submitted; i < num_requests; ++i) {
+    if (requests[i]->callback)
+      requests[i]->callback(-ECANCELED);
+    delete requests[i];
+  }
+  return true;
+}
+
+unsigned IoUring::SubmitLocked(const std::vector<Request*>& requests) {
+  const unsigned num_requests = static_cast<unsigned>(requests.size());
+  while (requests_in_flight_ + num_requests > cq_entries_)
+    room_available_.Wait(&mutex_);
+
+  // The submission queue is always drained before |mutex_| is released, so
+  // there is room for all the requests.
+  const unsigned first_tail = *sq_tail_;
+  unsigned tail = first_tail;
+  for (Request* request : requests) {
+    const unsigned index = tail & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = request->opcode;
+    sqe->flags = request->sqe_flags;
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+    switch (request->opcode) {
+      case IORING_OP_WRITE:
+        sqe->fd = request->fd;
+        sqe->addr = reinterpret_cast<uint64_t>(request->buffer);
+        sqe->len = request->length;
+        sqe->off = request->offset;
+        break;
+      case IORING_OP_FSYNC:
+      case IORING_OP_CLOSE:
+        sqe->fd = request->fd;
+        break;
+      case IORING_OP_RENAMEAT:
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uint64_t>(request->path.c_str());
+        sqe->len = static_cast<uint32_t>(AT_FDCWD);
+        sqe->off = reinterpret_cast<uint64_t>(request->new_path.c_str());
+        break;
+      default:
+        NOTIMPLEMENTED() << "Unsupported io_uring operation "
+                         << static_cast<int>(request->opcode);
+        return 0;
+    }
+    sq_array_[index] = index;
+    ++tail;
+  }
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+  unsigned num_submitted = 0;
+  while (num_submitted < num_requests) {
+    const int result =
+        IoUringEnter(ring_fd_, num_requests - num_submitted, 0, 0);
+    if (result < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+        continue;
+      LOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+      // Take back the entries that the kernel has not consumed, so that they
+      // are not submitted with later requests.
+      __atomic_store_n(sq_tail_, first_tail + num_submitted, __ATOMIC_RELEASE);
+      break;
+    }
+    num_submitted += result;
+  }
+  requests_in_flight_ += num_submitted;
+  return num_submitted;
+}
+
+void IoUring::ReapCompletions() {
+  std::vector<std::pair<Request*, int32_t>> completions;
+  while (true) {
+    const int result = IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+    if (result < 0 && errno != EINTR) {
+      LOG(ERROR) << "Failed to wait for io_uring completions: "
+                 << strerror(errno);
+      return;
+    }
+
+    // Only this thread updates the completion queue head.
+    unsigned head = *cq_head_;
+    const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+      const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+      completions.emplace_back(reinterpret_cast<Request*>(cqe.user_data),
+                               cqe.res);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    if (completions.empty())
+      continue;
+
+    for (const auto& completion : completions) {
+      Request* request = completion.first;
+      if (request->callback)
+        request->callback(completion.second);
+      delete request;
+    }
+    {
+      absl::MutexLock lock(&mutex_);
+      requests_in_flight_ -= static_cast<unsigned>(completions.size());
+    }
+    room_available_.SignalAll();
+    completions.clear();
+  }
+}
+
+#else  // defined(SHAKA_HAS_IO_URING)
+
+// static
+IoUring* IoUring::GetInstance() {
+  return nullptr;
+}
+
+IoUring::IoUring() {}
+
+IoUring::~IoUring() {}
+
+bool IoUring::Initialize() {
+  return false;
+}
+
+bool IoUring::Write(int, uint64_t, std::vector<uint8_t>, Callback) {
+  NOTIMPLEMENTED();
+  return false;
+}
+
+bool IoUring::Sync(int) {
+  NOTIMPLEMENTED();
+  return false;
+}
+
+bool IoUring::WriteFileAtomically(const std::string&,
+                                  const std::string&,
+                                  const std::string&,
+                                  bool) {
+  NOTIMPLEMENTED();
+  return false;
+}
+
+bool IoUring::Submit(const std::vector<Request*>&) {
+  return false;
+}
+
+unsigned IoUring::SubmitLocked(const std::vector<Request*>&) {
+  return 0;
+}
+
+void IoUring::ReapCompletions() {}
+
+#endif  // defined(SHAKA_HAS_IO_URING)
+
+}  // namespace shaka
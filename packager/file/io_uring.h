@@ -0,0 +1,129 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_IO_URING_H_
+#define PACKAGER_FILE_IO_URING_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <packager/macros/classes.h>
+
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+namespace shaka {
+
+/// A process-wide io_uring instance, shared by all the files using it. Writes
+/// from all the files are submitted to the same ring and their completions
+/// are reaped by a single thread, instead of one I/O thread per open file.
+/// The ring is accessed through raw system calls so that there is no
+/// dependency on liburing. It is only available on Linux kernels that support
+/// io_uring and allow it (it is commonly blocked in containers); callers must
+/// fall back to regular I/O otherwise.
+class IoUring {
+ public:
+  /// Called on the completion thread with the result of the operation, i.e.
+  /// the number of bytes written or a negative errno.
+  typedef std::function<void(int32_t result)> Callback;
+
+  /// @return the process-wide instance, or nullptr if io_uring is not
+  ///         available on this system.
+  static IoUring* GetInstance();
+
+  /// Queues a write of @a data at @a offset of the file @a fd. The data is
+  /// owned by the ring until the write completes.
+  /// @return false if the operation cannot be submitted; @a callback is not
+  ///         called in that case.
+  bool Write(int fd,
+             uint64_t offset,
+             std::vector<uint8_t> data,
+             Callback callback);
+
+  /// Flushes the file @a fd to the storage device through the ring. Blocks
+  /// until the operation completes. Writes that are still in flight are not
+  /// waited for.
+  /// @return true on success, false otherwise.
+  bool Sync(int fd);
+
+  /// Writes @a contents to @a temp_file_name, closes it and renames it to
+  /// @a file_name, all submitted to the ring at once as linked operations.
+  /// If @a sync is true, the file is also flushed to the storage device
+  /// before it is closed. Blocks until the chain completes.
+  /// @return true on success, false otherwise.
+  bool WriteFileAtomically(const std::string& temp_file_name,
+                           const std::string& file_name,
+                           const std::string& contents,
+                           bool sync);
+
+  /// @return true if WriteFileAtomically() is supported by the kernel.
+  bool supports_atomic_write() const { return supports_atomic_write_; }
+
+ private:
+  struct Request;
+
+  IoUring();
+  ~IoUring();
+
+  // Sets up the ring. Returns false if io_uring is not available.
+  bool Initialize();
+
+  // Fills the next submission queue entries with |requests| and submits them
+  // in a single system call. Returns false if none of the requests could be
+  // submitted; the caller keeps ownership of them in that case. If only the
+  // first requests of a chain are submitted, the others are completed with
+  // -ECANCELED.
+  bool Submit(const std::vector<Request*>& requests);
+
+  // Submit() with |mutex_| held. Returns the number of submitted requests.
+  unsigned SubmitLocked(const std::vector<Request*>& requests)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Completion thread main loop.
+  void ReapCompletions();
+
+  int ring_fd_ = -1;
+  bool supports_atomic_write_ = false;
+
+  // Memory mapped rings. |cq_ring_| may alias |sq_ring_|.
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  size_t sqes_size_ = 0;
+
+  // Submission queue ring, shared with the kernel.
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+  unsigned* sq_array_ = nullptr;
+  io_uring_sqe* sqes_ = nullptr;
+
+  // Completion queue ring, shared with the kernel.
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  unsigned cq_entries_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+
+  absl::Mutex mutex_;
+  absl::CondVar room_available_;
+  // The number of requests submitted but not completed. This is bounded by the
+  // completion queue size so that completions are never dropped.
+  unsigned requests_in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(IoUring);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_IO_URING_H_
@@ -0,0 +1,185 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/file/io_uring_file.h>
+
+#if !defined(OS_WIN)
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // !defined(OS_WIN)
+
+#include <algorithm>
+#include <filesystem>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <packager/file/io_uring.h>
+#include <packager/macros/compiler.h>
+#include <packager/macros/logging.h>
+
+namespace shaka {
+
+IoUringFile::IoUringFile(const char* file_name,
+                         IoUring* io_uring,
+                         uint64_t io_cache_size,
+                         uint64_t io_block_size,
+                         bool sync_on_close)
+    : File(file_name),
+      io_uring_(io_uring),
+      max_writes_in_flight_(
+          std::max<uint64_t>(1, io_cache_size / io_block_size)),
+      io_block_size_(io_block_size),
+      sync_on_close_(sync_on_close) {
+  DCHECK(io_uring_);
+  pending_data_.reserve(io_block_size_);
+}
+
+IoUringFile::~IoUringFile() {}
+
+bool IoUringFile::Open() {
+#if defined(OS_WIN)
+  return false;
+#else
+  auto file_path = std::filesystem::u8path(file_name());
+  auto parent_path = file_path.parent_path();
+  std::error_code ec;
+  if (parent_path != "" && !std::filesystem::is_directory(parent_path, ec)) {
+    if (!std::filesystem::create_directories(parent_path, ec))
+      return false;
+  }
+
+  fd_ = open(file_path.u8string().c_str(),
+             O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  return fd_ >= 0;
+#endif  // defined(OS_WIN)
+}
+
+bool IoUringFile::Close() {
+  bool result = true;
+  if (fd_ >= 0) {
+    // Flush() waits for all the writes in flight, even on errors, so that no
+    // completion refers to this file after it is deleted.
+    result = Flush();
+    if (result && sync_on_close_)
+      result = io_uring_->Sync(fd_);
+#if !defined(OS_WIN)
+    result &= close(fd_) == 0;
+#endif  // !defined(OS_WIN)
+    fd_ = -1;
+  }
+  delete this;
+  return result;
+}
+
+int64_t IoUringFile::Read(void* buffer, uint64_t length) {
+  UNUSED(buffer);
+  UNUSED(length);
+  NOTIMPLEMENTED() << "IoUringFile is write-only.";
+  return -1;
+}
+
+int64_t IoUringFile::Write(const void* buffer, uint64_t length) {
+  DCHECK(buffer);
+  DCHECK_GE(fd_, 0);
+  {
+    absl::MutexLock lock(&mutex_);
+    if (has_error_)
+      return -1;
+  }
+
+  const uint8_t* data = static_cast<const uint8_t*>(buffer);
+  pending_data_.insert(pending_data_.end(), data, data + length);
+  position_ += length;
+  size_ = std::max(size_, position_);
+
+  if (pending_data_.size() >= io_block_size_ && !SubmitPendingData())
+    return -1;
+  return length;
+}
+
+void IoUringFile::CloseForWriting() {}
+
+int64_t IoUringFile::Size() {
+  return size_;
+}
+
+bool IoUringFile::Flush() {
+  // Wait for the earlier writes even if this one fails to be submitted.
+  const bool submitted = SubmitPendingData();
+
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(
+      +[](uint64_t* writes_in_flight) { return *writes_in_flight == 0; },
+      &writes_in_flight_));
+  return submitted && !has_error_;
+}
+
+bool IoUringFile::Seek(uint64_t position) {
+  // Writes are positional, so seeking only needs to submit the data for the
+  // current position.
+  if (!SubmitPendingData())
+    return false;
+  position_ = position;
+  pending_offset_ = position;
+  return true;
+}
+
+bool IoUringFile::Tell(uint64_t* position) {
+  DCHECK(position);
+  *position = position_;
+  return true;
+}
+
+bool IoUringFile::SubmitPendingData() {
+  if (pending_data_.empty())
+    return true;
+
+  {
+    absl::MutexLock lock(&mutex_);
+    // Bound the memory held by the ring on behalf of this file.
+    mutex_.Await(absl::Condition(
+        +[](IoUringFile* file) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+          return file->writes_in_flight_ < file->max_writes_in_flight_;
+        },
+        this));
+    if (has_error_)
+      return false;
+    ++writes_in_flight_;
+  }
+
+  std::vector<uint8_t> data;
+  data.swap(pending_data_);
+  pending_data_.reserve(io_block_size_);
+  const uint64_t length = data.size();
+  const uint64_t offset = pending_offset_;
+  pending_offset_ += length;
+
+  if (!io_uring_->Write(fd_, offset, std::move(data),
+                        [this, length](int32_t result) {
+                          OnWriteComplete(length, result);
+                        })) {
+    absl::MutexLock lock(&mutex_);
+    --writes_in_flight_;
+    has_error_ = true;
+    return false;
+  }
+  return true;
+}
+
+void IoUringFile::OnWriteComplete(uint64_t length, int32_t result) {
+  absl::MutexLock lock(&mutex_);
+  --writes_in_flight_;
+  // Short writes on regular files only happen on errors like running out of
+  // disk space, which are not retried.
+  if (result < 0 || static_cast<uint64_t>(result) != length) {
+    LOG(ERROR) << "Failed to write " << length << " bytes to " << file_name()
+               << ", result: " << result;
+    has_error_ = true;
+  }
+}
+
+}  // namespace shaka
@@ -0,0 +1,84 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_IO_URING_FILE_H_
+#define PACKAGER_FILE_IO_URING_FILE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include <packager/file.h>
+#include <packager/macros/classes.h>
+
+namespace shaka {
+
+class IoUring;
+
+/// Write-only local file which submits its writes to the process-wide
+/// io_uring instead of using a dedicated I/O thread like ThreadedIoFile.
+/// Writes are accumulated into blocks of |io_block_size| bytes, and at most
+/// |io_cache_size| bytes are in flight per file.
+class IoUringFile : public File {
+ public:
+  /// @param file_name is the path of the local file.
+  /// @param io_uring is the ring used for I/O. Must outlive this file.
+  /// @param io_cache_size is the maximum number of bytes in flight.
+  /// @param io_block_size is the size of each write submitted to the ring.
+  /// @param sync_on_close specifies whether the file is flushed to the
+  ///        storage device through the ring before it is closed.
+  IoUringFile(const char* file_name,
+              IoUring* io_uring,
+              uint64_t io_cache_size,
+              uint64_t io_block_size,
+              bool sync_on_close);
+
+  /// @name File implementation overrides.
+  /// @{
+  bool Close() override;
+  int64_t Read(void* buffer, uint64_t length) override;
+  int64_t Write(const void* buffer, uint64_t length) override;
+  void CloseForWriting() override;
+  int64_t Size() override;
+  bool Flush() override;
+  bool Seek(uint64_t position) override;
+  bool Tell(uint64_t* position) override;
+  /// @}
+
+ protected:
+  ~IoUringFile() override;
+
+  bool Open() override;
+
+ private:
+  // Submits |pending_data_| to the ring.
+  bool SubmitPendingData();
+  // Called on the completion thread.
+  void OnWriteComplete(uint64_t length, int32_t result);
+
+  IoUring* const io_uring_;
+  const uint64_t max_writes_in_flight_;
+  const uint64_t io_block_size_;
+  const bool sync_on_close_;
+  int fd_ = -1;
+  // Data not yet submitted, which starts at |pending_offset_|.
+  std::vector<uint8_t> pending_data_;
+  uint64_t pending_offset_ = 0;
+  uint64_t position_ = 0;
+  uint64_t size_ = 0;
+
+  absl::Mutex mutex_;
+  uint64_t writes_in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool has_error_ ABSL_GUARDED_BY(mutex_) = false;
+
+  DISALLOW_COPY_AND_ASSIGN(IoUringFile);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_IO_URING_FILE_H_
@@ -16,6 +16,12 @@
 namespace shaka {
 
 /// Implement LocalFile which deals with local storage.
+///
+/// Files opened for reading only are read sequentially with read-ahead, on
+/// platforms which support posix_fadvise. With --io_drop_consumed_input, the
+/// page cache backing data already consumed is also dropped as reading
+/// progresses. This keeps large inputs from evicting more useful pages on
+/// shared hosts.
 class LocalFile : public File {
  public:
   /// @param file_name C string containing the name of the file to be accessed.
@@ -46,8 +52,18 @@ class LocalFile : public File {
   bool Open() override;
 
  private:
+  // Drops the cached pages before |read_position_|, if enough data has been
+  // consumed since the last call.
+  void DropConsumedPages();
+
   std::string file_mode_;
   FILE* internal_file_;
+  // Whether cached pages are dropped once consumed, only for files opened
+  // for reading only and if --io_drop_consumed_input is set.
+  bool drop_consumed_pages_ = false;
+  uint64_t read_position_ = 0;
+  // The cached pages before this offset have been dropped.
+  uint64_t dropped_position_ = 0;
 
   DISALLOW_COPY_AND_ASSIGN(LocalFile);
 };
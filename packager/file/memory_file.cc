@@ -7,11 +7,12 @@
 #include <packager/file/memory_file.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>  // for memcpy
+#include <functional>
 #include <map>
-#include <memory>
-#include <set>
 
+#include <absl/base/thread_annotations.h>
 #include <absl/log/check.h>
 #include <absl/log/log.h>
 #include <absl/synchronization/mutex.h>
@@ -19,9 +20,37 @@
 #include <packager/macros/logging.h>
 
 namespace shaka {
+
+// The data of a memory file. Once a chunk is referenced outside of the file,
+// by a reader or a slice, the bytes it contains are never modified again:
+// overwriting them replaces the chunk with a copy.
+class MemoryFileData {
+ public:
+  absl::Mutex mutex;
+  // All the chunks are full, i.e. |kChunkSize| bytes, except the last one.
+  std::vector<std::shared_ptr<std::vector<uint8_t>>> chunks
+      ABSL_GUARDED_BY(mutex);
+  uint64_t size ABSL_GUARDED_BY(mutex) = 0;
+  bool writing ABSL_GUARDED_BY(mutex) = false;
+  // Whether the file has been deleted while there is a size limit. Deleted
+  // files are kept until they are evicted; other files are never evicted.
+  bool deleted ABSL_GUARDED_BY(mutex) = false;
+  int open_count ABSL_GUARDED_BY(mutex) = 0;
+  // Value of the access counter of the file system when the file was last
+  // opened or deleted.
+  uint64_t last_access ABSL_GUARDED_BY(mutex) = 0;
+  // Size added to the total size of the file system for this file.
+  uint64_t accounted_size ABSL_GUARDED_BY(mutex) = 0;
+};
+
 namespace {
 
+// Chunks grow up to this size, so that small files stay small.
+const size_t kChunkSize = 256 << 10;
+const size_t kNumShards = 16;
+
 // A helper filesystem object.  This holds the data for the memory files.
+// Lock order: the mutex of a shard is acquired before the mutex of a file.
 class FileSystem {
  public:
   ~FileSystem() {}
@@ -32,125 +61,310 @@ class FileSystem {
   }
 
   void Delete(const std::string& file_name) {
-    absl::MutexLock auto_lock(&mutex_);
-
-    if (open_files_.find(file_name) != open_files_.end()) {
-      LOG(ERROR) << "File '" << file_name
-                 << "' is still open. Deleting an open MemoryFile is not "
-                    "allowed. Exit without deleting the file.";
-      return;
+    Shard& shard = GetShard(file_name);
+    {
+      absl::MutexLock auto_lock(&shard.mutex);
+      auto iter = shard.files.find(file_name);
+      if (iter == shard.files.end())
+        return;
+      if (max_total_size_ == 0) {
+        Unaccount(iter->second.get());
+        shard.files.erase(iter);
+        return;
+      }
+      // Keep the data, e.g. for late requests of a segment which has just
+      // left the live window, until the size limit is reached.
+      absl::MutexLock data_lock(&iter->second->mutex);
+      iter->second->deleted = true;
+      iter->second->last_access = ++access_counter_;
     }
-
-    files_.erase(file_name);
+    EvictIfNeeded();
   }
 
   void DeleteAll() {
-    absl::MutexLock auto_lock(&mutex_);
-    if (!open_files_.empty()) {
-      LOG(ERROR) << "There are still files open. Deleting an open MemoryFile "
-                    "is not allowed. Exit without deleting the file.";
-      return;
+    for (Shard& shard : shards_) {
+      absl::MutexLock auto_lock(&shard.mutex);
+      for (auto& entry : shard.files)
+        Unaccount(entry.second.get());
+      shard.files.clear();
     }
-    files_.clear();
   }
 
-  std::vector<uint8_t>* Open(const std::string& file_name,
-                             const std::string& mode) {
-    absl::MutexLock auto_lock(&mutex_);
-
-    if (open_files_.find(file_name) != open_files_.end()) {
-      NOTIMPLEMENTED() << "File '" << file_name
-                       << "' is already open. MemoryFile does not support "
-                          "opening the same file before it is closed.";
+  std::shared_ptr<MemoryFileData> Open(const std::string& file_name,
+                                       const std::string& mode) {
+    if (mode != "r" && mode != "w") {
+      NOTIMPLEMENTED() << "File mode '" << mode
+                       << "' not supported by MemoryFile";
       return nullptr;
     }
 
-    auto iter = files_.find(file_name);
+    Shard& shard = GetShard(file_name);
+    absl::MutexLock auto_lock(&shard.mutex);
+    auto iter = shard.files.find(file_name);
+    std::shared_ptr<MemoryFileData> data;
     if (mode == "r") {
-      if (iter == files_.end())
+      if (iter == shard.files.end())
         return nullptr;
-    } else if (mode == "w") {
-      if (iter != files_.end())
-        iter->second.clear();
+      data = iter->second;
     } else {
-      NOTIMPLEMENTED() << "File mode '" << mode
-                       << "' not supported by MemoryFile";
-      return nullptr;
+      if (iter != shard.files.end()) {
+        {
+          absl::MutexLock data_lock(&iter->second->mutex);
+          if (iter->second->writing) {
+            NOTIMPLEMENTED() << "File '" << file_name
+                             << "' is already open for writing. MemoryFile "
+                                "does not support concurrent writers.";
+            return nullptr;
+          }
+        }
+        // Readers of the previous data, if any, keep it.
+        Unaccount(iter->second.get());
+      }
+      data = std::make_shared<MemoryFileData>();
+      shard.files[file_name] = data;
     }
 
-    open_files_[file_name] = mode;
-    return &files_[file_name];
+    absl::MutexLock data_lock(&data->mutex);
+    if (mode == "w")
+      data->writing = true;
+    ++data->open_count;
+    data->last_access = ++access_counter_;
+    return data;
   }
 
-  bool Close(const std::string& file_name) {
-    absl::MutexLock auto_lock(&mutex_);
+  void Close(const std::string& file_name,
+             const std::shared_ptr<MemoryFileData>& data) {
+    bool was_writing;
+    {
+      absl::MutexLock data_lock(&data->mutex);
+      was_writing = data->writing;
+      data->writing = false;
+    }
 
-    auto iter = open_files_.find(file_name);
-    if (iter == open_files_.end()) {
-      LOG(ERROR) << "Cannot close file '" << file_name
-                 << "' which is not open.";
-      return false;
+    Shard& shard = GetShard(file_name);
+    {
+      absl::MutexLock auto_lock(&shard.mutex);
+      auto iter = shard.files.find(file_name);
+      const bool in_store = iter != shard.files.end() && iter->second == data;
+      bool remove = false;
+      {
+        absl::MutexLock data_lock(&data->mutex);
+        --data->open_count;
+        if (was_writing && in_store) {
+          data->accounted_size = data->size;
+          total_size_ += data->size;
+        }
+        // The limit may have been removed since the file was deleted.
+        remove = in_store && data->deleted && data->open_count == 0 &&
+                 max_total_size_ == 0;
+      }
+      if (remove) {
+        Unaccount(data.get());
+        shard.files.erase(iter);
+      }
     }
+    if (was_writing)
+      EvictIfNeeded();
+  }
 
-    open_files_.erase(iter);
-    return true;
+  void SetMaxTotalSize(uint64_t max_total_size) {
+    max_total_size_ = max_total_size;
+    // Without a limit, deleted files are no longer kept.
+    Evict(max_total_size);
   }
 
  private:
+  struct Shard {
+    absl::Mutex mutex;
+    // Filename to file data map.
+    std::map<std::string, std::shared_ptr<MemoryFileData>> files
+        ABSL_GUARDED_BY(mutex);
+  };
+
   FileSystem(const FileSystem&) = delete;
   FileSystem& operator=(const FileSystem&) = delete;
 
   FileSystem() = default;
 
-  // Filename to file data map.
-  std::map<std::string, std::vector<uint8_t>> files_ ABSL_GUARDED_BY(mutex_);
-  // Filename to file open modes map.
-  std::map<std::string, std::string> open_files_ ABSL_GUARDED_BY(mutex_);
+  Shard& GetShard(const std::string& file_name) {
+    return shards_[std::hash<std::string>()(file_name) % kNumShards];
+  }
+
+  // Removes |data| from the total size. The caller must hold the mutex of the
+  // shard containing |data|.
+  void Unaccount(MemoryFileData* data) {
+    absl::MutexLock data_lock(&data->mutex);
+    total_size_ -= data->accounted_size;
+    data->accounted_size = 0;
+  }
+
+  void EvictIfNeeded() {
+    const uint64_t max_total_size = max_total_size_;
+    if (max_total_size == 0 || total_size_ <= max_total_size)
+      return;
+    Evict(max_total_size);
+  }
+
+  // Removes the least recently used deleted files which are not open, until
+  // the total size is at most |max_total_size|, or all of them if it is 0.
+  void Evict(uint64_t max_total_size) {
+    absl::MutexLock eviction_lock(&eviction_mutex_);
+    struct Candidate {
+      uint64_t last_access;
+      Shard* shard;
+      std::string file_name;
+    };
+    std::vector<Candidate> candidates;
+    for (Shard& shard : shards_) {
+      absl::MutexLock auto_lock(&shard.mutex);
+      for (const auto& entry : shard.files) {
+        absl::MutexLock data_lock(&entry.second->mutex);
+        if (entry.second->deleted && entry.second->open_count == 0) {
+          candidates.push_back(
+              {entry.second->last_access, &shard, entry.first});
+        }
+      }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) {
+                return a.last_access < b.last_access;
+              });
+
+    for (const Candidate& candidate : candidates) {
+      if (max_total_size != 0 && total_size_ <= max_total_size)
+        return;
+      absl::MutexLock auto_lock(&candidate.shard->mutex);
+      auto iter = candidate.shard->files.find(candidate.file_name);
+      if (iter == candidate.shard->files.end())
+        continue;
+      {
+        // Skip the file if it has been opened since it was collected.
+        absl::MutexLock data_lock(&iter->second->mutex);
+        if (iter->second->open_count != 0 ||
+            iter->second->last_access != candidate.last_access) {
+          continue;
+        }
+      }
+      VLOG(1) << "Evicting memory file '" << candidate.file_name << "'.";
+      Unaccount(iter->second.get());
+      candidate.shard->files.erase(iter);
+    }
+  }
 
-  absl::Mutex mutex_;
+  Shard shards_[kNumShards];
+  std::atomic<uint64_t> access_counter_{0};
+  // Total size of the files in |shards_| which have been closed for writing.
+  std::atomic<uint64_t> total_size_{0};
+  std::atomic<uint64_t> max_total_size_{0};
+  absl::Mutex eviction_mutex_;
 };
 
 }  // namespace
 
 MemoryFile::MemoryFile(const std::string& file_name, const std::string& mode)
-    : File(file_name), mode_(mode), file_(NULL), position_(0) {}
+    : File(file_name), mode_(mode), position_(0) {}
 
 MemoryFile::~MemoryFile() {}
 
 bool MemoryFile::Close() {
-  if (!FileSystem::Instance()->Close(file_name()))
-    return false;
+  if (file_)
+    FileSystem::Instance()->Close(file_name(), file_);
   delete this;
   return true;
 }
 
 int64_t MemoryFile::Read(void* buffer, uint64_t length) {
-  const uint64_t size = Size();
+  std::vector<Slice> slices;
+  const int64_t bytes_read = ReadSlices(length, &slices);
+  uint8_t* output = static_cast<uint8_t*>(buffer);
+  for (const Slice& slice : slices) {
+    memcpy(output, slice.data, slice.size);
+    output += slice.size;
+  }
+  return bytes_read;
+}
+
+int64_t MemoryFile::ReadSlices(uint64_t length, std::vector<Slice>* slices) {
+  DCHECK(file_);
+  DCHECK(slices);
+  slices->clear();
+
+  absl::MutexLock lock(&file_->mutex);
+  if (mode_ == "r") {
+    // Wait for more data while the file is being written.
+    file_->mutex.Await(absl::Condition(
+        +[](MemoryFile* file) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+          return file->position_ < file->file_->size || !file->file_->writing;
+        },
+        this));
+  }
+
+  const uint64_t size = file_->size;
   DCHECK_LE(position_, size);
   if (position_ >= size)
     return 0;
 
   const uint64_t bytes_to_read = std::min(length, size - position_);
-  memcpy(buffer, &(*file_)[position_], bytes_to_read);
-  position_ += bytes_to_read;
+  uint64_t position = position_;
+  const uint64_t end = position_ + bytes_to_read;
+  while (position < end) {
+    const std::shared_ptr<std::vector<uint8_t>>& chunk =
+        file_->chunks[position / kChunkSize];
+    const uint64_t offset = position % kChunkSize;
+    Slice slice;
+    slice.chunk = chunk;
+    slice.data = chunk->data() + offset;
+    slice.size = std::min<uint64_t>(end - position, chunk->size() - offset);
+    position += slice.size;
+    slices->push_back(std::move(slice));
+  }
+  position_ = end;
   return bytes_to_read;
 }
 
 int64_t MemoryFile::Write(const void* buffer, uint64_t length) {
-  // If length is zero, we won't resize the buffer and it is possible for
-  // |position| to equal the length of the buffer. This will cause a segfault
-  // when indexing into the buffer for the memcpy.
-  if (length == 0) {
+  DCHECK(file_);
+  if (length == 0)
     return 0;
-  }
 
-  const uint64_t size = Size();
-  if (size < position_ + length) {
-    file_->resize(position_ + length);
-  }
+  absl::MutexLock lock(&file_->mutex);
+  const uint8_t* input = static_cast<const uint8_t*>(buffer);
+  const uint64_t end = position_ + length;
+  while (position_ < end) {
+    const size_t index = position_ / kChunkSize;
+    const size_t offset = position_ % kChunkSize;
+    const size_t bytes = std::min<uint64_t>(end - position_,
+                                            kChunkSize - offset);
+    if (index == file_->chunks.size())
+      file_->chunks.push_back(std::make_shared<std::vector<uint8_t>>());
+    std::shared_ptr<std::vector<uint8_t>>& chunk = file_->chunks[index];
+    DCHECK_LE(offset, chunk->size());
+
+    // Chunks grow geometrically up to |kChunkSize|.
+    const size_t chunk_end = offset + bytes;
+    const size_t capacity =
+        chunk_end > chunk->capacity()
+            ? std::min(kChunkSize, std::max(chunk_end, 2 * chunk->capacity()))
+            : chunk->capacity();
+    const size_t overwritten = std::min(bytes, chunk->size() - offset);
+    if (chunk.use_count() > 1 &&
+        (overwritten > 0 || capacity > chunk->capacity())) {
+      // The chunk is referenced by readers, which may be reading the bytes
+      // being overwritten or the buffer being reallocated.
+      auto copy = std::make_shared<std::vector<uint8_t>>();
+      copy->reserve(capacity);
+      copy->assign(chunk->begin(), chunk->end());
+      chunk = std::move(copy);
+    } else {
+      chunk->reserve(capacity);
+    }
+    memcpy(chunk->data() + offset, input, overwritten);
+    chunk->insert(chunk->end(), input + overwritten, input + bytes);
 
-  memcpy(&(*file_)[position_], buffer, length);
-  position_ += length;
+    input += bytes;
+    position_ += bytes;
+  }
+  file_->size = std::max(file_->size, position_);
   return length;
 }
 
@@ -158,7 +372,8 @@ void MemoryFile::CloseForWriting() {}
 
 int64_t MemoryFile::Size() {
   DCHECK(file_);
-  return file_->size();
+  absl::MutexLock lock(&file_->mutex);
+  return file_->size;
 }
 
 bool MemoryFile::Flush() {
@@ -195,4 +410,8 @@ void MemoryFile::Delete(const std::string& file_name) {
   FileSystem::Instance()->Delete(file_name);
 }
 
+void MemoryFile::SetMaxTotalSize(uint64_t max_total_size) {
+  FileSystem::Instance()->SetMaxTotalSize(max_total_size);
+}
+
 }  // namespace shaka
@@ -8,6 +8,7 @@
 #define MEDIA_FILE_MEDIA_FILE_H_
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -16,10 +17,25 @@
 
 namespace shaka {
 
-/// Implements a File that is stored in memory.  This should be only used for
-/// testing, since this does not support larger files.
+class MemoryFileData;
+
+/// Implements a File that is stored in memory.
+///
+/// The data is stored in chunks, so files grow without copying, in a store
+/// which is sharded by file name. A file may be opened for reading any number
+/// of times, including while it is being written, in which case reads wait
+/// for more data until the writer closes the file. Deleting or overwriting a
+/// file does not affect the handles and slices which still reference its
+/// data.
 class MemoryFile : public File {
  public:
+  /// Part of the data of a memory file, which keeps the data alive.
+  struct Slice {
+    std::shared_ptr<const std::vector<uint8_t>> chunk;
+    const uint8_t* data = nullptr;
+    uint64_t size = 0;
+  };
+
   MemoryFile(const std::string& file_name, const std::string& mode);
 
   /// @name File implementation overrides.
@@ -34,13 +50,31 @@ class MemoryFile : public File {
   bool Tell(uint64_t* position) override;
   /// @}
 
-  /// Deletes all memory file data created.  This assumes that there are no
-  /// MemoryFile objects alive.  Any alive objects will be in an undefined
-  /// state.
+  /// Reads without copying. Like Read, this waits for more data if the file
+  /// is still being written.
+  /// @param length is the maximum number of bytes to read.
+  /// @param slices receives the data read. The data remains valid and
+  ///        unchanged as long as the slices are alive, even if the file is
+  ///        modified or deleted.
+  /// @return the number of bytes read, or 0 at the end of the file.
+  int64_t ReadSlices(uint64_t length, std::vector<Slice>* slices);
+
+  /// Deletes all memory file data created. Open files keep their data until
+  /// they are closed.
   static void DeleteAll();
-  /// Deletes the memory file data with the given file_name.  Any objects open
-  /// with that file name will be in an undefined state.
+  /// Deletes the memory file data with the given file_name. Open files keep
+  /// their data until they are closed. If there is a size limit, the file
+  /// remains readable until it is evicted, see SetMaxTotalSize().
   static void Delete(const std::string& file_name);
+  /// Limits the total size of the memory files. Deleted files are kept while
+  /// the limit is not exceeded, e.g. to serve late requests for segments
+  /// which have left the live window. When the limit is exceeded, the least
+  /// recently opened or deleted files which are not open are evicted. Files
+  /// which have not been deleted, e.g. init segments, manifests and segments
+  /// in the live window, are never evicted.
+  /// @param max_total_size is the limit in bytes, or 0 for no limit, which is
+  ///        the default. Without a limit, deleted files are not kept.
+  static void SetMaxTotalSize(uint64_t max_total_size);
 
  protected:
   ~MemoryFile() override;
@@ -48,7 +82,7 @@ class MemoryFile : public File {
 
  private:
   std::string mode_;
-  std::vector<uint8_t>* file_;
+  std::shared_ptr<MemoryFileData> file_;
   uint64_t position_;
 
   DISALLOW_COPY_AND_ASSIGN(MemoryFile);
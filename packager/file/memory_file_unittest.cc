@@ -4,7 +4,11 @@
 
 #include <packager/file/memory_file.h>
 
+#include <cstring>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -21,7 +25,19 @@ const int64_t kWriteBufferSize = sizeof(kWriteBuffer);
 
 class MemoryFileTest : public testing::Test {
  protected:
-  void TearDown() override { MemoryFile::DeleteAll(); }
+  void TearDown() override {
+    MemoryFile::SetMaxTotalSize(0);
+    MemoryFile::DeleteAll();
+  }
+
+  void WriteFile(const std::string& file_name,
+                 const std::vector<uint8_t>& data) {
+    std::unique_ptr<File, FileCloser> file(
+        File::Open(file_name.c_str(), "w"));
+    ASSERT_TRUE(file);
+    ASSERT_EQ(static_cast<int64_t>(data.size()),
+              file->Write(data.data(), data.size()));
+  }
 };
 
 TEST_F(MemoryFileTest, ModifiesSameFile) {
@@ -112,4 +128,193 @@ TEST_F(MemoryFileTest, WriteExistingFileDeletes) {
   EXPECT_EQ(0, file2->Size());
 }
 
+TEST_F(MemoryFileTest, LargeFileWithOverwrite) {
+  // Spans several chunks.
+  std::vector<uint8_t> data(1000000);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i * 13);
+
+  std::unique_ptr<File, FileCloser> file(File::Open("memory://file1", "w"));
+  ASSERT_TRUE(file);
+  const size_t kWriteSize = 999;
+  for (size_t i = 0; i < data.size(); i += kWriteSize) {
+    const size_t size = std::min(kWriteSize, data.size() - i);
+    ASSERT_EQ(static_cast<int64_t>(size), file->Write(&data[i], size));
+  }
+  // Overwrite across a chunk boundary.
+  const uint64_t kOverwritePosition = (256 << 10) - 4;
+  ASSERT_TRUE(file->Seek(kOverwritePosition));
+  ASSERT_EQ(kWriteBufferSize, file->Write(kWriteBuffer, kWriteBufferSize));
+  memcpy(&data[kOverwritePosition], kWriteBuffer, kWriteBufferSize);
+  EXPECT_EQ(static_cast<int64_t>(data.size()), file->Size());
+  file.release()->Close();
+
+  std::unique_ptr<File, FileCloser> reader(File::Open("memory://file1", "r"));
+  ASSERT_TRUE(reader);
+  std::vector<uint8_t> read_data(data.size() + 1);
+  ASSERT_EQ(static_cast<int64_t>(data.size()),
+            reader->Read(read_data.data(), read_data.size()));
+  read_data.resize(data.size());
+  EXPECT_EQ(data, read_data);
+}
+
+TEST_F(MemoryFileTest, MultipleReaders) {
+  WriteFile("memory://file1",
+            std::vector<uint8_t>(std::begin(kWriteBuffer),
+                                 std::end(kWriteBuffer)));
+
+  std::unique_ptr<File, FileCloser> reader1(File::Open("memory://file1", "r"));
+  std::unique_ptr<File, FileCloser> reader2(File::Open("memory://file1", "r"));
+  ASSERT_TRUE(reader1);
+  ASSERT_TRUE(reader2);
+
+  uint8_t read_buffer[kWriteBufferSize];
+  ASSERT_EQ(kWriteBufferSize, reader1->Read(read_buffer, kWriteBufferSize));
+  EXPECT_EQ(0, memcmp(kWriteBuffer, read_buffer, kWriteBufferSize));
+  ASSERT_EQ(kWriteBufferSize, reader2->Read(read_buffer, kWriteBufferSize));
+  EXPECT_EQ(0, memcmp(kWriteBuffer, read_buffer, kWriteBufferSize));
+}
+
+TEST_F(MemoryFileTest, ConcurrentWritersFail) {
+  std::unique_ptr<File, FileCloser> writer(File::Open("memory://file1", "w"));
+  ASSERT_TRUE(writer);
+  EXPECT_FALSE(File::Open("memory://file1", "w"));
+}
+
+TEST_F(MemoryFileTest, ReadWhileWriting) {
+  const int kNumWrites = 100;
+  std::unique_ptr<File, FileCloser> writer(File::Open("memory://file1", "w"));
+  ASSERT_TRUE(writer);
+  std::unique_ptr<File, FileCloser> reader(File::Open("memory://file1", "r"));
+  ASSERT_TRUE(reader);
+
+  std::thread writer_thread([&writer]() {
+    for (int i = 0; i < kNumWrites; ++i)
+      writer->Write(kWriteBuffer, kWriteBufferSize);
+    writer.release()->Close();
+  });
+
+  // Reads wait for the writer until it closes the file.
+  std::vector<uint8_t> read_data;
+  uint8_t read_buffer[3];
+  int64_t bytes_read;
+  while ((bytes_read = reader->Read(read_buffer, sizeof(read_buffer))) > 0)
+    read_data.insert(read_data.end(), read_buffer, read_buffer + bytes_read);
+  writer_thread.join();
+
+  ASSERT_EQ(static_cast<size_t>(kNumWrites * kWriteBufferSize),
+            read_data.size());
+  for (int i = 0; i < kNumWrites; ++i) {
+    EXPECT_EQ(0, memcmp(kWriteBuffer, &read_data[i * kWriteBufferSize],
+                        kWriteBufferSize));
+  }
+}
+
+TEST_F(MemoryFileTest, SlicesOutliveOverwriteAndDelete) {
+  std::unique_ptr<File, FileCloser> writer(File::Open("memory://file1", "w"));
+  ASSERT_TRUE(writer);
+  ASSERT_EQ(kWriteBufferSize, writer->Write(kWriteBuffer, kWriteBufferSize));
+
+  std::unique_ptr<File, FileCloser> reader(File::Open("memory://file1", "r"));
+  ASSERT_TRUE(reader);
+  std::vector<MemoryFile::Slice> slices;
+  ASSERT_EQ(kWriteBufferSize,
+            static_cast<MemoryFile*>(reader.get())
+                ->ReadSlices(kWriteBufferSize, &slices));
+  ASSERT_EQ(1u, slices.size());
+  reader.reset();
+
+  // Overwrite the data in place, then delete the file.
+  const uint8_t kOtherBuffer[kWriteBufferSize] = {};
+  ASSERT_TRUE(writer->Seek(0));
+  ASSERT_EQ(kWriteBufferSize, writer->Write(kOtherBuffer, kWriteBufferSize));
+  writer.reset();
+  ASSERT_TRUE(File::Delete("memory://file1"));
+  EXPECT_FALSE(File::Open("memory://file1", "r"));
+
+  ASSERT_EQ(static_cast<uint64_t>(kWriteBufferSize), slices[0].size);
+  EXPECT_EQ(0, memcmp(kWriteBuffer, slices[0].data, kWriteBufferSize));
+}
+
+TEST_F(MemoryFileTest, OpenFileKeepsDataAfterDelete) {
+  WriteFile("memory://file1",
+            std::vector<uint8_t>(std::begin(kWriteBuffer),
+                                 std::end(kWriteBuffer)));
+  std::unique_ptr<File, FileCloser> reader(File::Open("memory://file1", "r"));
+  ASSERT_TRUE(reader);
+  ASSERT_TRUE(File::Delete("memory://file1"));
+
+  uint8_t read_buffer[kWriteBufferSize];
+  ASSERT_EQ(kWriteBufferSize, reader->Read(read_buffer, kWriteBufferSize));
+  EXPECT_EQ(0, memcmp(kWriteBuffer, read_buffer, kWriteBufferSize));
+}
+
+TEST_F(MemoryFileTest, EvictsLeastRecentlyUsedDeletedFiles) {
+  const std::vector<uint8_t> data(100, 1);
+  MemoryFile::SetMaxTotalSize(250);
+  WriteFile("memory://file1", data);
+  WriteFile("memory://file2", data);
+  ASSERT_TRUE(File::Delete("memory://file1"));
+  ASSERT_TRUE(File::Delete("memory://file2"));
+  // Deleted files are kept within the limit. Opening file1 makes file2 the
+  // least recently used file.
+  File::Open("memory://file1", "r")->Close();
+  WriteFile("memory://file3", data);
+
+  std::unique_ptr<File, FileCloser> file1(File::Open("memory://file1", "r"));
+  ASSERT_TRUE(file1);
+  EXPECT_FALSE(File::Open("memory://file2", "r"));
+  ASSERT_TRUE(File::Delete("memory://file3"));
+
+  // file1 is the least recently used file, but it is open.
+  WriteFile("memory://file4", data);
+  EXPECT_EQ(100, file1->Size());
+  EXPECT_FALSE(File::Open("memory://file3", "r"));
+  std::unique_ptr<File, FileCloser> file4(File::Open("memory://file4", "r"));
+  EXPECT_TRUE(file4);
+}
+
+TEST_F(MemoryFileTest, KeepsFilesNotDeleted) {
+  const std::vector<uint8_t> data(100, 1);
+  // Room for the init segment, a window of two segments and one deleted
+  // segment.
+  MemoryFile::SetMaxTotalSize(450);
+  // The init segment is only opened once, but it is never deleted so it is
+  // never evicted.
+  WriteFile("memory://init.mp4", data);
+  for (int i = 1; i <= 10; ++i) {
+    WriteFile("memory://segment" + std::to_string(i) + ".m4s", data);
+    if (i > 2) {
+      ASSERT_TRUE(File::Delete(
+          ("memory://segment" + std::to_string(i - 2) + ".m4s").c_str()));
+    }
+  }
+
+  std::unique_ptr<File, FileCloser> init(File::Open("memory://init.mp4", "r"));
+  ASSERT_TRUE(init);
+  EXPECT_EQ(100, init->Size());
+  EXPECT_TRUE(File::Open("memory://segment10.m4s", "r")->Close());
+  EXPECT_TRUE(File::Open("memory://segment8.m4s", "r")->Close());
+  EXPECT_FALSE(File::Open("memory://segment7.m4s", "r"));
+
+  // Files which are not deleted are kept even above the limit.
+  WriteFile("memory://segment11.m4s", data);
+  WriteFile("memory://segment12.m4s", data);
+  EXPECT_FALSE(File::Open("memory://segment8.m4s", "r"));
+  EXPECT_TRUE(File::Open("memory://segment9.m4s", "r")->Close());
+  EXPECT_TRUE(File::Open("memory://segment12.m4s", "r")->Close());
+  EXPECT_EQ(100, init->Size());
+}
+
+TEST_F(MemoryFileTest, DeletedFilesNotKeptWithoutLimit) {
+  const std::vector<uint8_t> data(100, 1);
+  MemoryFile::SetMaxTotalSize(250);
+  WriteFile("memory://file1", data);
+  ASSERT_TRUE(File::Delete("memory://file1"));
+  EXPECT_TRUE(File::Open("memory://file1", "r")->Close());
+
+  MemoryFile::SetMaxTotalSize(0);
+  EXPECT_FALSE(File::Open("memory://file1", "r"));
+}
+
 }  // namespace shaka
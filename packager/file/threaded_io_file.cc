@@ -6,12 +6,21 @@
 
 #include <packager/file/threaded_io_file.h>
 
+#include <algorithm>
+
 #include <absl/log/check.h>
 
 #include <packager/file/thread_pool.h>
 
 namespace shaka {
 
+namespace {
+
+// Upper bound of the adaptive read size in input mode.
+const uint64_t kMaxInputBlockSize = 4 << 20;
+
+}  // namespace
+
 ThreadedIoFile::ThreadedIoFile(std::unique_ptr<File, FileCloser> internal_file,
                                Mode mode,
                                uint64_t io_cache_size,
@@ -20,6 +29,10 @@ ThreadedIoFile::ThreadedIoFile(std::unique_ptr<File, FileCloser> internal_file,
       internal_file_(std::move(internal_file)),
       mode_(mode),
       cache_(io_cache_size),
+      io_block_size_(io_block_size),
+      max_input_block_size_(std::max(
+          io_block_size,
+          std::min(io_cache_size / 4, kMaxInputBlockSize))),
       io_buffer_(io_block_size),
       position_(0),
       size_(0),
@@ -132,6 +145,9 @@ bool ThreadedIoFile::Seek(uint64_t position) {
     cache_.Close();
     WaitForSignal(&task_exited_mutex_, &task_exited_);
 
+    // Start over with small reads, as the access pattern may have changed.
+    io_buffer_.resize(io_block_size_);
+
     bool result = internal_file_->Seek(position);
     if (!result) {
       // Seek failed. Seek to logical position instead.
@@ -191,6 +207,12 @@ void ThreadedIoFile::RunInInputMode() {
     if (cache_.Write(&io_buffer_[0], read_result) == 0) {
       return;
     }
+    // A full read suggests that more data is readily available, so read ahead
+    // in larger blocks.
+    if (static_cast<uint64_t>(read_result) == io_buffer_.size() &&
+        io_buffer_.size() < max_input_block_size_) {
+      io_buffer_.resize(std::min(io_buffer_.size() * 2, max_input_block_size_));
+    }
   }
 }
 
@@ -24,6 +24,14 @@ class ThreadedIoFile : public File {
  public:
   enum Mode { kInputMode, kOutputMode };
 
+  /// @param internal_file is the file to read from or write to.
+  /// @param mode is the I/O mode.
+  /// @param io_cache_size is the size of the circular buffer.
+  /// @param io_block_size is the size of each read or write on
+  ///        @a internal_file. In input mode, this is the initial read size,
+  ///        which doubles after each full read, up to a quarter of
+  ///        @a io_cache_size, so that sequential reads of large inputs need
+  ///        fewer, larger requests. It is reset on Seek.
   ThreadedIoFile(std::unique_ptr<File, FileCloser> internal_file,
                  Mode mode,
                  uint64_t io_cache_size,
@@ -57,6 +65,8 @@ class ThreadedIoFile : public File {
   std::unique_ptr<File, FileCloser> internal_file_;
   const Mode mode_;
   IoCache cache_;
+  const uint64_t io_block_size_;
+  const uint64_t max_input_block_size_;
   std::vector<uint8_t> io_buffer_;
   uint64_t position_;
   uint64_t size_;
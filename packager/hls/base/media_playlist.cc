@@ -18,6 +18,7 @@
 #include <absl/strings/str_format.h>
 
 #include <packager/file.h>
+#include <packager/file/file_deleter.h>
 #include <packager/hls/base/tag.h>
 #include <packager/macros/logging.h>
 #include <packager/media/base/language_utils.h>
@@ -505,6 +506,11 @@ bool MediaPlaylist::WriteToFile(const std::filesystem::path& file_path) {
     LOG(ERROR) << "Failed to write playlist to: " << file_path.string();
     return false;
   }
+
+  // The published playlist no longer refers to these segments.
+  for (const std::string& segment_name : segments_to_delete_)
+    FileDeleter::instance.Delete(segment_name, file_deletions_);
+  segments_to_delete_.clear();
   return true;
 }
 
@@ -742,12 +748,7 @@ void MediaPlaylist::RemoveOldSegment(int64_t start_time) {
                             media_sequence_number_, media_info_.bandwidth()));
   while (segments_to_be_removed_.size() >
          hls_params_.preserved_segments_outside_live_window) {
-    VLOG(2) << "Deleting " << segments_to_be_removed_.front();
-    if (!File::Delete(segments_to_be_removed_.front().c_str())) {
-      LOG(WARNING) << "Failed to delete " << segments_to_be_removed_.front()
-                   << "; Will retry later.";
-      break;
-    }
+    segments_to_delete_.push_back(std::move(segments_to_be_removed_.front()));
     segments_to_be_removed_.pop_front();
   }
 }
@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 
+#include <packager/file/file_deleter.h>
 #include <packager/hls_params.h>
 #include <packager/macros/classes.h>
 #include <packager/mpd/base/bandwidth_estimator.h>
@@ -110,6 +111,12 @@ class MediaPlaylist {
   /// @param sample_duration is the duration of a sample.
   virtual void SetSampleDuration(int32_t sample_duration);
 
+  /// @param file_deletions is the group of the deletions of the segments which
+  ///        left the live window, or null.
+  void set_file_deletions(FileDeleter::Group* file_deletions) {
+    file_deletions_ = file_deletions;
+  }
+
   /// Segments must be added in order.
   /// @param file_name is the file name of the segment.
   /// @param start_time is in terms of the timescale of the media.
@@ -252,7 +259,8 @@ class MediaPlaylist {
   void SlideWindow();
   // Remove the segment specified by |start_time|. The actual deletion can
   // happen at a later time depending on the value of
-  // |preserved_segment_outside_live_window| in |hls_params_|.
+  // |preserved_segment_outside_live_window| in |hls_params_|, and only after
+  // the playlist has been written.
   void RemoveOldSegment(int64_t start_time);
 
   const HlsParams& hls_params_;
@@ -292,6 +300,9 @@ class MediaPlaylist {
   // A list to hold the file names of the segments to be removed temporarily.
   // Once a file is actually removed, it is removed from the list.
   std::list<std::string> segments_to_be_removed_;
+  // Segments to delete once the playlist without them has been written.
+  std::vector<std::string> segments_to_delete_;
+  FileDeleter::Group* file_deletions_ = nullptr;
 
   // Used by kVideoIFrameOnly playlists to track the i-frames (key frames).
   struct KeyFrameInfo {
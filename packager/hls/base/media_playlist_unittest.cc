@@ -12,6 +12,7 @@
 
 #include <packager/file.h>
 #include <packager/file/file_closer.h>
+#include <packager/file/file_deleter.h>
 #include <packager/file/file_test_util.h>
 #include <packager/version/version.h>
 
@@ -1131,6 +1132,12 @@ class MediaPlaylistDeleteSegmentsTest
     return file_closer.get() == nullptr;
   }
 
+  // Segments are deleted in the background once the playlist is written.
+  void WritePlaylistAndWaitForDeletions() {
+    ASSERT_TRUE(media_playlist_->WriteToFile("memory://media.m3u8"));
+    FileDeleter::instance.Flush();
+  }
+
  private:
   std::string segment_template_;
   std::string segment_template_url_;
@@ -1143,6 +1150,7 @@ TEST_P(MediaPlaylistDeleteSegmentsTest, NoSegmentsDeletedInitially) {
     media_playlist_->AddSegment(kIgnoredSegmentName, GetTime(i), kDuration,
                                 kZeroByteOffset, kMBytes);
   }
+  WritePlaylistAndWaitForDeletions();
   for (int i = 0; i < kMaxNumSegmentsAvailable; ++i) {
     EXPECT_FALSE(SegmentDeleted(GetSegmentName(i)));
   }
@@ -1153,16 +1161,30 @@ TEST_P(MediaPlaylistDeleteSegmentsTest, OneSegmentDeleted) {
     media_playlist_->AddSegment(kIgnoredSegmentName, GetTime(i), kDuration,
                                 kZeroByteOffset, kMBytes);
   }
+  WritePlaylistAndWaitForDeletions();
   EXPECT_FALSE(SegmentDeleted(GetSegmentName(1)));
   EXPECT_TRUE(SegmentDeleted(GetSegmentName(0)));
 }
 
+TEST_P(MediaPlaylistDeleteSegmentsTest, NoSegmentsDeletedBeforeWrite) {
+  for (int i = 0; i <= kMaxNumSegmentsAvailable; ++i) {
+    media_playlist_->AddSegment(kIgnoredSegmentName, GetTime(i), kDuration,
+                                kZeroByteOffset, kMBytes);
+  }
+  FileDeleter::instance.Flush();
+  EXPECT_FALSE(SegmentDeleted(GetSegmentName(0)));
+
+  WritePlaylistAndWaitForDeletions();
+  EXPECT_TRUE(SegmentDeleted(GetSegmentName(0)));
+}
+
 TEST_P(MediaPlaylistDeleteSegmentsTest, ManySegments) {
   int many_segments = 50;
   for (int i = 0; i < many_segments; ++i) {
     media_playlist_->AddSegment(kIgnoredSegmentName, GetTime(i), kDuration,
                                 kZeroByteOffset, kMBytes);
   }
+  WritePlaylistAndWaitForDeletions();
   const int last_available_segment_index =
       many_segments - kMaxNumSegmentsAvailable;
   EXPECT_FALSE(SegmentDeleted(GetSegmentName(last_available_segment_index)));
@@ -306,6 +306,7 @@ bool SimpleHlsNotifier::NotifyNewStream(const MediaInfo& media_info,
   std::unique_ptr<MediaPlaylist> media_playlist =
       media_playlist_factory_->Create(hls_params(), relative_playlist_path,
                                       name, group_id);
+  media_playlist->set_file_deletions(file_deletions_);
   MediaInfo adjusted_media_info = MakeMediaInfoPathsRelativeToPlaylist(
       media_info, hls_params().base_url, master_playlist_dir_,
       media_playlist->file_name());
@@ -15,6 +15,7 @@
 
 #include <absl/synchronization/mutex.h>
 
+#include <packager/file/file_deleter.h>
 #include <packager/hls/base/hls_notifier.h>
 #include <packager/hls/base/master_playlist.h>
 #include <packager/hls/base/media_playlist.h>
@@ -42,6 +43,13 @@ class SimpleHlsNotifier : public HlsNotifier {
   explicit SimpleHlsNotifier(const HlsParams& hls_params);
   ~SimpleHlsNotifier() override;
 
+  /// @param file_deletions is the group of the deletions of the segments which
+  ///        left the live window, or null. It must be set before any stream
+  ///        is added.
+  void set_file_deletions(FileDeleter::Group* file_deletions) {
+    file_deletions_ = file_deletions;
+  }
+
   /// @name HlsNotifier implemetation overrides.
   /// @{
   bool Init() override;
@@ -82,6 +90,7 @@ class SimpleHlsNotifier : public HlsNotifier {
 
   std::string master_playlist_dir_;
   int32_t target_duration_ = 0;
+  FileDeleter::Group* file_deletions_ = nullptr;
 
   std::unique_ptr<MediaPlaylistFactory> media_playlist_factory_;
   std::unique_ptr<MasterPlaylist> master_playlist_;
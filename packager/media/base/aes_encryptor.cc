@@ -68,28 +68,46 @@ bool AesCtrEncryptor::CryptInternal(const uint8_t* plaintext,
   }
   *ciphertext_size = plaintext_size;
 
-  for (size_t i = 0; i < plaintext_size; ++i) {
-    if (block_offset_ == 0) {
-      size_t ignored_output_size;
-      CHECK_EQ(
-          mbedtls_cipher_crypt(&cipher_ctx_, /* iv= */ NULL, /* iv_len= */ 0,
-                               &counter_[0], AES_BLOCK_SIZE,
-                               &encrypted_counter_[0], &ignored_output_size),
-          0);
-
-      // As mentioned in ISO/IEC 23001-7:2016 CENC spec, of the 16 byte counter
-      // block, bytes 8 to 15 (i.e. the least significant bytes) are used as a
-      // simple 64 bit unsigned integer that is incremented by one for each
-      // subsequent block of sample data processed and is kept in network byte
-      // order.
-      Increment64(&counter_[8]);
-    }
+  size_t i = 0;
+  // Use up the key stream left from the previous call first.
+  for (; block_offset_ != 0 && i < plaintext_size; ++i) {
     ciphertext[i] = plaintext[i] ^ encrypted_counter_[block_offset_];
     block_offset_ = (block_offset_ + 1) % AES_BLOCK_SIZE;
   }
+
+  // Then process whole blocks at a time, which the compiler vectorizes.
+  for (; plaintext_size - i >= AES_BLOCK_SIZE; i += AES_BLOCK_SIZE) {
+    EncryptCounter();
+    for (size_t j = 0; j < AES_BLOCK_SIZE; ++j)
+      ciphertext[i + j] = plaintext[i + j] ^ encrypted_counter_[j];
+  }
+
+  if (i < plaintext_size) {
+    EncryptCounter();
+    for (; i < plaintext_size; ++i)
+      ciphertext[i] = plaintext[i] ^ encrypted_counter_[block_offset_++];
+  }
   return true;
 }
 
+void AesCtrEncryptor::EncryptCounter() {
+  // ECB mode is a single block cipher operation, so call mbedtls_cipher_update
+  // directly instead of going through the IV and finalization steps of
+  // mbedtls_cipher_crypt.
+  size_t ignored_output_size;
+  CHECK_EQ(mbedtls_cipher_update(&cipher_ctx_, counter_.data(), AES_BLOCK_SIZE,
+                                 encrypted_counter_.data(),
+                                 &ignored_output_size),
+           0);
+
+  // As mentioned in ISO/IEC 23001-7:2016 CENC spec, of the 16 byte counter
+  // block, bytes 8 to 15 (i.e. the least significant bytes) are used as a
+  // simple 64 bit unsigned integer that is incremented by one for each
+  // subsequent block of sample data processed and is kept in network byte
+  // order.
+  Increment64(&counter_[8]);
+}
+
 void AesCtrEncryptor::SetIvInternal() {
   block_offset_ = 0;
   counter_ = iv();
@@ -152,7 +170,8 @@ bool AesCbcEncryptor::CryptInternal(const uint8_t* plaintext,
     CbcEncryptBlocks(plaintext, cbc_size, ciphertext, internal_iv_.data());
   } else if (padding_scheme_ == kCtsPadding) {
     // Don't have a full block, leave unencrypted.
-    memcpy(ciphertext, plaintext, plaintext_size);
+    if (ciphertext != plaintext)
+      memcpy(ciphertext, plaintext, plaintext_size);
     return true;
   }
   if (residual_block_size == 0 && padding_scheme_ != kPkcs5Padding) {
@@ -161,8 +180,12 @@ bool AesCbcEncryptor::CryptInternal(const uint8_t* plaintext,
   }
 
   if (padding_scheme_ == kNoPadding) {
-    // The residual block is left unencrypted.
-    memcpy(ciphertext + cbc_size, plaintext + cbc_size, residual_block_size);
+    // The residual block is left unencrypted. It is already in place when
+    // encrypting in place.
+    if (ciphertext != plaintext) {
+      memcpy(ciphertext + cbc_size, plaintext + cbc_size,
+             residual_block_size);
+    }
     return true;
   }
 
@@ -37,6 +37,8 @@ class AesCtrEncryptor : public AesCryptor {
                      uint8_t* ciphertext,
                      size_t* ciphertext_size) override;
   void SetIvInternal() override;
+  // Encrypts |counter_| into |encrypted_counter_| and increments |counter_|.
+  void EncryptCounter();
 
   // Current block offset.
   uint32_t block_offset_;
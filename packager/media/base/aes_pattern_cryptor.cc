@@ -72,7 +72,8 @@ bool AesPatternCryptor::CryptInternal(const uint8_t* text,
       }
 
       // The remaining bytes are not encrypted.
-      memcpy(crypt_text, text, text_size);
+      if (crypt_text != text)
+        memcpy(crypt_text, text, text_size);
       return true;
     }
 
@@ -84,7 +85,8 @@ bool AesPatternCryptor::CryptInternal(const uint8_t* text,
 
     const size_t skip_byte_size = std::min(
         static_cast<size_t>(skip_byte_block_ * AES_BLOCK_SIZE), text_size);
-    memcpy(crypt_text, text, skip_byte_size);
+    if (crypt_text != text)
+      memcpy(crypt_text, text, skip_byte_size);
     text += skip_byte_size;
     text_size -= skip_byte_size;
     crypt_text += skip_byte_size;
@@ -0,0 +1,127 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/async_segment_writer.h>
+
+#include <algorithm>
+#include <memory>
+
+#include <absl/log/log.h>
+
+#include <packager/file/file_closer.h>
+#include <packager/file/thread_pool.h>
+#include <packager/macros/logging.h>
+#include <packager/macros/status.h>
+
+namespace shaka {
+namespace media {
+
+AsyncSegmentWriter::AsyncSegmentWriter() {}
+
+AsyncSegmentWriter::~AsyncSegmentWriter() {
+  WaitForWriteTask();
+}
+
+Status AsyncSegmentWriter::WriteSegment(const std::string& file_name,
+                                        File* file,
+                                        BufferWriter* segment_buffer,
+                                        WrittenCallback on_written) {
+  RETURN_IF_ERROR(Flush());
+  buffer_.Swap(segment_buffer);
+
+  return RunTask(
+      file_name,
+      [this, file_name, file]() {
+        if (file)
+          return buffer_.WriteToFile(file);
+
+        std::unique_ptr<File, FileCloser> output(
+            File::Open(file_name.c_str(), "w"));
+        if (!output) {
+          return Status(error::FILE_FAILURE,
+                        "Cannot open file for write " + file_name);
+        }
+        RETURN_IF_ERROR(buffer_.WriteToFile(output.get()));
+        if (!output.release()->Close()) {
+          return Status(error::FILE_FAILURE,
+                        "Cannot close file " + file_name +
+                            ", possibly file permission issue or running out "
+                            "of disk space.");
+        }
+        return Status::OK;
+      },
+      std::move(on_written));
+}
+
+Status AsyncSegmentWriter::RunTask(const std::string& segment_name,
+                                   WriteTask task,
+                                   WrittenCallback on_written) {
+  RETURN_IF_ERROR(Flush());
+
+  pending_ = true;
+  segment_name_ = segment_name;
+  task_ = std::move(task);
+  on_written_ = std::move(on_written);
+  {
+    absl::MutexLock lock(&mutex_);
+    running_ = true;
+  }
+  ThreadPool::instance.PostTask(
+      std::bind(&AsyncSegmentWriter::WriteTaskMain, this));
+  return Status::OK;
+}
+
+Status AsyncSegmentWriter::Flush() {
+  if (!pending_)
+    return Status::OK;
+  pending_ = false;
+
+  WaitForWriteTask();
+  Status status;
+  absl::Duration latency;
+  {
+    absl::MutexLock lock(&mutex_);
+    status = task_status_;
+    latency = task_latency_;
+  }
+  task_ = nullptr;
+  WrittenCallback on_written = std::move(on_written_);
+  on_written_ = nullptr;
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to write segment " << segment_name_ << ": "
+               << status;
+    return status;
+  }
+
+  stats_.segment_count++;
+  stats_.total_write_latency += latency;
+  stats_.max_write_latency = std::max(stats_.max_write_latency, latency);
+  VLOG(1) << "Segment " << segment_name_ << " written in "
+          << absl::FormatDuration(latency) << ".";
+
+  if (on_written)
+    on_written();
+  return Status::OK;
+}
+
+void AsyncSegmentWriter::WriteTaskMain() {
+  const absl::Time start = absl::Now();
+  Status status = task_();
+
+  absl::MutexLock lock(&mutex_);
+  task_status_ = std::move(status);
+  task_latency_ = absl::Now() - start;
+  running_ = false;
+}
+
+void AsyncSegmentWriter::WaitForWriteTask() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(
+      +[](bool* running) { return !*running; }, &running_));
+}
+
+}  // namespace media
+}  // namespace shaka
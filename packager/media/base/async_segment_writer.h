@@ -0,0 +1,106 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_ASYNC_SEGMENT_WRITER_H_
+#define PACKAGER_MEDIA_BASE_ASYNC_SEGMENT_WRITER_H_
+
+#include <functional>
+#include <string>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+
+#include <packager/file.h>
+#include <packager/macros/classes.h>
+#include <packager/media/base/buffer_writer.h>
+#include <packager/status.h>
+
+namespace shaka {
+namespace media {
+
+/// Writes finished segments on a worker thread, so that the muxer can keep
+/// packetizing the next segment while the current one is written. At most one
+/// segment is written at a time: a new write first waits for the previous one.
+///
+/// Listener notifications for a segment, e.g. MuxerListener::OnNewSegment(),
+/// are passed as a callback, which runs on the muxer thread once the segment is
+/// written, i.e. in the next write or in Flush(). This keeps the listener
+/// events in order and guarantees that manifests only reference segments that
+/// are fully written.
+class AsyncSegmentWriter {
+ public:
+  /// Run on the muxer thread after a segment is written successfully.
+  typedef std::function<void()> WrittenCallback;
+  /// Run on the worker thread to write a segment.
+  typedef std::function<Status()> WriteTask;
+
+  /// Segment write statistics.
+  struct Stats {
+    size_t segment_count = 0;
+    absl::Duration total_write_latency;
+    absl::Duration max_write_latency;
+  };
+
+  AsyncSegmentWriter();
+  /// Waits for the segment being written, if any, without running its
+  /// callback.
+  ~AsyncSegmentWriter();
+
+  /// Writes the content of @a segment_buffer on the worker thread. The content
+  /// is swapped out of @a segment_buffer, which gets the buffer of the
+  /// previous segment back so that its memory is reused.
+  /// @param file_name is the name of the file to write the segment to. It is
+  ///        only used for logging if @a file is not null.
+  /// @param file, if not null, is an open file to append the segment to, e.g.
+  ///        in single segment mode. It must stay open until Flush() returns.
+  /// @param segment_buffer contains the segment to write.
+  /// @param on_written is called once the segment is written.
+  /// @return The status of the previous write, or OK.
+  Status WriteSegment(const std::string& file_name,
+                      File* file,
+                      BufferWriter* segment_buffer,
+                      WrittenCallback on_written);
+
+  /// Runs @a task on the worker thread like WriteSegment(), e.g. to copy a
+  /// segment which was written to a memory file.
+  /// @param segment_name is the name of the segment, used for logging.
+  Status RunTask(const std::string& segment_name,
+                 WriteTask task,
+                 WrittenCallback on_written);
+
+  /// Waits for the segment being written, if any, and runs its callback.
+  /// @return The status of the write.
+  Status Flush();
+
+  /// @return The statistics of the segments written so far.
+  const Stats& stats() const { return stats_; }
+
+ private:
+  void WriteTaskMain();
+  void WaitForWriteTask();
+
+  // Only accessed on the muxer thread, or on the worker thread while a task
+  // is running.
+  bool pending_ = false;
+  std::string segment_name_;
+  WriteTask task_;
+  WrittenCallback on_written_;
+  BufferWriter buffer_;
+  Stats stats_;
+
+  absl::Mutex mutex_;
+  bool running_ ABSL_GUARDED_BY(mutex_) = false;
+  Status task_status_ ABSL_GUARDED_BY(mutex_);
+  absl::Duration task_latency_ ABSL_GUARDED_BY(mutex_);
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncSegmentWriter);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_ASYNC_SEGMENT_WRITER_H_
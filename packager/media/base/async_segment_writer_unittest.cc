@@ -0,0 +1,95 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/async_segment_writer.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <packager/file/file_closer.h>
+#include <packager/file/file_test_util.h>
+#include <packager/status/status_test_util.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const char kSegment1Name[] = "memory://segment_1.ts";
+const char kSegment2Name[] = "memory://segment_2.ts";
+const char kOutputFile[] = "memory://output.ts";
+const char kSegment1Data[] = "segment 1";
+const char kSegment2Data[] = "segment 2";
+
+}  // namespace
+
+class AsyncSegmentWriterTest : public testing::Test {
+ protected:
+  void TearDown() override {
+    File::Delete(kSegment1Name);
+    File::Delete(kSegment2Name);
+    File::Delete(kOutputFile);
+  }
+
+  AsyncSegmentWriter writer_;
+  BufferWriter buffer_;
+  std::vector<std::string> written_segments_;
+};
+
+TEST_F(AsyncSegmentWriterTest, CallbacksRunInOrderAfterWrites) {
+  buffer_.AppendString(kSegment1Data);
+  ASSERT_OK(writer_.WriteSegment(kSegment1Name, nullptr, &buffer_, [this]() {
+    written_segments_.push_back(kSegment1Name);
+  }));
+  // The content is swapped out, so the next segment can be written right away.
+  EXPECT_EQ(0u, buffer_.Size());
+  EXPECT_TRUE(written_segments_.empty());
+
+  buffer_.AppendString(kSegment2Data);
+  ASSERT_OK(writer_.WriteSegment(kSegment2Name, nullptr, &buffer_, [this]() {
+    written_segments_.push_back(kSegment2Name);
+  }));
+  // Writing the second segment waits for the first one.
+  EXPECT_EQ(std::vector<std::string>({kSegment1Name}), written_segments_);
+  ASSERT_FILE_STREQ(kSegment1Name, kSegment1Data);
+
+  ASSERT_OK(writer_.Flush());
+  EXPECT_EQ(std::vector<std::string>({kSegment1Name, kSegment2Name}),
+            written_segments_);
+  ASSERT_FILE_STREQ(kSegment2Name, kSegment2Data);
+  EXPECT_EQ(2u, writer_.stats().segment_count);
+}
+
+TEST_F(AsyncSegmentWriterTest, AppendToOpenFile) {
+  std::unique_ptr<File, FileCloser> file(File::Open(kOutputFile, "w"));
+  ASSERT_TRUE(file);
+
+  buffer_.AppendString(kSegment1Data);
+  ASSERT_OK(writer_.WriteSegment(kOutputFile, file.get(), &buffer_, nullptr));
+  buffer_.AppendString(kSegment2Data);
+  ASSERT_OK(writer_.WriteSegment(kOutputFile, file.get(), &buffer_, nullptr));
+  ASSERT_OK(writer_.Flush());
+  ASSERT_TRUE(file.release()->Close());
+
+  ASSERT_FILE_STREQ(kOutputFile,
+                    std::string(kSegment1Data) + std::string(kSegment2Data));
+}
+
+TEST_F(AsyncSegmentWriterTest, FailedWriteIsReportedWithoutCallback) {
+  ASSERT_OK(writer_.RunTask(
+      kSegment1Name, []() { return Status(error::FILE_FAILURE, "Failed."); },
+      [this]() { written_segments_.push_back(kSegment1Name); }));
+
+  EXPECT_EQ(error::FILE_FAILURE, writer_.Flush().error_code());
+  EXPECT_TRUE(written_segments_.empty());
+  EXPECT_EQ(0u, writer_.stats().segment_count);
+  // The failure is only reported once.
+  ASSERT_OK(writer_.Flush());
+}
+
+}  // namespace media
+}  // namespace shaka
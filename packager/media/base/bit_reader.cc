@@ -4,9 +4,8 @@
 
 #include <packager/media/base/bit_reader.h>
 
-#include <algorithm>
-
 #include <absl/log/check.h>
+#include <absl/numeric/bits.h>
 
 namespace shaka {
 namespace media {
@@ -15,100 +14,142 @@ BitReader::BitReader(const uint8_t* data, size_t size)
     : data_(data),
       initial_size_(size),
       bytes_left_(size),
-      num_remaining_bits_in_curr_byte_(0) {
+      cache_(0),
+      num_cached_bits_(0) {
   DCHECK(data_ != NULL && bytes_left_ > 0);
 
-  UpdateCurrByte();
+  RefillCache();
 }
 
 BitReader::~BitReader() {}
 
 bool BitReader::SkipBits(size_t num_bits) {
-  // Skip any bits in the current byte waiting to be processed, then
-  // process full bytes until less than 8 bits remaining.
-  if (num_bits > num_remaining_bits_in_curr_byte_) {
-    num_bits -= num_remaining_bits_in_curr_byte_;
-    num_remaining_bits_in_curr_byte_ = 0;
+  // Skip the cached bits, then skip whole bytes without loading them.
+  if (num_bits > num_cached_bits_) {
+    num_bits -= num_cached_bits_;
+    ConsumeCachedBits(num_cached_bits_);
 
-    size_t num_bytes = num_bits / 8;
+    const size_t num_bytes = num_bits / 8;
     num_bits %= 8;
     if (bytes_left_ < num_bytes) {
-      bytes_left_ = 0;
+      SetEndOfStream();
       return false;
     }
     bytes_left_ -= num_bytes;
     data_ += num_bytes;
-    UpdateCurrByte();
-
-    // If there is no more data remaining, only return true if we
-    // skipped all that were requested.
-    if (num_remaining_bits_in_curr_byte_ == 0)
-      return (num_bits == 0);
+    RefillCache();
   }
 
-  // Less than 8 bits remaining to skip. Use ReadBitsInternal to verify
-  // that the remaining bits we need exist, and adjust them as necessary
-  // for subsequent operations.
+  // Less than 8 bits or the bits in the cache remaining to skip. Use
+  // ReadBitsInternal to verify that the remaining bits we need exist.
   uint64_t not_needed;
   return ReadBitsInternal(num_bits, &not_needed);
 }
 
 void BitReader::SkipToNextByte() {
-  // Already aligned.
-  if (num_remaining_bits_in_curr_byte_ == 8)
-    return;
-
-  num_remaining_bits_in_curr_byte_ = 0;
-  UpdateCurrByte();
+  // The cache only contains whole bytes after a refill, so the stream is byte
+  // aligned when a whole number of bytes is cached.
+  ConsumeCachedBits(num_cached_bits_ % 8);
+  if (num_cached_bits_ == 0)
+    RefillCache();
 }
 
 bool BitReader::SkipBytes(size_t num_bytes) {
   if (num_bytes == 0)
     return true;
-  if (num_remaining_bits_in_curr_byte_ != 8)
+  if (num_cached_bits_ % 8 != 0 || bits_available() == 0)
     return false;
 
-  data_ += num_bytes - 1;  // One additional byte in curr_byte_.
-  if (num_bytes > bytes_left_ + 1)
-    return false;
-  bytes_left_ -= num_bytes - 1;
-  num_remaining_bits_in_curr_byte_ = 0;
-  UpdateCurrByte();
+  const size_t num_cached_bytes = num_cached_bits_ / 8;
+  if (num_bytes <= num_cached_bytes) {
+    ConsumeCachedBits(num_bytes * 8);
+  } else {
+    num_bytes -= num_cached_bytes;
+    if (num_bytes > bytes_left_)
+      return false;
+    ConsumeCachedBits(num_cached_bits_);
+    bytes_left_ -= num_bytes;
+    data_ += num_bytes;
+  }
+  if (num_cached_bits_ == 0)
+    RefillCache();
   return true;
 }
 
+bool BitReader::ReadLeadingZeroBits(size_t* num_zero_bits) {
+  *num_zero_bits = 0;
+  while (true) {
+    if (num_cached_bits_ == 0) {
+      RefillCache();
+      if (num_cached_bits_ == 0)
+        return false;
+    }
+    // The bits after the cached bits are zero, so the cache is zero if all the
+    // cached bits are zero.
+    if (cache_ == 0) {
+      *num_zero_bits += num_cached_bits_;
+      ConsumeCachedBits(num_cached_bits_);
+      continue;
+    }
+    const size_t num_zeros = absl::countl_zero(cache_);
+    *num_zero_bits += num_zeros;
+    ConsumeCachedBits(num_zeros + 1);
+    return true;
+  }
+}
+
 bool BitReader::ReadBitsInternal(size_t num_bits, uint64_t* out) {
   DCHECK_LE(num_bits, 64u);
 
   *out = 0;
-
-  while (num_remaining_bits_in_curr_byte_ != 0 && num_bits != 0) {
-    size_t bits_to_take = std::min(num_remaining_bits_in_curr_byte_, num_bits);
-
-    *out <<= bits_to_take;
-    *out += curr_byte_ >> (num_remaining_bits_in_curr_byte_ - bits_to_take);
-    num_bits -= bits_to_take;
-    num_remaining_bits_in_curr_byte_ -= bits_to_take;
-    curr_byte_ &= (1 << num_remaining_bits_in_curr_byte_) - 1;
-
-    if (num_remaining_bits_in_curr_byte_ == 0)
-      UpdateCurrByte();
+  if (num_bits == 0)
+    return true;
+  if (num_bits > bits_available()) {
+    SetEndOfStream();
+    return false;
   }
 
-  return num_bits == 0;
+  if (num_bits > num_cached_bits_)
+    RefillCache();
+  // At least 57 bits are cached after a refill, so the bits can only span
+  // beyond the cache if more than 56 bits are read.
+  if (num_bits > num_cached_bits_) {
+    const size_t num_high_bits = num_cached_bits_;
+    *out = cache_ >> (64 - num_high_bits);
+    ConsumeCachedBits(num_high_bits);
+    RefillCache();
+    num_bits -= num_high_bits;
+    *out <<= num_bits;
+  }
+  *out |= cache_ >> (64 - num_bits);
+  ConsumeCachedBits(num_bits);
+  return true;
 }
 
-void BitReader::UpdateCurrByte() {
-  DCHECK_EQ(num_remaining_bits_in_curr_byte_, 0u);
+void BitReader::RefillCache() {
+  const size_t num_bytes = (64 - num_cached_bits_) / 8;
+  if (num_bytes == 0)
+    return;
 
-  if (bytes_left_ == 0)
+  if (bytes_left_ >= sizeof(cache_)) {
+    // Load a whole big-endian word and keep the bytes that fit.
+    uint64_t word = 0;
+    for (size_t i = 0; i < sizeof(word); ++i)
+      word = (word << 8) | data_[i];
+    const uint64_t mask = ~uint64_t{0} << (64 - 8 * num_bytes);
+    cache_ |= (word & mask) >> num_cached_bits_;
+    num_cached_bits_ += 8 * num_bytes;
+    data_ += num_bytes;
+    bytes_left_ -= num_bytes;
     return;
+  }
 
-  // Load a new byte and advance pointers.
-  curr_byte_ = *data_;
-  ++data_;
-  --bytes_left_;
-  num_remaining_bits_in_curr_byte_ = 8;
+  while (bytes_left_ > 0 && num_cached_bits_ <= 56) {
+    cache_ |= static_cast<uint64_t>(*data_) << (56 - num_cached_bits_);
+    num_cached_bits_ += 8;
+    ++data_;
+    --bytes_left_;
+  }
 }
 
 }  // namespace media
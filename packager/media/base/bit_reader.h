@@ -7,6 +7,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <type_traits>
 
 #include <absl/log/check.h>
 #include <absl/log/log.h>
@@ -52,6 +53,35 @@ class BitReader {
     return ret;
   }
 
+  /// Read a fixed number of bits from stream. Same as ReadBits(num_bits, out)
+  /// but the bits are taken from the cached word without a loop if possible,
+  /// so prefer this version for fields with a fixed width.
+  /// @tparam kNumBits specifies the number of bits to read. It cannot be
+  ///         larger than the number of bits the type can hold.
+  template <size_t kNumBits, typename T>
+  bool ReadBits(T* out) {
+    static_assert(kNumBits > 0 && kNumBits <= sizeof(T) * 8,
+                  "The type cannot hold the number of bits.");
+    if (num_cached_bits_ < kNumBits)
+      return ReadBits(kNumBits, out);
+    const uint64_t value = cache_ >> (64 - kNumBits);
+    ConsumeCachedBits(kNumBits);
+    if constexpr (std::is_same_v<T, bool>)
+      *out = value != 0;
+    else
+      *out = static_cast<T>(value);
+    return true;
+  }
+
+  /// Read bits up to and including the first bit set, i.e. the prefix of an
+  /// exp-Golomb code.
+  /// @param[out] num_zero_bits stores the number of bits read before the bit
+  ///             set.
+  /// @return false if there is no bit set in the rest of the stream, true
+  ///         otherwise. When false is returned, the stream will enter the
+  ///         same state as when ReadBits returns false.
+  bool ReadLeadingZeroBits(size_t* num_zero_bits);
+
   /// Skip a number of bits from stream.
   /// @param num_bits specifies the number of bits to be skipped.
   /// @return false if the given number of bits cannot be skipped (not enough
@@ -89,40 +119,54 @@ class BitReader {
   bool SkipBytes(size_t num_bytes);
 
   /// @return The number of bits available for reading.
-  size_t bits_available() const {
-    return 8 * bytes_left_ + num_remaining_bits_in_curr_byte_;
-  }
+  size_t bits_available() const { return 8 * bytes_left_ + num_cached_bits_; }
 
   /// @return The current bit position.
   size_t bit_position() const { return 8 * initial_size_ - bits_available(); }
 
-  /// @return A pointer to the current byte.
-  const uint8_t* current_byte_ptr() const { return data_ - 1; }
+  /// @return A pointer to the current byte, i.e. the byte containing the next
+  ///         unread bit, or the last byte if the stream has reached the end.
+  const uint8_t* current_byte_ptr() const {
+    return data_ - (num_cached_bits_ + 7) / 8 - (bits_available() == 0);
+  }
 
  private:
   // Help function used by ReadBits to avoid inlining the bit reading logic.
   bool ReadBitsInternal(size_t num_bits, uint64_t* out);
 
-  // Advance to the next byte, loading it into curr_byte_.
-  // If the num_remaining_bits_in_curr_byte_ is 0 after this function returns,
-  // the stream has reached the end.
-  void UpdateCurrByte();
+  // Load as many whole bytes as fit into cache_.
+  void RefillCache();
+
+  // Drop |num_bits| (which cannot be more than num_cached_bits_) from cache_.
+  void ConsumeCachedBits(size_t num_bits) {
+    DCHECK_LE(num_bits, num_cached_bits_);
+    cache_ = num_bits < 64 ? cache_ << num_bits : 0;
+    num_cached_bits_ -= num_bits;
+  }
+
+  // Drop all the remaining bits, which is the state after a failed read.
+  void SetEndOfStream() {
+    data_ += bytes_left_;
+    bytes_left_ = 0;
+    cache_ = 0;
+    num_cached_bits_ = 0;
+  }
 
-  // Pointer to the next unread (not in curr_byte_) byte in the stream.
+  // Pointer to the next byte in the stream not loaded into cache_.
   const uint8_t* data_;
 
   // Initial size of the input data.
   size_t initial_size_;
 
-  // Bytes left in the stream (without the curr_byte_).
+  // Bytes left in the stream (without the ones in cache_).
   size_t bytes_left_;
 
-  // Contents of the current byte; first unread bit starting at position
-  // 8 - num_remaining_bits_in_curr_byte_ from MSB.
-  uint8_t curr_byte_;
+  // Cached bits; first unread bit at the MSB. The bits after the first
+  // num_cached_bits_ bits are always zero.
+  uint64_t cache_;
 
-  // Number of bits remaining in curr_byte_
-  size_t num_remaining_bits_in_curr_byte_;
+  // Number of bits in cache_.
+  size_t num_cached_bits_;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(BitReader);
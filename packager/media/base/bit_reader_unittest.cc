@@ -114,5 +114,69 @@ TEST(BitReaderTest, SkipToNextByteTestUnaligned) {
   EXPECT_EQ(8u, reader.bit_position());
 }
 
+TEST(BitReaderTest, ReadFixedNumberOfBits) {
+  uint8_t buffer[] = {0x55, 0x99, 0x55, 0x99, 0x55, 0x99, 0x55, 0x99, 0xf0};
+  BitReader reader(buffer, sizeof(buffer));
+
+  bool flag = true;
+  uint8_t value8;
+  uint64_t value64;
+  EXPECT_TRUE(reader.ReadBits<1>(&flag));
+  EXPECT_FALSE(flag);
+  EXPECT_TRUE(reader.ReadBits<8>(&value8));
+  EXPECT_EQ(0xab, value8);
+  // Spans beyond the initially cached word.
+  EXPECT_TRUE(reader.ReadBits<56>(&value64));
+  EXPECT_EQ(0x32ab32ab32ab33u, value64);
+  EXPECT_EQ(65u, reader.bit_position());
+  EXPECT_TRUE(reader.ReadBits<3>(&value8));
+  EXPECT_EQ(7, value8);
+  EXPECT_FALSE(reader.ReadBits<5>(&value8));
+  EXPECT_EQ(0u, reader.bits_available());
+}
+
+TEST(BitReaderTest, ReadLeadingZeroBits) {
+  // 1, 01, 0000 0001, then 76 zero bits and a one bit, then 1.
+  uint8_t buffer[] = {0xa0, 0x20, 0x00, 0x00, 0x00, 0x00,
+                      0x00, 0x00, 0x00, 0x00, 0x01, 0x80};
+  BitReader reader(buffer, sizeof(buffer));
+
+  size_t num_zero_bits = 0;
+  EXPECT_TRUE(reader.ReadLeadingZeroBits(&num_zero_bits));
+  EXPECT_EQ(0u, num_zero_bits);
+  EXPECT_TRUE(reader.ReadLeadingZeroBits(&num_zero_bits));
+  EXPECT_EQ(1u, num_zero_bits);
+  EXPECT_TRUE(reader.ReadLeadingZeroBits(&num_zero_bits));
+  EXPECT_EQ(7u, num_zero_bits);
+  EXPECT_EQ(11u, reader.bit_position());
+  EXPECT_TRUE(reader.ReadLeadingZeroBits(&num_zero_bits));
+  EXPECT_EQ(76u, num_zero_bits);
+  EXPECT_EQ(88u, reader.bit_position());
+  EXPECT_TRUE(reader.ReadLeadingZeroBits(&num_zero_bits));
+  EXPECT_EQ(0u, num_zero_bits);
+  EXPECT_FALSE(reader.ReadLeadingZeroBits(&num_zero_bits));
+  EXPECT_EQ(0u, reader.bits_available());
+}
+
+TEST(BitReaderTest, CurrentBytePtr) {
+  uint8_t buffer[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  BitReader reader(buffer, sizeof(buffer));
+
+  EXPECT_EQ(buffer, reader.current_byte_ptr());
+  EXPECT_TRUE(reader.SkipBits(4));
+  EXPECT_EQ(buffer, reader.current_byte_ptr());
+  reader.SkipToNextByte();
+  EXPECT_EQ(buffer + 1, reader.current_byte_ptr());
+  EXPECT_TRUE(reader.SkipBytes(8));
+  EXPECT_EQ(buffer + 9, reader.current_byte_ptr());
+  uint8_t value8;
+  EXPECT_TRUE(reader.ReadBits<8>(&value8));
+  EXPECT_EQ(10, value8);
+  EXPECT_EQ(buffer + 10, reader.current_byte_ptr());
+  EXPECT_TRUE(reader.SkipBytes(2));
+  EXPECT_EQ(0u, reader.bits_available());
+  EXPECT_FALSE(reader.SkipBytes(1));
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -23,10 +23,15 @@ void BitWriter::WriteBits(uint32_t bits, size_t number_of_bits) {
   DCHECK_LE(num_bits_, 64);
   bits_ |= static_cast<uint64_t>(bits) << (64 - num_bits_);
 
-  while (num_bits_ >= 8) {
-    storage_->push_back(bits_ >> 56);
-    bits_ <<= 8;
-    num_bits_ -= 8;
+  // Write a whole word at a time, so there is always room for the next
+  // 32 bits in |bits_|.
+  if (num_bits_ >= 32) {
+    const uint8_t word[] = {
+        static_cast<uint8_t>(bits_ >> 56), static_cast<uint8_t>(bits_ >> 48),
+        static_cast<uint8_t>(bits_ >> 40), static_cast<uint8_t>(bits_ >> 32)};
+    storage_->insert(storage_->end(), word, word + sizeof(word));
+    bits_ <<= 32;
+    num_bits_ -= 32;
   }
 }
 
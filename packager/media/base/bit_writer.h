@@ -31,14 +31,18 @@ class BitWriter {
   ///        be zero.
   void WriteBits(uint32_t bits, size_t number_of_bits);
 
-  /// Write pending bits, and align bitstream with extra zero bits.
+  /// Write pending bits, and align bitstream with extra zero bits. The
+  /// storage is only complete after this is called.
   void Flush();
 
   /// @return last written position, in bits.
-  size_t BitPos() const { return BytePos() * 8 + num_bits_; }
+  size_t BitPos() const {
+    return (storage_->size() - initial_storage_size_) * 8 + num_bits_;
+  }
 
-  /// @return last written position, in bytes.
-  size_t BytePos() const { return storage_->size() - initial_storage_size_; }
+  /// @return last written position, in bytes. Pending whole bytes, which are
+  ///         written to the storage in words, are included.
+  size_t BytePos() const { return BitPos() / 8; }
 
  private:
   BitWriter(const BitWriter&) = delete;
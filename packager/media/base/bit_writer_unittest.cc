@@ -58,5 +58,21 @@ TEST(BitWriterTest, Test) {
                                          0x00, 0x00, 0x98}));
 }
 
+TEST(BitWriterTest, WriteWords) {
+  std::vector<uint8_t> storage = {0x01};
+  BitWriter writer(&storage);
+  writer.WriteBits(0x12345678, 32);
+  EXPECT_EQ(32u, writer.BitPos());
+  EXPECT_EQ(4u, writer.BytePos());
+  writer.WriteBits(0x9a, 8);
+  writer.WriteBits(0xbcd, 12);
+  EXPECT_EQ(52u, writer.BitPos());
+  EXPECT_EQ(6u, writer.BytePos());
+  writer.Flush();
+
+  EXPECT_THAT(storage, ElementsAreArray({0x01, 0x12, 0x34, 0x56, 0x78, 0x9a,
+                                         0xbc, 0xd0}));
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -6,6 +6,8 @@
 
 #include <packager/media/base/buffer_writer.h>
 
+#include <algorithm>
+
 #include <absl/base/internal/endian.h>
 #include <absl/log/check.h>
 #include <absl/log/log.h>
@@ -53,6 +55,17 @@ void BufferWriter::AppendNBytes(uint64_t v, size_t num_bytes) {
   AppendArray(&data[sizeof(v) - num_bytes], num_bytes);
 }
 
+void BufferWriter::OverwriteNBytes(size_t position,
+                                   uint64_t v,
+                                   size_t num_bytes) {
+  DCHECK_GE(sizeof(v), num_bytes);
+  DCHECK_LE(position + num_bytes, buf_.size());
+  v = absl::big_endian::FromHost64(v);
+  const uint8_t* data = reinterpret_cast<uint8_t*>(&v);
+  std::copy(&data[sizeof(v) - num_bytes], &data[sizeof(v)],
+            buf_.begin() + position);
+}
+
 void BufferWriter::AppendVector(const std::vector<uint8_t>& v) {
   buf_.insert(buf_.end(), v.begin(), v.end());
 }
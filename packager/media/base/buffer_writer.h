@@ -48,6 +48,12 @@ class BufferWriter {
   ///        64-bit system.
   void AppendNBytes(uint64_t v, size_t num_bytes);
 
+  /// Overwrite @a num_bytes already appended at @a position with the least
+  /// significant @a num_bytes of @a v. Used to patch sizes and offsets that
+  /// are only known after the data following them has been written.
+  /// @param position + @a num_bytes should not be larger than Size().
+  void OverwriteNBytes(size_t position, uint64_t v, size_t num_bytes);
+
   void AppendVector(const std::vector<uint8_t>& v);
   void AppendString(const std::string& s);
   void AppendArray(const uint8_t* buf, size_t size);
@@ -97,6 +97,20 @@ TEST_F(BufferWriterTest, AppendNBytes) {
   ReadAndExpect(static_cast<uint32_t>(kuint64 & 0xFFFFFFFF));
 }
 
+TEST_F(BufferWriterTest, OverwriteNBytes) {
+  writer_->AppendInt(kuint8);
+  writer_->AppendInt(static_cast<uint32_t>(0));
+  writer_->AppendInt(kuint16);
+  writer_->OverwriteNBytes(sizeof(kuint8), kuint32, sizeof(uint32_t));
+  ASSERT_EQ(sizeof(kuint8) + sizeof(uint32_t) + sizeof(kuint16),
+            writer_->Size());
+
+  CreateReader();
+  ReadAndExpect(kuint8);
+  ReadAndExpect(kuint32);
+  ReadAndExpect(kuint16);
+}
+
 TEST_F(BufferWriterTest, AppendEmptyVector) {
   std::vector<uint8_t> v;
   writer_->AppendVector(v);
@@ -21,16 +21,16 @@ Status CcStreamFilter::InitializeInternal() {
 
 Status CcStreamFilter::Process(std::unique_ptr<StreamData> stream_data) {
   if (stream_data->stream_data_type == StreamDataType::kTextSample) {
-    if (stream_data->text_sample->sub_stream_index() != -1 &&
-        stream_data->text_sample->sub_stream_index() != cc_index_) {
+    if (stream_data->text_sample()->sub_stream_index() != -1 &&
+        stream_data->text_sample()->sub_stream_index() != cc_index_) {
       return Status::OK;
     }
   } else if (stream_data->stream_data_type == StreamDataType::kStreamInfo) {
-    if (stream_data->stream_info->stream_type() == kStreamText) {
+    if (stream_data->stream_info()->stream_type() == kStreamText) {
       // Overwrite the per-input-stream language with our per-output-stream
       // language; this requires cloning the stream info as it is used by other
       // output streams.
-      auto clone = stream_data->stream_info->Clone();
+      auto clone = stream_data->stream_info()->Clone();
       if (!language_.empty()) {
         clone->set_language(language_);
       } else {
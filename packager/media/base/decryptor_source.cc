@@ -41,25 +41,83 @@ bool DecryptorSource::DecryptSampleBuffer(const DecryptConfig* decrypt_config,
   DCHECK(encrypted_buffer);
   DCHECK(decrypted_buffer);
 
-  if (CheckMemoryOverlap(encrypted_buffer, buffer_size, decrypted_buffer)) {
+  const bool in_place = encrypted_buffer == decrypted_buffer;
+  if (!in_place &&
+      CheckMemoryOverlap(encrypted_buffer, buffer_size, decrypted_buffer)) {
     LOG(ERROR) << "Encrypted buffer and decrypted buffer cannot overlap.";
     return false;
   }
 
-  // Get the decryptor object.
-  AesCryptor* decryptor = nullptr;
-  auto found = decryptor_map_.find(decrypt_config->key_id());
+  AesCryptor* decryptor = GetSampleDecryptor(*decrypt_config);
+  if (!decryptor)
+    return false;
+
+  if (decrypt_config->subsamples().empty()) {
+    // Sample not encrypted using subsample encryption. Decrypt whole.
+    if (!decryptor->Crypt(encrypted_buffer, buffer_size, decrypted_buffer)) {
+      LOG(ERROR) << "Error during bulk sample decryption.";
+      return false;
+    }
+    return true;
+  }
+
+  // Subsample decryption.
+  const std::vector<SubsampleEntry>& subsamples = decrypt_config->subsamples();
+  const uint8_t* current_ptr = encrypted_buffer;
+  const uint8_t* const buffer_end = encrypted_buffer + buffer_size;
+  for (const auto& subsample : subsamples) {
+    if ((current_ptr + subsample.clear_bytes + subsample.cipher_bytes) >
+        buffer_end) {
+      LOG(ERROR) << "Subsamples overflow sample buffer.";
+      return false;
+    }
+    if (!in_place)
+      memcpy(decrypted_buffer, current_ptr, subsample.clear_bytes);
+    current_ptr += subsample.clear_bytes;
+    decrypted_buffer += subsample.clear_bytes;
+    if (!decryptor->Crypt(current_ptr, subsample.cipher_bytes,
+                          decrypted_buffer)) {
+      LOG(ERROR) << "Error decrypting subsample buffer.";
+      return false;
+    }
+    current_ptr += subsample.cipher_bytes;
+    decrypted_buffer += subsample.cipher_bytes;
+  }
+  return true;
+}
+
+AesCryptor* DecryptorSource::GetSampleDecryptor(
+    const DecryptConfig& decrypt_config) {
+  AesCryptor* decryptor = GetDecryptor(decrypt_config);
+  if (!decryptor)
+    return nullptr;
+  if (!decryptor->SetIv(decrypt_config.iv())) {
+    LOG(ERROR) << "Invalid initialization vector.";
+    return nullptr;
+  }
+  return decryptor;
+}
+
+AesCryptor* DecryptorSource::GetDecryptor(const DecryptConfig& decrypt_config) {
+  const std::vector<uint8_t>& key_id = decrypt_config.key_id();
+  DecryptorCacheEntry& cache_entry =
+      decryptor_cache_[key_id.empty() ? 0
+                                      : key_id.back() % kDecryptorCacheSize];
+  if (cache_entry.key_id && *cache_entry.key_id == key_id)
+    return cache_entry.decryptor;
+
+  auto found = decryptor_map_.find(key_id);
   if (found == decryptor_map_.end()) {
     // Create new AesDecryptor based on decryption mode.
     EncryptionKey key;
-    Status status(key_source_->GetKey(decrypt_config->key_id(), &key));
+    Status status(key_source_->GetKey(key_id, &key));
     if (!status.ok()) {
       LOG(ERROR) << "Error retrieving decryption key: " << status;
-      return false;
+      return nullptr;
     }
 
     std::unique_ptr<AesCryptor> aes_decryptor;
-    switch (decrypt_config->protection_scheme()) {
+    switch (decrypt_config.protection_scheme()) {
       case FOURCC_cenc:
         aes_decryptor.reset(new AesCtrDecryptor);
         break;
@@ -68,71 +126,36 @@ bool DecryptorSource::DecryptSampleBuffer(const DecryptConfig* decrypt_config,
         break;
       case FOURCC_cens:
         aes_decryptor.reset(new AesPatternCryptor(
-            decrypt_config->crypt_byte_block(),
-            decrypt_config->skip_byte_block(),
+            decrypt_config.crypt_byte_block(),
+            decrypt_config.skip_byte_block(),
             AesPatternCryptor::kEncryptIfCryptByteBlockRemaining,
             AesCryptor::kDontUseConstantIv,
             std::unique_ptr<AesCryptor>(new AesCtrDecryptor())));
         break;
       case FOURCC_cbcs:
         aes_decryptor.reset(new AesPatternCryptor(
-            decrypt_config->crypt_byte_block(),
-            decrypt_config->skip_byte_block(),
+            decrypt_config.crypt_byte_block(),
+            decrypt_config.skip_byte_block(),
             AesPatternCryptor::kEncryptIfCryptByteBlockRemaining,
             AesCryptor::kUseConstantIv,
             std::unique_ptr<AesCryptor>(new AesCbcDecryptor(kNoPadding))));
         break;
       default:
         LOG(ERROR) << "Unsupported protection scheme: "
-                   << decrypt_config->protection_scheme();
-        return false;
+                   << decrypt_config.protection_scheme();
+        return nullptr;
     }
 
-    if (!aes_decryptor->InitializeWithIv(key.key, decrypt_config->iv())) {
+    if (!aes_decryptor->InitializeWithIv(key.key, decrypt_config.iv())) {
       LOG(ERROR) << "Failed to initialize AesDecryptor for decryption.";
-      return false;
+      return nullptr;
     }
-    decryptor = aes_decryptor.get();
-    decryptor_map_[decrypt_config->key_id()] = std::move(aes_decryptor);
-  } else {
-    decryptor = found->second.get();
-  }
-  if (!decryptor->SetIv(decrypt_config->iv())) {
-    LOG(ERROR) << "Invalid initialization vector.";
-    return false;
+    found = decryptor_map_.emplace(key_id, std::move(aes_decryptor)).first;
   }
 
-  if (decrypt_config->subsamples().empty()) {
-    // Sample not encrypted using subsample encryption. Decrypt whole.
-    if (!decryptor->Crypt(encrypted_buffer, buffer_size, decrypted_buffer)) {
-      LOG(ERROR) << "Error during bulk sample decryption.";
-      return false;
-    }
-    return true;
-  }
-
-  // Subsample decryption.
-  const std::vector<SubsampleEntry>& subsamples = decrypt_config->subsamples();
-  const uint8_t* current_ptr = encrypted_buffer;
-  const uint8_t* const buffer_end = encrypted_buffer + buffer_size;
-  for (const auto& subsample : subsamples) {
-    if ((current_ptr + subsample.clear_bytes + subsample.cipher_bytes) >
-        buffer_end) {
-      LOG(ERROR) << "Subsamples overflow sample buffer.";
-      return false;
-    }
-    memcpy(decrypted_buffer, current_ptr, subsample.clear_bytes);
-    current_ptr += subsample.clear_bytes;
-    decrypted_buffer += subsample.clear_bytes;
-    if (!decryptor->Crypt(current_ptr, subsample.cipher_bytes,
-                          decrypted_buffer)) {
-      LOG(ERROR) << "Error decrypting subsample buffer.";
-      return false;
-    }
-    current_ptr += subsample.cipher_bytes;
-    decrypted_buffer += subsample.cipher_bytes;
-  }
-  return true;
+  cache_entry.key_id = &found->first;
+  cache_entry.decryptor = found->second.get();
+  return cache_entry.decryptor;
 }
 
 }  // namespace media
@@ -7,6 +7,7 @@
 #ifndef PACKAGER_MEDIA_BASE_DECRYPTOR_SOURCE_H_
 #define PACKAGER_MEDIA_BASE_DECRYPTOR_SOURCE_H_
 
+#include <array>
 #include <map>
 #include <memory>
 #include <vector>
@@ -31,19 +32,44 @@ class DecryptorSource {
   /// @param decrypt_config contains decrypt configuration, e.g. protection
   ///        scheme, subsample information etc.
   /// @param encrypted_buffer points to the encrypted buffer that is to be
-  ///        decrypted. It should not overlap with @a decrypted_buffer.
+  ///        decrypted. It should either be the same as @a decrypted_buffer,
+  ///        to decrypt in place, or not overlap with it.
   /// @param buffer_size is the size of encrypted buffer and decrypted buffer.
-  /// @param decrypted_buffer points to the decrypted buffer. It should not
-  ///        overlap with @a encrypted_buffer.
+  /// @param decrypted_buffer points to the decrypted buffer. It should either
+  ///        be the same as @a encrypted_buffer or not overlap with it. Clear
+  ///        bytes are not copied when decrypting in place.
   /// @return true if success, false otherwise.
   bool DecryptSampleBuffer(const DecryptConfig* decrypt_config,
                            const uint8_t* encrypted_buffer,
                            size_t buffer_size,
                            uint8_t* decrypted_buffer);
 
+  /// Get the decryptor for a sample, for callers which decrypt the sample one
+  /// subsample at a time, e.g. to process each subsample while it is hot in
+  /// the cache. The subsamples must be decrypted in order.
+  /// @param decrypt_config contains decrypt configuration of the sample.
+  /// @return the decryptor, with its IV set to the sample IV, on success;
+  ///         nullptr otherwise. The decryptor is owned by this object.
+  AesCryptor* GetSampleDecryptor(const DecryptConfig& decrypt_config);
+
  private:
+  struct DecryptorCacheEntry {
+    // Points to the key in |decryptor_map_|.
+    const std::vector<uint8_t>* key_id = nullptr;
+    AesCryptor* decryptor = nullptr;
+  };
+
+  // Returns the decryptor for the key in |decrypt_config|, creating it if
+  // needed. Returns nullptr on failure.
+  AesCryptor* GetDecryptor(const DecryptConfig& decrypt_config);
+
   KeySource* key_source_;
   std::map<std::vector<uint8_t>, std::unique_ptr<AesCryptor>> decryptor_map_;
+  // Small direct-mapped cache in front of |decryptor_map_|, indexed by the
+  // last byte of the key ID, so that the map is not searched for every
+  // sample.
+  static constexpr size_t kDecryptorCacheSize = 8;
+  std::array<DecryptorCacheEntry, kDecryptorCacheSize> decryptor_cache_;
 
   DISALLOW_COPY_AND_ASSIGN(DecryptorSource);
 };
@@ -149,6 +149,63 @@ TEST_F(DecryptorSourceTest, SubsampleDecryption) {
       decrypted_buffer_);
 }
 
+TEST_F(DecryptorSourceTest, InPlaceSubsampleDecryption) {
+  EncryptionKey encryption_key;
+  encryption_key.key.assign(kMockKey, kMockKey + std::size(kMockKey));
+  EXPECT_CALL(mock_key_source_, GetKey(key_id_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(encryption_key), Return(Status::OK)));
+
+  const SubsampleEntry kSubsamples[] = {
+    {2, 3},
+    {3, 13},
+  };
+  // clang-format off
+  const uint8_t kExpectedDecryptedSubsampleBuffer[] = {
+    0x03, 0x04, 0xfb, 0xfb, 0x89, 0x08, 0x09, 0x0a,
+    0xb0, 0x1f, 0xdd, 0x09, 0x70, 0x5c, 0xfb, 0xd2,
+    0xfb, 0x18, 0x64, 0x16, 0xc9,
+  };
+  // clang-format on
+
+  DecryptConfig decrypt_config(
+      key_id_, std::vector<uint8_t>(kIv, kIv + std::size(kIv)),
+      std::vector<SubsampleEntry>(kSubsamples,
+                                  kSubsamples + std::size(kSubsamples)));
+  ASSERT_TRUE(decryptor_source_.DecryptSampleBuffer(
+      &decrypt_config, &encrypted_buffer_[0], encrypted_buffer_.size(),
+      &encrypted_buffer_[0]));
+  EXPECT_EQ(
+      std::vector<uint8_t>(kExpectedDecryptedSubsampleBuffer,
+                           kExpectedDecryptedSubsampleBuffer +
+                               std::size(kExpectedDecryptedSubsampleBuffer)),
+      encrypted_buffer_);
+}
+
+TEST_F(DecryptorSourceTest, SwitchBetweenKeys) {
+  EncryptionKey encryption_key;
+  encryption_key.key.assign(kMockKey, kMockKey + std::size(kMockKey));
+  // Another key id which maps to the same decryptor cache entry.
+  std::vector<uint8_t> key_id2 = key_id_;
+  key_id2.back() += 8;
+  EXPECT_CALL(mock_key_source_, GetKey(key_id_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(encryption_key), Return(Status::OK)));
+  EXPECT_CALL(mock_key_source_, GetKey(key_id2, _))
+      .WillOnce(DoAll(SetArgPointee<1>(encryption_key), Return(Status::OK)));
+
+  const std::vector<uint8_t> iv(kIv, kIv + std::size(kIv));
+  const std::vector<uint8_t> expected(
+      kExpectedDecryptedBuffer,
+      kExpectedDecryptedBuffer + std::size(kExpectedDecryptedBuffer));
+  // No GetKey call again when switching back to a key id.
+  for (const auto& key_id : {key_id_, key_id2, key_id_, key_id2}) {
+    DecryptConfig decrypt_config(key_id, iv, std::vector<SubsampleEntry>());
+    ASSERT_TRUE(decryptor_source_.DecryptSampleBuffer(
+        &decrypt_config, &encrypted_buffer_[0], encrypted_buffer_.size(),
+        &decrypted_buffer_[0]));
+    EXPECT_EQ(expected, decrypted_buffer_);
+  }
+}
+
 TEST_F(DecryptorSourceTest, SubsampleDecryptionSizeValidation) {
   EncryptionKey encryption_key;
   encryption_key.key.assign(kMockKey, kMockKey + std::size(kMockKey));
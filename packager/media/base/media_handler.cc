@@ -6,6 +6,11 @@
 
 #include <packager/media/base/media_handler.h>
 
+#include <algorithm>
+#include <iterator>
+
+#include <absl/log/check.h>
+
 #include <packager/macros/status.h>
 
 namespace shaka {
@@ -91,7 +96,17 @@ bool MediaHandler::ValidateOutputStreamIndex(size_t stream_index) const {
   return stream_index < num_input_streams_;
 }
 
+Status MediaHandler::ProcessBatch(StreamDataBatch batch) {
+  for (auto& stream_data : batch)
+    RETURN_IF_ERROR(Process(std::move(stream_data)));
+  return Status::OK;
+}
+
 Status MediaHandler::Dispatch(std::unique_ptr<StreamData> stream_data) const {
+  if (batch_dispatch_) {
+    dispatch_batch_.push_back(std::move(stream_data));
+    return Status::OK;
+  }
   size_t output_stream_index = stream_data->stream_index;
   auto handler_it = output_handlers_.find(output_stream_index);
   if (handler_it == output_handlers_.end()) {
@@ -102,6 +117,52 @@ Status MediaHandler::Dispatch(std::unique_ptr<StreamData> stream_data) const {
   return handler_it->second.first->Process(std::move(stream_data));
 }
 
+Status MediaHandler::DispatchBatch(StreamDataBatch batch) const {
+  if (batch.empty())
+    return Status::OK;
+  size_t output_stream_index = batch.front()->stream_index;
+  auto handler_it = output_handlers_.find(output_stream_index);
+  if (handler_it == output_handlers_.end()) {
+    return Status(error::NOT_FOUND,
+                  "No output handler exist at the specified index.");
+  }
+  for (auto& stream_data : batch) {
+    DCHECK_EQ(stream_data->stream_index, output_stream_index);
+    stream_data->stream_index = handler_it->second.second;
+  }
+  return handler_it->second.first->ProcessBatch(std::move(batch));
+}
+
+void MediaHandler::StartBatchDispatch() {
+  DCHECK(!batch_dispatch_);
+  DCHECK(dispatch_batch_.empty());
+  batch_dispatch_ = true;
+}
+
+Status MediaHandler::FinishBatchDispatch() {
+  batch_dispatch_ = false;
+  StreamDataBatch batch;
+  batch.swap(dispatch_batch_);
+
+  auto run_begin = batch.begin();
+  while (run_begin != batch.end()) {
+    const size_t stream_index = (*run_begin)->stream_index;
+    auto run_end = std::find_if(run_begin, batch.end(),
+                                [stream_index](const auto& stream_data) {
+                                  return stream_data->stream_index !=
+                                         stream_index;
+                                });
+    // Avoid copying the batch in the common case of a single output stream.
+    if (run_begin == batch.begin() && run_end == batch.end())
+      return DispatchBatch(std::move(batch));
+    RETURN_IF_ERROR(DispatchBatch(
+        StreamDataBatch(std::make_move_iterator(run_begin),
+                        std::make_move_iterator(run_end))));
+    run_begin = run_end;
+  }
+  return Status::OK;
+}
+
 Status MediaHandler::FlushDownstream(size_t output_stream_index) {
   auto handler_it = output_handlers_.find(output_stream_index);
   if (handler_it == output_handlers_.end()) {
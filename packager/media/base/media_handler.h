@@ -10,6 +10,10 @@
 #include <map>
 #include <memory>
 #include <utility>
+#include <variant>
+#include <vector>
+
+#include <absl/log/check.h>
 
 #include <packager/media/base/media_sample.h>
 #include <packager/media/base/stream_info.h>
@@ -66,78 +70,119 @@ struct SegmentInfo {
 };
 
 // TODO(kqyang): Should we use protobuf?
+/// StreamData carries one payload, whose type is given by |stream_data_type|.
+/// A StreamData is allocated for every sample at every handler hop, so the
+/// payload is stored in a tagged union to keep the object small.
 struct StreamData {
   size_t stream_index = static_cast<size_t>(-1);
   StreamDataType stream_data_type = StreamDataType::kUnknown;
 
-  std::shared_ptr<const StreamInfo> stream_info;
-  std::shared_ptr<const MediaSample> media_sample;
-  std::shared_ptr<const TextSample> text_sample;
-  std::shared_ptr<const SegmentInfo> segment_info;
-  std::shared_ptr<const Scte35Event> scte35_event;
-  std::shared_ptr<const CueEvent> cue_event;
+  /// @name Payload accessors. They return null if the payload is of another
+  ///       type.
+  /// @{
+  const std::shared_ptr<const StreamInfo>& stream_info() const {
+    return Get<StreamInfo>();
+  }
+  const std::shared_ptr<const MediaSample>& media_sample() const {
+    return Get<MediaSample>();
+  }
+  const std::shared_ptr<const TextSample>& text_sample() const {
+    return Get<TextSample>();
+  }
+  const std::shared_ptr<const SegmentInfo>& segment_info() const {
+    return Get<SegmentInfo>();
+  }
+  const std::shared_ptr<const Scte35Event>& scte35_event() const {
+    return Get<Scte35Event>();
+  }
+  const std::shared_ptr<const CueEvent>& cue_event() const {
+    return Get<CueEvent>();
+  }
+  /// @}
+
+  /// Moves the payload of type T out of this StreamData, which avoids the
+  /// reference count updates of a copy when handing the payload off.
+  template <typename T>
+  std::shared_ptr<const T> Take() {
+    auto* payload = std::get_if<std::shared_ptr<const T>>(&payload_);
+    DCHECK(payload);
+    return payload ? std::move(*payload) : nullptr;
+  }
 
   static std::unique_ptr<StreamData> FromStreamInfo(
       size_t stream_index,
       std::shared_ptr<const StreamInfo> stream_info) {
-    std::unique_ptr<StreamData> stream_data(new StreamData);
-    stream_data->stream_index = stream_index;
-    stream_data->stream_data_type = StreamDataType::kStreamInfo;
-    stream_data->stream_info = std::move(stream_info);
-    return stream_data;
+    return Create(stream_index, StreamDataType::kStreamInfo,
+                  std::move(stream_info));
   }
 
   static std::unique_ptr<StreamData> FromMediaSample(
       size_t stream_index,
       std::shared_ptr<const MediaSample> media_sample) {
-    std::unique_ptr<StreamData> stream_data(new StreamData);
-    stream_data->stream_index = stream_index;
-    stream_data->stream_data_type = StreamDataType::kMediaSample;
-    stream_data->media_sample = std::move(media_sample);
-    return stream_data;
+    return Create(stream_index, StreamDataType::kMediaSample,
+                  std::move(media_sample));
   }
 
   static std::unique_ptr<StreamData> FromTextSample(
       size_t stream_index,
       std::shared_ptr<const TextSample> text_sample) {
-    std::unique_ptr<StreamData> stream_data(new StreamData);
-    stream_data->stream_index = stream_index;
-    stream_data->stream_data_type = StreamDataType::kTextSample;
-    stream_data->text_sample = std::move(text_sample);
-    return stream_data;
+    return Create(stream_index, StreamDataType::kTextSample,
+                  std::move(text_sample));
   }
 
   static std::unique_ptr<StreamData> FromSegmentInfo(
       size_t stream_index,
       std::shared_ptr<const SegmentInfo> segment_info) {
-    std::unique_ptr<StreamData> stream_data(new StreamData);
-    stream_data->stream_index = stream_index;
-    stream_data->stream_data_type = StreamDataType::kSegmentInfo;
-    stream_data->segment_info = std::move(segment_info);
-    return stream_data;
+    return Create(stream_index, StreamDataType::kSegmentInfo,
+                  std::move(segment_info));
   }
 
   static std::unique_ptr<StreamData> FromScte35Event(
       size_t stream_index,
       std::shared_ptr<const Scte35Event> scte35_event) {
-    std::unique_ptr<StreamData> stream_data(new StreamData);
-    stream_data->stream_index = stream_index;
-    stream_data->stream_data_type = StreamDataType::kScte35Event;
-    stream_data->scte35_event = std::move(scte35_event);
-    return stream_data;
+    return Create(stream_index, StreamDataType::kScte35Event,
+                  std::move(scte35_event));
   }
 
   static std::unique_ptr<StreamData> FromCueEvent(
       size_t stream_index,
       std::shared_ptr<const CueEvent> cue_event) {
+    return Create(stream_index, StreamDataType::kCueEvent,
+                  std::move(cue_event));
+  }
+
+ private:
+  template <typename T>
+  static std::unique_ptr<StreamData> Create(size_t stream_index,
+                                            StreamDataType stream_data_type,
+                                            std::shared_ptr<const T> payload) {
     std::unique_ptr<StreamData> stream_data(new StreamData);
     stream_data->stream_index = stream_index;
-    stream_data->stream_data_type = StreamDataType::kCueEvent;
-    stream_data->cue_event = std::move(cue_event);
+    stream_data->stream_data_type = stream_data_type;
+    stream_data->payload_ = std::move(payload);
     return stream_data;
   }
+
+  template <typename T>
+  const std::shared_ptr<const T>& Get() const {
+    static const std::shared_ptr<const T> kNull;
+    const auto* payload = std::get_if<std::shared_ptr<const T>>(&payload_);
+    return payload ? *payload : kNull;
+  }
+
+  std::variant<std::monostate,
+               std::shared_ptr<const StreamInfo>,
+               std::shared_ptr<const MediaSample>,
+               std::shared_ptr<const TextSample>,
+               std::shared_ptr<const SegmentInfo>,
+               std::shared_ptr<const Scte35Event>,
+               std::shared_ptr<const CueEvent>>
+      payload_;
 };
 
+/// A run of stream data for the same stream, processed in one call.
+typedef std::vector<std::unique_ptr<StreamData>> StreamDataBatch;
+
 /// MediaHandler is the base media processing unit. Media handlers transform
 /// the input streams and propagate the outputs to downstream media handlers.
 /// There are three different types of media handlers:
@@ -187,6 +232,12 @@ class MediaHandler {
   /// handlers after finishing processing if needed.
   virtual Status Process(std::unique_ptr<StreamData> stream_data) = 0;
 
+  /// Process a batch of incoming stream data, which all have the same input
+  /// stream index. The default implementation calls Process on each of them.
+  /// Handlers on the hot path override it to amortize the per stream data
+  /// overhead, e.g. with StartBatchDispatch and FinishBatchDispatch.
+  virtual Status ProcessBatch(StreamDataBatch batch);
+
   /// Event handler for flush request at the specific input stream index.
   virtual Status OnFlushRequest(size_t input_stream_index);
 
@@ -197,6 +248,21 @@ class MediaHandler {
   /// stream_data.stream_index should be the output stream index.
   Status Dispatch(std::unique_ptr<StreamData> stream_data) const;
 
+  /// Dispatch a batch of stream data to downstream handlers in one call. Note
+  /// that all stream_data.stream_index in @a batch should be the same output
+  /// stream index.
+  Status DispatchBatch(StreamDataBatch batch) const;
+
+  /// Collect the stream data dispatched from now on instead of dispatching
+  /// them right away. The collected stream data are dispatched by
+  /// FinishBatchDispatch, with one DispatchBatch per run of stream data for
+  /// the same output stream, which preserves the dispatch order.
+  void StartBatchDispatch();
+
+  /// Dispatch the stream data collected since StartBatchDispatch and resume
+  /// dispatching stream data right away.
+  Status FinishBatchDispatch();
+
   /// Dispatch the stream info to downstream handlers.
   Status DispatchStreamInfo(
       size_t stream_index,
@@ -268,6 +334,10 @@ class MediaHandler {
   size_t num_input_streams_ = 0;
   // The next available output stream index, used by AddHandler.
   size_t next_output_stream_index_ = 0;
+  // Set between StartBatchDispatch and FinishBatchDispatch.
+  bool batch_dispatch_ = false;
+  // Stream data collected by Dispatch while |batch_dispatch_| is set.
+  mutable StreamDataBatch dispatch_batch_;
   // output stream index -> {output handler, output handler input stream index}
   // map.
   std::map<size_t, std::pair<std::shared_ptr<MediaHandler>, size_t>>
@@ -0,0 +1,115 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Measures the cost of passing media samples through a handler graph, i.e.
+// the allocation, dispatch and release of StreamData. It is only built with
+// -DBUILD_BENCHMARKS=ON and is not run by ctest; run media_handler_benchmark
+// from an optimized build with --gtest_output=xml to get the timings, which
+// are recorded as test properties.
+
+#include <chrono>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <packager/media/base/media_handler.h>
+#include <packager/media/base/media_sample.h>
+#include <packager/media/replicator/replicator.h>
+#include <packager/status/status_test_util.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kStreamIndex = 0;
+const size_t kNumPassThroughHandlers = 3;
+const size_t kNumOutputs = 3;
+const int kNumSamples = 2000000;
+const int kNumRuns = 3;
+const size_t kMaxQueuedStreamData = 16;
+
+class InputHandler : public MediaHandler {
+ public:
+  using MediaHandler::Dispatch;
+  using MediaHandler::FlushAllDownstreams;
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+  Status Process(std::unique_ptr<StreamData>) override { return Status::OK; }
+  bool ValidateOutputStreamIndex(size_t) const override { return true; }
+};
+
+class PassThroughHandler : public MediaHandler {
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    return Dispatch(std::move(stream_data));
+  }
+};
+
+class SinkHandler : public MediaHandler {
+ public:
+  int num_samples() const { return num_samples_; }
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    if (stream_data->stream_data_type == StreamDataType::kMediaSample)
+      ++num_samples_;
+    return Status::OK;
+  }
+  Status OnFlushRequest(size_t) override { return Status::OK; }
+
+  int num_samples_ = 0;
+};
+
+}  // namespace
+
+// The parameter is the number of messages queued for each output of the
+// Replicator. With a queue, the StreamData are allocated on the input thread
+// and released on the output threads.
+class MediaHandlerBenchmark : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(MediaHandlerBenchmark, DispatchMediaSamples) {
+  auto input = std::make_shared<InputHandler>();
+  std::vector<std::shared_ptr<MediaHandler>> handlers = {input};
+  for (size_t i = 0; i < kNumPassThroughHandlers; ++i)
+    handlers.push_back(std::make_shared<PassThroughHandler>());
+  auto replicator = std::make_shared<Replicator>(GetParam());
+  handlers.push_back(replicator);
+  ASSERT_OK(MediaHandler::Chain(handlers));
+  std::vector<std::shared_ptr<SinkHandler>> sinks;
+  for (size_t i = 0; i < kNumOutputs; ++i) {
+    sinks.push_back(std::make_shared<SinkHandler>());
+    ASSERT_OK(replicator->AddHandler(sinks.back()));
+  }
+  ASSERT_OK(input->Initialize());
+
+  std::shared_ptr<MediaSample> sample = MediaSample::CreateEOSBuffer();
+  for (int run = 0; run < kNumRuns; ++run) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kNumSamples; ++i)
+      ASSERT_OK(input->Dispatch(StreamData::FromMediaSample(kStreamIndex,
+                                                            sample)));
+    const auto end = std::chrono::steady_clock::now();
+    const auto ns_per_sample =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+            .count() /
+        kNumSamples;
+    RecordProperty("ns_per_sample_run_" + std::to_string(run),
+                   static_cast<int>(ns_per_sample));
+  }
+  ASSERT_OK(input->FlushAllDownstreams());
+  for (const auto& sink : sinks)
+    EXPECT_EQ(kNumRuns * kNumSamples, sink->num_samples());
+}
+
+INSTANTIATE_TEST_SUITE_P(SynchronousAndParallel,
+                         MediaHandlerBenchmark,
+                         ::testing::Values(0u, kMaxQueuedStreamData));
+
+}  // namespace media
+}  // namespace shaka
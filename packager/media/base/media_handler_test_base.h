@@ -61,20 +61,20 @@ MATCHER_P4(IsStreamInfo, stream_index, time_scale, encrypted, language, "") {
   }
 
   const std::string is_encrypted_string =
-      BoolToString(arg->stream_info->is_encrypted());
+      BoolToString(arg->stream_info()->is_encrypted());
 
   *result_listener << "which is (" << arg->stream_index << ", "
-                   << arg->stream_info->time_scale() << ", "
+                   << arg->stream_info()->time_scale() << ", "
                    << is_encrypted_string << ", "
-                   << arg->stream_info->language() << ")";
+                   << arg->stream_info()->language() << ")";
 
   return TryMatch(arg->stream_index, stream_index, result_listener,
                   "stream_index") &&
-         TryMatch(arg->stream_info->time_scale(), time_scale, result_listener,
+         TryMatch(arg->stream_info()->time_scale(), time_scale, result_listener,
                   "time_scale") &&
-         TryMatch(arg->stream_info->is_encrypted(), encrypted, result_listener,
-                  "is_encrypted") &&
-         TryMatch(arg->stream_info->language(), language, result_listener,
+         TryMatch(arg->stream_info()->is_encrypted(), encrypted,
+                  result_listener, "is_encrypted") &&
+         TryMatch(arg->stream_info()->language(), language, result_listener,
                   "language");
 }
 
@@ -84,13 +84,13 @@ MATCHER_P3(IsVideoStream, stream_index, trick_play_factor, playback_rate, "") {
     return false;
   }
 
-  if (!TryMatchStreamType(arg->stream_info->stream_type(), kStreamVideo,
+  if (!TryMatchStreamType(arg->stream_info()->stream_type(), kStreamVideo,
                           result_listener)) {
     return false;
   }
 
   const VideoStreamInfo* info =
-      static_cast<const VideoStreamInfo*>(arg->stream_info.get());
+      static_cast<const VideoStreamInfo*>(arg->stream_info().get());
 
   *result_listener << "which is (" << arg->stream_index << ", "
                    << info->trick_play_factor() << ", " << info->playback_rate()
@@ -117,25 +117,25 @@ MATCHER_P5(IsSegmentInfo,
   }
 
   const std::string is_subsegment_string =
-      BoolToString(arg->segment_info->is_subsegment);
+      BoolToString(arg->segment_info()->is_subsegment);
   const std::string is_encrypted_string =
-      BoolToString(arg->segment_info->is_encrypted);
+      BoolToString(arg->segment_info()->is_encrypted);
 
   *result_listener << "which is (" << arg->stream_index << ", "
-                   << arg->segment_info->start_timestamp << ", "
-                   << arg->segment_info->duration << ", "
+                   << arg->segment_info()->start_timestamp << ", "
+                   << arg->segment_info()->duration << ", "
                    << is_subsegment_string << ", " << is_encrypted_string
                    << ")";
 
   return TryMatch(arg->stream_index, stream_index, result_listener,
                   "stream_index") &&
-         TryMatch(arg->segment_info->start_timestamp, start_timestamp,
+         TryMatch(arg->segment_info()->start_timestamp, start_timestamp,
                   result_listener, "start_timestamp") &&
-         TryMatch(arg->segment_info->duration, duration, result_listener,
+         TryMatch(arg->segment_info()->duration, duration, result_listener,
                   "duration") &&
-         TryMatch(arg->segment_info->is_subsegment, subsegment, result_listener,
-                  "is_subsegment") &&
-         TryMatch(arg->segment_info->is_encrypted, encrypted, result_listener,
+         TryMatch(arg->segment_info()->is_subsegment, subsegment,
+                  result_listener, "is_subsegment") &&
+         TryMatch(arg->segment_info()->is_encrypted, encrypted, result_listener,
                   "is_encrypted");
 }
 
@@ -189,25 +189,25 @@ MATCHER_P5(IsMediaSample,
   }
 
   const std::string is_encrypted_string =
-      BoolToString(arg->media_sample->is_encrypted());
+      BoolToString(arg->media_sample()->is_encrypted());
   const std::string is_key_frame_string =
-      BoolToString(arg->media_sample->is_key_frame());
+      BoolToString(arg->media_sample()->is_key_frame());
 
   *result_listener << "which is (" << arg->stream_index << ", "
-                   << arg->media_sample->dts() << ", "
-                   << arg->media_sample->duration() << ", "
+                   << arg->media_sample()->dts() << ", "
+                   << arg->media_sample()->duration() << ", "
                    << is_encrypted_string << ", " << is_key_frame_string << ")";
 
   return TryMatch(arg->stream_index, stream_index, result_listener,
                   "stream_index") &&
-         TryMatch(arg->media_sample->dts(), timestamp, result_listener,
+         TryMatch(arg->media_sample()->dts(), timestamp, result_listener,
                   "dts") &&
-         TryMatch(arg->media_sample->duration(), duration, result_listener,
+         TryMatch(arg->media_sample()->duration(), duration, result_listener,
                   "duration") &&
-         TryMatch(arg->media_sample->is_encrypted(), encrypted, result_listener,
-                  "is_encrypted") &&
-         TryMatch(arg->media_sample->is_key_frame(), keyframe, result_listener,
-                  "is_key_frame");
+         TryMatch(arg->media_sample()->is_encrypted(), encrypted,
+                  result_listener, "is_encrypted") &&
+         TryMatch(arg->media_sample()->is_key_frame(), keyframe,
+                  result_listener, "is_key_frame");
 }
 
 MATCHER_P4(IsTextSample, stream_index, id, start_time, end_time, "") {
@@ -217,16 +217,16 @@ MATCHER_P4(IsTextSample, stream_index, id, start_time, end_time, "") {
   }
 
   *result_listener << "which is (" << arg->stream_index << ", "
-                   << ToPrettyString(arg->text_sample->id()) << ", "
-                   << arg->text_sample->start_time() << ", "
-                   << arg->text_sample->EndTime() << ")";
+                   << ToPrettyString(arg->text_sample()->id()) << ", "
+                   << arg->text_sample()->start_time() << ", "
+                   << arg->text_sample()->EndTime() << ")";
 
   return TryMatch(arg->stream_index, stream_index, result_listener,
                   "stream_index") &&
-         TryMatch(arg->text_sample->id(), id, result_listener, "id") &&
-         TryMatch(arg->text_sample->start_time(), start_time, result_listener,
+         TryMatch(arg->text_sample()->id(), id, result_listener, "id") &&
+         TryMatch(arg->text_sample()->start_time(), start_time, result_listener,
                   "start_time") &&
-         TryMatch(arg->text_sample->EndTime(), end_time, result_listener,
+         TryMatch(arg->text_sample()->EndTime(), end_time, result_listener,
                   "EndTime");
 }
 
@@ -237,17 +237,18 @@ MATCHER_P2(IsCueEvent, stream_index, time_in_seconds, "") {
   }
 
   *result_listener << "which is (" << arg->stream_index << ", "
-                   << arg->cue_event->time_in_seconds << ")";
+                   << arg->cue_event()->time_in_seconds << ")";
 
   return TryMatch(arg->stream_index, stream_index, result_listener,
                   "stream_index") &&
-         TryMatch(arg->cue_event->time_in_seconds, time_in_seconds,
+         TryMatch(arg->cue_event()->time_in_seconds, time_in_seconds,
                   result_listener, "time_in_seconds");
 }
 
 class FakeInputMediaHandler : public MediaHandler {
  public:
   using MediaHandler::Dispatch;
+  using MediaHandler::DispatchBatch;
   using MediaHandler::FlushAllDownstreams;
   using MediaHandler::FlushDownstream;
 
@@ -0,0 +1,64 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/base/media_handler.h>
+
+#include <gtest/gtest.h>
+
+namespace shaka {
+namespace media {
+namespace {
+const size_t kStreamIndex = 2;
+const double kCueTime = 12.5;
+}  // namespace
+
+TEST(StreamDataTest, PayloadOfOtherTypesIsNull) {
+  std::shared_ptr<const CueEvent> cue_event(
+      new CueEvent{CueEventType::kCuePoint, kCueTime, ""});
+  auto stream_data = StreamData::FromCueEvent(kStreamIndex, cue_event);
+
+  EXPECT_EQ(kStreamIndex, stream_data->stream_index);
+  EXPECT_EQ(StreamDataType::kCueEvent, stream_data->stream_data_type);
+  EXPECT_EQ(cue_event, stream_data->cue_event());
+  EXPECT_FALSE(stream_data->stream_info());
+  EXPECT_FALSE(stream_data->media_sample());
+  EXPECT_FALSE(stream_data->text_sample());
+  EXPECT_FALSE(stream_data->segment_info());
+  EXPECT_FALSE(stream_data->scte35_event());
+}
+
+TEST(StreamDataTest, CopySharesPayload) {
+  std::shared_ptr<const SegmentInfo> segment_info(new SegmentInfo);
+  auto stream_data = StreamData::FromSegmentInfo(kStreamIndex, segment_info);
+  std::unique_ptr<StreamData> copy(new StreamData(*stream_data));
+
+  EXPECT_EQ(StreamDataType::kSegmentInfo, copy->stream_data_type);
+  EXPECT_EQ(segment_info, copy->segment_info());
+  EXPECT_EQ(segment_info, stream_data->segment_info());
+  EXPECT_EQ(3, segment_info.use_count());
+}
+
+TEST(StreamDataTest, Take) {
+  std::shared_ptr<const Scte35Event> scte35_event(new Scte35Event);
+  auto stream_data = StreamData::FromScte35Event(kStreamIndex, scte35_event);
+
+  EXPECT_EQ(scte35_event, stream_data->Take<Scte35Event>());
+  EXPECT_FALSE(stream_data->scte35_event());
+  EXPECT_EQ(1, scte35_event.use_count());
+}
+
+TEST(StreamDataTest, ReusesFreedStreamData) {
+  std::shared_ptr<const CueEvent> cue_event(new CueEvent);
+  auto stream_data = StreamData::FromCueEvent(kStreamIndex, cue_event);
+  const StreamData* freed = stream_data.get();
+  stream_data.reset();
+
+  stream_data = StreamData::FromCueEvent(kStreamIndex, cue_event);
+  EXPECT_EQ(freed, stream_data.get());
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -7,6 +7,7 @@
 #ifndef PACKAGER_MEDIA_BASE_MEDIA_PARSER_H_
 #define PACKAGER_MEDIA_BASE_MEDIA_PARSER_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -77,6 +78,22 @@ class MediaParser {
   /// @return true if successful.
   [[nodiscard]] virtual bool Parse(const uint8_t* buf, int size) = 0;
 
+  /// Can be called from the new sample callback.
+  /// @return the offset in the input of the data of the sample being passed
+  ///         to the callback, or a negative value if the sample data is not
+  ///         stored as is in the input, e.g. when it is reassembled from
+  ///         transport stream packets.
+  virtual int64_t GetCurrentSampleOffset() const { return -1; }
+
+  /// Can be called from the init callback.
+  /// @param[out] data is set to the container header the stream info is
+  ///             parsed from, e.g. the 'moov' box of an MP4 input.
+  /// @param[out] size is set to the size of the header.
+  /// @return false if the header is not available.
+  virtual bool GetCurrentHeader(const uint8_t** data, size_t* size) const {
+    return false;
+  }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(MediaParser);
 };
@@ -98,6 +98,7 @@ std::shared_ptr<MediaSample> MediaSample::Clone() const {
         decrypt_config_->crypt_byte_block(),
         decrypt_config_->skip_byte_block()));
   }
+  new_media_sample->subsample_layout_ = subsample_layout();
   return new_media_sample;
 }
 
@@ -105,6 +106,7 @@ void MediaSample::TransferData(std::shared_ptr<uint8_t> data,
                                size_t data_size) {
   data_ = std::move(data);
   data_size_ = data_size;
+  set_subsample_layout(nullptr);
 }
 
 void MediaSample::SetData(const uint8_t* data, size_t data_size) {
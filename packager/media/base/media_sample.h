@@ -21,6 +21,22 @@
 namespace shaka {
 namespace media {
 
+/// Layout of the clear bitstream of a sample, as found by parsing it for
+/// subsample encryption: which byte ranges must stay in the clear, e.g. NAL
+/// unit and slice headers, and which can be protected. Protection scheme
+/// specific constraints, e.g. AES block alignment, are not applied yet, so the
+/// layout can be shared by all the encryption stages of a sample.
+struct SubsampleLayout {
+  struct Range {
+    size_t clear_bytes = 0;
+    size_t protectable_bytes = 0;
+  };
+  std::vector<Range> ranges;
+  /// Whether the sample contains parameter sets, which update the state of
+  /// the parser used to find the ranges.
+  bool has_parameter_sets = false;
+};
+
 /// Class to hold a media sample.
 class MediaSample {
  public:
@@ -145,6 +161,22 @@ class MediaSample {
     decrypt_config_ = std::move(decrypt_config);
   }
 
+  /// @return the layout attached to the sample data by an encryption stage,
+  ///         or nullptr if there is none.
+  std::shared_ptr<const SubsampleLayout> subsample_layout() const {
+    return std::atomic_load(&subsample_layout_);
+  }
+
+  /// Attach the subsample layout of the sample data, so that other encryption
+  /// stages do not need to parse it again. The layout is metadata about the
+  /// data rather than part of the sample, so it can be attached to a shared
+  /// sample, e.g. by encryption stages on different outputs of a Replicator,
+  /// which may run on different threads. It is dropped if the data changes.
+  void set_subsample_layout(
+      std::shared_ptr<const SubsampleLayout> subsample_layout) const {
+    std::atomic_store(&subsample_layout_, std::move(subsample_layout));
+  }
+
   // If there's no data in this buffer, it represents end of stream.
   bool end_of_stream() const { return data_size_ == 0; }
 
@@ -190,6 +222,9 @@ class MediaSample {
   // Decrypt configuration.
   std::unique_ptr<DecryptConfig> decrypt_config_;
 
+  // Subsample layout of |data_|. Accessed atomically.
+  mutable std::shared_ptr<const SubsampleLayout> subsample_layout_;
+
   DISALLOW_COPY_AND_ASSIGN(MediaSample);
 };
 
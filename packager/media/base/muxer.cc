@@ -49,15 +49,19 @@ Status Muxer::Process(std::unique_ptr<StreamData> stream_data) {
   Status status;
   switch (stream_data->stream_data_type) {
     case StreamDataType::kStreamInfo:
-      streams_.push_back(std::move(stream_data->stream_info));
+      streams_.push_back(stream_data->Take<StreamInfo>());
       return ReinitializeMuxer(kStartTime);
     case StreamDataType::kSegmentInfo: {
-      const auto& segment_info = *stream_data->segment_info;
+      const auto& segment_info = *stream_data->segment_info();
       if (muxer_listener_ && segment_info.is_encrypted) {
         const EncryptionConfig* encryption_config =
             segment_info.key_rotation_encryption_config.get();
+        const bool key_updated =
+            encryption_config && encryption_config->key_id != current_key_id_;
+        if (key_updated || !encryption_started_)
+          RETURN_IF_ERROR(FlushPendingSegments());
         // Only call OnEncryptionInfoReady again when key updates.
-        if (encryption_config && encryption_config->key_id != current_key_id_) {
+        if (key_updated) {
           muxer_listener_->OnEncryptionInfoReady(
               !kInitialEncryptionInfo, encryption_config->protection_scheme,
               encryption_config->key_id, encryption_config->constant_iv,
@@ -73,19 +77,21 @@ Status Muxer::Process(std::unique_ptr<StreamData> stream_data) {
     }
     case StreamDataType::kMediaSample:
       return AddMediaSample(stream_data->stream_index,
-                            *stream_data->media_sample);
+                            *stream_data->media_sample());
     case StreamDataType::kTextSample:
       return AddTextSample(stream_data->stream_index,
-                           *stream_data->text_sample);
+                           *stream_data->text_sample());
     case StreamDataType::kCueEvent:
       if (muxer_listener_) {
+        RETURN_IF_ERROR(FlushPendingSegments());
         const int64_t time_scale =
             streams_[stream_data->stream_index]->time_scale();
-        const double time_in_seconds = stream_data->cue_event->time_in_seconds;
+        const double time_in_seconds =
+            stream_data->cue_event()->time_in_seconds;
         const int64_t scaled_time =
             static_cast<int64_t>(time_in_seconds * time_scale);
         muxer_listener_->OnCueEvent(scaled_time,
-                                    stream_data->cue_event->cue_data);
+                                    stream_data->cue_event()->cue_data);
 
         // Finalize and re-initialize Muxer to generate different content files.
         if (!output_file_template_.empty()) {
@@ -120,6 +126,10 @@ Status Muxer::AddTextSample(size_t stream_id, const TextSample& sample) {
   return Status::OK;
 }
 
+Status Muxer::FlushPendingSegments() {
+  return Status::OK;
+}
+
 Status Muxer::ReinitializeMuxer(int64_t timestamp) {
   if (muxer_listener_ && streams_.back()->is_encrypted()) {
     const EncryptionConfig& encryption_config =
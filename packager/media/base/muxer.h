@@ -100,6 +100,11 @@ class Muxer : public MediaHandler {
       size_t stream_id,
       const SegmentInfo& segment_info) = 0;
 
+  // Wait for the segments being written asynchronously, if any, and notify the
+  // listener about them. Called before the listener is notified about other
+  // events, so that the events stay in order. This does nothing by default.
+  virtual Status FlushPendingSegments();
+
   // Re-initialize Muxer. Could be called on StreamInfo or CueEvent.
   // |timestamp| may be used to set the output file name.
   Status ReinitializeMuxer(int64_t timestamp);
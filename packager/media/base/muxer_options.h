@@ -44,6 +44,11 @@ struct MuxerOptions {
   /// User-specified bit rate for the media stream. If zero, the muxer will
   /// attempt to estimate.
   uint32_t bandwidth = 0;
+
+  /// The number of segments generated from |segment_template| by an earlier
+  /// run of the same live session, see MpdParams::live_state_file. The
+  /// numbering of the segments continues after them.
+  uint32_t num_previous_segments = 0;
 };
 
 }  // namespace media
@@ -0,0 +1,49 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_SEGMENT_HISTORY_H_
+#define PACKAGER_MEDIA_BASE_SEGMENT_HISTORY_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace shaka {
+namespace media {
+
+/// Describes the part of a stream which is skipped when a single segment of
+/// the stream is packaged, so that the handlers and muxers can restore the
+/// state they would have after processing it. The segments are the ones
+/// generated by ChunkingHandler.
+struct SegmentHistory {
+  struct Segment {
+    /// The start timestamp and duration of the segment, as in its
+    /// SegmentInfo.
+    int64_t start_timestamp = 0;
+    int64_t duration = 0;
+    /// The number of subsegments ending before the end of the segment.
+    uint32_t num_subsegments = 0;
+    /// The decoding timestamp of the first sample of the segment.
+    int64_t first_sample_dts = 0;
+    uint32_t num_samples = 0;
+  };
+
+  /// The segments before the packaged segment.
+  std::vector<Segment> segments;
+
+  /// The timestamps and duration of the first sample of the stream.
+  int64_t first_sample_pts = 0;
+  int64_t first_sample_dts = 0;
+  int64_t first_sample_duration = 0;
+
+  /// The sum of the durations of the samples which are not in the packaged
+  /// segment, i.e. of the segments before and after it.
+  int64_t skipped_samples_duration = 0;
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_SEGMENT_HISTORY_H_
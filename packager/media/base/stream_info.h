@@ -9,9 +9,11 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <packager/media/base/encryption_config.h>
+#include <packager/media/base/segment_history.h>
 
 namespace shaka {
 namespace media {
@@ -108,6 +110,11 @@ class StreamInfo {
   const EncryptionConfig& encryption_config() const {
     return encryption_config_;
   }
+  /// @return the part of the stream before the packaged segment, if only a
+  ///         single segment of the stream is packaged, or null otherwise.
+  const std::shared_ptr<const SegmentHistory>& segment_history() const {
+    return segment_history_;
+  }
 
   void set_duration(int64_t duration) { duration_ = duration; }
   void set_codec(Codec codec) { codec_ = codec; }
@@ -125,6 +132,10 @@ class StreamInfo {
   void set_encryption_config(const EncryptionConfig& encryption_config) {
     encryption_config_ = encryption_config;
   }
+  void set_segment_history(
+      std::shared_ptr<const SegmentHistory> segment_history) {
+    segment_history_ = std::move(segment_history);
+  }
 
  private:
   // Whether the stream is Audio or Video.
@@ -144,6 +155,7 @@ class StreamInfo {
   // Whether the stream has clear lead.
   bool has_clear_lead_ = false;
   EncryptionConfig encryption_config_;
+  std::shared_ptr<const SegmentHistory> segment_history_;
   // Optional byte data required for some audio/video decoders such as Vorbis
   // codebooks.
   std::vector<uint8_t> codec_config_;
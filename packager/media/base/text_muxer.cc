@@ -15,7 +15,8 @@
 namespace shaka {
 namespace media {
 
-TextMuxer::TextMuxer(const MuxerOptions& options) : Muxer(options) {}
+TextMuxer::TextMuxer(const MuxerOptions& options)
+    : Muxer(options), segment_index_(options.num_previous_segments) {}
 TextMuxer::~TextMuxer() {}
 
 Status TextMuxer::InitializeMuxer() {
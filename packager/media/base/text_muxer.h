@@ -38,7 +38,7 @@ class TextMuxer : public Muxer {
 
   int64_t total_duration_ms_ = 0;
   int64_t last_cue_ms_ = 0;
-  uint32_t segment_index_ = 0;
+  uint32_t segment_index_;
 };
 
 }  // namespace media
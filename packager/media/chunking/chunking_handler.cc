@@ -44,17 +44,24 @@ Status ChunkingHandler::InitializeInternal() {
   return Status::OK;
 }
 
+Status ChunkingHandler::ProcessBatch(StreamDataBatch batch) {
+  StartBatchDispatch();
+  Status status = MediaHandler::ProcessBatch(std::move(batch));
+  status.Update(FinishBatchDispatch());
+  return status;
+}
+
 Status ChunkingHandler::Process(std::unique_ptr<StreamData> stream_data) {
   switch (stream_data->stream_data_type) {
     case StreamDataType::kStreamInfo:
-      return OnStreamInfo(std::move(stream_data->stream_info));
+      return OnStreamInfo(stream_data->Take<StreamInfo>());
     case StreamDataType::kCueEvent:
-      return OnCueEvent(std::move(stream_data->cue_event));
+      return OnCueEvent(stream_data->Take<CueEvent>());
     case StreamDataType::kSegmentInfo:
       VLOG(3) << "Droppping existing segment info.";
       return Status::OK;
     case StreamDataType::kMediaSample:
-      return OnMediaSample(std::move(stream_data->media_sample));
+      return OnMediaSample(stream_data->Take<MediaSample>());
     default:
       VLOG(3) << "Stream data type "
               << static_cast<int>(stream_data->stream_data_type) << " ignored.";
@@ -47,6 +47,7 @@ class ChunkingHandler : public MediaHandler {
   /// @{
   Status InitializeInternal() override;
   Status Process(std::unique_ptr<StreamData> stream_data) override;
+  Status ProcessBatch(StreamDataBatch batch) override;
   Status OnFlushRequest(size_t input_stream_index) override;
   /// @}
 
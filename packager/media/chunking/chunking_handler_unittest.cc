@@ -42,6 +42,10 @@ class ChunkingHandlerTest : public MediaHandlerGraphTestBase {
     return chunking_handler_->Process(std::move(stream_data));
   }
 
+  Status ProcessBatch(StreamDataBatch batch) {
+    return chunking_handler_->ProcessBatch(std::move(batch));
+  }
+
   Status OnFlushRequest(int stream_index) {
     return chunking_handler_->OnFlushRequest(stream_index);
   }
@@ -115,6 +119,36 @@ TEST_F(ChunkingHandlerTest, AudioWithSubsegments) {
                         _)));
 }
 
+TEST_F(ChunkingHandlerTest, AudioWithSubsegmentsInBatch) {
+  ChunkingParams chunking_params;
+  chunking_params.segment_duration_in_seconds = 1;
+  chunking_params.subsegment_duration_in_seconds = 0.5;
+  SetUpChunkingHandler(1, chunking_params);
+
+  StreamDataBatch batch;
+  batch.push_back(StreamData::FromStreamInfo(kStreamIndex,
+                                             GetAudioStreamInfo(kTimeScale0)));
+  for (int i = 0; i < 5; ++i) {
+    batch.push_back(StreamData::FromMediaSample(
+        kStreamIndex, GetMediaSample(i * kDuration, kDuration, kKeyFrame)));
+  }
+  ASSERT_OK(ProcessBatch(std::move(batch)));
+  EXPECT_THAT(
+      GetOutputStreamDataVector(),
+      ElementsAre(
+          IsStreamInfo(kStreamIndex, kTimeScale0, !kEncrypted, _),
+          IsMediaSample(kStreamIndex, 0, kDuration, !kEncrypted, _),
+          IsMediaSample(kStreamIndex, kDuration, kDuration, !kEncrypted, _),
+          IsSegmentInfo(kStreamIndex, 0, kDuration * 2, kIsSubsegment,
+                        !kEncrypted),
+          IsMediaSample(kStreamIndex, 2 * kDuration, kDuration, !kEncrypted, _),
+          IsSegmentInfo(kStreamIndex, 0, kDuration * 3, !kIsSubsegment,
+                        !kEncrypted),
+          IsMediaSample(kStreamIndex, 3 * kDuration, kDuration, !kEncrypted, _),
+          IsMediaSample(kStreamIndex, 4 * kDuration, kDuration, !kEncrypted,
+                        _)));
+}
+
 TEST_F(ChunkingHandlerTest, VideoAndSubsegmentAndNonzeroStart) {
   ChunkingParams chunking_params;
   chunking_params.segment_duration_in_seconds = 1;
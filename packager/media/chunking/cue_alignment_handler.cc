@@ -9,6 +9,7 @@
 #include <algorithm>
 
 #include <absl/log/check.h>
+#include <absl/time/time.h>
 
 #include <packager/macros/logging.h>
 #include <packager/macros/status.h>
@@ -22,10 +23,10 @@ namespace {
 const size_t kMaxBufferSize = 1000;
 
 int64_t GetScaledTime(const StreamInfo& info, const StreamData& data) {
-  DCHECK(data.text_sample || data.media_sample);
+  DCHECK(data.text_sample() || data.media_sample());
 
-  if (data.text_sample) {
-    return data.text_sample->start_time();
+  if (data.text_sample()) {
+    return data.text_sample()->start_time();
   }
 
   if (info.stream_type() == kStreamText) {
@@ -40,11 +41,11 @@ int64_t GetScaledTime(const StreamInfo& info, const StreamData& data) {
     // Return the mid-point for audio because if the portion of the sample
     // after the cue point is bigger than the portion of the sample before
     // the cue point, the sample is placed after the cue.
-    return data.media_sample->pts() + data.media_sample->duration() / 2;
+    return data.media_sample()->pts() + data.media_sample()->duration() / 2;
   }
 
   DCHECK_EQ(info.stream_type(), kStreamVideo);
-  return data.media_sample->pts();
+  return data.media_sample()->pts();
 }
 
 double TimeInSeconds(const StreamInfo& info, const StreamData& data) {
@@ -55,21 +56,22 @@ double TimeInSeconds(const StreamInfo& info, const StreamData& data) {
 }
 
 double TextEndTimeInSeconds(const StreamInfo& info, const StreamData& data) {
-  DCHECK(data.text_sample);
+  DCHECK(data.text_sample());
 
-  const int64_t scaled_time = data.text_sample->EndTime();
+  const int64_t scaled_time = data.text_sample()->EndTime();
   const int32_t time_scale = info.time_scale();
 
   return static_cast<double>(scaled_time) / time_scale;
 }
 
-Status GetNextCue(double hint,
+Status GetNextCue(size_t thread_id,
+                  double hint,
                   SyncPointQueue* sync_points,
                   std::shared_ptr<const CueEvent>* out_cue) {
   DCHECK(sync_points);
   DCHECK(out_cue);
 
-  *out_cue = sync_points->GetNext(hint);
+  *out_cue = sync_points->GetNext(thread_id, hint);
 
   // |*out_cue| will only be null if the job was cancelled.
   return *out_cue ? Status::OK
@@ -81,9 +83,14 @@ CueAlignmentHandler::CueAlignmentHandler(SyncPointQueue* sync_points)
     : sync_points_(sync_points) {}
 
 Status CueAlignmentHandler::InitializeInternal() {
-  sync_points_->AddThread();
   stream_states_.resize(num_input_streams());
 
+  // Frame accurate cues are known up front, so there is nothing to wait for.
+  if (sync_points_->frame_accurate())
+    return Status::OK;
+
+  thread_id_ = sync_points_->AddThread();
+
   // Get the first hint for the stream. Use a negative hint so that if there is
   // suppose to be a sync point at zero, we will still respect it.
   hint_ = sync_points_->GetHint(-1);
@@ -117,6 +124,9 @@ Status CueAlignmentHandler::OnFlushRequest(size_t stream_index) {
     }
   }
 
+  if (sync_points_->frame_accurate())
+    return FlushFrameAccurateCues();
+
   // Do a once over all the streams to ensure that their states are as we expect
   // them. Video and non-video streams have different allowances here. Video
   // should absolutely have no cues or samples where as non-video streams may
@@ -136,10 +146,16 @@ Status CueAlignmentHandler::OnFlushRequest(size_t stream_index) {
   // when we call |UseNextSyncPoint|.
   while (sync_points_->HasMore(hint_)) {
     std::shared_ptr<const CueEvent> next_cue;
-    RETURN_IF_ERROR(GetNextCue(hint_, sync_points_, &next_cue));
+    RETURN_IF_ERROR(GetNextCue(thread_id_, hint_, sync_points_, &next_cue));
     RETURN_IF_ERROR(UseNewSyncPoint(std::move(next_cue)));
   }
 
+  const SyncPointQueue::WaitStats wait_stats =
+      sync_points_->GetWaitStats(thread_id_);
+  VLOG(1) << "Cue alignment thread " << thread_id_ << " waited "
+          << absl::FormatDuration(wait_stats.wait_time) << " for "
+          << wait_stats.wait_count << " cues.";
+
   // Now that there are new cues, it may be possible to dispatch some of the
   // samples that may be left waiting.
   for (StreamState& stream : stream_states_) {
@@ -153,18 +169,29 @@ Status CueAlignmentHandler::OnFlushRequest(size_t stream_index) {
     // two at the cue point.
     for (auto& cue : stream.cues) {
       // |max_text_sample_end_time_seconds| is always 0 for non-text samples.
-      if (cue->cue_event->time_in_seconds <
+      if (cue->cue_event()->time_in_seconds <
           stream.max_text_sample_end_time_seconds) {
         RETURN_IF_ERROR(Dispatch(std::move(cue)));
       } else {
         VLOG(1) << "Ignore extra cue in stream " << cue->stream_index
-                << " with time " << cue->cue_event->time_in_seconds
+                << " with time " << cue->cue_event()->time_in_seconds
                 << "s in the end.";
       }
     }
     stream.cues.clear();
   }
 
+  for (size_t stream_index = 0; stream_index < stream_states_.size();
+       stream_index++) {
+    const StreamProgress& progress = stream_states_[stream_index].progress;
+    VLOG(1) << "Cue alignment thread " << thread_id_ << " stream "
+            << stream_index << " dispatched " << progress.sample_count
+            << " samples up to " << progress.time_in_seconds
+            << "s, holding back at most " << progress.max_buffered_samples
+            << " samples for " << absl::FormatDuration(progress.buffered_time)
+            << " in total.";
+  }
+
   return FlushAllDownstreams();
 }
 
@@ -172,20 +199,34 @@ Status CueAlignmentHandler::OnStreamInfo(std::unique_ptr<StreamData> data) {
   StreamState& stream_state = stream_states_[data->stream_index];
   // Keep a copy of the stream info so that we can check type and check
   // timescale.
-  stream_state.info = data->stream_info;
+  stream_state.info = data->stream_info();
+
+  // Once all the streams are known, let the other threads know whether this
+  // thread will promote cues, i.e. whether it has video streams.
+  if (sync_points_->frame_accurate())
+    return Dispatch(std::move(data));
+
+  bool has_video = false;
+  for (const StreamState& state : stream_states_) {
+    if (!state.info)
+      return Dispatch(std::move(data));
+    has_video |= state.info->stream_type() == kStreamVideo;
+  }
+  if (!has_video)
+    sync_points_->SetPromotesCues(thread_id_, false);
 
   return Dispatch(std::move(data));
 }
 
 Status CueAlignmentHandler::OnVideoSample(std::unique_ptr<StreamData> sample) {
   DCHECK(sample);
-  DCHECK(sample->media_sample);
+  DCHECK(sample->media_sample());
 
   const size_t stream_index = sample->stream_index;
   StreamState& stream = stream_states_[stream_index];
 
   const double sample_time = TimeInSeconds(*stream.info, *sample);
-  const bool is_key_frame = sample->media_sample->is_key_frame();
+  const bool is_key_frame = sample->media_sample()->is_key_frame();
 
   if (is_key_frame && sample_time >= hint_) {
     auto next_sync = sync_points_->PromoteAt(sample_time);
@@ -203,13 +244,13 @@ Status CueAlignmentHandler::OnVideoSample(std::unique_ptr<StreamData> sample) {
     stream.cues.pop_front();
   }
 
-  return Dispatch(std::move(sample));
+  return DispatchSample(std::move(sample), &stream);
 }
 
 Status CueAlignmentHandler::OnNonVideoSample(
     std::unique_ptr<StreamData> sample) {
   DCHECK(sample);
-  DCHECK(sample->media_sample || sample->text_sample);
+  DCHECK(sample->media_sample() || sample->text_sample());
 
   const size_t stream_index = sample->stream_index;
   StreamState& stream_state = stream_states_[stream_index];
@@ -224,7 +265,7 @@ Status CueAlignmentHandler::OnNonVideoSample(
   // sync point.
   if (EveryoneWaitingAtHint()) {
     std::shared_ptr<const CueEvent> next_sync;
-    RETURN_IF_ERROR(GetNextCue(hint_, sync_points_, &next_sync));
+    RETURN_IF_ERROR(GetNextCue(thread_id_, hint_, sync_points_, &next_sync));
     RETURN_IF_ERROR(UseNewSyncPoint(next_sync));
   }
 
@@ -244,13 +285,16 @@ Status CueAlignmentHandler::OnSample(std::unique_ptr<StreamData> sample) {
 
   const size_t stream_index = sample->stream_index;
 
-  if (sample->text_sample) {
+  if (sample->text_sample()) {
     StreamState& stream = stream_states_[stream_index];
     stream.max_text_sample_end_time_seconds =
         std::max(stream.max_text_sample_end_time_seconds,
                  TextEndTimeInSeconds(*stream.info, *sample));
   }
 
+  if (sync_points_->frame_accurate())
+    return OnSampleWithFrameAccurateCues(std::move(sample));
+
   const StreamType stream_type =
       stream_states_[stream_index].info->stream_type();
   const bool is_video = stream_type == kStreamVideo;
@@ -259,6 +303,55 @@ Status CueAlignmentHandler::OnSample(std::unique_ptr<StreamData> sample) {
                   : OnNonVideoSample(std::move(sample));
 }
 
+Status CueAlignmentHandler::OnSampleWithFrameAccurateCues(
+    std::unique_ptr<StreamData> sample) {
+  const size_t stream_index = sample->stream_index;
+  StreamState& stream = stream_states_[stream_index];
+  const auto& cues = sync_points_->frame_accurate_cues();
+  const double sample_time = TimeInSeconds(*stream.info, *sample);
+
+  // Only the last cue is injected if there are multiple cues before this
+  // sample, as the others would result in empty segments.
+  const size_t cue_index = stream.next_cue_index;
+  while (stream.next_cue_index < cues.size() &&
+         cues[stream.next_cue_index]->time_in_seconds <= sample_time) {
+    stream.next_cue_index++;
+  }
+
+  if (stream.next_cue_index > cue_index) {
+    const auto& cue = cues[stream.next_cue_index - 1];
+    if (stream.info->stream_type() == kStreamVideo &&
+        !sample->media_sample()->is_key_frame()) {
+      LOG(ERROR) << "Stream " << stream_index << " has no key frame at cue "
+                 << "point " << cue->time_in_seconds << ".";
+      return Status(error::INVALID_ARGUMENT,
+                    "Video key frames are not aligned with the cue points.");
+    }
+    RETURN_IF_ERROR(Dispatch(StreamData::FromCueEvent(stream_index, cue)));
+  }
+
+  return DispatchSample(std::move(sample), &stream);
+}
+
+Status CueAlignmentHandler::FlushFrameAccurateCues() {
+  const auto& cues = sync_points_->frame_accurate_cues();
+
+  // Like with promoted cues, the cues after the last sample are ignored except
+  // for text, where the samples crossing the cues can be split.
+  for (size_t stream_index = 0; stream_index < stream_states_.size();
+       stream_index++) {
+    StreamState& stream = stream_states_[stream_index];
+    for (; stream.next_cue_index < cues.size(); stream.next_cue_index++) {
+      const auto& cue = cues[stream.next_cue_index];
+      if (cue->time_in_seconds >= stream.max_text_sample_end_time_seconds)
+        break;
+      RETURN_IF_ERROR(Dispatch(StreamData::FromCueEvent(stream_index, cue)));
+    }
+  }
+
+  return FlushAllDownstreams();
+}
+
 Status CueAlignmentHandler::UseNewSyncPoint(
     std::shared_ptr<const CueEvent> new_sync) {
   hint_ = sync_points_->GetHint(new_sync->time_in_seconds);
@@ -287,7 +380,7 @@ bool CueAlignmentHandler::EveryoneWaitingAtHint() const {
 Status CueAlignmentHandler::AcceptSample(std::unique_ptr<StreamData> sample,
                                          StreamState* stream) {
   DCHECK(sample);
-  DCHECK(sample->media_sample || sample->text_sample);
+  DCHECK(sample->media_sample() || sample->text_sample());
   DCHECK(stream);
 
   // Need to cache the stream index as we will lose the pointer when we add
@@ -295,6 +388,8 @@ Status CueAlignmentHandler::AcceptSample(std::unique_ptr<StreamData> sample,
   const size_t stream_index = sample->stream_index;
 
   stream->samples.push_back(std::move(sample));
+  stream->progress.max_buffered_samples =
+      std::max(stream->progress.max_buffered_samples, stream->samples.size());
 
   if (stream->samples.size() > kMaxBufferSize) {
     LOG(ERROR) << "Stream " << stream_index << " has buffered "
@@ -311,12 +406,13 @@ Status CueAlignmentHandler::RunThroughSamples(StreamState* stream) {
   // Step through all our samples until we find where we can insert the cue.
   // Think of this as a merge sort.
   while (stream->cues.size() && stream->samples.size()) {
-    const double cue_time = stream->cues.front()->cue_event->time_in_seconds;
+    const double cue_time = stream->cues.front()->cue_event()->time_in_seconds;
     const double sample_time =
         TimeInSeconds(*stream->info, *stream->samples.front());
 
     if (sample_time < cue_time) {
-      RETURN_IF_ERROR(Dispatch(std::move(stream->samples.front())));
+      RETURN_IF_ERROR(
+          DispatchSample(std::move(stream->samples.front()), stream));
       stream->samples.pop_front();
     } else {
       RETURN_IF_ERROR(Dispatch(std::move(stream->cues.front())));
@@ -329,11 +425,28 @@ Status CueAlignmentHandler::RunThroughSamples(StreamState* stream) {
   // downstream.
   while (stream->samples.size() &&
          TimeInSeconds(*stream->info, *stream->samples.front()) < hint_) {
-    RETURN_IF_ERROR(Dispatch(std::move(stream->samples.front())));
+    RETURN_IF_ERROR(DispatchSample(std::move(stream->samples.front()), stream));
     stream->samples.pop_front();
   }
 
+  // The samples left are held back until the next cue is known.
+  if (stream->samples.empty()) {
+    if (stream->buffered_since != absl::InfiniteFuture()) {
+      stream->progress.buffered_time += absl::Now() - stream->buffered_since;
+      stream->buffered_since = absl::InfiniteFuture();
+    }
+  } else if (stream->buffered_since == absl::InfiniteFuture()) {
+    stream->buffered_since = absl::Now();
+  }
+
   return Status::OK;
 }
+
+Status CueAlignmentHandler::DispatchSample(std::unique_ptr<StreamData> sample,
+                                           StreamState* stream) {
+  stream->progress.sample_count++;
+  stream->progress.time_in_seconds = TimeInSeconds(*stream->info, *sample);
+  return Dispatch(std::move(sample));
+}
 }  // namespace media
 }  // namespace shaka
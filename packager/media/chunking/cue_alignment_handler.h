@@ -7,9 +7,12 @@
 #ifndef PACKAGER_MEDIA_CHUNKING_CUE_ALIGNMENT_HANDLER_
 #define PACKAGER_MEDIA_CHUNKING_CUE_ALIGNMENT_HANDLER_
 
+#include <cstdint>
 #include <deque>
 #include <list>
 
+#include <absl/time/time.h>
+
 #include <packager/media/base/media_handler.h>
 #include <packager/media/chunking/sync_point_queue.h>
 
@@ -25,9 +28,27 @@ namespace media {
 /// manage blocking.
 class CueAlignmentHandler : public MediaHandler {
  public:
+  /// Progress of a stream through the handler.
+  struct StreamProgress {
+    /// Number of samples dispatched.
+    uint64_t sample_count = 0;
+    /// Time in seconds of the last dispatched sample.
+    double time_in_seconds = 0;
+    /// Largest number of samples held back at once, waiting for a cue.
+    size_t max_buffered_samples = 0;
+    /// Total time samples were held back, waiting for a cue.
+    absl::Duration buffered_time;
+  };
+
   explicit CueAlignmentHandler(SyncPointQueue* sync_points);
   ~CueAlignmentHandler() = default;
 
+  /// @return The progress of stream @a stream_index. Unless the cues are frame
+  ///         accurate, it is logged (VLOG 1) when the handler is flushed.
+  StreamProgress GetStreamProgress(size_t stream_index) const {
+    return stream_states_.at(stream_index).progress;
+  }
+
  private:
   CueAlignmentHandler(const CueAlignmentHandler&) = delete;
   CueAlignmentHandler& operator=(const CueAlignmentHandler&) = delete;
@@ -36,8 +57,8 @@ class CueAlignmentHandler : public MediaHandler {
     // Information for the stream.
     std::shared_ptr<const StreamInfo> info;
     // Cached samples that cannot be dispatched. All the samples should be at or
-    // after |hint|.
-    std::list<std::unique_ptr<StreamData>> samples;
+    // after |hint|. The look-ahead is bounded, see AcceptSample().
+    std::deque<std::unique_ptr<StreamData>> samples;
     // If set, the stream is pending to be flushed.
     bool to_be_flushed = false;
     // Only set for text stream.
@@ -46,6 +67,13 @@ class CueAlignmentHandler : public MediaHandler {
     // A list of cues that the stream should inject between media samples. When
     // there are no cues, the stream should run up to the hint.
     std::list<std::unique_ptr<StreamData>> cues;
+
+    // Only used for frame accurate cues. The index of the next cue to inject.
+    size_t next_cue_index = 0;
+
+    StreamProgress progress;
+    // When |samples| became non-empty, or InfiniteFuture() if it is empty.
+    absl::Time buffered_since = absl::InfiniteFuture();
   };
 
   // MediaHandler overrides.
@@ -60,6 +88,11 @@ class CueAlignmentHandler : public MediaHandler {
   Status OnNonVideoSample(std::unique_ptr<StreamData> sample);
   Status OnSample(std::unique_ptr<StreamData> sample);
 
+  // Handling of samples and flushes for frame accurate cues. The cue times are
+  // known up front, so samples are dispatched right away.
+  Status OnSampleWithFrameAccurateCues(std::unique_ptr<StreamData> sample);
+  Status FlushFrameAccurateCues();
+
   // Update stream states with new sync point.
   Status UseNewSyncPoint(std::shared_ptr<const CueEvent> new_sync);
 
@@ -73,7 +106,13 @@ class CueAlignmentHandler : public MediaHandler {
   // Dispatch all samples and cues (in the correct order) for the given stream.
   Status RunThroughSamples(StreamState* stream);
 
+  // Dispatch a sample of the given stream and update its progress.
+  Status DispatchSample(std::unique_ptr<StreamData> sample,
+                        StreamState* stream);
+
   SyncPointQueue* const sync_points_ = nullptr;
+  // The id of this handler's thread in |sync_points_|.
+  size_t thread_id_ = 0;
   std::deque<StreamState> stream_states_;
 
   // A common hint used by all streams. When a new cue is given to all streams,
@@ -84,6 +123,8 @@ class CueAlignmentHandler : public MediaHandler {
   // When a video stream passes the hint, it will promote the corresponding cue
   // event. If all streams get to the hint and there are no video streams, the
   // thread will block until |sync_points_| gives back a promoted cue event.
+  // Handlers without video streams do not promote cues, so they only wait for
+  // the handlers with video streams.
   double hint_;
 };
 
@@ -33,13 +33,17 @@ const bool kKeyFrame = true;
 const int32_t kMsTimeScale = 1000;
 
 const size_t kStreamIndex = 0;
+
+const bool kFrameAccurate = true;
 }  // namespace
 
 class CueAlignmentHandlerTest : public MediaHandlerTestBase {
  protected:
   std::unique_ptr<SyncPointQueue> CreateSyncPoints(
-      std::initializer_list<double> cues) {
+      std::initializer_list<double> cues,
+      bool frame_accurate = false) {
     AdCueGeneratorParams params;
+    params.frame_accurate_cue_points = frame_accurate;
 
     for (double cue_time : cues) {
       Cuepoint cue;
@@ -407,6 +411,16 @@ TEST_F(CueAlignmentHandlerTest, AudioInputWithCues) {
                                 kKeyFrame));
 
   ASSERT_OK(FlushAll({kAudioStream}));
+
+  // The sample after the cue is held back until the cue is promoted. Audio
+  // samples are timed by their mid-point.
+  const CueAlignmentHandler::StreamProgress progress =
+      handler->GetStreamProgress(kAudioStream);
+  EXPECT_EQ(3u, progress.sample_count);
+  EXPECT_DOUBLE_EQ(
+      static_cast<double>(kSample2Start + kSampleDuration / 2) / kMsTimeScale,
+      progress.time_in_seconds);
+  EXPECT_EQ(1u, progress.max_buffered_samples);
 }
 
 TEST_F(CueAlignmentHandlerTest, TextInputWithCues) {
@@ -609,6 +623,107 @@ TEST_F(CueAlignmentHandlerTest, TextAudioVideoInputWithCues) {
   ASSERT_OK(FlushAll({kTextStream, kAudioStream, kVideoStream}));
 }
 
+TEST_F(CueAlignmentHandlerTest, AudioVideoInputWithFrameAccurateCues) {
+  const size_t kAudioStream = 0;
+  const size_t kVideoStream = 1;
+  const size_t kTwoInputs = 2;
+  const size_t kTwoOutputs = 2;
+
+  const int64_t kSampleDuration = 1000;
+  const int64_t kSample0Start = 0;
+  const int64_t kSample1Start = kSample0Start + kSampleDuration;
+  const int64_t kSample2Start = kSample1Start + kSampleDuration;
+
+  const double kCueTimeInSeconds =
+      static_cast<double>(kSample1Start) / kMsTimeScale;
+
+  auto sync_points = CreateSyncPoints({kCueTimeInSeconds}, kFrameAccurate);
+  auto handler = std::make_shared<CueAlignmentHandler>(sync_points.get());
+  ASSERT_OK(SetUpAndInitializeGraph(handler, kTwoInputs, kTwoOutputs));
+
+  // The audio samples are dispatched before the video reaches the cue, i.e.
+  // they are not buffered.
+  testing::MockFunction<void()> video_dispatch;
+  {
+    testing::InSequence s;
+
+    EXPECT_CALL(*Output(kAudioStream),
+                OnProcess(IsStreamInfo(_, kMsTimeScale, _, _)));
+    EXPECT_CALL(
+        *Output(kAudioStream),
+        OnProcess(IsMediaSample(_, kSample0Start, kSampleDuration, _, _)));
+    EXPECT_CALL(*Output(kAudioStream),
+                OnProcess(IsCueEvent(_, kCueTimeInSeconds)));
+    EXPECT_CALL(
+        *Output(kAudioStream),
+        OnProcess(IsMediaSample(_, kSample1Start, kSampleDuration, _, _)));
+    EXPECT_CALL(
+        *Output(kAudioStream),
+        OnProcess(IsMediaSample(_, kSample2Start, kSampleDuration, _, _)));
+    EXPECT_CALL(video_dispatch, Call());
+  }
+
+  {
+    testing::InSequence s;
+
+    EXPECT_CALL(*Output(kVideoStream),
+                OnProcess(IsStreamInfo(_, kMsTimeScale, _, _)));
+    EXPECT_CALL(
+        *Output(kVideoStream),
+        OnProcess(IsMediaSample(_, kSample0Start, kSampleDuration, _, _)));
+    EXPECT_CALL(*Output(kVideoStream),
+                OnProcess(IsCueEvent(_, kCueTimeInSeconds)));
+    EXPECT_CALL(
+        *Output(kVideoStream),
+        OnProcess(IsMediaSample(_, kSample1Start, kSampleDuration, _, _)));
+    EXPECT_CALL(
+        *Output(kVideoStream),
+        OnProcess(IsMediaSample(_, kSample2Start, kSampleDuration, _, _)));
+  }
+
+  EXPECT_CALL(*Output(kAudioStream), OnFlush(_));
+  EXPECT_CALL(*Output(kVideoStream), OnFlush(_));
+
+  ASSERT_OK(DispatchAudioInfo(kAudioStream));
+  ASSERT_OK(DispatchVideoInfo(kVideoStream));
+
+  for (int64_t start : {kSample0Start, kSample1Start, kSample2Start}) {
+    ASSERT_OK(
+        DispatchMediaSample(kAudioStream, start, kSampleDuration, kKeyFrame));
+  }
+
+  video_dispatch.Call();
+  ASSERT_OK(DispatchMediaSample(kVideoStream, kSample0Start, kSampleDuration,
+                                kKeyFrame));
+  ASSERT_OK(DispatchMediaSample(kVideoStream, kSample1Start, kSampleDuration,
+                                kKeyFrame));
+  ASSERT_OK(DispatchMediaSample(kVideoStream, kSample2Start, kSampleDuration,
+                                !kKeyFrame));
+
+  ASSERT_OK(FlushAll({kAudioStream, kVideoStream}));
+}
+
+TEST_F(CueAlignmentHandlerTest, FrameAccurateCueWithoutVideoKeyFrame) {
+  const size_t kVideoStream = 0;
+
+  const int64_t kSampleDuration = 1000;
+  const int64_t kSample0Start = 0;
+  const int64_t kSample1Start = kSample0Start + kSampleDuration;
+
+  auto sync_points = CreateSyncPoints(
+      {static_cast<double>(kSample1Start) / kMsTimeScale}, kFrameAccurate);
+  auto handler = std::make_shared<CueAlignmentHandler>(sync_points.get());
+  ASSERT_OK(SetUpAndInitializeGraph(handler, kOneInput, kOneOutput));
+
+  ASSERT_OK(DispatchVideoInfo(kVideoStream));
+  ASSERT_OK(DispatchMediaSample(kVideoStream, kSample0Start, kSampleDuration,
+                                kKeyFrame));
+  ASSERT_EQ(error::INVALID_ARGUMENT,
+            DispatchMediaSample(kVideoStream, kSample1Start, kSampleDuration,
+                                !kKeyFrame)
+                .error_code());
+}
+
 // TODO(kqyang): Add more tests, in particular, multi-thread tests.
 
 }  // namespace media
@@ -0,0 +1,162 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/chunking/segment_locator.h>
+
+#include <string>
+
+#include <packager/macros/status.h>
+#include <packager/media/base/media_handler.h>
+#include <packager/media/base/media_sample.h>
+#include <packager/media/chunking/chunking_handler.h>
+
+namespace shaka {
+namespace media {
+namespace {
+const size_t kStreamIndex = 0;
+}  // namespace
+
+// Feeds the stream to the ChunkingHandler.
+class SegmentLocator::SampleSource : public MediaHandler {
+ public:
+  Status PushStreamInfo(std::shared_ptr<const StreamInfo> stream_info) {
+    return DispatchStreamInfo(kStreamIndex, std::move(stream_info));
+  }
+  Status PushMediaSample(std::shared_ptr<const MediaSample> sample) {
+    return DispatchMediaSample(kStreamIndex, std::move(sample));
+  }
+  Status Flush() { return FlushAllDownstreams(); }
+
+ protected:
+  Status InitializeInternal() override { return Status::OK; }
+  bool ValidateOutputStreamIndex(size_t stream_index) const override {
+    return stream_index == kStreamIndex;
+  }
+  Status Process(std::unique_ptr<StreamData> /*stream_data*/) override {
+    return Status(error::INTERNAL_ERROR,
+                  "SampleSource should not be the downstream handler.");
+  }
+};
+
+// Receives the samples and segments generated by the ChunkingHandler.
+class SegmentLocator::SegmentRecorder : public MediaHandler {
+ public:
+  explicit SegmentRecorder(SegmentLocator* locator) : locator_(locator) {}
+
+ protected:
+  Status InitializeInternal() override { return Status::OK; }
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    switch (stream_data->stream_data_type) {
+      case StreamDataType::kMediaSample:
+        locator_->OnMediaSample(*stream_data->media_sample());
+        break;
+      case StreamDataType::kSegmentInfo:
+        locator_->OnSegmentInfo(*stream_data->segment_info());
+        break;
+      default:
+        break;
+    }
+    return Status::OK;
+  }
+  Status OnFlushRequest(size_t /*input_stream_index*/) override {
+    return Status::OK;
+  }
+
+ private:
+  SegmentLocator* const locator_;
+};
+
+SegmentLocator::SegmentLocator(const ChunkingParams& chunking_params,
+                               uint32_t segment_index)
+    : segment_index_(segment_index),
+      source_(new SampleSource),
+      chunking_handler_(new ChunkingHandler(chunking_params)),
+      recorder_(new SegmentRecorder(this)) {}
+
+SegmentLocator::~SegmentLocator() = default;
+
+Status SegmentLocator::Initialize(
+    std::shared_ptr<const StreamInfo> stream_info) {
+  RETURN_IF_ERROR(MediaHandler::Chain({source_, chunking_handler_, recorder_}));
+  RETURN_IF_ERROR(source_->Initialize());
+  return source_->PushStreamInfo(std::move(stream_info));
+}
+
+Status SegmentLocator::AddSample(int64_t dts,
+                                 int64_t pts,
+                                 int64_t duration,
+                                 bool is_key_frame) {
+  if (num_segments_ > segment_index_) {
+    // The segment is located already; the remaining samples are skipped.
+    total_duration_ += duration;
+    ++num_samples_;
+    return Status::OK;
+  }
+
+  std::shared_ptr<MediaSample> sample = MediaSample::CreateEmptyMediaSample();
+  sample->set_dts(dts);
+  sample->set_pts(pts);
+  sample->set_duration(duration);
+  sample->set_is_key_frame(is_key_frame);
+  // The sample, if not discarded, is received by OnMediaSample before
+  // PushMediaSample returns.
+  RETURN_IF_ERROR(source_->PushMediaSample(std::move(sample)));
+  ++num_samples_;
+  return Status::OK;
+}
+
+Status SegmentLocator::Finalize() {
+  if (num_segments_ <= segment_index_)
+    RETURN_IF_ERROR(source_->Flush());
+  if (num_segments_ <= segment_index_) {
+    return Status(error::NOT_FOUND,
+                  "The stream has only " + std::to_string(num_segments_) +
+                      " segments.");
+  }
+  history_.skipped_samples_duration = total_duration_ - segment_duration_;
+  return Status::OK;
+}
+
+void SegmentLocator::OnMediaSample(const MediaSample& sample) {
+  if (!has_first_sample_) {
+    has_first_sample_ = true;
+    history_.first_sample_pts = sample.pts();
+    history_.first_sample_dts = sample.dts();
+    history_.first_sample_duration = sample.duration();
+  }
+  total_duration_ += sample.duration();
+
+  if (num_segments_ < segment_index_) {
+    if (current_segment_.num_samples == 0)
+      current_segment_.first_sample_dts = sample.dts();
+    ++current_segment_.num_samples;
+  } else if (num_segments_ == segment_index_) {
+    if (end_sample_ == 0)
+      first_sample_ = num_samples_;
+    end_sample_ = num_samples_ + 1;
+    segment_duration_ += sample.duration();
+  }
+}
+
+void SegmentLocator::OnSegmentInfo(const SegmentInfo& segment_info) {
+  if (num_segments_ > segment_index_)
+    return;
+  if (segment_info.is_subsegment) {
+    if (num_segments_ < segment_index_)
+      ++current_segment_.num_subsegments;
+    return;
+  }
+  if (num_segments_ < segment_index_) {
+    current_segment_.start_timestamp = segment_info.start_timestamp;
+    current_segment_.duration = segment_info.duration;
+    history_.segments.push_back(current_segment_);
+    current_segment_ = SegmentHistory::Segment();
+  }
+  ++num_segments_;
+}
+
+}  // namespace media
+}  // namespace shaka
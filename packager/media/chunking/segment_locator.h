@@ -0,0 +1,93 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_CHUNKING_SEGMENT_LOCATOR_H_
+#define PACKAGER_MEDIA_CHUNKING_SEGMENT_LOCATOR_H_
+
+#include <cstdint>
+#include <memory>
+
+#include <packager/chunking_params.h>
+#include <packager/media/base/segment_history.h>
+#include <packager/status.h>
+
+namespace shaka {
+namespace media {
+
+class MediaHandler;
+class MediaSample;
+class StreamInfo;
+struct SegmentInfo;
+
+/// SegmentLocator finds the samples of a single segment of a stream from the
+/// timing of the samples only, e.g. from a sample index. The timing is run
+/// through a ChunkingHandler, so the segment boundaries are the ones of a
+/// full run, and the segments before the located segment are summarized in a
+/// SegmentHistory.
+class SegmentLocator {
+ public:
+  /// @param chunking_params are the chunking parameters of the full run.
+  /// @param segment_index is the zero-based index of the segment to locate.
+  SegmentLocator(const ChunkingParams& chunking_params, uint32_t segment_index);
+  ~SegmentLocator();
+
+  /// Must be called before adding samples.
+  Status Initialize(std::shared_ptr<const StreamInfo> stream_info);
+
+  /// Adds the next sample of the stream, in decoding order.
+  Status AddSample(int64_t dts,
+                   int64_t pts,
+                   int64_t duration,
+                   bool is_key_frame);
+
+  /// Must be called after all the samples are added.
+  /// @return NOT_FOUND if the stream does not have the segment.
+  Status Finalize();
+
+  /// @return the index of the first sample of the segment, in the order the
+  ///         samples are added.
+  size_t first_sample() const { return first_sample_; }
+  /// @return the index after the last sample of the segment.
+  size_t end_sample() const { return end_sample_; }
+  /// @return the part of the stream which is not in the segment. Valid after
+  ///         Finalize() succeeds.
+  const SegmentHistory& history() const { return history_; }
+
+ private:
+  SegmentLocator(const SegmentLocator&) = delete;
+  SegmentLocator& operator=(const SegmentLocator&) = delete;
+
+  class SampleSource;
+  class SegmentRecorder;
+
+  void OnMediaSample(const MediaSample& sample);
+  void OnSegmentInfo(const SegmentInfo& segment_info);
+
+  const uint32_t segment_index_;
+  std::shared_ptr<SampleSource> source_;
+  std::shared_ptr<MediaHandler> chunking_handler_;
+  std::shared_ptr<SegmentRecorder> recorder_;
+
+  // The number of samples added so far.
+  size_t num_samples_ = 0;
+  // The number of segments ended so far.
+  uint32_t num_segments_ = 0;
+  // The segment being recorded if it is before the located segment.
+  SegmentHistory::Segment current_segment_;
+  bool has_first_sample_ = false;
+  size_t first_sample_ = 0;
+  size_t end_sample_ = 0;
+  // The durations of the samples dispatched by ChunkingHandler and of the
+  // samples of the located segment.
+  int64_t total_duration_ = 0;
+  int64_t segment_duration_ = 0;
+  SegmentHistory history_;
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_CHUNKING_SEGMENT_LOCATOR_H_
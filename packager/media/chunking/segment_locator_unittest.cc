@@ -0,0 +1,114 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/chunking/segment_locator.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <packager/macros/status.h>
+#include <packager/media/base/media_handler_test_base.h>
+#include <packager/status/status_test_util.h>
+
+namespace shaka {
+namespace media {
+namespace {
+const int32_t kTimeScale = 1000;
+const int64_t kDuration = 300;
+const bool kKeyFrame = true;
+const int kNumSamples = 10;
+}  // namespace
+
+class SegmentLocatorTest : public MediaHandlerTestBase {
+ protected:
+  void SetUp() override { chunking_params_.segment_duration_in_seconds = 1; }
+
+  // Adds |kNumSamples| samples of |kDuration|, all key frames except the
+  // ones in |non_key_frames|.
+  Status Locate(uint32_t segment_index,
+                const std::vector<int>& non_key_frames = {}) {
+    locator_.reset(new SegmentLocator(chunking_params_, segment_index));
+    RETURN_IF_ERROR(locator_->Initialize(GetVideoStreamInfo(kTimeScale)));
+    for (int i = 0; i < kNumSamples; ++i) {
+      const bool is_key_frame =
+          std::find(non_key_frames.begin(), non_key_frames.end(), i) ==
+          non_key_frames.end();
+      RETURN_IF_ERROR(locator_->AddSample(i * kDuration, i * kDuration,
+                                          kDuration, is_key_frame));
+    }
+    return locator_->Finalize();
+  }
+
+  ChunkingParams chunking_params_;
+  std::unique_ptr<SegmentLocator> locator_;
+};
+
+TEST_F(SegmentLocatorTest, FirstSegment) {
+  // Segments: [0, 900], [1200, 1800], [2100, 2700].
+  ASSERT_OK(Locate(0));
+  EXPECT_EQ(0u, locator_->first_sample());
+  EXPECT_EQ(4u, locator_->end_sample());
+
+  const SegmentHistory& history = locator_->history();
+  EXPECT_TRUE(history.segments.empty());
+  EXPECT_EQ(0, history.first_sample_pts);
+  EXPECT_EQ(0, history.first_sample_dts);
+  EXPECT_EQ(kDuration, history.first_sample_duration);
+  EXPECT_EQ(6 * kDuration, history.skipped_samples_duration);
+}
+
+TEST_F(SegmentLocatorTest, LastSegment) {
+  ASSERT_OK(Locate(2));
+  EXPECT_EQ(7u, locator_->first_sample());
+  EXPECT_EQ(10u, locator_->end_sample());
+
+  const SegmentHistory& history = locator_->history();
+  ASSERT_EQ(2u, history.segments.size());
+  EXPECT_EQ(0, history.segments[0].start_timestamp);
+  EXPECT_EQ(4 * kDuration, history.segments[0].duration);
+  EXPECT_EQ(0, history.segments[0].first_sample_dts);
+  EXPECT_EQ(4u, history.segments[0].num_samples);
+  EXPECT_EQ(4 * kDuration, history.segments[1].start_timestamp);
+  EXPECT_EQ(3 * kDuration, history.segments[1].duration);
+  EXPECT_EQ(4 * kDuration, history.segments[1].first_sample_dts);
+  EXPECT_EQ(3u, history.segments[1].num_samples);
+  EXPECT_EQ(7 * kDuration, history.skipped_samples_duration);
+}
+
+TEST_F(SegmentLocatorTest, SegmentsStartWithKeyFrames) {
+  // The leading non key frame is discarded, and the first segment runs from
+  // 300 to 1500 as 1200 is not a key frame.
+  ASSERT_OK(Locate(1, {0, 4}));
+  EXPECT_EQ(5u, locator_->first_sample());
+  EXPECT_EQ(7u, locator_->end_sample());
+
+  const SegmentHistory& history = locator_->history();
+  ASSERT_EQ(1u, history.segments.size());
+  EXPECT_EQ(kDuration, history.segments[0].start_timestamp);
+  EXPECT_EQ(4 * kDuration, history.segments[0].duration);
+  EXPECT_EQ(4u, history.segments[0].num_samples);
+  EXPECT_EQ(kDuration, history.first_sample_pts);
+  EXPECT_EQ(7 * kDuration, history.skipped_samples_duration);
+}
+
+TEST_F(SegmentLocatorTest, Subsegments) {
+  chunking_params_.subsegment_duration_in_seconds = 0.5;
+  ASSERT_OK(Locate(1));
+
+  const SegmentHistory& history = locator_->history();
+  ASSERT_EQ(1u, history.segments.size());
+  // The subsegment starting at 600 ends before the segment.
+  EXPECT_EQ(1u, history.segments[0].num_subsegments);
+}
+
+TEST_F(SegmentLocatorTest, SegmentNotFound) {
+  EXPECT_EQ(error::NOT_FOUND, Locate(3).error_code());
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -16,25 +16,44 @@
 namespace shaka {
 namespace media {
 
-SyncPointQueue::SyncPointQueue(const AdCueGeneratorParams& params) {
+SyncPointQueue::SyncPointQueue(const AdCueGeneratorParams& params)
+    : frame_accurate_(params.frame_accurate_cue_points) {
   for (const Cuepoint& point : params.cue_points) {
     std::shared_ptr<CueEvent> event = std::make_shared<CueEvent>();
     event->time_in_seconds = point.start_time_in_seconds;
     unpromoted_[point.start_time_in_seconds] = std::move(event);
   }
+
+  if (frame_accurate_) {
+    for (const auto& entry : unpromoted_)
+      frame_accurate_cues_.push_back(entry.second);
+  }
 }
 
-void SyncPointQueue::AddThread() {
+size_t SyncPointQueue::AddThread() {
   absl::MutexLock lock(&mutex_);
-  thread_count_++;
+  threads_.emplace_back();
+  active_promoter_count_++;
+  return threads_.size() - 1;
 }
 
-void SyncPointQueue::Cancel() {
-  {
-    absl::MutexLock lock(&mutex_);
-    cancelled_ = true;
+void SyncPointQueue::SetPromotesCues(size_t thread_id, bool promotes_cues) {
+  absl::MutexLock lock(&mutex_);
+  ThreadState& thread = threads_.at(thread_id);
+  if (thread.promotes_cues == promotes_cues)
+    return;
+  thread.promotes_cues = promotes_cues;
+  if (!thread.waiting) {
+    if (promotes_cues)
+      active_promoter_count_++;
+    else
+      active_promoter_count_--;
   }
-  sync_condition_.SignalAll();
+}
+
+void SyncPointQueue::Cancel() {
+  absl::MutexLock lock(&mutex_);
+  cancelled_ = true;
 }
 
 double SyncPointQueue::GetHint(double time_in_seconds) {
@@ -54,33 +73,45 @@ double SyncPointQueue::GetHint(double time_in_seconds) {
 }
 
 std::shared_ptr<const CueEvent> SyncPointQueue::GetNext(
+    size_t thread_id,
     double hint_in_seconds) {
   absl::MutexLock lock(&mutex_);
-  while (!cancelled_) {
-    // Find the promoted cue that would line up with our hint, which is the
-    // first cue that is not less than |hint_in_seconds|.
-    auto iter = promoted_.lower_bound(hint_in_seconds);
-    if (iter != promoted_.end()) {
-      return iter->second;
-    }
-
-    // Promote |hint_in_seconds| if everyone is waiting.
-    if (waiting_thread_count_ + 1 == thread_count_) {
-      std::shared_ptr<const CueEvent> cue = PromoteAtNoLocking(hint_in_seconds);
-      CHECK(cue);
-      return cue;
-    }
-
-    waiting_thread_count_++;
-    // This blocks until either a cue is promoted or all threads are blocked
-    // (in which case, the unpromoted cue at the hint will be self-promoted
-    // and returned - see section above). Spurious signal events are possible
-    // with most condition variable implementations, so if it returns, we go
-    // back and check if a cue is actually promoted or not.
-    sync_condition_.Wait(&mutex_);
-    waiting_thread_count_--;
+  ThreadState& thread = threads_.at(thread_id);
+
+  Waiter waiter = {this, hint_in_seconds};
+  if (!IsReady(&waiter)) {
+    // Block until either a cue is promoted or all threads that may promote
+    // cues are blocked (in which case, the unpromoted cue at the hint will be
+    // self-promoted and returned - see below). The condition is evaluated by
+    // the thread releasing the mutex, so only the threads whose condition
+    // holds are woken up.
+    thread.waiting = true;
+    if (thread.promotes_cues)
+      active_promoter_count_--;
+
+    const absl::Time wait_start = absl::Now();
+    mutex_.Await(absl::Condition(&SyncPointQueue::IsReady, &waiter));
+    thread.wait_stats.wait_count++;
+    thread.wait_stats.wait_time += absl::Now() - wait_start;
+
+    thread.waiting = false;
+    if (thread.promotes_cues)
+      active_promoter_count_++;
   }
-  return nullptr;
+
+  if (cancelled_)
+    return nullptr;
+
+  // Find the promoted cue that would line up with our hint, which is the
+  // first cue that is not less than |hint_in_seconds|.
+  auto iter = promoted_.lower_bound(hint_in_seconds);
+  if (iter != promoted_.end())
+    return iter->second;
+
+  // Everyone that may promote cues is waiting, so promote |hint_in_seconds|.
+  std::shared_ptr<const CueEvent> cue = PromoteAtNoLocking(hint_in_seconds);
+  CHECK(cue);
+  return cue;
 }
 
 std::shared_ptr<const CueEvent> SyncPointQueue::PromoteAt(
@@ -93,6 +124,19 @@ bool SyncPointQueue::HasMore(double hint_in_seconds) const {
   return hint_in_seconds < std::numeric_limits<double>::max();
 }
 
+SyncPointQueue::WaitStats SyncPointQueue::GetWaitStats(size_t thread_id) {
+  absl::MutexLock lock(&mutex_);
+  return threads_.at(thread_id).wait_stats;
+}
+
+bool SyncPointQueue::IsReady(Waiter* waiter) {
+  SyncPointQueue* queue = waiter->queue;
+  queue->mutex_.AssertHeld();
+  return queue->cancelled_ || queue->active_promoter_count_ == 0 ||
+         queue->promoted_.lower_bound(waiter->hint_in_seconds) !=
+             queue->promoted_.end();
+}
+
 std::shared_ptr<const CueEvent> SyncPointQueue::PromoteAtNoLocking(
     double time_in_seconds) {
   mutex_.AssertHeld();
@@ -123,9 +167,6 @@ std::shared_ptr<const CueEvent> SyncPointQueue::PromoteAtNoLocking(
   // User may provide multiple cue points at the same or similar timestamps. The
   // extra unused cues are simply ignored.
   unpromoted_.erase(unpromoted_.begin(), iter);
-
-  // Wake up other threads that may be waiting.
-  sync_condition_.SignalAll();
   return cue;
 }
 
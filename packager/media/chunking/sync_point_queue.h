@@ -6,8 +6,10 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 
 #include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
 
 #include <packager/ad_cue_generator_params.h>
 
@@ -17,14 +19,35 @@ namespace media {
 struct CueEvent;
 
 /// A synchronized queue for cue points.
+///
+/// Threads only synchronize at cue hints. A thread waiting for a cue is woken
+/// up only when its own wait condition becomes true, i.e. when a cue at or
+/// after its hint is promoted, so promoting a cue does not wake up every
+/// waiting thread.
 class SyncPointQueue {
  public:
+  /// Statistics on how long a thread waited for cues to be promoted.
+  struct WaitStats {
+    /// Number of cues the thread waited for.
+    size_t wait_count = 0;
+    /// Total time spent waiting.
+    absl::Duration wait_time;
+  };
+
   explicit SyncPointQueue(const AdCueGeneratorParams& params);
   ~SyncPointQueue() = default;
 
   /// Add a new thread. Each thread using this instance must call this method in
   /// order to keep track of its clients.
-  void AddThread();
+  /// @return The id of the thread, to be used in the calls below.
+  size_t AddThread();
+
+  /// Set whether thread @a thread_id may promote cues with PromoteAt(). Every
+  /// thread is assumed to promote cues until declared otherwise, e.g. once it
+  /// is known that it has no video streams. The unpromoted cue at a hint is
+  /// self-promoted as soon as every thread that may promote cues is waiting,
+  /// so threads that do not promote cues never wait for each other.
+  void SetPromotesCues(size_t thread_id, bool promotes_cues);
 
   /// Cancel the queue and unblock all threads.
   void Cancel();
@@ -38,10 +61,12 @@ class SyncPointQueue {
   /// @return The next cue based on a previous hint. If a cue has been promoted
   ///         that comes after @a hint_in_seconds it is returned. If no cue
   ///         after @a hint_in_seconds has been promoted, this will block until
-  ///         either a cue is promoted or all threads are blocked (in which
-  ///         case, the unpromoted cue at @a hint_in_seconds will be
-  ///         self-promoted and returned) or Cancel() is called.
-  std::shared_ptr<const CueEvent> GetNext(double hint_in_seconds);
+  ///         either a cue is promoted or all threads that may promote cues
+  ///         are blocked (in which case, the unpromoted cue at
+  ///         @a hint_in_seconds will be self-promoted and returned) or
+  ///         Cancel() is called.
+  std::shared_ptr<const CueEvent> GetNext(size_t thread_id,
+                                          double hint_in_seconds);
 
   /// Promote the first cue that is not greater than @a time_in_seconds. All
   /// unpromoted cues before the cue will be discarded.
@@ -52,7 +77,34 @@ class SyncPointQueue {
   ///         in undefined behavior.
   bool HasMore(double hint_in_seconds) const;
 
+  /// @return The wait statistics of thread @a thread_id.
+  WaitStats GetWaitStats(size_t thread_id);
+
+  /// @return True if the cues are to be inserted at the exact cue point times.
+  ///         The cues are then known up front and never need promotion.
+  bool frame_accurate() const { return frame_accurate_; }
+
+  /// @return All the cues sorted by time, if frame_accurate() is true.
+  const std::vector<std::shared_ptr<const CueEvent>>& frame_accurate_cues()
+      const {
+    return frame_accurate_cues_;
+  }
+
  private:
+  struct ThreadState {
+    bool promotes_cues = true;
+    bool waiting = false;
+    WaitStats wait_stats;
+  };
+
+  struct Waiter {
+    SyncPointQueue* queue;
+    double hint_in_seconds;
+  };
+
+  // Wait condition of GetNext().
+  static bool IsReady(Waiter* waiter);
+
   SyncPointQueue(const SyncPointQueue&) = delete;
   SyncPointQueue& operator=(const SyncPointQueue&) = delete;
 
@@ -60,14 +112,19 @@ class SyncPointQueue {
   // functions that have locks.
   std::shared_ptr<const CueEvent> PromoteAtNoLocking(double time_in_seconds);
 
-  absl::Mutex mutex_;
-  absl::CondVar sync_condition_ ABSL_GUARDED_BY(mutex_);
-  size_t thread_count_ = 0;
-  size_t waiting_thread_count_ = 0;
-  bool cancelled_ = false;
+  const bool frame_accurate_;
+  std::vector<std::shared_ptr<const CueEvent>> frame_accurate_cues_;
 
-  std::map<double, std::shared_ptr<CueEvent>> unpromoted_;
-  std::map<double, std::shared_ptr<CueEvent>> promoted_;
+  absl::Mutex mutex_;
+  std::vector<ThreadState> threads_ ABSL_GUARDED_BY(mutex_);
+  // Number of threads that may promote cues and are not waiting.
+  size_t active_promoter_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool cancelled_ ABSL_GUARDED_BY(mutex_) = false;
+
+  std::map<double, std::shared_ptr<CueEvent>> unpromoted_
+      ABSL_GUARDED_BY(mutex_);
+  std::map<double, std::shared_ptr<CueEvent>> promoted_
+      ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace media
@@ -0,0 +1,127 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/chunking/sync_point_queue.h>
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <packager/ad_cue_generator_params.h>
+#include <packager/media/base/media_handler.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const double kCue1TimeInSeconds = 10.0;
+const double kCue2TimeInSeconds = 20.0;
+const double kPromotedTimeInSeconds = 10.5;
+
+std::unique_ptr<SyncPointQueue> CreateSyncPoints() {
+  AdCueGeneratorParams params;
+  for (double cue_time : {kCue1TimeInSeconds, kCue2TimeInSeconds}) {
+    Cuepoint cue;
+    cue.start_time_in_seconds = cue_time;
+    params.cue_points.push_back(cue);
+  }
+  return std::unique_ptr<SyncPointQueue>(new SyncPointQueue(params));
+}
+
+}  // namespace
+
+TEST(SyncPointQueueTest, SingleThreadSelfPromotes) {
+  auto sync_points = CreateSyncPoints();
+  const size_t thread_id = sync_points->AddThread();
+
+  const double hint = sync_points->GetHint(-1);
+  EXPECT_EQ(kCue1TimeInSeconds, hint);
+  auto cue = sync_points->GetNext(thread_id, hint);
+  ASSERT_TRUE(cue);
+  EXPECT_EQ(kCue1TimeInSeconds, cue->time_in_seconds);
+  EXPECT_EQ(kCue2TimeInSeconds, sync_points->GetHint(cue->time_in_seconds));
+}
+
+TEST(SyncPointQueueTest, NonPromotingThreadDoesNotWaitForOthers) {
+  auto sync_points = CreateSyncPoints();
+  const size_t audio_thread = sync_points->AddThread();
+  const size_t text_thread = sync_points->AddThread();
+  sync_points->SetPromotesCues(audio_thread, false);
+  sync_points->SetPromotesCues(text_thread, false);
+
+  // |text_thread| has not reached the hint yet, but the cue can be
+  // self-promoted since no thread will promote it at a different time.
+  const double hint = sync_points->GetHint(-1);
+  auto cue = sync_points->GetNext(audio_thread, hint);
+  ASSERT_TRUE(cue);
+  EXPECT_EQ(kCue1TimeInSeconds, cue->time_in_seconds);
+  EXPECT_EQ(cue, sync_points->GetNext(text_thread, hint));
+
+  EXPECT_EQ(0u, sync_points->GetWaitStats(audio_thread).wait_count);
+  EXPECT_EQ(0u, sync_points->GetWaitStats(text_thread).wait_count);
+}
+
+TEST(SyncPointQueueTest, WaitsForPromotingThread) {
+  auto sync_points = CreateSyncPoints();
+  const size_t video_thread = sync_points->AddThread();
+  const size_t audio_thread = sync_points->AddThread();
+  sync_points->SetPromotesCues(audio_thread, false);
+
+  const double hint = sync_points->GetHint(-1);
+  std::shared_ptr<const CueEvent> audio_cue;
+  std::thread audio(
+      [&]() { audio_cue = sync_points->GetNext(audio_thread, hint); });
+
+  auto video_cue = sync_points->PromoteAt(kPromotedTimeInSeconds);
+  audio.join();
+
+  ASSERT_TRUE(video_cue);
+  EXPECT_EQ(kPromotedTimeInSeconds, video_cue->time_in_seconds);
+  EXPECT_EQ(video_cue, audio_cue);
+  EXPECT_EQ(0u, sync_points->GetWaitStats(video_thread).wait_count);
+}
+
+TEST(SyncPointQueueTest, SelfPromotesWhenPromotingThreadsAreWaiting) {
+  auto sync_points = CreateSyncPoints();
+  const size_t video_thread = sync_points->AddThread();
+  const size_t audio_thread = sync_points->AddThread();
+  sync_points->SetPromotesCues(audio_thread, false);
+
+  // The video stream ended before the hint, so the video thread waits for the
+  // cue too.
+  const double hint = sync_points->GetHint(-1);
+  std::shared_ptr<const CueEvent> audio_cue;
+  std::thread audio(
+      [&]() { audio_cue = sync_points->GetNext(audio_thread, hint); });
+
+  auto video_cue = sync_points->GetNext(video_thread, hint);
+  audio.join();
+
+  ASSERT_TRUE(video_cue);
+  EXPECT_EQ(kCue1TimeInSeconds, video_cue->time_in_seconds);
+  EXPECT_EQ(video_cue, audio_cue);
+  EXPECT_EQ(1u, sync_points->GetWaitStats(video_thread).wait_count);
+}
+
+TEST(SyncPointQueueTest, CancelUnblocksWaitingThreads) {
+  auto sync_points = CreateSyncPoints();
+  sync_points->AddThread();
+  const size_t audio_thread = sync_points->AddThread();
+  sync_points->SetPromotesCues(audio_thread, false);
+
+  const double hint = sync_points->GetHint(-1);
+  std::shared_ptr<const CueEvent> audio_cue =
+      std::make_shared<const CueEvent>();
+  std::thread audio(
+      [&]() { audio_cue = sync_points->GetNext(audio_thread, hint); });
+
+  sync_points->Cancel();
+  audio.join();
+  EXPECT_FALSE(audio_cue);
+}
+
+}  // namespace media
+}  // namespace shaka
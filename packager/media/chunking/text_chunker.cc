@@ -22,11 +22,11 @@ TextChunker::TextChunker(double segment_duration_in_seconds)
 Status TextChunker::Process(std::unique_ptr<StreamData> data) {
   switch (data->stream_data_type) {
     case StreamDataType::kStreamInfo:
-      return OnStreamInfo(std::move(data->stream_info));
+      return OnStreamInfo(data->Take<StreamInfo>());
     case StreamDataType::kTextSample:
-      return OnTextSample(data->text_sample);
+      return OnTextSample(data->text_sample());
     case StreamDataType::kCueEvent:
-      return OnCueEvent(data->cue_event);
+      return OnCueEvent(data->cue_event());
     default:
       return Status(error::INTERNAL_ERROR,
                     "Invalid stream data type for this handler");
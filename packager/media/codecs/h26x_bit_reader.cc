@@ -6,6 +6,7 @@
 
 #include <absl/log/check.h>
 #include <absl/log/log.h>
+#include <absl/numeric/bits.h>
 
 namespace shaka {
 namespace media {
@@ -109,16 +110,26 @@ bool H26xBitReader::SkipBits(int num_bits) {
 }
 
 bool H26xBitReader::ReadUE(int* val) {
-  int num_bits = -1;
-  int bit;
+  int num_bits = 0;
   int rest;
 
-  // Count the number of contiguous zero bits.
-  do {
-    if (!ReadBits(1, &bit))
+  // Count the number of contiguous zero bits, a byte at a time.
+  while (true) {
+    if (num_remaining_bits_in_curr_byte_ == 0 && !UpdateCurrByte())
       return false;
-    num_bits++;
-  } while (bit == 0);
+    const unsigned remaining_bits =
+        curr_byte_ & ((1 << num_remaining_bits_in_curr_byte_) - 1);
+    if (remaining_bits != 0) {
+      const int num_zero_bits = num_remaining_bits_in_curr_byte_ -
+                                absl::bit_width(remaining_bits);
+      num_bits += num_zero_bits;
+      // Skip the zero bits and the one bit.
+      num_remaining_bits_in_curr_byte_ -= num_zero_bits + 1;
+      break;
+    }
+    num_bits += num_remaining_bits_in_curr_byte_;
+    num_remaining_bits_in_curr_byte_ = 0;
+  }
 
   if (num_bits > 31)
     return false;
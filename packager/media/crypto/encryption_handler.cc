@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include <absl/log/check.h>
 
@@ -17,6 +18,7 @@
 #include <packager/media/base/aes_encryptor.h>
 #include <packager/media/base/audio_stream_info.h>
 #include <packager/media/base/common_pssh_generator.h>
+#include <packager/media/base/decryptor_source.h>
 #include <packager/media/base/key_source.h>
 #include <packager/media/base/media_sample.h>
 #include <packager/media/base/playready_pssh_generator.h>
@@ -173,6 +175,14 @@ EncryptionHandler::EncryptionHandler(const EncryptionParams& encryption_params,
 
 EncryptionHandler::~EncryptionHandler() = default;
 
+void EncryptionHandler::SetDecryptionKeySource(
+    std::shared_ptr<KeySource> decryption_key_source) {
+  decryption_key_source_ = std::move(decryption_key_source);
+  decryptor_source_.reset(
+      decryption_key_source_ ? new DecryptorSource(decryption_key_source_.get())
+                             : nullptr);
+}
+
 Status EncryptionHandler::InitializeInternal() {
   if (!encryption_params_.stream_label_func) {
     return Status(error::INVALID_ARGUMENT, "Stream label function not set.");
@@ -184,13 +194,20 @@ Status EncryptionHandler::InitializeInternal() {
   return Status::OK;
 }
 
+Status EncryptionHandler::ProcessBatch(StreamDataBatch batch) {
+  StartBatchDispatch();
+  Status status = MediaHandler::ProcessBatch(std::move(batch));
+  status.Update(FinishBatchDispatch());
+  return status;
+}
+
 Status EncryptionHandler::Process(std::unique_ptr<StreamData> stream_data) {
   switch (stream_data->stream_data_type) {
     case StreamDataType::kStreamInfo:
-      return ProcessStreamInfo(*stream_data->stream_info);
+      return ProcessStreamInfo(*stream_data->stream_info());
     case StreamDataType::kSegmentInfo: {
       std::shared_ptr<SegmentInfo> segment_info(new SegmentInfo(
-          *stream_data->segment_info));
+          *stream_data->segment_info()));
 
       segment_info->is_encrypted = remaining_clear_lead_ <= 0;
 
@@ -207,7 +224,7 @@ Status EncryptionHandler::Process(std::unique_ptr<StreamData> stream_data) {
       return DispatchSegmentInfo(kStreamIndex, segment_info);
     }
     case StreamDataType::kMediaSample:
-      return ProcessMediaSample(std::move(stream_data->media_sample));
+      return ProcessMediaSample(stream_data->Take<MediaSample>());
     default:
       VLOG(3) << "Stream data type "
               << static_cast<int>(stream_data->stream_data_type) << " ignored.";
@@ -216,7 +233,7 @@ Status EncryptionHandler::Process(std::unique_ptr<StreamData> stream_data) {
 }
 
 Status EncryptionHandler::ProcessStreamInfo(const StreamInfo& clear_info) {
-  if (clear_info.is_encrypted()) {
+  if (clear_info.is_encrypted() && !decryptor_source_) {
     return Status(error::INVALID_ARGUMENT,
                   "Input stream is already encrypted.");
   }
@@ -237,6 +254,8 @@ Status EncryptionHandler::ProcessStreamInfo(const StreamInfo& clear_info) {
       *stream_info, encryption_params_.stream_label_func);
 
   SetupProtectionPattern(stream_info->stream_type());
+  if (stream_info->segment_history())
+    ReplaySegmentHistory(*stream_info->segment_history());
 
   EncryptionKey encryption_key;
   const bool key_rotation_enabled = crypto_period_duration_ != 0;
@@ -254,6 +273,8 @@ Status EncryptionHandler::ProcessStreamInfo(const StreamInfo& clear_info) {
   }
   if (!CreateEncryptor(encryption_key))
     return Status(error::ENCRYPTION_FAILURE, "Failed to create encryptor");
+  if (!key_rotation_enabled)
+    RETURN_IF_ERROR(SkipEncryptedSamples(num_skipped_encrypted_samples_));
 
   stream_info->set_is_encrypted(true);
   stream_info->set_has_clear_lead(encryption_params_.clear_lead_in_seconds > 0);
@@ -265,34 +286,17 @@ Status EncryptionHandler::ProcessStreamInfo(const StreamInfo& clear_info) {
 Status EncryptionHandler::ProcessMediaSample(
     std::shared_ptr<const MediaSample> clear_sample) {
   DCHECK(clear_sample);
+  if (clear_sample->is_encrypted())
+    return TranscryptMediaSample(std::move(clear_sample));
 
   // Process the frame even if the frame is not encrypted as the next
   // (encrypted) frame may be dependent on this clear frame.
   std::vector<SubsampleEntry> subsamples;
   RETURN_IF_ERROR(subsample_generator_->GenerateSubsamples(
-      clear_sample->data(), clear_sample->data_size(), &subsamples));
+      *clear_sample, clear_sample->data(), clear_sample->data_size(),
+      &subsamples));
 
-  // Need to setup the encryptor for new segments even if this segment does not
-  // need to be encrypted, so we can signal encryption metadata earlier to
-  // allows clients to prefetch the keys.
-  if (check_new_crypto_period_) {
-    // |dts| can be negative, e.g. after EditList adjustments. Normalized to 0
-    // in that case.
-    const int64_t dts = std::max(clear_sample->dts(), static_cast<int64_t>(0));
-    const int64_t current_crypto_period_index = dts / crypto_period_duration_;
-    const int32_t crypto_period_duration_in_seconds = static_cast<int32_t>(
-        encryption_params_.crypto_period_duration_in_seconds);
-    if (current_crypto_period_index != prev_crypto_period_index_) {
-      EncryptionKey encryption_key;
-      RETURN_IF_ERROR(key_source_->GetCryptoPeriodKey(
-          current_crypto_period_index, crypto_period_duration_in_seconds,
-          stream_label_, &encryption_key));
-      if (!CreateEncryptor(encryption_key))
-        return Status(error::ENCRYPTION_FAILURE, "Failed to create encryptor");
-      prev_crypto_period_index_ = current_crypto_period_index;
-    }
-    check_new_crypto_period_ = false;
-  }
+  RETURN_IF_ERROR(UpdateCryptoPeriod(*clear_sample));
 
   // Since there is no encryption needed right now, send the clear copy
   // downstream so we can save the costs of copying it.
@@ -305,35 +309,220 @@ Status EncryptionHandler::ProcessMediaSample(
 
   std::shared_ptr<uint8_t> cipher_sample_data(new uint8_t[ciphertext_size],
                                               std::default_delete<uint8_t[]>());
+  EncryptSampleData(clear_sample->data(), clear_sample->data_size(),
+                    subsamples, cipher_sample_data.get(), ciphertext_size);
+  return DispatchEncryptedSample(*clear_sample, std::move(cipher_sample_data),
+                                 subsamples);
+}
 
-  const uint8_t* source = clear_sample->data();
-  uint8_t* dest = cipher_sample_data.get();
-  if (!subsamples.empty()) {
-    size_t total_size = 0;
-    for (const SubsampleEntry& subsample : subsamples) {
-      if (subsample.clear_bytes > 0) {
-        // clear_bytes is the number of bytes to leave in the clear
+Status EncryptionHandler::TranscryptMediaSample(
+    std::shared_ptr<const MediaSample> encrypted_sample) {
+  DCHECK(decryptor_source_);
+  const DecryptConfig* decrypt_config = encrypted_sample->decrypt_config();
+  if (!decrypt_config) {
+    return Status(error::ENCRYPTION_FAILURE,
+                  "Missing decrypt config in encrypted sample.");
+  }
+
+  RETURN_IF_ERROR(UpdateCryptoPeriod(*encrypted_sample));
+
+  // The sample is decrypted and re-encrypted in place in a single buffer.
+  const bool encrypt = remaining_clear_lead_ <= 0;
+  const size_t data_size = encrypted_sample->data_size();
+  const size_t buffer_size =
+      encrypt ? encryptor_->RequiredOutputSize(data_size) : data_size;
+  std::shared_ptr<uint8_t> data(new uint8_t[buffer_size],
+                                std::default_delete<uint8_t[]>());
+
+  if (encrypt && CanReuseSubsamples(*decrypt_config)) {
+    // Transcrypt each subsample in one pass, while it is hot in the cache.
+    AesCryptor* decryptor =
+        decryptor_source_->GetSampleDecryptor(*decrypt_config);
+    if (!decryptor)
+      return Status(error::ENCRYPTION_FAILURE, "Failed to get decryptor.");
+    const std::vector<SubsampleEntry>& subsamples =
+        decrypt_config->subsamples();
+    if (subsamples.empty()) {
+      if (!decryptor->Crypt(encrypted_sample->data(), data_size, data.get()))
+        return Status(error::ENCRYPTION_FAILURE, "Failed to decrypt sample.");
+      EncryptBytes(data.get(), data_size, data.get(), buffer_size);
+    } else {
+      const uint8_t* source = encrypted_sample->data();
+      uint8_t* dest = data.get();
+      size_t remaining_size = data_size;
+      for (const SubsampleEntry& subsample : subsamples) {
+        const size_t subsample_size =
+            static_cast<size_t>(subsample.clear_bytes) + subsample.cipher_bytes;
+        if (subsample_size > remaining_size) {
+          return Status(error::ENCRYPTION_FAILURE,
+                        "Subsamples overflow sample buffer.");
+        }
+        remaining_size -= subsample_size;
         memcpy(dest, source, subsample.clear_bytes);
         source += subsample.clear_bytes;
         dest += subsample.clear_bytes;
-        total_size += subsample.clear_bytes;
+        if (subsample.cipher_bytes > 0) {
+          if (!decryptor->Crypt(source, subsample.cipher_bytes, dest)) {
+            return Status(error::ENCRYPTION_FAILURE,
+                          "Failed to decrypt subsample.");
+          }
+          EncryptBytes(dest, subsample.cipher_bytes, dest, buffer_size);
+          source += subsample.cipher_bytes;
+          dest += subsample.cipher_bytes;
+        }
       }
-      if (subsample.cipher_bytes > 0) {
-        // cipher_bytes is the number of bytes we want to encrypt
-        EncryptBytes(source, subsample.cipher_bytes, dest, ciphertext_size);
-        source += subsample.cipher_bytes;
-        dest += subsample.cipher_bytes;
-        total_size += subsample.cipher_bytes;
+      // Bytes after the last subsample, if any, are left in the clear.
+      memcpy(dest, source, remaining_size);
+    }
+    return DispatchEncryptedSample(*encrypted_sample, std::move(data),
+                                   subsamples);
+  }
+
+  if (!decryptor_source_->DecryptSampleBuffer(
+          decrypt_config, encrypted_sample->data(), data_size, data.get())) {
+    return Status(error::ENCRYPTION_FAILURE, "Failed to decrypt sample.");
+  }
+  std::vector<SubsampleEntry> subsamples;
+  RETURN_IF_ERROR(subsample_generator_->GenerateSubsamples(
+      *encrypted_sample, data.get(), data_size, &subsamples));
+
+  if (!encrypt) {
+    std::shared_ptr<MediaSample> clear_sample(encrypted_sample->Clone());
+    clear_sample->TransferData(std::move(data), data_size);
+    clear_sample->set_is_encrypted(false);
+    clear_sample->set_decrypt_config(nullptr);
+    return DispatchMediaSample(kStreamIndex, std::move(clear_sample));
+  }
+
+  EncryptSampleData(data.get(), data_size, subsamples, data.get(),
+                    buffer_size);
+  return DispatchEncryptedSample(*encrypted_sample, std::move(data),
+                                 subsamples);
+}
+
+Status EncryptionHandler::UpdateCryptoPeriod(const MediaSample& sample) {
+  // Need to setup the encryptor for new segments even if this segment does not
+  // need to be encrypted, so we can signal encryption metadata earlier to
+  // allows clients to prefetch the keys.
+  if (!check_new_crypto_period_)
+    return Status::OK;
+
+  // |dts| can be negative, e.g. after EditList adjustments. Normalized to 0
+  // in that case.
+  const int64_t dts = std::max(sample.dts(), static_cast<int64_t>(0));
+  const int64_t current_crypto_period_index = dts / crypto_period_duration_;
+  const int32_t crypto_period_duration_in_seconds = static_cast<int32_t>(
+      encryption_params_.crypto_period_duration_in_seconds);
+  if (current_crypto_period_index != prev_crypto_period_index_) {
+    EncryptionKey encryption_key;
+    RETURN_IF_ERROR(key_source_->GetCryptoPeriodKey(
+        current_crypto_period_index, crypto_period_duration_in_seconds,
+        stream_label_, &encryption_key));
+    if (!CreateEncryptor(encryption_key))
+      return Status(error::ENCRYPTION_FAILURE, "Failed to create encryptor");
+    if (current_crypto_period_index == skipped_crypto_period_index_) {
+      // The crypto period started in the skipped segments.
+      RETURN_IF_ERROR(SkipEncryptedSamples(num_skipped_encrypted_samples_));
+      skipped_crypto_period_index_ = -1;
+    }
+    prev_crypto_period_index_ = current_crypto_period_index;
+  }
+  check_new_crypto_period_ = false;
+  return Status::OK;
+}
+
+void EncryptionHandler::ReplaySegmentHistory(
+    const SegmentHistory& segment_history) {
+  // Same as processing the segment infos and samples of the skipped segments,
+  // see Process(), ProcessMediaSample() and UpdateCryptoPeriod().
+  for (const SegmentHistory::Segment& segment : segment_history.segments) {
+    if (crypto_period_duration_ != 0) {
+      const int64_t crypto_period_index =
+          std::max(segment.first_sample_dts, static_cast<int64_t>(0)) /
+          crypto_period_duration_;
+      if (crypto_period_index != skipped_crypto_period_index_) {
+        skipped_crypto_period_index_ = crypto_period_index;
+        num_skipped_encrypted_samples_ = 0;
       }
     }
-    DCHECK_EQ(total_size, clear_sample->data_size());
-  } else {
-    EncryptBytes(source, clear_sample->data_size(), dest, ciphertext_size);
+    if (remaining_clear_lead_ > 0)
+      remaining_clear_lead_ -= segment.duration;
+    else
+      num_skipped_encrypted_samples_ += segment.num_samples;
+  }
+}
+
+Status EncryptionHandler::SkipEncryptedSamples(uint64_t num_samples) {
+  DCHECK(encryptor_);
+  if (num_samples == 0 || encryptor_->use_constant_iv())
+    return Status::OK;
+  std::vector<uint8_t> iv = encryptor_->iv();
+  // 16-byte IVs are advanced by the block count of each sample, which needs
+  // the sample data.
+  if (iv.size() != 8) {
+    return Status(error::UNIMPLEMENTED,
+                  "Skipping encrypted samples requires 8-byte per-sample "
+                  "IVs.");
   }
+  // Same as calling AesCryptor::UpdateIv() |num_samples| times.
+  uint64_t increment = num_samples;
+  for (size_t i = iv.size(); increment > 0 && i > 0; --i) {
+    increment += iv[i - 1];
+    iv[i - 1] = increment & 0xFF;
+    increment >>= 8;
+  }
+  if (!encryptor_->SetIv(iv))
+    return Status(error::ENCRYPTION_FAILURE, "Failed to set IV.");
+  return Status::OK;
+}
+
+bool EncryptionHandler::CanReuseSubsamples(
+    const DecryptConfig& decrypt_config) const {
+  // The input subsamples are valid for the output if only the key changes.
+  return decrypt_config.protection_scheme() == protection_scheme_ &&
+         decrypt_config.crypt_byte_block() == crypt_byte_block_ &&
+         decrypt_config.skip_byte_block() == skip_byte_block_;
+}
+
+void EncryptionHandler::EncryptSampleData(
+    const uint8_t* source,
+    size_t source_size,
+    const std::vector<SubsampleEntry>& subsamples,
+    uint8_t* dest,
+    size_t dest_size) {
+  if (subsamples.empty()) {
+    EncryptBytes(source, source_size, dest, dest_size);
+    return;
+  }
+
+  size_t total_size = 0;
+  for (const SubsampleEntry& subsample : subsamples) {
+    if (subsample.clear_bytes > 0) {
+      // clear_bytes is the number of bytes to leave in the clear
+      if (dest != source)
+        memcpy(dest, source, subsample.clear_bytes);
+      source += subsample.clear_bytes;
+      dest += subsample.clear_bytes;
+      total_size += subsample.clear_bytes;
+    }
+    if (subsample.cipher_bytes > 0) {
+      // cipher_bytes is the number of bytes we want to encrypt
+      EncryptBytes(source, subsample.cipher_bytes, dest, dest_size);
+      source += subsample.cipher_bytes;
+      dest += subsample.cipher_bytes;
+      total_size += subsample.cipher_bytes;
+    }
+  }
+  DCHECK_EQ(total_size, source_size);
+}
 
-  std::shared_ptr<MediaSample> cipher_sample(clear_sample->Clone());
+Status EncryptionHandler::DispatchEncryptedSample(
+    const MediaSample& source_sample,
+    std::shared_ptr<uint8_t> cipher_sample_data,
+    const std::vector<SubsampleEntry>& subsamples) {
+  std::shared_ptr<MediaSample> cipher_sample(source_sample.Clone());
   cipher_sample->TransferData(std::move(cipher_sample_data),
-                              clear_sample->data_size());
+                              source_sample.data_size());
 
   // Finish initializing the sample before sending it downstream. We must
   // wait until now to finish the initialization as we will lose access to
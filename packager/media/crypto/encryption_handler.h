@@ -7,7 +7,11 @@
 #ifndef PACKAGER_MEDIA_CRYPTO_ENCRYPTION_HANDLER_H_
 #define PACKAGER_MEDIA_CRYPTO_ENCRYPTION_HANDLER_H_
 
+#include <memory>
+#include <vector>
+
 #include <packager/crypto_params.h>
+#include <packager/media/base/decrypt_config.h>
 #include <packager/media/base/key_source.h>
 #include <packager/media/base/media_handler.h>
 
@@ -16,6 +20,7 @@ namespace media {
 
 class AesCryptor;
 class AesEncryptorFactory;
+class DecryptorSource;
 class SubsampleGenerator;
 struct EncryptionKey;
 
@@ -26,11 +31,20 @@ class EncryptionHandler : public MediaHandler {
 
   ~EncryptionHandler() override;
 
+  /// Enables transcrypting of encrypted input streams. Encrypted input samples
+  /// are decrypted with keys from @a decryption_key_source and re-encrypted
+  /// in the same buffer, instead of being decrypted by the demuxer first. The
+  /// input subsamples are reused if only the key changes.
+  /// @param decryption_key_source is the key source for the input keys. It
+  ///        can be shared with the handlers of the other streams of the input.
+  void SetDecryptionKeySource(std::shared_ptr<KeySource> decryption_key_source);
+
  protected:
   /// @name MediaHandler implementation overrides.
   /// @{
   Status InitializeInternal() override;
   Status Process(std::unique_ptr<StreamData> stream_data) override;
+  Status ProcessBatch(StreamDataBatch batch) override;
   /// @}
 
  private:
@@ -43,6 +57,30 @@ class EncryptionHandler : public MediaHandler {
   Status ProcessStreamInfo(const StreamInfo& stream_info);
   // Processes media sample and encrypts it if needed.
   Status ProcessMediaSample(std::shared_ptr<const MediaSample> clear_sample);
+  // Processes encrypted media sample and re-encrypts it if needed.
+  Status TranscryptMediaSample(
+      std::shared_ptr<const MediaSample> encrypted_sample);
+  // Switches to the key of a new crypto period if needed.
+  Status UpdateCryptoPeriod(const MediaSample& sample);
+  // Restores the clear lead and counts the encrypted samples of the segments
+  // skipped when a single segment is packaged.
+  void ReplaySegmentHistory(const SegmentHistory& segment_history);
+  // Advances the per-sample IV as if |num_samples| samples were encrypted.
+  Status SkipEncryptedSamples(uint64_t num_samples);
+  // Returns true if the subsamples in |decrypt_config| can be used for the
+  // re-encrypted sample.
+  bool CanReuseSubsamples(const DecryptConfig& decrypt_config) const;
+  // Encrypts |source| as described by |subsamples| into |dest|, which may be
+  // the same as |source|.
+  void EncryptSampleData(const uint8_t* source,
+                         size_t source_size,
+                         const std::vector<SubsampleEntry>& subsamples,
+                         uint8_t* dest,
+                         size_t dest_size);
+  // Dispatches a copy of |source_sample| with |cipher_sample_data|.
+  Status DispatchEncryptedSample(const MediaSample& source_sample,
+                                 std::shared_ptr<uint8_t> cipher_sample_data,
+                                 const std::vector<SubsampleEntry>& subsamples);
 
   void SetupProtectionPattern(StreamType stream_type);
   bool CreateEncryptor(const EncryptionKey& encryption_key);
@@ -86,6 +124,14 @@ class EncryptionHandler : public MediaHandler {
   // Previous crypto period index if key rotation is enabled.
   int64_t prev_crypto_period_index_ = -1;
   bool check_new_crypto_period_ = false;
+  // The encrypted samples of the skipped segments in the crypto period of the
+  // last skipped segment, see ReplaySegmentHistory().
+  uint64_t num_skipped_encrypted_samples_ = 0;
+  int64_t skipped_crypto_period_index_ = -1;
+
+  // Only set when transcrypting.
+  std::shared_ptr<KeySource> decryption_key_source_;
+  std::unique_ptr<DecryptorSource> decryptor_source_;
 
   std::unique_ptr<SubsampleGenerator> subsample_generator_;
   std::unique_ptr<AesEncryptorFactory> encryptor_factory_;
@@ -10,7 +10,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <packager/macros/status.h>
 #include <packager/media/base/aes_cryptor.h>
+#include <packager/media/base/aes_encryptor.h>
+#include <packager/media/base/decryptor_source.h>
 #include <packager/media/base/media_handler_test_base.h>
 #include <packager/media/base/mock_aes_cryptor.h>
 #include <packager/media/base/protection_system_ids.h>
@@ -78,8 +81,9 @@ class MockSubsampleGenerator : public SubsampleGenerator {
 
   MOCK_METHOD2(Initialize,
                Status(FourCC protection_scheme, const StreamInfo& stream_info));
-  MOCK_METHOD3(GenerateSubsamples,
-               Status(const uint8_t* frame,
+  MOCK_METHOD4(GenerateSubsamples,
+               Status(const MediaSample& sample,
+                      const uint8_t* frame,
                       size_t frame_size,
                       std::vector<SubsampleEntry>* subsamples));
 };
@@ -139,9 +143,9 @@ class EncryptionHandlerTest : public MediaHandlerGraphTestBase {
   void InjectSubsamples(const std::vector<SubsampleEntry>& subsamples) {
     std::unique_ptr<MockSubsampleGenerator> mock_generator(
         new MockSubsampleGenerator);
-    EXPECT_CALL(*mock_generator, GenerateSubsamples(_, _, _))
+    EXPECT_CALL(*mock_generator, GenerateSubsamples(_, _, _, _))
         .WillRepeatedly(
-            DoAll(SetArgPointee<2>(subsamples), Return(Status::OK)));
+            DoAll(SetArgPointee<3>(subsamples), Return(Status::OK)));
 
     encryption_handler_->InjectSubsampleGeneratorForTesting(
         std::move(mock_generator));
@@ -338,7 +342,7 @@ TEST_P(EncryptionHandlerEncryptionTest, ClearLeadWithNoKeyRotation) {
       GetOutputStreamDataVector(),
       ElementsAre(IsStreamInfo(kStreamIndex, kTimeScale, kEncrypted, _)));
   const StreamInfo* stream_info =
-      GetOutputStreamDataVector().back()->stream_info.get();
+      GetOutputStreamDataVector().back()->stream_info().get();
   ASSERT_TRUE(stream_info);
   EXPECT_TRUE(stream_info->has_clear_lead());
   EXPECT_THAT(stream_info->encryption_config(),
@@ -367,7 +371,8 @@ TEST_P(EncryptionHandlerEncryptionTest, ClearLeadWithNoKeyRotation) {
                                           kSegmentDuration, !kIsSubsegment,
                                           is_encrypted)));
     if (is_encrypted) {
-      const auto* media_sample = output_stream_data.front()->media_sample.get();
+      const auto* media_sample =
+          output_stream_data.front()->media_sample().get();
       const auto* decrypt_config = media_sample->decrypt_config();
       EXPECT_EQ(std::vector<uint8_t>(kKeyId, kKeyId + sizeof(kKeyId)),
                 decrypt_config->key_id());
@@ -380,7 +385,7 @@ TEST_P(EncryptionHandlerEncryptionTest, ClearLeadWithNoKeyRotation) {
       EXPECT_EQ(GetExpectedSkipByteBlock(), decrypt_config->skip_byte_block());
     }
     EXPECT_FALSE(output_stream_data.back()
-                     ->segment_info->key_rotation_encryption_config);
+                     ->segment_info()->key_rotation_encryption_config);
     ClearOutputStreamDataVector();
   }
 }
@@ -409,7 +414,7 @@ TEST_P(EncryptionHandlerEncryptionTest, ClearLeadWithKeyRotation) {
       GetOutputStreamDataVector(),
       ElementsAre(IsStreamInfo(kStreamIndex, kTimeScale, kEncrypted, _)));
   const StreamInfo* stream_info =
-      GetOutputStreamDataVector().back()->stream_info.get();
+      GetOutputStreamDataVector().back()->stream_info().get();
   ASSERT_TRUE(stream_info);
   EXPECT_TRUE(stream_info->has_clear_lead());
   const EncryptionConfig& encryption_config = stream_info->encryption_config();
@@ -446,7 +451,7 @@ TEST_P(EncryptionHandlerEncryptionTest, ClearLeadWithKeyRotation) {
                                           kSegmentDuration, !kIsSubsegment,
                                           is_encrypted)));
     EXPECT_THAT(*output_stream_data.back()
-                     ->segment_info->key_rotation_encryption_config,
+                     ->segment_info()->key_rotation_encryption_config,
                 MatchEncryptionConfig(
                     protection_scheme_, GetExpectedCryptByteBlock(),
                     GetExpectedSkipByteBlock(), GetExpectedPerSampleIvSize(),
@@ -465,6 +470,106 @@ INSTANTIATE_TEST_CASE_P(ProtectionSchemes,
                                        FOURCC_cbcs),
                                 Values(kCodecAAC, kCodecH264)));
 
+class EncryptionHandlerSegmentHistoryTest : public EncryptionHandlerTest {
+ protected:
+  void SetUp() override {
+    encryption_params_.protection_scheme = FOURCC_cenc;
+    encryption_params_.clear_lead_in_seconds =
+        1.5 * kSegmentDuration / kTimeScale;
+    encryption_key_ = GetMockEncryptionKey();
+    encryption_key_.iv.resize(8);
+  }
+
+  // Encrypts the single sample segments from |first_segment| to
+  // |end_segment|, with the segments before |first_segment| in the segment
+  // history, and gets the IVs of the samples, which are empty for clear
+  // samples.
+  Status EncryptSegments(int first_segment,
+                         int end_segment,
+                         std::vector<std::vector<uint8_t>>* ivs) {
+    SetUpEncryptionHandler(encryption_params_);
+    EXPECT_CALL(mock_key_source_, GetKey(_, _))
+        .WillRepeatedly(
+            DoAll(SetArgPointee<1>(encryption_key_), Return(Status::OK)));
+    EXPECT_CALL(mock_key_source_, GetCryptoPeriodKey(_, _, _, _))
+        .WillRepeatedly(
+            DoAll(SetArgPointee<3>(encryption_key_), Return(Status::OK)));
+
+    std::shared_ptr<StreamInfo> stream_info = GetVideoStreamInfo(kTimeScale);
+    auto segment_history = std::make_shared<SegmentHistory>();
+    for (int i = 0; i < first_segment; ++i) {
+      SegmentHistory::Segment segment;
+      segment.start_timestamp = i * kSegmentDuration;
+      segment.duration = kSegmentDuration;
+      segment.first_sample_dts = i * kSegmentDuration;
+      segment.num_samples = 1;
+      segment_history->segments.push_back(segment);
+    }
+    stream_info->set_segment_history(segment_history);
+    ClearOutputStreamDataVector();
+    RETURN_IF_ERROR(
+        Process(StreamData::FromStreamInfo(kStreamIndex, stream_info)));
+
+    for (int i = first_segment; i < end_segment; ++i) {
+      RETURN_IF_ERROR(Process(StreamData::FromMediaSample(
+          kStreamIndex, GetMediaSample(i * kSegmentDuration, kSegmentDuration,
+                                       kIsKeyFrame, kData, kDataSize))));
+      RETURN_IF_ERROR(Process(StreamData::FromSegmentInfo(
+          kStreamIndex, GetSegmentInfo(i * kSegmentDuration, kSegmentDuration,
+                                       !kIsSubsegment))));
+    }
+    ivs->clear();
+    for (const auto& stream_data : GetOutputStreamDataVector()) {
+      if (stream_data->stream_data_type != StreamDataType::kMediaSample)
+        continue;
+      const DecryptConfig* decrypt_config =
+          stream_data->media_sample()->decrypt_config();
+      ivs->push_back(decrypt_config ? decrypt_config->iv()
+                                    : std::vector<uint8_t>());
+    }
+    return Status::OK;
+  }
+
+  // Expects each segment to be encrypted as in a full run when it is
+  // encrypted alone after its segment history.
+  void ExpectSameIvsAsFullRun() {
+    const int kNumSegments = 6;
+    std::vector<std::vector<uint8_t>> full_run_ivs;
+    ASSERT_OK(EncryptSegments(0, kNumSegments, &full_run_ivs));
+    ASSERT_EQ(static_cast<size_t>(kNumSegments), full_run_ivs.size());
+    EXPECT_TRUE(full_run_ivs[0].empty());
+    EXPECT_FALSE(full_run_ivs[kNumSegments - 1].empty());
+
+    for (int i = 1; i < kNumSegments; ++i) {
+      SCOPED_TRACE(i);
+      std::vector<std::vector<uint8_t>> ivs;
+      ASSERT_OK(EncryptSegments(i, i + 1, &ivs));
+      ASSERT_EQ(1u, ivs.size());
+      EXPECT_EQ(full_run_ivs[i], ivs[0]);
+    }
+  }
+
+  EncryptionParams encryption_params_;
+  EncryptionKey encryption_key_;
+};
+
+TEST_F(EncryptionHandlerSegmentHistoryTest, NoKeyRotation) {
+  ExpectSameIvsAsFullRun();
+}
+
+TEST_F(EncryptionHandlerSegmentHistoryTest, KeyRotation) {
+  encryption_params_.crypto_period_duration_in_seconds =
+      2.0 * kSegmentDuration / kTimeScale;
+  ExpectSameIvsAsFullRun();
+}
+
+TEST_F(EncryptionHandlerSegmentHistoryTest, SixteenByteIvNotSupported) {
+  encryption_key_ = GetMockEncryptionKey();
+  std::vector<std::vector<uint8_t>> ivs;
+  EXPECT_EQ(error::UNIMPLEMENTED,
+            EncryptSegments(3, 4, &ivs).error_code());
+}
+
 struct SubsampleTestCase {
   std::vector<SubsampleEntry> subsamples;
   std::vector<uint8_t> expected_output;
@@ -551,7 +656,7 @@ TEST_P(EncryptionHandlerSubsampleTest, SubsampleTest) {
                           IsMediaSample(kStreamIndex, 0, kSampleDuration,
                                         kEncrypted, _)));
 
-  const MediaSample& sample = *output_stream_data.back()->media_sample;
+  const MediaSample& sample = *output_stream_data.back()->media_sample();
   EXPECT_EQ(
       GetParam().expected_output,
       std::vector<uint8_t>(sample.data(), sample.data() + sample.data_size()));
@@ -560,6 +665,182 @@ TEST_P(EncryptionHandlerSubsampleTest, SubsampleTest) {
   EXPECT_EQ(GetParam().subsamples, decrypt_config.subsamples());
 }
 
+namespace {
+
+const uint8_t kInputKeyId[]{
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+    0x28, 0x29, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35,
+};
+const uint8_t kInputKey[]{
+    0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+    0x48, 0x49, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55,
+};
+const uint8_t kInputIv[]{
+    0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67,
+};
+const size_t kTranscryptDataSize = 100;
+
+class MockDecryptionKeySource : public RawKeySource {
+ public:
+  MOCK_METHOD2(GetKey,
+               Status(const std::vector<uint8_t>& key_id, EncryptionKey* key));
+};
+
+std::unique_ptr<KeySource> CreateMockDecryptionKeySource(const uint8_t* key_id,
+                                                         size_t key_id_size,
+                                                         const uint8_t* key,
+                                                         size_t key_size) {
+  EncryptionKey encryption_key;
+  encryption_key.key.assign(key, key + key_size);
+  std::unique_ptr<MockDecryptionKeySource> key_source(
+      new MockDecryptionKeySource);
+  EXPECT_CALL(*key_source,
+              GetKey(std::vector<uint8_t>(key_id, key_id + key_id_size), _))
+      .WillRepeatedly(
+          DoAll(SetArgPointee<1>(encryption_key), Return(Status::OK)));
+  return std::move(key_source);
+}
+
+}  // namespace
+
+class EncryptionHandlerTranscryptTest
+    : public EncryptionHandlerTest,
+      public WithParamInterface<FourCC> {
+ public:
+  void SetUp() override {
+    for (size_t i = 0; i < kTranscryptDataSize; ++i)
+      clear_data_.push_back(static_cast<uint8_t>(i * 7));
+  }
+
+  void SetUpTranscryptHandler(double clear_lead_in_seconds) {
+    EncryptionParams encryption_params;
+    encryption_params.protection_scheme = GetParam();
+    encryption_params.clear_lead_in_seconds = clear_lead_in_seconds;
+    SetUpEncryptionHandler(encryption_params);
+    encryption_handler_->SetDecryptionKeySource(CreateMockDecryptionKeySource(
+        kInputKeyId, sizeof(kInputKeyId), kInputKey, sizeof(kInputKey)));
+  }
+
+  // Returns a 'cenc' encrypted copy of |clear_data_|.
+  std::shared_ptr<MediaSample> GetEncryptedSample(
+      const std::vector<SubsampleEntry>& subsamples) {
+    const std::vector<uint8_t> key(std::begin(kInputKey),
+                                   std::end(kInputKey));
+    const std::vector<uint8_t> iv(std::begin(kInputIv), std::end(kInputIv));
+    AesCtrEncryptor encryptor;
+    EXPECT_TRUE(encryptor.InitializeWithIv(key, iv));
+    std::vector<uint8_t> data = clear_data_;
+    size_t offset = 0;
+    for (const SubsampleEntry& subsample : subsamples) {
+      offset += subsample.clear_bytes;
+      EXPECT_TRUE(encryptor.Crypt(&data[offset], subsample.cipher_bytes,
+                                  &data[offset]));
+      offset += subsample.cipher_bytes;
+    }
+
+    std::shared_ptr<MediaSample> sample = GetMediaSample(
+        0, kSampleDuration, kIsKeyFrame, data.data(), data.size());
+    sample->set_is_encrypted(true);
+    sample->set_decrypt_config(std::unique_ptr<DecryptConfig>(
+        new DecryptConfig(std::vector<uint8_t>(std::begin(kInputKeyId),
+                                               std::end(kInputKeyId)),
+                          iv, subsamples)));
+    return sample;
+  }
+
+  std::unique_ptr<StreamInfo> GetEncryptedVideoStreamInfo() {
+    std::unique_ptr<StreamInfo> info =
+        GetVideoStreamInfo(kTimeScale, kCodecH264);
+    info->set_is_encrypted(true);
+    EncryptionConfig encryption_config;
+    encryption_config.protection_scheme = FOURCC_cenc;
+    encryption_config.key_id.assign(std::begin(kInputKeyId),
+                                    std::end(kInputKeyId));
+    info->set_encryption_config(encryption_config);
+    return info;
+  }
+
+  // Decrypts |sample| with the output key.
+  std::vector<uint8_t> Decrypt(const MediaSample& sample) {
+    std::unique_ptr<KeySource> key_source = CreateMockDecryptionKeySource(
+        kKeyId, sizeof(kKeyId), kKey, sizeof(kKey));
+    DecryptorSource decryptor_source(key_source.get());
+    std::vector<uint8_t> data(sample.data(),
+                              sample.data() + sample.data_size());
+    EXPECT_TRUE(decryptor_source.DecryptSampleBuffer(
+        sample.decrypt_config(), data.data(), data.size(), data.data()));
+    return data;
+  }
+
+ protected:
+  std::vector<uint8_t> clear_data_;
+};
+
+TEST_P(EncryptionHandlerTranscryptTest, Transcrypt) {
+  SetUpTranscryptHandler(0);
+  EXPECT_CALL(mock_key_source_, GetKey(_, _))
+      .WillOnce(
+          DoAll(SetArgPointee<1>(GetMockEncryptionKey()), Return(Status::OK)));
+  // Used if the input subsamples cannot be reused.
+  const std::vector<SubsampleEntry> generated_subsamples = {{20, 64},
+                                                            {16, 0}};
+  InjectSubsamples(generated_subsamples);
+
+  const std::vector<SubsampleEntry> input_subsamples = {{4, 32}, {20, 44}};
+  ASSERT_OK(Process(
+      StreamData::FromStreamInfo(kStreamIndex, GetEncryptedVideoStreamInfo())));
+  ASSERT_OK(Process(StreamData::FromMediaSample(
+      kStreamIndex, GetEncryptedSample(input_subsamples))));
+
+  const auto& output_stream_data = GetOutputStreamDataVector();
+  EXPECT_THAT(output_stream_data,
+              ElementsAre(IsStreamInfo(kStreamIndex, kTimeScale, kEncrypted, _),
+                          IsMediaSample(kStreamIndex, 0, kSampleDuration,
+                                        kEncrypted, _)));
+  const StreamInfo& info = *output_stream_data.front()->stream_info();
+  EXPECT_EQ(GetParam(), info.encryption_config().protection_scheme);
+  EXPECT_EQ(std::vector<uint8_t>(std::begin(kKeyId), std::end(kKeyId)),
+            info.encryption_config().key_id);
+
+  const MediaSample& sample = *output_stream_data.back()->media_sample();
+  const DecryptConfig& decrypt_config = *sample.decrypt_config();
+  EXPECT_EQ(GetParam(), decrypt_config.protection_scheme());
+  EXPECT_EQ(GetParam() == FOURCC_cenc ? input_subsamples
+                                      : generated_subsamples,
+            decrypt_config.subsamples());
+  const std::vector<uint8_t> data(sample.data(),
+                                 sample.data() + sample.data_size());
+  EXPECT_NE(clear_data_, data);
+  EXPECT_EQ(clear_data_, Decrypt(sample));
+}
+
+TEST_P(EncryptionHandlerTranscryptTest, ClearLead) {
+  const double kClearLeadInSeconds = 1;
+  SetUpTranscryptHandler(kClearLeadInSeconds);
+  EXPECT_CALL(mock_key_source_, GetKey(_, _))
+      .WillOnce(
+          DoAll(SetArgPointee<1>(GetMockEncryptionKey()), Return(Status::OK)));
+  ASSERT_OK(Process(
+      StreamData::FromStreamInfo(kStreamIndex, GetEncryptedVideoStreamInfo())));
+  ASSERT_OK(Process(StreamData::FromMediaSample(
+      kStreamIndex, GetEncryptedSample({{4, 32}, {20, 44}}))));
+
+  const auto& output_stream_data = GetOutputStreamDataVector();
+  EXPECT_THAT(output_stream_data,
+              ElementsAre(IsStreamInfo(kStreamIndex, kTimeScale, kEncrypted, _),
+                          IsMediaSample(kStreamIndex, 0, kSampleDuration,
+                                        !kEncrypted, _)));
+  const MediaSample& sample = *output_stream_data.back()->media_sample();
+  EXPECT_FALSE(sample.decrypt_config());
+  EXPECT_EQ(clear_data_, std::vector<uint8_t>(
+                             sample.data(),
+                             sample.data() + sample.data_size()));
+}
+
+INSTANTIATE_TEST_CASE_P(ProtectionSchemes,
+                        EncryptionHandlerTranscryptTest,
+                        Values(FOURCC_cenc, FOURCC_cbcs));
+
 class EncryptionHandlerTrackTypeTest : public EncryptionHandlerTest {};
 
 TEST_F(EncryptionHandlerTrackTypeTest, AudioTrackType) {
@@ -626,7 +907,7 @@ TEST_F(EncryptionHandlerPsshTest, GeneratesPssh) {
   EXPECT_THAT(GetOutputStreamDataVector(),
               ElementsAre(IsStreamInfo(_, kTimeScale, kEncrypted, _)));
   const StreamInfo* stream_info =
-      GetOutputStreamDataVector().back()->stream_info.get();
+      GetOutputStreamDataVector().back()->stream_info().get();
 
   std::vector<uint8_t> widevine_system_id(
       kWidevineSystemId, kWidevineSystemId + std::size(kWidevineSystemId));
@@ -660,7 +941,7 @@ TEST_F(EncryptionHandlerPsshTest, UsesKeyInfoFirst) {
   EXPECT_THAT(GetOutputStreamDataVector(),
               ElementsAre(IsStreamInfo(_, kTimeScale, kEncrypted, _)));
   const StreamInfo* stream_info =
-      GetOutputStreamDataVector().back()->stream_info.get();
+      GetOutputStreamDataVector().back()->stream_info().get();
 
   ASSERT_THAT(stream_info->encryption_config().key_system_info,
               ElementsAre(IsPsshInfoWithSystemId(widevine_system_id)));
@@ -93,7 +93,10 @@ bool SampleAesEc3Cryptor::CryptInternal(const uint8_t* text,
   const size_t kLeadingClearBytesSize = 16u;
 
   for (size_t syncframe_size : syncframe_sizes) {
-    memcpy(crypt_text, text, std::min(syncframe_size, kLeadingClearBytesSize));
+    if (crypt_text != text) {
+      memcpy(crypt_text, text,
+             std::min(syncframe_size, kLeadingClearBytesSize));
+    }
     if (syncframe_size > kLeadingClearBytesSize) {
       // The residual block is left untouched (copied without
       // encryption/decryption). No need to do special handling here.
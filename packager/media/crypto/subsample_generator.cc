@@ -12,7 +12,9 @@
 #include <absl/log/check.h>
 
 #include <packager/macros/compiler.h>
+#include <packager/macros/status.h>
 #include <packager/media/base/decrypt_config.h>
+#include <packager/media/base/media_sample.h>
 #include <packager/media/base/video_stream_info.h>
 #include <packager/media/codecs/av1_parser.h>
 #include <packager/media/codecs/video_slice_header_parser.h>
@@ -118,6 +120,25 @@ class SubsampleOrganizer {
   size_t accumulated_clear_bytes_ = 0;
 };
 
+bool IsParameterSet(Nalu::CodecType nalu_type, const Nalu& nalu) {
+  if (nalu_type == Nalu::kH264)
+    return nalu.type() == Nalu::H264_SPS || nalu.type() == Nalu::H264_PPS;
+  return nalu.type() == Nalu::H265_SPS || nalu.type() == Nalu::H265_PPS;
+}
+
+void AddRange(size_t clear_bytes,
+              size_t protectable_bytes,
+              SubsampleLayout* layout) {
+  layout->ranges.push_back({clear_bytes, protectable_bytes});
+}
+
+size_t GetLayoutSize(const SubsampleLayout& layout) {
+  size_t size = 0;
+  for (const SubsampleLayout::Range& range : layout.ranges)
+    size += range.clear_bytes + range.protectable_bytes;
+  return size;
+}
+
 }  // namespace
 
 SubsampleGenerator::SubsampleGenerator(bool vp9_subsample_encryption)
@@ -214,30 +235,77 @@ Status SubsampleGenerator::GenerateSubsamples(
     const uint8_t* frame,
     size_t frame_size,
     std::vector<SubsampleEntry>* subsamples) {
-  subsamples->clear();
+  SubsampleLayout layout;
+  RETURN_IF_ERROR(FindProtectableRanges(frame, frame_size, &layout));
+  OrganizeSubsamples(layout, subsamples);
+  return Status::OK;
+}
+
+Status SubsampleGenerator::GenerateSubsamples(
+    const MediaSample& sample,
+    const uint8_t* frame,
+    size_t frame_size,
+    std::vector<SubsampleEntry>* subsamples) {
+  // Only the slice header parsing for NAL structured video is shared. The VPx
+  // and AV1 parsers keep state from every frame, so they cannot skip any.
+  const bool share_layout = header_parser_ && leading_clear_bytes_size_ == 0;
+  if (!share_layout)
+    return GenerateSubsamples(frame, frame_size, subsamples);
+
+  std::shared_ptr<const SubsampleLayout> layout = sample.subsample_layout();
+  // Frames with parameter sets are always parsed to keep |header_parser_| up
+  // to date.
+  if (!layout || layout->has_parameter_sets ||
+      GetLayoutSize(*layout) != frame_size) {
+    std::shared_ptr<SubsampleLayout> new_layout(new SubsampleLayout);
+    RETURN_IF_ERROR(FindProtectableRanges(frame, frame_size, new_layout.get()));
+    if (!layout)
+      sample.set_subsample_layout(new_layout);
+    layout = std::move(new_layout);
+  }
+  OrganizeSubsamples(*layout, subsamples);
+  return Status::OK;
+}
+
+void SubsampleGenerator::InjectVpxParserForTesting(
+    std::unique_ptr<VPxParser> vpx_parser) {
+  vpx_parser_ = std::move(vpx_parser);
+}
+
+void SubsampleGenerator::InjectVideoSliceHeaderParserForTesting(
+    std::unique_ptr<VideoSliceHeaderParser> header_parser) {
+  header_parser_ = std::move(header_parser);
+}
+
+void SubsampleGenerator::InjectAV1ParserForTesting(
+    std::unique_ptr<AV1Parser> av1_parser) {
+  av1_parser_ = std::move(av1_parser);
+}
+
+Status SubsampleGenerator::FindProtectableRanges(const uint8_t* frame,
+                                                 size_t frame_size,
+                                                 SubsampleLayout* layout) {
   switch (codec_) {
     case kCodecAV1:
-      return GenerateSubsamplesFromAV1Frame(frame, frame_size, subsamples);
+      return FindProtectableRangesInAV1Frame(frame, frame_size, layout);
     case kCodecH264:
       FALLTHROUGH_INTENDED;
     case kCodecH265:
     case kCodecH265DolbyVision:
-      return GenerateSubsamplesFromH26xFrame(frame, frame_size, subsamples);
+      return FindProtectableRangesInH26xFrame(frame, frame_size, layout);
     case kCodecVP9:
       if (vp9_subsample_encryption_)
-        return GenerateSubsamplesFromVPxFrame(frame, frame_size, subsamples);
+        return FindProtectableRangesInVPxFrame(frame, frame_size, layout);
       // Full sample encrypted so no subsamples.
       break;
     default:
       // Other codecs are full sample encrypted unless there are clear leading
       // bytes.
       if (leading_clear_bytes_size_ > 0) {
-        SubsampleOrganizer subsample_organizer(align_protected_data_,
-                                               subsamples);
         const size_t clear_bytes =
             std::min(frame_size, leading_clear_bytes_size_);
         const size_t cipher_bytes = frame_size - clear_bytes;
-        subsample_organizer.AddSubsample(clear_bytes, cipher_bytes);
+        AddRange(clear_bytes, cipher_bytes, layout);
       } else {
         // Full sample encrypted so no subsamples.
       }
@@ -246,37 +314,30 @@ Status SubsampleGenerator::GenerateSubsamples(
   return Status::OK;
 }
 
-void SubsampleGenerator::InjectVpxParserForTesting(
-    std::unique_ptr<VPxParser> vpx_parser) {
-  vpx_parser_ = std::move(vpx_parser);
-}
-
-void SubsampleGenerator::InjectVideoSliceHeaderParserForTesting(
-    std::unique_ptr<VideoSliceHeaderParser> header_parser) {
-  header_parser_ = std::move(header_parser);
-}
-
-void SubsampleGenerator::InjectAV1ParserForTesting(
-    std::unique_ptr<AV1Parser> av1_parser) {
-  av1_parser_ = std::move(av1_parser);
+void SubsampleGenerator::OrganizeSubsamples(
+    const SubsampleLayout& layout,
+    std::vector<SubsampleEntry>* subsamples) {
+  subsamples->clear();
+  SubsampleOrganizer subsample_organizer(align_protected_data_, subsamples);
+  for (const SubsampleLayout::Range& range : layout.ranges) {
+    subsample_organizer.AddSubsample(range.clear_bytes,
+                                     range.protectable_bytes);
+  }
 }
 
-Status SubsampleGenerator::GenerateSubsamplesFromVPxFrame(
+Status SubsampleGenerator::FindProtectableRangesInVPxFrame(
     const uint8_t* frame,
     size_t frame_size,
-    std::vector<SubsampleEntry>* subsamples) {
+    SubsampleLayout* layout) {
   DCHECK(vpx_parser_);
   std::vector<VPxFrameInfo> vpx_frames;
   if (!vpx_parser_->Parse(frame, frame_size, &vpx_frames))
     return Status(error::ENCRYPTION_FAILURE, "Failed to parse vpx frame.");
 
-  SubsampleOrganizer subsample_organizer(align_protected_data_, subsamples);
-
   size_t total_size = 0;
   for (const VPxFrameInfo& vpx_frame : vpx_frames) {
-    subsample_organizer.AddSubsample(
-        vpx_frame.uncompressed_header_size,
-        vpx_frame.frame_size - vpx_frame.uncompressed_header_size);
+    AddRange(vpx_frame.uncompressed_header_size,
+             vpx_frame.frame_size - vpx_frame.uncompressed_header_size, layout);
     total_size += vpx_frame.frame_size;
   }
   // Add subsample for the superframe index if exists.
@@ -285,22 +346,20 @@ Status SubsampleGenerator::GenerateSubsamplesFromVPxFrame(
     const size_t index_size = frame_size - total_size;
     DCHECK_LE(index_size, 2 + vpx_frames.size() * 4);
     DCHECK_GE(index_size, 2 + vpx_frames.size() * 1);
-    subsample_organizer.AddSubsample(index_size, 0);
+    AddRange(index_size, 0, layout);
   } else {
     DCHECK_EQ(total_size, frame_size);
   }
   return Status::OK;
 }
 
-Status SubsampleGenerator::GenerateSubsamplesFromH26xFrame(
+Status SubsampleGenerator::FindProtectableRangesInH26xFrame(
     const uint8_t* frame,
     size_t frame_size,
-    std::vector<SubsampleEntry>* subsamples) {
+    SubsampleLayout* layout) {
   DCHECK_NE(nalu_length_size_, 0u);
   DCHECK(header_parser_);
 
-  SubsampleOrganizer subsample_organizer(align_protected_data_, subsamples);
-
   const Nalu::CodecType nalu_type =
       (codec_ == kCodecH265 || codec_ == kCodecH265DolbyVision) ? Nalu::kH265
                                                                 : Nalu::kH264;
@@ -315,6 +374,8 @@ Status SubsampleGenerator::GenerateSubsamplesFromH26xFrame(
       LOG(ERROR) << "Failed to process NAL unit: NAL type = " << nalu.type();
       return Status(error::ENCRYPTION_FAILURE, "Failed to process NAL unit.");
     }
+    if (IsParameterSet(nalu_type, nalu))
+      layout->has_parameter_sets = true;
 
     const size_t nalu_total_size = nalu.header_size() + nalu.payload_size();
     size_t clear_bytes = 0;
@@ -337,8 +398,7 @@ Status SubsampleGenerator::GenerateSubsamplesFromH26xFrame(
       clear_bytes = nalu_total_size;
     }
     const size_t cipher_bytes = nalu_total_size - clear_bytes;
-    subsample_organizer.AddSubsample(nalu_length_size_ + clear_bytes,
-                                     cipher_bytes);
+    AddRange(nalu_length_size_ + clear_bytes, cipher_bytes, layout);
   }
   if (result != NaluReader::kEOStream) {
     LOG(ERROR) << "Failed to parse NAL units.";
@@ -347,29 +407,27 @@ Status SubsampleGenerator::GenerateSubsamplesFromH26xFrame(
   return Status::OK;
 }
 
-Status SubsampleGenerator::GenerateSubsamplesFromAV1Frame(
+Status SubsampleGenerator::FindProtectableRangesInAV1Frame(
     const uint8_t* frame,
     size_t frame_size,
-    std::vector<SubsampleEntry>* subsamples) {
+    SubsampleLayout* layout) {
   DCHECK(av1_parser_);
   std::vector<AV1Parser::Tile> av1_tiles;
   if (!av1_parser_->Parse(frame, frame_size, &av1_tiles))
     return Status(error::ENCRYPTION_FAILURE, "Failed to parse AV1 frame.");
 
-  SubsampleOrganizer subsample_organizer(align_protected_data_, subsamples);
-
   size_t last_tile_end_offset = 0;
   for (const AV1Parser::Tile& tile : av1_tiles) {
     DCHECK_LE(last_tile_end_offset, tile.start_offset_in_bytes);
     // Per AV1 in ISO-BMFF spec [1], only decode_tile is encrypted.
     // [1] https://aomediacodec.github.io/av1-isobmff/#subsample-encryption
-    subsample_organizer.AddSubsample(
-        tile.start_offset_in_bytes - last_tile_end_offset, tile.size_in_bytes);
+    AddRange(tile.start_offset_in_bytes - last_tile_end_offset,
+             tile.size_in_bytes, layout);
     last_tile_end_offset = tile.start_offset_in_bytes + tile.size_in_bytes;
   }
   DCHECK_LE(last_tile_end_offset, frame_size);
   if (last_tile_end_offset < frame_size)
-    subsample_organizer.AddSubsample(frame_size - last_tile_end_offset, 0);
+    AddRange(frame_size - last_tile_end_offset, 0, layout);
   return Status::OK;
 }
 
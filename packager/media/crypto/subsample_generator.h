@@ -18,9 +18,11 @@ namespace shaka {
 namespace media {
 
 class AV1Parser;
+class MediaSample;
 class VideoSliceHeaderParser;
 class VPxParser;
 struct SubsampleEntry;
+struct SubsampleLayout;
 
 /// Parsing and generating encryption subsamples from bitstreams. Note that the
 /// class can be used to generate subsamples from both audio and video
@@ -60,6 +62,24 @@ class SubsampleGenerator {
                                     size_t frame_size,
                                     std::vector<SubsampleEntry>* subsamples);
 
+  /// Generates subsamples for @a sample, sharing the bitstream parsing with
+  /// other generators of the same sample, e.g. when a stream is encrypted for
+  /// several protection schemes: the SubsampleLayout found by parsing is
+  /// attached to @a sample, and reused if another generator attached it
+  /// already. The protection scheme specific constraints are still applied by
+  /// each generator.
+  /// @param sample is the sample to generate subsamples for.
+  /// @param frame points to the clear data of @a sample, which is not the
+  ///        sample data if the sample is encrypted.
+  /// @param frame_size is the size of the frame.
+  /// @param[out] subsamples will contain the output subsamples on success. It
+  ///             will be empty if the frame should be full sample encrypted.
+  /// @returns OK on success, an error status otherwise.
+  virtual Status GenerateSubsamples(const MediaSample& sample,
+                                    const uint8_t* frame,
+                                    size_t frame_size,
+                                    std::vector<SubsampleEntry>* subsamples);
+
   // Testing injections.
   void InjectVpxParserForTesting(std::unique_ptr<VPxParser> vpx_parser);
   void InjectVideoSliceHeaderParserForTesting(
@@ -70,18 +90,23 @@ class SubsampleGenerator {
   SubsampleGenerator(const SubsampleGenerator&) = delete;
   SubsampleGenerator& operator=(const SubsampleGenerator&) = delete;
 
-  Status GenerateSubsamplesFromVPxFrame(
-      const uint8_t* frame,
-      size_t frame_size,
-      std::vector<SubsampleEntry>* subsamples);
-  Status GenerateSubsamplesFromH26xFrame(
-      const uint8_t* frame,
-      size_t frame_size,
-      std::vector<SubsampleEntry>* subsamples);
-  Status GenerateSubsamplesFromAV1Frame(
-      const uint8_t* frame,
-      size_t frame_size,
-      std::vector<SubsampleEntry>* subsamples);
+  // Finds the protectable ranges in |frame| by parsing it.
+  Status FindProtectableRanges(const uint8_t* frame,
+                               size_t frame_size,
+                               SubsampleLayout* layout);
+  // Applies the protection scheme specific constraints to |layout|.
+  void OrganizeSubsamples(const SubsampleLayout& layout,
+                          std::vector<SubsampleEntry>* subsamples);
+
+  Status FindProtectableRangesInVPxFrame(const uint8_t* frame,
+                                         size_t frame_size,
+                                         SubsampleLayout* layout);
+  Status FindProtectableRangesInH26xFrame(const uint8_t* frame,
+                                          size_t frame_size,
+                                          SubsampleLayout* layout);
+  Status FindProtectableRangesInAV1Frame(const uint8_t* frame,
+                                         size_t frame_size,
+                                         SubsampleLayout* layout);
 
   const bool vp9_subsample_encryption_ = false;
   // Whether the protected portion should be AES block (16 bytes) aligned.
@@ -10,6 +10,7 @@
 #include <gtest/gtest.h>
 
 #include <packager/media/base/audio_stream_info.h>
+#include <packager/media/base/media_sample.h>
 #include <packager/media/base/video_stream_info.h>
 #include <packager/media/codecs/av1_parser.h>
 #include <packager/media/codecs/video_slice_header_parser.h>
@@ -32,6 +33,7 @@ using ::testing::Values;
 using ::testing::WithParamInterface;
 
 const bool kVP9SubsampleEncryption = true;
+const bool kIsKeyFrame = true;
 const uint8_t kH264CodecConfig[] = {
     // clang-format off
     // Header
@@ -450,6 +452,94 @@ INSTANTIATE_TEST_CASE_P(
     SubsampleGeneratorTest,
     Values(FOURCC_cenc, FOURCC_cens, FOURCC_cbc1, FOURCC_cbcs));
 
+TEST(SubsampleGeneratorLayoutTest, H264LayoutIsShared) {
+  constexpr uint8_t kFrame[] = {
+      // First NALU (nalu_size = 9).
+      0x09, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+      // Second NALU (nalu_size = 0x25).
+      0x27, 0x25, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+      0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+      0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23,
+      0x24, 0x25, 0x26, 0x27};
+  std::shared_ptr<MediaSample> sample =
+      MediaSample::CopyFrom(kFrame, sizeof(kFrame), kIsKeyFrame);
+
+  SubsampleGenerator cbcs_generator(kVP9SubsampleEncryption);
+  ASSERT_OK(
+      cbcs_generator.Initialize(FOURCC_cbcs, GetVideoStreamInfo(kCodecH264)));
+  std::unique_ptr<MockVideoSliceHeaderParser> cbcs_header_parser(
+      new MockVideoSliceHeaderParser);
+  EXPECT_CALL(*cbcs_header_parser, ProcessNalu(_))
+      .WillRepeatedly(Return(true));
+  EXPECT_CALL(*cbcs_header_parser, GetHeaderSize(_))
+      .WillOnce(Return(4))
+      .WillOnce(Return(5));
+  cbcs_generator.InjectVideoSliceHeaderParserForTesting(
+      std::move(cbcs_header_parser));
+
+  std::vector<SubsampleEntry> subsamples;
+  ASSERT_OK(cbcs_generator.GenerateSubsamples(*sample, sample->data(),
+                                              sample->data_size(),
+                                              &subsamples));
+  EXPECT_THAT(subsamples, ElementsAre(SubsampleEntry(6, 4),
+                                      SubsampleEntry(7, 0x21)));
+  ASSERT_TRUE(sample->subsample_layout());
+
+  // The second generator uses the layout from the first one, with its own
+  // block alignment.
+  SubsampleGenerator cenc_generator(kVP9SubsampleEncryption);
+  ASSERT_OK(
+      cenc_generator.Initialize(FOURCC_cenc, GetVideoStreamInfo(kCodecH264)));
+  std::unique_ptr<MockVideoSliceHeaderParser> cenc_header_parser(
+      new MockVideoSliceHeaderParser);
+  EXPECT_CALL(*cenc_header_parser, ProcessNalu(_)).Times(0);
+  EXPECT_CALL(*cenc_header_parser, GetHeaderSize(_)).Times(0);
+  cenc_generator.InjectVideoSliceHeaderParserForTesting(
+      std::move(cenc_header_parser));
+
+  ASSERT_OK(cenc_generator.GenerateSubsamples(*sample, sample->data(),
+                                              sample->data_size(),
+                                              &subsamples));
+  EXPECT_THAT(subsamples, ElementsAre(SubsampleEntry(18, 0x20)));
+
+  // The layout describes the sample data, so it is dropped with the data.
+  std::shared_ptr<MediaSample> clone = sample->Clone();
+  EXPECT_TRUE(clone->subsample_layout());
+  clone->SetData(kFrame, sizeof(kFrame));
+  EXPECT_FALSE(clone->subsample_layout());
+}
+
+TEST(SubsampleGeneratorLayoutTest, H264FrameWithParameterSetsIsParsed) {
+  constexpr uint8_t kFrame[] = {
+      // SPS NALU (nalu_size = 4).
+      0x04, 0x67, 0x02, 0x03, 0x04,
+      // Video slice NALU (nalu_size = 0x25).
+      0x25, 0x25, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+      0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+      0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23,
+      0x24, 0x25};
+  std::shared_ptr<MediaSample> sample =
+      MediaSample::CopyFrom(kFrame, sizeof(kFrame), kIsKeyFrame);
+
+  // Both generators need to see the parameter sets.
+  for (FourCC protection_scheme : {FOURCC_cbcs, FOURCC_cenc}) {
+    SubsampleGenerator generator(kVP9SubsampleEncryption);
+    ASSERT_OK(generator.Initialize(protection_scheme,
+                                   GetVideoStreamInfo(kCodecH264)));
+    std::unique_ptr<MockVideoSliceHeaderParser> header_parser(
+        new MockVideoSliceHeaderParser);
+    EXPECT_CALL(*header_parser, ProcessNalu(_))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+    EXPECT_CALL(*header_parser, GetHeaderSize(_)).WillOnce(Return(4));
+    generator.InjectVideoSliceHeaderParserForTesting(std::move(header_parser));
+
+    std::vector<SubsampleEntry> subsamples;
+    ASSERT_OK(generator.GenerateSubsamples(*sample, sample->data(),
+                                           sample->data_size(), &subsamples));
+  }
+}
+
 TEST(SampleAesSubsampleGeneratorTest, AAC) {
   SubsampleGenerator generator(kVP9SubsampleEncryption);
   ASSERT_OK(generator.Initialize(kAppleSampleAesProtectionScheme,
@@ -14,14 +14,18 @@
 #include <absl/strings/escaping.h>
 #include <absl/strings/numbers.h>
 #include <absl/strings/str_format.h>
+#include <absl/time/clock.h>
 
 #include <packager/file.h>
 #include <packager/macros/compiler.h>
 #include <packager/macros/logging.h>
+#include <packager/macros/status.h>
 #include <packager/media/base/decryptor_source.h>
 #include <packager/media/base/key_source.h>
 #include <packager/media/base/media_sample.h>
 #include <packager/media/base/stream_info.h>
+#include <packager/media/chunking/segment_locator.h>
+#include <packager/media/demuxer/sample_index.h>
 #include <packager/media/formats/mp2t/mp2t_media_parser.h>
 #include <packager/media/formats/mp4/mp4_media_parser.h>
 #include <packager/media/formats/webm/webm_media_parser.h>
@@ -92,6 +96,7 @@ void Demuxer::SetKeySource(std::unique_ptr<KeySource> key_source) {
 
 Status Demuxer::Run() {
   LOG(INFO) << "Demuxer::Run() on file '" << file_name_ << "'.";
+  run_start_time_ = absl::Now();
   Status status = InitializeParser();
   // ParserInitEvent callback is called after a few calls to Parse(), which sets
   // up the streams. Only after that, we can verify the outputs below.
@@ -115,8 +120,18 @@ Status Demuxer::Run() {
     }
   }
 
+  if (sample_index_) {
+    // The samples received so far, e.g. the samples parsed from the same
+    // buffer as the stream info, have been pushed already, unless they are
+    // dropped to demux a single segment.
+    next_sample_index_entry_ = segment_number_ > 0 ? 0 : num_parsed_samples_;
+    if (next_sample_index_entry_ > sample_index_->entries().size()) {
+      return Status(error::PARSER_FAILURE,
+                    "Sample index does not match " + file_name_);
+    }
+  }
   while (!cancelled_ && status.ok())
-    status.Update(Parse());
+    status.Update(sample_index_ ? ParseWithSampleIndex() : Parse());
   if (cancelled_ && status.ok())
     return Status(error::CANCELLED, "Demuxer run cancelled");
 
@@ -126,6 +141,15 @@ Status Demuxer::Run() {
       if (!status.ok())
         return status;
     }
+    if (new_sample_index_) {
+      if (new_sample_index_->WriteToFile(sample_index_file_)) {
+        LOG(INFO) << "Wrote sample index '" << sample_index_file_ << "' with "
+                  << new_sample_index_->entries().size() << " samples.";
+      } else {
+        LOG(WARNING) << "Failed to write sample index '"
+                     << sample_index_file_ << "'.";
+      }
+    }
     return Status::OK;
   }
   return status;
@@ -159,12 +183,15 @@ Status Demuxer::InitializeParser() {
 
   LOG(INFO) << "Initialize Demuxer for file '" << file_name_ << "'.";
 
+  const absl::Time open_start_time = absl::Now();
   media_file_ = File::Open(file_name_.c_str(), "r");
   if (!media_file_) {
     return Status(error::FILE_FAILURE,
                   "Cannot open file for reading " + file_name_);
   }
+  open_duration_ = absl::Now() - open_start_time;
 
+  const absl::Time probe_start_time = absl::Now();
   int64_t bytes_read = 0;
   bool eof = false;
   if (input_format_.empty()) {
@@ -184,6 +211,7 @@ Status Demuxer::InitializeParser() {
   } else {
     container_name_ = DetermineContainerFromFormatName(input_format_);
   }
+  probe_duration_ = absl::Now() - probe_start_time;
 
   // Initialize media parser.
   switch (container_name_) {
@@ -248,6 +276,13 @@ Status Demuxer::InitializeParser() {
 
 void Demuxer::ParserInitEvent(
     const std::vector<std::shared_ptr<StreamInfo>>& stream_infos) {
+  LOG(INFO) << "Stream info of '" << file_name_ << "' received after "
+            << absl::FormatDuration(absl::Now() - run_start_time_)
+            << " (open: " << absl::FormatDuration(open_duration_)
+            << ", probe: " << absl::FormatDuration(probe_duration_) << ").";
+
+  init_event_status_.Update(SetUpSampleIndex(stream_infos));
+
   if (dump_stream_info_) {
     printf("\nFile \"%s\":\n", file_name_.c_str());
     printf("Found %zu stream(s).\n", stream_infos.size());
@@ -265,6 +300,8 @@ void Demuxer::ParserInitEvent(
   bool text_handler_set =
       output_handlers().find(kBaseTextOutputStreamIndex) !=
       output_handlers().end();
+  // The sample index entries of the segment to demux, if any.
+  std::vector<size_t> segment_entries;
   for (const std::shared_ptr<StreamInfo>& stream_info : stream_infos) {
     size_t stream_index = base_stream_index;
     if (video_handler_set && stream_info->stream_type() == kStreamVideo) {
@@ -292,11 +329,14 @@ void Demuxer::ParserInitEvent(
           stream_info->stream_type() != kStreamVideo) {
         stream_info->set_language(iter->second);
       }
-      if (stream_info->is_encrypted()) {
+      if (stream_info->is_encrypted() && !keep_encrypted_) {
         init_event_status_.Update(Status(error::INVALID_ARGUMENT,
                                          "A decryption key source is not "
                                          "provided for an encrypted stream."));
       } else {
+        if (segment_number_ > 0 && init_event_status_.ok())
+          init_event_status_.Update(
+              LocateSegment(stream_info, &segment_entries));
         init_event_status_.Update(
             DispatchStreamInfo(stream_index, stream_info));
       }
@@ -306,11 +346,28 @@ void Demuxer::ParserInitEvent(
     }
     ++base_stream_index;
   }
+
+  if (segment_number_ > 0 && init_event_status_.ok()) {
+    // Only read the samples of the segment, in the order they are stored.
+    std::sort(segment_entries.begin(), segment_entries.end());
+    std::unique_ptr<SampleIndex> segment_index(
+        new SampleIndex(sample_index_->fingerprint()));
+    for (size_t entry : segment_entries)
+      segment_index->AddEntry(sample_index_->entries()[entry]);
+    sample_index_ = std::move(segment_index);
+  }
   all_streams_ready_ = true;
 }
 
 bool Demuxer::NewMediaSampleEvent(uint32_t track_id,
                                   std::shared_ptr<MediaSample> sample) {
+  ++num_parsed_samples_;
+  // The samples of the segment are read with the sample index.
+  if (segment_number_ > 0)
+    return true;
+  if (new_sample_index_)
+    AddToSampleIndex(track_id, *sample);
+
   if (!all_streams_ready_) {
     if (queued_media_samples_.size() >= kQueuedSamplesLimit) {
       LOG(ERROR) << "Queued samples limit reached: " << kQueuedSamplesLimit;
@@ -335,6 +392,11 @@ bool Demuxer::NewMediaSampleEvent(uint32_t track_id,
 
 bool Demuxer::NewTextSampleEvent(uint32_t track_id,
                                  std::shared_ptr<TextSample> sample) {
+  if (new_sample_index_) {
+    LOG(WARNING) << "Text samples cannot be indexed.";
+    new_sample_index_.reset();
+  }
+
   if (!all_streams_ready_) {
     if (queued_text_samples_.size() >= kQueuedSamplesLimit) {
       LOG(ERROR) << "Queued samples limit reached: " << kQueuedSamplesLimit;
@@ -399,18 +461,207 @@ Status Demuxer::Parse() {
   DCHECK(buffer_);
 
   int64_t bytes_read = media_file_->Read(buffer_.get(), kBufSize);
+  if (bytes_read < 0)
+    return Status(error::FILE_FAILURE, "Cannot read file " + file_name_);
+
+  // The samples parsed from one buffer are dispatched in batches, which
+  // amortizes the per sample overhead of the downstream handlers.
+  StartBatchDispatch();
+  const bool parsed = bytes_read == 0
+                          ? parser_->Flush()
+                          : parser_->Parse(buffer_.get(), bytes_read);
+  RETURN_IF_ERROR(FinishBatchDispatch());
+
   if (bytes_read == 0) {
-    if (!parser_->Flush())
+    if (!parsed)
       return Status(error::PARSER_FAILURE, "Failed to flush.");
     return Status(error::END_OF_STREAM, "");
-  } else if (bytes_read < 0) {
-    return Status(error::FILE_FAILURE, "Cannot read file " + file_name_);
   }
+  return parsed ? Status::OK
+                : Status(error::PARSER_FAILURE,
+                         "Cannot parse media file " + file_name_);
+}
+
+Status Demuxer::SetUpSampleIndex(
+    const std::vector<std::shared_ptr<StreamInfo>>& stream_infos) {
+  if (sample_index_file_.empty()) {
+    if (segment_number_ > 0) {
+      return Status(error::INVALID_ARGUMENT,
+                    "A sample index is required to demux a single segment.");
+    }
+    return Status::OK;
+  }
+  // Encrypted samples are not indexed, see AddToSampleIndex().
+  if (container_name_ != CONTAINER_MOV || key_source_ ||
+      !File::IsLocalRegularFile(file_name_.c_str())) {
+    if (segment_number_ > 0) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Single segment demuxing is only supported for "
+                    "unencrypted local MP4 inputs.");
+    }
+    LOG(WARNING) << "Sample index is only supported for unencrypted local "
+                    "MP4 inputs. Ignoring '"
+                 << sample_index_file_ << "' for '" << file_name_ << "'.";
+    return Status::OK;
+  }
+
+  // The sample tables of non-fragmented inputs are in the header. Fragmented
+  // inputs have them in the fragments, which are not parsed when the index
+  // is used, so a rewritten input is detected by its modification time.
+  const uint8_t* header = nullptr;
+  size_t header_size = 0;
+  int64_t modification_time = 0;
+  if (!parser_->GetCurrentHeader(&header, &header_size) ||
+      !File::GetLastModificationTime(file_name_.c_str(), &modification_time)) {
+    return Status(error::FILE_FAILURE,
+                  "Cannot compute the fingerprint of " + file_name_);
+  }
+  const uint64_t fingerprint = SampleIndex::ComputeFingerprint(
+      File::GetFileSize(file_name_.c_str()), modification_time, header,
+      header_size, stream_infos);
+  std::unique_ptr<SampleIndex> sample_index(new SampleIndex);
+  if (sample_index->ReadFromFile(sample_index_file_) &&
+      sample_index->fingerprint() == fingerprint) {
+    LOG(INFO) << "Reading the samples of '" << file_name_
+              << "' with sample index '" << sample_index_file_ << "'.";
+    sample_index_ = std::move(sample_index);
+    return Status::OK;
+  }
+  if (segment_number_ > 0) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Sample index '" + sample_index_file_ +
+                      "' is missing or does not match " + file_name_);
+  }
+  LOG(INFO) << "Building sample index '" << sample_index_file_ << "' for '"
+            << file_name_ << "'.";
+  new_sample_index_.reset(new SampleIndex(fingerprint));
+  return Status::OK;
+}
+
+Status Demuxer::LocateSegment(const std::shared_ptr<StreamInfo>& stream_info,
+                              std::vector<size_t>* entries) {
+  DCHECK(sample_index_);
+  DCHECK(entries);
+
+  SegmentLocator locator(chunking_params_, segment_number_ - 1);
+  RETURN_IF_ERROR(locator.Initialize(stream_info));
+  // The entries of the samples of the stream.
+  std::vector<size_t> stream_entries;
+  const std::vector<SampleIndex::Entry>& index_entries =
+      sample_index_->entries();
+  for (size_t i = 0; i < index_entries.size(); ++i) {
+    const SampleIndex::Entry& entry = index_entries[i];
+    if (entry.track_id != stream_info->track_id())
+      continue;
+    stream_entries.push_back(i);
+    RETURN_IF_ERROR(locator.AddSample(entry.dts, entry.pts, entry.duration,
+                                      entry.is_key_frame));
+  }
+  Status status = locator.Finalize();
+  if (!status.ok()) {
+    return Status(status.error_code(),
+                  absl::StrFormat("Cannot find segment %u of track %u: %s",
+                                  segment_number_, stream_info->track_id(),
+                                  status.error_message()));
+  }
+
+  LOG(INFO) << "Demuxing segment " << segment_number_ << " of track "
+            << stream_info->track_id() << " with "
+            << locator.end_sample() - locator.first_sample() << " samples.";
+  entries->insert(entries->end(),
+                  stream_entries.begin() + locator.first_sample(),
+                  stream_entries.begin() + locator.end_sample());
+  stream_info->set_segment_history(
+      std::make_shared<SegmentHistory>(locator.history()));
+  return Status::OK;
+}
+
+void Demuxer::AddToSampleIndex(uint32_t track_id, const MediaSample& sample) {
+  const int64_t offset = parser_->GetCurrentSampleOffset();
+  if (offset < 0 || sample.is_encrypted()) {
+    LOG(WARNING) << "The samples of '" << file_name_
+                 << "' cannot be indexed.";
+    new_sample_index_.reset();
+    return;
+  }
+
+  SampleIndex::Entry entry;
+  entry.track_id = track_id;
+  entry.offset = offset;
+  entry.size = static_cast<uint32_t>(sample.data_size());
+  entry.dts = sample.dts();
+  entry.pts = sample.pts();
+  entry.duration = sample.duration();
+  entry.is_key_frame = sample.is_key_frame();
+  new_sample_index_->AddEntry(entry);
+}
+
+Status Demuxer::ParseWithSampleIndex() {
+  DCHECK(media_file_);
+  DCHECK(sample_index_);
+
+  while (!queued_media_samples_.empty()) {
+    if (!PushMediaSample(queued_media_samples_.front().track_id,
+                         queued_media_samples_.front().sample)) {
+      return Status(error::PARSER_FAILURE,
+                    "Cannot parse media file " + file_name_);
+    }
+    queued_media_samples_.pop_front();
+  }
+
+  const std::vector<SampleIndex::Entry>& entries = sample_index_->entries();
+  if (next_sample_index_entry_ >= entries.size())
+    return Status(error::END_OF_STREAM, "");
+
+  // Read a buffer full starting at the next sample. Samples are usually
+  // stored in the order they are listed, so the following samples are
+  // usually in the same buffer.
+  const uint64_t buffer_offset = entries[next_sample_index_entry_].offset;
+  sample_index_buffer_.resize(
+      std::max<size_t>(kBufSize, entries[next_sample_index_entry_].size));
+  if (!media_file_->Seek(buffer_offset))
+    return Status(error::FILE_FAILURE, "Cannot seek file " + file_name_);
+  size_t buffer_size = 0;
+  while (buffer_size < sample_index_buffer_.size()) {
+    const int64_t bytes_read =
+        media_file_->Read(sample_index_buffer_.data() + buffer_size,
+                          sample_index_buffer_.size() - buffer_size);
+    if (bytes_read < 0)
+      return Status(error::FILE_FAILURE, "Cannot read file " + file_name_);
+    if (bytes_read == 0)
+      break;
+    buffer_size += bytes_read;
+  }
+  if (buffer_size < entries[next_sample_index_entry_].size) {
+    return Status(error::PARSER_FAILURE,
+                  "Sample index does not match " + file_name_);
+  }
+
+  StartBatchDispatch();
+  bool pushed = true;
+  while (next_sample_index_entry_ < entries.size() && !cancelled_) {
+    const SampleIndex::Entry& entry = entries[next_sample_index_entry_];
+    if (entry.offset < buffer_offset ||
+        entry.offset + entry.size > buffer_offset + buffer_size) {
+      break;
+    }
+    std::shared_ptr<MediaSample> sample = MediaSample::CopyFrom(
+        sample_index_buffer_.data() + (entry.offset - buffer_offset),
+        entry.size, entry.is_key_frame);
+    sample->set_dts(entry.dts);
+    sample->set_pts(entry.pts);
+    sample->set_duration(entry.duration);
+    if (!PushMediaSample(entry.track_id, std::move(sample))) {
+      pushed = false;
+      break;
+    }
+    ++next_sample_index_entry_;
+  }
+  RETURN_IF_ERROR(FinishBatchDispatch());
 
-  return parser_->Parse(buffer_.get(), bytes_read)
-             ? Status::OK
-             : Status(error::PARSER_FAILURE,
-                      "Cannot parse media file " + file_name_);
+  return pushed ? Status::OK
+                : Status(error::PARSER_FAILURE,
+                         "Cannot parse media file " + file_name_);
 }
 
 }  // namespace media
@@ -11,6 +11,9 @@
 #include <memory>
 #include <vector>
 
+#include <absl/time/time.h>
+
+#include <packager/chunking_params.h>
 #include <packager/macros/classes.h>
 #include <packager/media/base/container_names.h>
 #include <packager/media/origin/origin_handler.h>
@@ -26,6 +29,7 @@ class Decryptor;
 class KeySource;
 class MediaParser;
 class MediaSample;
+class SampleIndex;
 class StreamInfo;
 
 /// Demuxer is responsible for extracting elementary stream samples from a
@@ -79,6 +83,34 @@ class Demuxer : public OriginHandler {
     input_format_ = input_format;
   }
 
+  /// Pass encrypted streams on encrypted, with the decrypt config of each
+  /// sample, instead of rejecting them when there is no key source. Used when
+  /// the samples are transcrypted by the encryption handlers.
+  void set_keep_encrypted(bool keep_encrypted) {
+    keep_encrypted_ = keep_encrypted;
+  }
+
+  /// Use a sample index sidecar for the input. If @a sample_index_file
+  /// contains a valid index for the input, the samples are read directly
+  /// using the index instead of parsing the container. Otherwise, the index
+  /// is built while parsing and written once the whole input is parsed.
+  /// Only unencrypted local MP4 inputs are supported.
+  void set_sample_index_file(const std::string& sample_index_file) {
+    sample_index_file_ = sample_index_file;
+  }
+
+  /// Only demux the samples of a single segment of each stream, as the
+  /// segments would be generated by ChunkingHandler. The stream info carries
+  /// the SegmentHistory of the stream. Requires a valid sample index, see
+  /// set_sample_index_file().
+  /// @param segment_number is the 1-based segment number, as in $Number$.
+  /// @param chunking_params are the chunking params of the streams.
+  void set_segment_number(uint32_t segment_number,
+                          const ChunkingParams& chunking_params) {
+    segment_number_ = segment_number;
+    chunking_params_ = chunking_params;
+  }
+
  protected:
   /// @name MediaHandler implementation overrides.
   /// @{
@@ -130,6 +162,19 @@ class Demuxer : public OriginHandler {
   // Read from the source and send it to the parser.
   Status Parse();
 
+  // Load the sample index if it matches the input, or start building it.
+  Status SetUpSampleIndex(
+      const std::vector<std::shared_ptr<StreamInfo>>& stream_infos);
+  // Locate the segment to demux in the samples of |stream_info| and append
+  // the sample index entries of the segment to |entries|.
+  Status LocateSegment(const std::shared_ptr<StreamInfo>& stream_info,
+                       std::vector<size_t>* entries);
+  // Add the sample being passed by the parser to the index being built.
+  void AddToSampleIndex(uint32_t track_id, const MediaSample& sample);
+  // Read the next samples listed in the sample index from the source, up to
+  // a buffer full, and push them to the corresponding streams.
+  Status ParseWithSampleIndex();
+
   std::string file_name_;
   File* media_file_ = nullptr;
   // A stream is considered ready after receiving the stream info.
@@ -154,6 +199,27 @@ class Demuxer : public OriginHandler {
   Status init_event_status_;
   // Explicitly defined input format, for avoiding autodetection.
   std::string input_format_;
+  // Whether encrypted streams are passed on encrypted, see
+  // set_keep_encrypted().
+  bool keep_encrypted_ = false;
+  // Sample index sidecar, see set_sample_index_file().
+  std::string sample_index_file_;
+  // The index used to read the samples instead of parsing the input, if any.
+  std::unique_ptr<SampleIndex> sample_index_;
+  // The index being built while parsing the input, if any.
+  std::unique_ptr<SampleIndex> new_sample_index_;
+  // The number of samples received from the parser.
+  size_t num_parsed_samples_ = 0;
+  // The next entry of |sample_index_| to read.
+  size_t next_sample_index_entry_ = 0;
+  std::vector<uint8_t> sample_index_buffer_;
+  // Single segment demuxing, see set_segment_number().
+  uint32_t segment_number_ = 0;
+  ChunkingParams chunking_params_;
+  // Startup timing, reported when the stream info is received.
+  absl::Time run_start_time_;
+  absl::Duration open_duration_;
+  absl::Duration probe_duration_;
 };
 
 }  // namespace media
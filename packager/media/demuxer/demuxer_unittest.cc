@@ -6,11 +6,17 @@
 
 #include <packager/media/demuxer/demuxer.h>
 
+#include <algorithm>
+#include <filesystem>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <packager/file/file_test_util.h>
 #include <packager/media/base/media_handler_test_base.h>
+#include <packager/media/base/media_sample.h>
 #include <packager/media/base/raw_key_source.h>
+#include <packager/media/demuxer/sample_index.h>
 #include <packager/media/test/test_data_util.h>
 #include <packager/status/status_test_util.h>
 
@@ -32,6 +38,46 @@ class MockKeySource : public RawKeySource {
 
 class DemuxerTest : public MediaHandlerGraphTestBase {
  protected:
+  // Demuxes the video and audio streams of |input| into |video_handler| and
+  // |audio_handler|.
+  void RunDemuxer(const std::string& input,
+                  const std::string& sample_index_file,
+                  std::shared_ptr<CachingMediaHandler>* video_handler,
+                  std::shared_ptr<CachingMediaHandler>* audio_handler) {
+    *video_handler = std::make_shared<CachingMediaHandler>();
+    *audio_handler = std::make_shared<CachingMediaHandler>();
+    Demuxer demuxer(input);
+    demuxer.set_sample_index_file(sample_index_file);
+    ASSERT_OK(demuxer.SetHandler("video", *video_handler));
+    ASSERT_OK(demuxer.SetHandler("audio", *audio_handler));
+    ASSERT_OK(demuxer.Run());
+  }
+
+  void ExpectSameMediaSamples(const CachingMediaHandler& expected,
+                              const CachingMediaHandler& actual) {
+    ASSERT_EQ(expected.Cache().size(), actual.Cache().size());
+    for (size_t i = 0; i < expected.Cache().size(); ++i) {
+      SCOPED_TRACE(i);
+      const StreamData& expected_data = *expected.Cache()[i];
+      const StreamData& actual_data = *actual.Cache()[i];
+      ASSERT_EQ(expected_data.stream_data_type, actual_data.stream_data_type);
+      if (expected_data.stream_data_type != StreamDataType::kMediaSample)
+        continue;
+      const MediaSample& expected_sample = *expected_data.media_sample();
+      const MediaSample& actual_sample = *actual_data.media_sample();
+      EXPECT_EQ(expected_sample.dts(), actual_sample.dts());
+      EXPECT_EQ(expected_sample.pts(), actual_sample.pts());
+      EXPECT_EQ(expected_sample.duration(), actual_sample.duration());
+      EXPECT_EQ(expected_sample.is_key_frame(), actual_sample.is_key_frame());
+      EXPECT_EQ(std::vector<uint8_t>(
+                    expected_sample.data(),
+                    expected_sample.data() + expected_sample.data_size()),
+                std::vector<uint8_t>(
+                    actual_sample.data(),
+                    actual_sample.data() + actual_sample.data_size()));
+    }
+  }
+
   EncryptionKey GetMockEncryptionKey() {
     const uint8_t kKeyId[]{
         0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
@@ -73,6 +119,228 @@ TEST_F(DemuxerTest, EncryptedContentWithKeySource) {
   EXPECT_OK(demuxer.Run());
 }
 
+TEST_F(DemuxerTest, EncryptedContentKeptEncrypted) {
+  auto handler = std::make_shared<CachingMediaHandler>();
+  Demuxer demuxer(
+      GetAppTestDataFilePath("encryption/bear-640x360-video.mp4").string());
+  demuxer.set_keep_encrypted(true);
+  ASSERT_OK(demuxer.SetHandler("video", handler));
+  ASSERT_OK(demuxer.Run());
+
+  const auto& cache = handler->Cache();
+  ASSERT_LT(1u, cache.size());
+  ASSERT_EQ(StreamDataType::kStreamInfo, cache[0]->stream_data_type);
+  EXPECT_TRUE(cache[0]->stream_info()->is_encrypted());
+  bool has_encrypted_sample = false;
+  for (const auto& stream_data : cache) {
+    if (stream_data->stream_data_type != StreamDataType::kMediaSample ||
+        !stream_data->media_sample()->is_encrypted()) {
+      continue;
+    }
+    has_encrypted_sample = true;
+    EXPECT_TRUE(stream_data->media_sample()->decrypt_config());
+  }
+  EXPECT_TRUE(has_encrypted_sample);
+}
+
+TEST_F(DemuxerTest, SampleIndex) {
+  const std::string input = GetTestDataFilePath("bear-640x360.mp4").string();
+  const std::string sample_index_file = "memory://bear-640x360.index";
+
+  std::shared_ptr<CachingMediaHandler> video_handler;
+  std::shared_ptr<CachingMediaHandler> audio_handler;
+  RunDemuxer(input, "", &video_handler, &audio_handler);
+
+  // The index is built on the first run.
+  std::shared_ptr<CachingMediaHandler> indexing_video_handler;
+  std::shared_ptr<CachingMediaHandler> indexing_audio_handler;
+  RunDemuxer(input, sample_index_file, &indexing_video_handler,
+             &indexing_audio_handler);
+  ExpectSameMediaSamples(*video_handler, *indexing_video_handler);
+  ExpectSameMediaSamples(*audio_handler, *indexing_audio_handler);
+
+  // Each handler also receives the stream info.
+  SampleIndex sample_index;
+  ASSERT_TRUE(sample_index.ReadFromFile(sample_index_file));
+  EXPECT_EQ(video_handler->Cache().size() + audio_handler->Cache().size() - 2,
+            sample_index.entries().size());
+
+  // And used on the next runs.
+  std::shared_ptr<CachingMediaHandler> indexed_video_handler;
+  std::shared_ptr<CachingMediaHandler> indexed_audio_handler;
+  RunDemuxer(input, sample_index_file, &indexed_video_handler,
+             &indexed_audio_handler);
+  ExpectSameMediaSamples(*video_handler, *indexed_video_handler);
+  ExpectSameMediaSamples(*audio_handler, *indexed_audio_handler);
+}
+
+TEST_F(DemuxerTest, SampleIndexReplacesParsing) {
+  const std::string input = GetTestDataFilePath("bear-640x360.mp4").string();
+  const std::string sample_index_file = "memory://bear-640x360-shifted.index";
+
+  std::shared_ptr<CachingMediaHandler> video_handler;
+  std::shared_ptr<CachingMediaHandler> audio_handler;
+  RunDemuxer(input, sample_index_file, &video_handler, &audio_handler);
+
+  // Shift the timestamps of the last sample in the index. The shifted
+  // timestamps show up in the samples read with the index.
+  const int64_t kShift = 10;
+  SampleIndex sample_index;
+  ASSERT_TRUE(sample_index.ReadFromFile(sample_index_file));
+  ASSERT_FALSE(sample_index.entries().empty());
+  SampleIndex shifted_index(sample_index.fingerprint());
+  for (size_t i = 0; i + 1 < sample_index.entries().size(); ++i)
+    shifted_index.AddEntry(sample_index.entries()[i]);
+  SampleIndex::Entry last_entry = sample_index.entries().back();
+  last_entry.dts += kShift;
+  last_entry.pts += kShift;
+  shifted_index.AddEntry(last_entry);
+  ASSERT_TRUE(shifted_index.WriteToFile(sample_index_file));
+
+  std::shared_ptr<CachingMediaHandler> indexed_video_handler;
+  std::shared_ptr<CachingMediaHandler> indexed_audio_handler;
+  RunDemuxer(input, sample_index_file, &indexed_video_handler,
+             &indexed_audio_handler);
+
+  // The last sample of the input is the last sample of one of the streams.
+  const int64_t last_dts = sample_index.entries().back().dts;
+  const StreamData* expected = nullptr;
+  const StreamData* actual = nullptr;
+  for (const auto& handlers :
+       {std::make_pair(video_handler, indexed_video_handler),
+        std::make_pair(audio_handler, indexed_audio_handler)}) {
+    ASSERT_EQ(handlers.first->Cache().size(), handlers.second->Cache().size());
+    const StreamData& stream_data = *handlers.first->Cache().back();
+    if (stream_data.stream_data_type == StreamDataType::kMediaSample &&
+        stream_data.media_sample()->dts() == last_dts) {
+      expected = &stream_data;
+      actual = handlers.second->Cache().back().get();
+    }
+  }
+  ASSERT_TRUE(expected);
+  EXPECT_EQ(expected->media_sample()->dts() + kShift,
+            actual->media_sample()->dts());
+  EXPECT_EQ(expected->media_sample()->pts() + kShift,
+            actual->media_sample()->pts());
+}
+
+TEST_F(DemuxerTest, SampleIndexRebuiltForModifiedSampleTable) {
+  const std::string sample_index_file = "memory://bear-640x360-modified.index";
+  std::string data;
+  ASSERT_TRUE(File::ReadFileToString(
+      GetTestDataFilePath("bear-640x360.mp4").string().c_str(), &data));
+  TempFile input;
+  ASSERT_TRUE(File::WriteStringToFile(input.path().c_str(), data));
+  const auto modification_time =
+      std::filesystem::last_write_time(input.path());
+
+  std::shared_ptr<CachingMediaHandler> video_handler;
+  std::shared_ptr<CachingMediaHandler> audio_handler;
+  RunDemuxer(input.path(), sample_index_file, &video_handler, &audio_handler);
+  SampleIndex sample_index;
+  ASSERT_TRUE(sample_index.ReadFromFile(sample_index_file));
+
+  // Swap the first two entries of the 'stco' sample table. The stream info
+  // and the file size and modification time are the same.
+  const size_t stco = data.find("stco");
+  ASSERT_NE(std::string::npos, stco);
+  // Skip the version, flags and entry count.
+  const size_t first_entry = stco + 4 + 4 + 4;
+  std::swap_ranges(data.begin() + first_entry, data.begin() + first_entry + 4,
+                   data.begin() + first_entry + 4);
+  ASSERT_TRUE(File::WriteStringToFile(input.path().c_str(), data));
+  std::filesystem::last_write_time(input.path(), modification_time);
+
+  // The index does not match the input anymore and is rebuilt.
+  RunDemuxer(input.path(), sample_index_file, &video_handler, &audio_handler);
+  SampleIndex rebuilt_sample_index;
+  ASSERT_TRUE(rebuilt_sample_index.ReadFromFile(sample_index_file));
+  EXPECT_NE(sample_index.fingerprint(), rebuilt_sample_index.fingerprint());
+  std::vector<uint64_t> offsets;
+  for (const SampleIndex::Entry& entry : sample_index.entries())
+    offsets.push_back(entry.offset);
+  std::vector<uint64_t> rebuilt_offsets;
+  for (const SampleIndex::Entry& entry : rebuilt_sample_index.entries())
+    rebuilt_offsets.push_back(entry.offset);
+  EXPECT_NE(offsets, rebuilt_offsets);
+}
+
+TEST_F(DemuxerTest, SingleSegment) {
+  const std::string input = GetTestDataFilePath("bear-640x360.mp4").string();
+  const std::string sample_index_file = "memory://bear-640x360-segment.index";
+  const uint32_t kSegmentNumber = 2;
+  ChunkingParams chunking_params;
+  chunking_params.segment_duration_in_seconds = 1;
+
+  std::shared_ptr<CachingMediaHandler> video_handler;
+  std::shared_ptr<CachingMediaHandler> audio_handler;
+  RunDemuxer(input, sample_index_file, &video_handler, &audio_handler);
+
+  auto segment_video_handler = std::make_shared<CachingMediaHandler>();
+  auto segment_audio_handler = std::make_shared<CachingMediaHandler>();
+  Demuxer demuxer(input);
+  demuxer.set_sample_index_file(sample_index_file);
+  demuxer.set_segment_number(kSegmentNumber, chunking_params);
+  ASSERT_OK(demuxer.SetHandler("video", segment_video_handler));
+  ASSERT_OK(demuxer.SetHandler("audio", segment_audio_handler));
+  ASSERT_OK(demuxer.Run());
+
+  for (const auto& handlers :
+       {std::make_pair(video_handler, segment_video_handler),
+        std::make_pair(audio_handler, segment_audio_handler)}) {
+    const auto& cache = handlers.first->Cache();
+    const auto& segment_cache = handlers.second->Cache();
+    ASSERT_LT(1u, segment_cache.size());
+    ASSERT_EQ(StreamDataType::kStreamInfo,
+              segment_cache[0]->stream_data_type);
+    const std::shared_ptr<const SegmentHistory>& history =
+        segment_cache[0]->stream_info()->segment_history();
+    ASSERT_TRUE(history);
+    ASSERT_EQ(kSegmentNumber - 1, history->segments.size());
+
+    // The samples of the segment follow the samples of the segments before
+    // it, and the segment starts with a key frame.
+    size_t first_sample = 1;
+    for (const SegmentHistory::Segment& segment : history->segments)
+      first_sample += segment.num_samples;
+    ASSERT_LE(first_sample + segment_cache.size() - 1, cache.size());
+    EXPECT_TRUE(segment_cache[1]->media_sample()->is_key_frame());
+    for (size_t i = 1; i < segment_cache.size(); ++i) {
+      SCOPED_TRACE(i);
+      const MediaSample& expected =
+          *cache[first_sample + i - 1]->media_sample();
+      const MediaSample& actual = *segment_cache[i]->media_sample();
+      EXPECT_EQ(expected.dts(), actual.dts());
+      EXPECT_EQ(expected.data_size(), actual.data_size());
+    }
+  }
+}
+
+TEST_F(DemuxerTest, SingleSegmentRequiresSampleIndex) {
+  ChunkingParams chunking_params;
+  chunking_params.segment_duration_in_seconds = 1;
+  Demuxer demuxer(GetTestDataFilePath("bear-640x360.mp4").string());
+  demuxer.set_segment_number(1, chunking_params);
+  ASSERT_OK(demuxer.SetHandler("video", some_handler()));
+  EXPECT_EQ(error::INVALID_ARGUMENT, demuxer.Run().error_code());
+}
+
+TEST_F(DemuxerTest, SingleSegmentNotFound) {
+  const std::string input = GetTestDataFilePath("bear-640x360.mp4").string();
+  const std::string sample_index_file = "memory://bear-640x360-missing.index";
+  std::shared_ptr<CachingMediaHandler> video_handler;
+  std::shared_ptr<CachingMediaHandler> audio_handler;
+  RunDemuxer(input, sample_index_file, &video_handler, &audio_handler);
+
+  ChunkingParams chunking_params;
+  chunking_params.segment_duration_in_seconds = 1;
+  Demuxer demuxer(input);
+  demuxer.set_sample_index_file(sample_index_file);
+  demuxer.set_segment_number(100, chunking_params);
+  ASSERT_OK(demuxer.SetHandler("video", some_handler()));
+  EXPECT_EQ(error::NOT_FOUND, demuxer.Run().error_code());
+}
+
 // TODO(kqyang): Add more tests.
 
 }  // namespace media
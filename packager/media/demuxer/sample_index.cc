@@ -0,0 +1,222 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/demuxer/sample_index.h>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <packager/file.h>
+#include <packager/media/base/stream_info.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const uint8_t kMagic[] = {'S', 'P', 'S', 'I'};
+const uint8_t kVersion = 1;
+// Each entry takes at least one byte for each of its six fields.
+const size_t kMinEntrySize = 6;
+
+const uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ull;
+const uint64_t kFnvPrime = 0x100000001b3ull;
+
+uint64_t Fnv1a(const void* data, size_t size, uint64_t hash) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void AppendVarint(uint64_t value, std::vector<uint8_t>* data) {
+  while (value >= 0x80) {
+    data->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  data->push_back(static_cast<uint8_t>(value));
+}
+
+class VarintReader {
+ public:
+  VarintReader(const uint8_t* data, size_t size)
+      : data_(data), end_(data + size) {}
+
+  bool Read(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (data_ == end_)
+        return false;
+      const uint8_t byte = *data_++;
+      *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  bool ReadSigned(int64_t* value) {
+    uint64_t encoded;
+    if (!Read(&encoded))
+      return false;
+    *value = ZigZagDecode(encoded);
+    return true;
+  }
+
+  size_t remaining() const { return end_ - data_; }
+
+ private:
+  const uint8_t* data_;
+  const uint8_t* const end_;
+};
+
+// Per track state for delta encoding.
+struct TrackState {
+  int64_t next_dts = 0;
+  int64_t duration = 0;
+};
+
+}  // namespace
+
+SampleIndex::SampleIndex(uint64_t fingerprint) : fingerprint_(fingerprint) {}
+
+uint64_t SampleIndex::ComputeFingerprint(
+    int64_t file_size,
+    int64_t modification_time,
+    const uint8_t* header,
+    size_t header_size,
+    const std::vector<std::shared_ptr<StreamInfo>>& stream_infos) {
+  uint64_t hash = Fnv1a(&file_size, sizeof(file_size), kFnvOffsetBasis);
+  hash = Fnv1a(&modification_time, sizeof(modification_time), hash);
+  hash = Fnv1a(header, header_size, hash);
+  for (const std::shared_ptr<StreamInfo>& stream_info : stream_infos) {
+    const std::string info = stream_info->ToString();
+    hash = Fnv1a(info.data(), info.size(), hash);
+    const std::vector<uint8_t>& codec_config = stream_info->codec_config();
+    hash = Fnv1a(codec_config.data(), codec_config.size(), hash);
+  }
+  return hash;
+}
+
+void SampleIndex::Serialize(std::vector<uint8_t>* data) const {
+  DCHECK(data);
+  data->assign(std::begin(kMagic), std::end(kMagic));
+  data->push_back(kVersion);
+  AppendVarint(fingerprint_, data);
+  AppendVarint(entries_.size(), data);
+
+  // Samples are usually stored back to back, and the timestamps of a track
+  // usually advance by a constant sample duration, so the deltas are small.
+  uint64_t expected_offset = 0;
+  std::map<uint32_t, TrackState> track_states;
+  for (const Entry& entry : entries_) {
+    AppendVarint((static_cast<uint64_t>(entry.track_id) << 1) |
+                     (entry.is_key_frame ? 1 : 0),
+                 data);
+    AppendVarint(ZigZagEncode(static_cast<int64_t>(entry.offset) -
+                              static_cast<int64_t>(expected_offset)),
+                 data);
+    AppendVarint(entry.size, data);
+    TrackState& track_state = track_states[entry.track_id];
+    AppendVarint(ZigZagEncode(entry.dts - track_state.next_dts), data);
+    AppendVarint(ZigZagEncode(entry.pts - entry.dts), data);
+    AppendVarint(ZigZagEncode(entry.duration - track_state.duration), data);
+
+    expected_offset = entry.offset + entry.size;
+    track_state.next_dts = entry.dts + entry.duration;
+    track_state.duration = entry.duration;
+  }
+}
+
+bool SampleIndex::Parse(const uint8_t* data, size_t size) {
+  if (size < sizeof(kMagic) + 1 ||
+      !std::equal(std::begin(kMagic), std::end(kMagic), data)) {
+    return false;
+  }
+  if (data[sizeof(kMagic)] != kVersion) {
+    LOG(WARNING) << "Unsupported sample index version "
+                 << static_cast<int>(data[sizeof(kMagic)]);
+    return false;
+  }
+  VarintReader reader(data + sizeof(kMagic) + 1, size - sizeof(kMagic) - 1);
+
+  uint64_t fingerprint;
+  uint64_t num_entries;
+  if (!reader.Read(&fingerprint) || !reader.Read(&num_entries) ||
+      num_entries > reader.remaining() / kMinEntrySize) {
+    return false;
+  }
+
+  std::vector<Entry> entries(num_entries);
+  uint64_t expected_offset = 0;
+  std::map<uint32_t, TrackState> track_states;
+  for (Entry& entry : entries) {
+    uint64_t track_id_and_flags;
+    int64_t offset_delta;
+    uint64_t sample_size;
+    int64_t dts_delta;
+    int64_t composition_offset;
+    int64_t duration_delta;
+    if (!reader.Read(&track_id_and_flags) ||
+        !reader.ReadSigned(&offset_delta) || !reader.Read(&sample_size) ||
+        !reader.ReadSigned(&dts_delta) ||
+        !reader.ReadSigned(&composition_offset) ||
+        !reader.ReadSigned(&duration_delta) ||
+        (track_id_and_flags >> 1) > UINT32_MAX || sample_size > UINT32_MAX) {
+      return false;
+    }
+    entry.track_id = static_cast<uint32_t>(track_id_and_flags >> 1);
+    entry.is_key_frame = (track_id_and_flags & 1) != 0;
+    entry.offset = expected_offset + offset_delta;
+    entry.size = static_cast<uint32_t>(sample_size);
+    TrackState& track_state = track_states[entry.track_id];
+    entry.dts = track_state.next_dts + dts_delta;
+    entry.pts = entry.dts + composition_offset;
+    entry.duration = track_state.duration + duration_delta;
+
+    expected_offset = entry.offset + entry.size;
+    track_state.next_dts = entry.dts + entry.duration;
+    track_state.duration = entry.duration;
+  }
+  if (reader.remaining() != 0)
+    return false;
+
+  fingerprint_ = fingerprint;
+  entries_ = std::move(entries);
+  return true;
+}
+
+bool SampleIndex::WriteToFile(const std::string& file_name) const {
+  std::vector<uint8_t> data;
+  Serialize(&data);
+  return File::WriteFileAtomically(
+      file_name.c_str(),
+      std::string(reinterpret_cast<const char*>(data.data()), data.size()));
+}
+
+bool SampleIndex::ReadFromFile(const std::string& file_name) {
+  std::string data;
+  if (!File::ReadFileToString(file_name.c_str(), &data))
+    return false;
+  return Parse(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,83 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_DEMUXER_SAMPLE_INDEX_H_
+#define PACKAGER_MEDIA_DEMUXER_SAMPLE_INDEX_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace shaka {
+namespace media {
+
+class StreamInfo;
+
+/// A compact index of the samples of an input, in the order the samples are
+/// produced by the media parser. It lets later runs on the same input read
+/// the samples directly from their offsets instead of parsing the container.
+class SampleIndex {
+ public:
+  struct Entry {
+    uint32_t track_id = 0;
+    /// Offset of the sample data in the input.
+    uint64_t offset = 0;
+    uint32_t size = 0;
+    int64_t dts = 0;
+    int64_t pts = 0;
+    int64_t duration = 0;
+    bool is_key_frame = false;
+  };
+
+  /// @param fingerprint identifies the input the index is built for, see
+  ///        ComputeFingerprint.
+  explicit SampleIndex(uint64_t fingerprint = 0);
+
+  /// Computes the fingerprint of an input.
+  /// @param file_size is the size of the input.
+  /// @param modification_time is the last modification time of the input,
+  ///        see File::GetLastModificationTime.
+  /// @param header is the container header of the input, e.g. the 'moov'
+  ///        box, which holds the sample tables of non-fragmented MP4 inputs.
+  /// @param header_size is the size of @a header.
+  /// @param stream_infos is the stream info reported by the media parser.
+  static uint64_t ComputeFingerprint(
+      int64_t file_size,
+      int64_t modification_time,
+      const uint8_t* header,
+      size_t header_size,
+      const std::vector<std::shared_ptr<StreamInfo>>& stream_infos);
+
+  void AddEntry(const Entry& entry) { entries_.push_back(entry); }
+
+  /// Serializes the index. Entries are delta and varint encoded, which
+  /// usually takes 6 to 9 bytes per sample.
+  void Serialize(std::vector<uint8_t>* data) const;
+
+  /// Parses a serialized index.
+  /// @return false if @a data is not a valid index.
+  bool Parse(const uint8_t* data, size_t size);
+
+  /// Writes the index to @a file_name.
+  bool WriteToFile(const std::string& file_name) const;
+
+  /// Reads the index from @a file_name.
+  /// @return false if the file cannot be read or is not a valid index.
+  bool ReadFromFile(const std::string& file_name);
+
+  uint64_t fingerprint() const { return fingerprint_; }
+  const std::vector<Entry>& entries() const { return entries_; }
+
+ private:
+  uint64_t fingerprint_ = 0;
+  std::vector<Entry> entries_;
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_DEMUXER_SAMPLE_INDEX_H_
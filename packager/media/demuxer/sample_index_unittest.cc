@@ -0,0 +1,166 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/demuxer/sample_index.h>
+
+#include <gtest/gtest.h>
+
+namespace shaka {
+namespace media {
+namespace {
+
+const uint64_t kFingerprint = 0x123456789abcdef0ull;
+
+SampleIndex::Entry CreateEntry(uint32_t track_id,
+                               uint64_t offset,
+                               uint32_t size,
+                               int64_t dts,
+                               int64_t pts,
+                               int64_t duration,
+                               bool is_key_frame) {
+  SampleIndex::Entry entry;
+  entry.track_id = track_id;
+  entry.offset = offset;
+  entry.size = size;
+  entry.dts = dts;
+  entry.pts = pts;
+  entry.duration = duration;
+  entry.is_key_frame = is_key_frame;
+  return entry;
+}
+
+void ExpectEntriesEqual(const std::vector<SampleIndex::Entry>& expected,
+                        const std::vector<SampleIndex::Entry>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    SCOPED_TRACE(i);
+    EXPECT_EQ(expected[i].track_id, actual[i].track_id);
+    EXPECT_EQ(expected[i].offset, actual[i].offset);
+    EXPECT_EQ(expected[i].size, actual[i].size);
+    EXPECT_EQ(expected[i].dts, actual[i].dts);
+    EXPECT_EQ(expected[i].pts, actual[i].pts);
+    EXPECT_EQ(expected[i].duration, actual[i].duration);
+    EXPECT_EQ(expected[i].is_key_frame, actual[i].is_key_frame);
+  }
+}
+
+}  // namespace
+
+class SampleIndexTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    // Interleaved video and audio, with composition offsets, a negative dts,
+    // a gap and samples which are not stored in order.
+    index_.AddEntry(CreateEntry(1, 1000, 5000, -1000, 0, 1000, true));
+    index_.AddEntry(CreateEntry(2, 6000, 300, 0, 0, 1024, true));
+    index_.AddEntry(CreateEntry(1, 6300, 800, 0, 2000, 1000, false));
+    index_.AddEntry(CreateEntry(1, 7100, 700, 1000, 1000, 1000, false));
+    index_.AddEntry(CreateEntry(2, 100000, 310, 1024, 1024, 1024, true));
+    index_.AddEntry(CreateEntry(2, 50, 290, 5000, 5000, 1024, true));
+    index_.AddEntry(CreateEntry(0xffffffff, 0xffffffffffull, 0xffffffff,
+                                INT64_C(1) << 40, (INT64_C(1) << 40) - 1, 0,
+                                false));
+  }
+
+  SampleIndex index_{kFingerprint};
+};
+
+TEST_F(SampleIndexTest, SerializeAndParse) {
+  std::vector<uint8_t> data;
+  index_.Serialize(&data);
+
+  SampleIndex parsed_index;
+  ASSERT_TRUE(parsed_index.Parse(data.data(), data.size()));
+  EXPECT_EQ(kFingerprint, parsed_index.fingerprint());
+  ExpectEntriesEqual(index_.entries(), parsed_index.entries());
+}
+
+TEST_F(SampleIndexTest, CompactEncoding) {
+  SampleIndex index(kFingerprint);
+  const int kNumSamples = 1000;
+  for (int i = 0; i < kNumSamples; ++i) {
+    index.AddEntry(
+        CreateEntry(1, 1000 + i * 1000, 1000, i * 1001, i * 1001 + 2002, 1001,
+                    i % 30 == 0));
+  }
+  std::vector<uint8_t> data;
+  index.Serialize(&data);
+  // Two bytes for the size and the composition offset, and one byte for each
+  // of the other fields.
+  EXPECT_LT(data.size(), 9u * kNumSamples);
+
+  SampleIndex parsed_index;
+  ASSERT_TRUE(parsed_index.Parse(data.data(), data.size()));
+  ExpectEntriesEqual(index.entries(), parsed_index.entries());
+}
+
+TEST_F(SampleIndexTest, ParseEmpty) {
+  SampleIndex empty_index(kFingerprint);
+  std::vector<uint8_t> data;
+  empty_index.Serialize(&data);
+
+  SampleIndex parsed_index;
+  ASSERT_TRUE(parsed_index.Parse(data.data(), data.size()));
+  EXPECT_EQ(kFingerprint, parsed_index.fingerprint());
+  EXPECT_TRUE(parsed_index.entries().empty());
+}
+
+TEST_F(SampleIndexTest, ParseInvalidData) {
+  std::vector<uint8_t> data;
+  index_.Serialize(&data);
+
+  SampleIndex parsed_index;
+  // Truncated data.
+  for (size_t size = 0; size < data.size(); ++size)
+    EXPECT_FALSE(parsed_index.Parse(data.data(), size)) << size;
+  // Trailing data.
+  std::vector<uint8_t> extended_data = data;
+  extended_data.push_back(0);
+  EXPECT_FALSE(parsed_index.Parse(extended_data.data(), extended_data.size()));
+  // Bad magic.
+  std::vector<uint8_t> bad_data = data;
+  bad_data[0] = 'X';
+  EXPECT_FALSE(parsed_index.Parse(bad_data.data(), bad_data.size()));
+  // Unsupported version.
+  bad_data = data;
+  bad_data[4] = 2;
+  EXPECT_FALSE(parsed_index.Parse(bad_data.data(), bad_data.size()));
+}
+
+TEST_F(SampleIndexTest, WriteAndReadFile) {
+  const std::string file_name = "memory://sample_index";
+  ASSERT_TRUE(index_.WriteToFile(file_name));
+
+  SampleIndex read_index;
+  ASSERT_TRUE(read_index.ReadFromFile(file_name));
+  EXPECT_EQ(kFingerprint, read_index.fingerprint());
+  ExpectEntriesEqual(index_.entries(), read_index.entries());
+
+  EXPECT_FALSE(read_index.ReadFromFile("memory://no_such_index"));
+}
+
+TEST(SampleIndexFingerprintTest, CoversInput) {
+  const uint8_t kHeader[] = {'m', 'o', 'o', 'v', 1, 2, 3};
+  const uint8_t kOtherHeader[] = {'m', 'o', 'o', 'v', 1, 2, 4};
+  const std::vector<std::shared_ptr<StreamInfo>> kNoStreamInfos;
+  const uint64_t fingerprint = SampleIndex::ComputeFingerprint(
+      1000, 5, kHeader, sizeof(kHeader), kNoStreamInfos);
+  EXPECT_EQ(fingerprint,
+            SampleIndex::ComputeFingerprint(1000, 5, kHeader, sizeof(kHeader),
+                                            kNoStreamInfos));
+  EXPECT_NE(fingerprint,
+            SampleIndex::ComputeFingerprint(1001, 5, kHeader, sizeof(kHeader),
+                                            kNoStreamInfos));
+  EXPECT_NE(fingerprint,
+            SampleIndex::ComputeFingerprint(1000, 6, kHeader, sizeof(kHeader),
+                                            kNoStreamInfos));
+  EXPECT_NE(fingerprint, SampleIndex::ComputeFingerprint(
+                             1000, 5, kOtherHeader, sizeof(kOtherHeader),
+                             kNoStreamInfos));
+}
+
+}  // namespace media
+}  // namespace shaka
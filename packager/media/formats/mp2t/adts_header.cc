@@ -55,25 +55,25 @@ bool AdtsHeader::Parse(const uint8_t* adts_frame, size_t adts_frame_size) {
   BitReader frame(adts_frame, adts_frame_size);
   // Verify frame starts with sync bits (0xfff).
   uint32_t sync;
-  RCHECK(frame.ReadBits(12, &sync));
+  RCHECK(frame.ReadBits<12>(&sync));
   RCHECK(sync == 0xfff);
   // Skip MPEG version and layer.
   RCHECK(frame.SkipBits(3));
-  RCHECK(frame.ReadBits(1, &protection_absent_));
-  RCHECK(frame.ReadBits(2, &profile_));
-  RCHECK(frame.ReadBits(4, &sampling_frequency_index_));
+  RCHECK(frame.ReadBits<1>(&protection_absent_));
+  RCHECK(frame.ReadBits<2>(&profile_));
+  RCHECK(frame.ReadBits<4>(&sampling_frequency_index_));
   RCHECK(sampling_frequency_index_ < kAdtsFrequencyTableSize);
   // Skip private stream bit.
   RCHECK(frame.SkipBits(1));
-  RCHECK(frame.ReadBits(3, &channel_configuration_));
+  RCHECK(frame.ReadBits<3>(&channel_configuration_));
   RCHECK(channel_configuration_ < kAdtsNumChannelsTableSize);
   // Skip originality, home and copyright info.
   RCHECK(frame.SkipBits(4));
-  RCHECK(frame.ReadBits(13, &frame_size_));
+  RCHECK(frame.ReadBits<13>(&frame_size_));
   // Skip buffer fullness indicator.
   RCHECK(frame.SkipBits(11));
   uint8_t num_blocks_minus_1;
-  RCHECK(frame.ReadBits(2, &num_blocks_minus_1));
+  RCHECK(frame.ReadBits<2>(&num_blocks_minus_1));
   if (num_blocks_minus_1) {
     NOTIMPLEMENTED() << "ADTS frames with more than one data block "
                         "not supported.";
@@ -19,7 +19,9 @@ namespace {
 const int32_t kTsTimescale = 90000;
 }  // namespace
 
-TsMuxer::TsMuxer(const MuxerOptions& muxer_options) : Muxer(muxer_options) {}
+TsMuxer::TsMuxer(const MuxerOptions& muxer_options)
+    : Muxer(muxer_options),
+      segment_number_(muxer_options.num_previous_segments) {}
 TsMuxer::~TsMuxer() {}
 
 Status TsMuxer::InitializeMuxer() {
@@ -43,6 +45,7 @@ Status TsMuxer::InitializeMuxer() {
 }
 
 Status TsMuxer::Finalize() {
+  RETURN_IF_ERROR(segment_writer_.Flush());
   FireOnMediaEndEvent();
   return segmenter_->Finalize();
 }
@@ -86,60 +89,48 @@ Status TsMuxer::FinalizeSegment(size_t stream_id,
 
   const int64_t file_size = segmenter_->segment_buffer()->Size();
 
-  RETURN_IF_ERROR(WriteSegment(segment_path, segmenter_->segment_buffer()));
-
-  total_duration_ += segment_info.duration;
-
-  if (muxer_listener()) {
-    muxer_listener()->OnNewSegment(
-        segment_path,
-        segment_info.start_timestamp * segmenter_->timescale() +
-            segmenter_->transport_stream_timestamp_offset(),
-        segment_info.duration * segmenter_->timescale(), file_size);
-  }
-
-  segmenter_->set_segment_started(false);
-
-  return Status::OK;
-}
-
-Status TsMuxer::WriteSegment(const std::string& segment_path,
-                             BufferWriter* segment_buffer) {
-  std::unique_ptr<File, FileCloser> file;
-
   if (output_file_) {
     // This is in single segment mode.
     Range range;
     range.start = media_ranges_.subsegment_ranges.empty()
                       ? 0
                       : (media_ranges_.subsegment_ranges.back().end + 1);
-    range.end = range.start + segment_buffer->Size() - 1;
+    range.end = range.start + file_size - 1;
     media_ranges_.subsegment_ranges.push_back(range);
-  } else {
-    file.reset(File::Open(segment_path.c_str(), "w"));
-    if (!file) {
-      return Status(error::FILE_FAILURE,
-                    "Cannot open file for write " + segment_path);
-    }
   }
 
-  RETURN_IF_ERROR(segment_buffer->WriteToFile(output_file_ ? output_file_.get()
-                                                           : file.get()));
+  total_duration_ += segment_info.duration;
+
+  // The listener is notified once the segment is written, while the next
+  // segment is being packetized.
+  std::vector<TsSegmenter::KeyFrameInfo> key_frame_infos =
+      segmenter_->TakeKeyFrameInfos();
+  const int64_t start_time = segment_info.start_timestamp *
+                                 segmenter_->timescale() +
+                             segmenter_->transport_stream_timestamp_offset();
+  const int64_t duration = segment_info.duration * segmenter_->timescale();
+  RETURN_IF_ERROR(segment_writer_.WriteSegment(
+      segment_path, output_file_.get(), segmenter_->segment_buffer(),
+      [this, segment_path, key_frame_infos, start_time, duration,
+       file_size]() {
+        if (!muxer_listener())
+          return;
+        for (const TsSegmenter::KeyFrameInfo& key_frame : key_frame_infos) {
+          muxer_listener()->OnKeyFrame(key_frame.timestamp,
+                                       key_frame.start_byte_offset,
+                                       key_frame.size);
+        }
+        muxer_listener()->OnNewSegment(segment_path, start_time, duration,
+                                       file_size);
+      }));
+
+  segmenter_->set_segment_started(false);
 
-  if (file)
-    RETURN_IF_ERROR(CloseFile(std::move(file)));
   return Status::OK;
 }
 
-Status TsMuxer::CloseFile(std::unique_ptr<File, FileCloser> file) {
-  std::string file_name = file->file_name();
-  if (!file.release()->Close()) {
-    return Status(
-        error::FILE_FAILURE,
-        "Cannot close file " + file_name +
-            ", possibly file permission issue or running out of disk space.");
-  }
-  return Status::OK;
+Status TsMuxer::FlushPendingSegments() {
+  return segment_writer_.Flush();
 }
 
 void TsMuxer::FireOnMediaStartEvent() {
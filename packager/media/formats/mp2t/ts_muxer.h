@@ -8,6 +8,7 @@
 #define PACKAGER_MEDIA_FORMATS_MP2T_TS_MUXER_H_
 
 #include <packager/macros/classes.h>
+#include <packager/media/base/async_segment_writer.h>
 #include <packager/media/base/muxer.h>
 #include <packager/media/formats/mp2t/ts_segmenter.h>
 
@@ -29,10 +30,7 @@ class TsMuxer : public Muxer {
   Status AddMediaSample(size_t stream_id, const MediaSample& sample) override;
   Status FinalizeSegment(size_t stream_id,
                          const SegmentInfo& sample) override;
-
-  Status WriteSegment(const std::string& segment_path,
-                      BufferWriter* segment_buffer);
-  Status CloseFile(std::unique_ptr<File, FileCloser> file);
+  Status FlushPendingSegments() override;
 
   void FireOnMediaStartEvent();
   void FireOnMediaEndEvent();
@@ -42,7 +40,7 @@ class TsMuxer : public Muxer {
   size_t num_samples_ = 0;
 
   // Used in multi-segment mode for segment template.
-  uint64_t segment_number_ = 0;
+  uint64_t segment_number_;
 
   // Used in single segment mode.
   std::unique_ptr<File, FileCloser> output_file_;
@@ -52,6 +50,10 @@ class TsMuxer : public Muxer {
 
   uint64_t total_duration_ = 0;
 
+  // Writes the segments while the next one is packetized. Declared last so that
+  // it waits for the segment being written before |output_file_| is closed.
+  AsyncSegmentWriter segment_writer_;
+
   DISALLOW_COPY_AND_ASSIGN(TsMuxer);
 };
 
@@ -90,14 +90,14 @@ bool TsPacket::ParseHeader(const uint8_t* buf) {
   int transport_priority;
   int transport_scrambling_control;
   int adaptation_field_control;
-  RCHECK(bit_reader.ReadBits(8, &syncword));
-  RCHECK(bit_reader.ReadBits(1, &transport_error_indicator));
-  RCHECK(bit_reader.ReadBits(1, &payload_unit_start_indicator));
-  RCHECK(bit_reader.ReadBits(1, &transport_priority));
-  RCHECK(bit_reader.ReadBits(13, &pid_));
-  RCHECK(bit_reader.ReadBits(2, &transport_scrambling_control));
-  RCHECK(bit_reader.ReadBits(2, &adaptation_field_control));
-  RCHECK(bit_reader.ReadBits(4, &continuity_counter_));
+  RCHECK(bit_reader.ReadBits<8>(&syncword));
+  RCHECK(bit_reader.ReadBits<1>(&transport_error_indicator));
+  RCHECK(bit_reader.ReadBits<1>(&payload_unit_start_indicator));
+  RCHECK(bit_reader.ReadBits<1>(&transport_priority));
+  RCHECK(bit_reader.ReadBits<13>(&pid_));
+  RCHECK(bit_reader.ReadBits<2>(&transport_scrambling_control));
+  RCHECK(bit_reader.ReadBits<2>(&adaptation_field_control));
+  RCHECK(bit_reader.ReadBits<4>(&continuity_counter_));
   payload_unit_start_indicator_ = (payload_unit_start_indicator != 0);
   payload_ += 4;
   payload_size_ -= 4;
@@ -112,7 +112,7 @@ bool TsPacket::ParseHeader(const uint8_t* buf) {
 
   // Read the adaptation field if needed.
   int adaptation_field_length;
-  RCHECK(bit_reader.ReadBits(8, &adaptation_field_length));
+  RCHECK(bit_reader.ReadBits<8>(&adaptation_field_length));
   DVLOG(LOG_LEVEL_TS) << "adaptation_field_length=" << adaptation_field_length;
   payload_ += 1;
   payload_size_ -= 1;
@@ -155,14 +155,14 @@ bool TsPacket::ParseAdaptationField(BitReader* bit_reader,
   int splicing_point_flag;
   int transport_private_data_flag;
   int adaptation_field_extension_flag;
-  RCHECK(bit_reader->ReadBits(1, &discontinuity_indicator));
-  RCHECK(bit_reader->ReadBits(1, &random_access_indicator));
-  RCHECK(bit_reader->ReadBits(1, &elementary_stream_priority_indicator));
-  RCHECK(bit_reader->ReadBits(1, &pcr_flag));
-  RCHECK(bit_reader->ReadBits(1, &opcr_flag));
-  RCHECK(bit_reader->ReadBits(1, &splicing_point_flag));
-  RCHECK(bit_reader->ReadBits(1, &transport_private_data_flag));
-  RCHECK(bit_reader->ReadBits(1, &adaptation_field_extension_flag));
+  RCHECK(bit_reader->ReadBits<1>(&discontinuity_indicator));
+  RCHECK(bit_reader->ReadBits<1>(&random_access_indicator));
+  RCHECK(bit_reader->ReadBits<1>(&elementary_stream_priority_indicator));
+  RCHECK(bit_reader->ReadBits<1>(&pcr_flag));
+  RCHECK(bit_reader->ReadBits<1>(&opcr_flag));
+  RCHECK(bit_reader->ReadBits<1>(&splicing_point_flag));
+  RCHECK(bit_reader->ReadBits<1>(&transport_private_data_flag));
+  RCHECK(bit_reader->ReadBits<1>(&adaptation_field_extension_flag));
   discontinuity_indicator_ = (discontinuity_indicator != 0);
   random_access_indicator_ = (random_access_indicator != 0);
 
@@ -170,35 +170,35 @@ bool TsPacket::ParseAdaptationField(BitReader* bit_reader,
     int64_t program_clock_reference_base;
     int reserved;
     int program_clock_reference_extension;
-    RCHECK(bit_reader->ReadBits(33, &program_clock_reference_base));
-    RCHECK(bit_reader->ReadBits(6, &reserved));
-    RCHECK(bit_reader->ReadBits(9, &program_clock_reference_extension));
+    RCHECK(bit_reader->ReadBits<33>(&program_clock_reference_base));
+    RCHECK(bit_reader->ReadBits<6>(&reserved));
+    RCHECK(bit_reader->ReadBits<9>(&program_clock_reference_extension));
   }
 
   if (opcr_flag) {
     int64_t original_program_clock_reference_base;
     int reserved;
     int original_program_clock_reference_extension;
-    RCHECK(bit_reader->ReadBits(33, &original_program_clock_reference_base));
-    RCHECK(bit_reader->ReadBits(6, &reserved));
+    RCHECK(bit_reader->ReadBits<33>(&original_program_clock_reference_base));
+    RCHECK(bit_reader->ReadBits<6>(&reserved));
     RCHECK(
-        bit_reader->ReadBits(9, &original_program_clock_reference_extension));
+        bit_reader->ReadBits<9>(&original_program_clock_reference_extension));
   }
 
   if (splicing_point_flag) {
     int splice_countdown;
-    RCHECK(bit_reader->ReadBits(8, &splice_countdown));
+    RCHECK(bit_reader->ReadBits<8>(&splice_countdown));
   }
 
   if (transport_private_data_flag) {
     int transport_private_data_length;
-    RCHECK(bit_reader->ReadBits(8, &transport_private_data_length));
+    RCHECK(bit_reader->ReadBits<8>(&transport_private_data_length));
     RCHECK(bit_reader->SkipBits(8 * transport_private_data_length));
   }
 
   if (adaptation_field_extension_flag) {
     int adaptation_field_extension_length;
-    RCHECK(bit_reader->ReadBits(8, &adaptation_field_extension_length));
+    RCHECK(bit_reader->ReadBits<8>(&adaptation_field_extension_length));
     RCHECK(bit_reader->SkipBits(8 * adaptation_field_extension_length));
   }
 
@@ -210,7 +210,7 @@ bool TsPacket::ParseAdaptationField(BitReader* bit_reader,
   RCHECK(adaptation_field_remaining_size >= 0);
   for (int k = 0; k < adaptation_field_remaining_size; k++) {
     int stuffing_byte;
-    RCHECK(bit_reader->ReadBits(8, &stuffing_byte));
+    RCHECK(bit_reader->ReadBits<8>(&stuffing_byte));
     RCHECK(stuffing_byte == 0xff);
   }
 
@@ -112,6 +112,12 @@ Status TsSegmenter::AddSample(const MediaSample& sample) {
   return WritePesPackets();
 }
 
+std::vector<TsSegmenter::KeyFrameInfo> TsSegmenter::TakeKeyFrameInfos() {
+  std::vector<KeyFrameInfo> key_frame_infos;
+  key_frame_infos.swap(key_frame_infos_);
+  return key_frame_infos;
+}
+
 void TsSegmenter::InjectTsWriterForTesting(std::unique_ptr<TsWriter> writer) {
   ts_writer_ = std::move(writer);
 }
@@ -153,7 +159,9 @@ Status TsSegmenter::WritePesPackets() {
 
       uint64_t end_pos = segment_buffer_.Size();
 
-      listener_->OnKeyFrame(timestamp, start_pos, end_pos - start_pos);
+      // The key frames are reported with the segment, which may be written
+      // asynchronously.
+      key_frame_infos_.push_back({timestamp, start_pos, end_pos - start_pos});
     } else {
       if (!ts_writer_->AddPesPacket(std::move(pes_packet), &segment_buffer_))
         return Status(error::MUXER_FAILURE, "Failed to add PES packet.");
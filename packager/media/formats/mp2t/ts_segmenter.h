@@ -8,6 +8,7 @@
 #define PACKAGER_MEDIA_FORMATS_MP2T_TS_SEGMENTER_H_
 
 #include <memory>
+#include <vector>
 
 #include <packager/file.h>
 #include <packager/macros/classes.h>
@@ -26,6 +27,14 @@ namespace mp2t {
 
 class TsSegmenter {
  public:
+  /// A key frame in the current segment, to be reported to the listener
+  /// together with the segment.
+  struct KeyFrameInfo {
+    int64_t timestamp;
+    uint64_t start_byte_offset;
+    uint64_t size;
+  };
+
   // TODO(rkuroiwa): Add progress listener?
   /// @param options is the options for this muxer. This must stay valid
   ///        throughout the life time of the instance.
@@ -69,6 +78,9 @@ class TsSegmenter {
   /// Only for testing.
   void SetSegmentStartedForTesting(bool value);
 
+  /// @return The key frames of the current segment, which are cleared.
+  std::vector<KeyFrameInfo> TakeKeyFrameInfos();
+
   int64_t segment_start_timestamp() const { return segment_start_timestamp_; }
   BufferWriter* segment_buffer() { return &segment_buffer_; }
   void set_segment_started(bool value) { segment_started_ = value; }
@@ -107,6 +119,10 @@ class TsSegmenter {
   std::unique_ptr<PesPacketGenerator> pes_packet_generator_;
 
   int64_t segment_start_timestamp_ = -1;
+
+  // Key frames of the current segment. Only collected if there is a listener.
+  std::vector<KeyFrameInfo> key_frame_infos_;
+
   DISALLOW_COPY_AND_ASSIGN(TsSegmenter);
 };
 
@@ -4,6 +4,7 @@
 
 #include <packager/media/formats/mp4/box_reader.h>
 
+#include <algorithm>
 #include <cinttypes>
 #include <limits>
 #include <memory>
@@ -26,10 +27,10 @@ BoxReader::BoxReader(const uint8_t* buf, size_t size)
 }
 
 BoxReader::~BoxReader() {
-  if (scanned_ && !children_.empty()) {
-    for (ChildMap::iterator itr = children_.begin(); itr != children_.end();
-         ++itr) {
-      DVLOG(1) << "Skipping unknown box: " << FourCCToString(itr->first);
+  if (scanned_) {
+    for (const Child& child : children_) {
+      if (child.type != FOURCC_NULL)
+        DVLOG(1) << "Skipping unknown box: " << FourCCToString(child.type);
     }
   }
 }
@@ -71,16 +72,14 @@ bool BoxReader::ScanChildren() {
   scanned_ = true;
 
   while (pos() < size()) {
-    std::unique_ptr<BoxReader> child(
-        new BoxReader(&data()[pos()], size() - pos()));
+    BoxReader child(&data()[pos()], size() - pos());
     bool err;
-    if (!child->ReadHeader(&err))
+    if (!child.ReadHeader(&err))
       return false;
 
-    FourCC box_type = child->type();
-    size_t box_size = child->size();
-    children_.insert(std::pair<FourCC, std::unique_ptr<BoxReader>>(
-        box_type, std::move(child)));
+    const FourCC box_type = child.type();
+    const size_t box_size = child.size();
+    children_.push_back({box_type, pos(), box_size});
     VLOG(2) << "Child " << FourCCToString(box_type) << " size 0x" << std::hex
             << box_size << std::dec;
     RCHECK(SkipBytes(box_size));
@@ -93,24 +92,39 @@ bool BoxReader::ReadChild(Box* child) {
   DCHECK(scanned_);
   FourCC child_type = child->BoxType();
 
-  ChildMap::iterator itr = children_.find(child_type);
+  std::vector<Child>::iterator itr = FindChild(child_type);
   RCHECK(itr != children_.end());
   DVLOG(2) << "Found a " << FourCCToString(child_type) << " box.";
-  RCHECK(child->Parse(itr->second.get()));
-  children_.erase(itr);
-  return true;
+  return ParseChild(&*itr, child);
 }
 
 bool BoxReader::ChildExist(Box* child) {
-  return children_.count(child->BoxType()) > 0;
+  return FindChild(child->BoxType()) != children_.end();
 }
 
 bool BoxReader::TryReadChild(Box* child) {
-  if (!children_.count(child->BoxType()))
+  if (FindChild(child->BoxType()) == children_.end())
     return true;
   return ReadChild(child);
 }
 
+std::vector<BoxReader::Child>::iterator BoxReader::FindChild(FourCC type) {
+  DCHECK_NE(type, FOURCC_NULL);
+  return std::find_if(
+      children_.begin(), children_.end(),
+      [type](const Child& child) { return child.type == type; });
+}
+
+bool BoxReader::ParseChild(Child* child, Box* box) {
+  DCHECK_NE(child->type, FOURCC_NULL);
+  // The header has been validated in ScanChildren().
+  BoxReader child_reader(&data()[child->offset], child->size);
+  bool err;
+  RCHECK(child_reader.ReadHeader(&err));
+  child->type = FOURCC_NULL;
+  return box->Parse(&child_reader);
+}
+
 bool BoxReader::ReadHeader(bool* err) {
   uint64_t size = 0;
   *err = false;
@@ -5,7 +5,6 @@
 #ifndef PACKAGER_MEDIA_FORMATS_MP4_BOX_READER_H_
 #define PACKAGER_MEDIA_FORMATS_MP4_BOX_READER_H_
 
-#include <map>
 #include <memory>
 #include <vector>
 
@@ -114,13 +113,28 @@ class BoxReader : public BufferReader {
   // true, the error is unrecoverable and the stream should be aborted.
   bool ReadHeader(bool* err);
 
-  FourCC type_;
+  // Location of a child box within the buffer.
+  struct Child {
+    FourCC type;
+    // Offset of the child box, including its header, from the start of the
+    // buffer of this box.
+    size_t offset;
+    size_t size;
+  };
+
+  // @return The first child of |type| which has not been read yet, or
+  //         children_.end() if there is none.
+  std::vector<Child>::iterator FindChild(FourCC type);
+
+  // Parse |box| from |child| and mark |child| as read.
+  bool ParseChild(Child* child, Box* box);
 
-  typedef std::multimap<FourCC, std::unique_ptr<BoxReader>> ChildMap;
+  FourCC type_;
 
-  // The set of child box FourCCs and their corresponding buffer readers. Only
-  // valid if scanned_ is true.
-  ChildMap children_;
+  // The child boxes in the order they appear in the buffer. Children which
+  // have been read have their type reset to FOURCC_NULL. Only valid if
+  // scanned_ is true.
+  std::vector<Child> children_;
   bool scanned_;
 
   DISALLOW_COPY_AND_ASSIGN(BoxReader);
@@ -138,18 +152,20 @@ bool BoxReader::TryReadChildren(std::vector<T>* children) {
   DCHECK(scanned_);
   DCHECK(children->empty());
 
-  children->resize(1);
-  FourCC child_type = (*children)[0].BoxType();
-
-  ChildMap::iterator start_itr = children_.lower_bound(child_type);
-  ChildMap::iterator end_itr = children_.upper_bound(child_type);
-  children->resize(std::distance(start_itr, end_itr));
+  const FourCC child_type = T().BoxType();
+  size_t num_children = 0;
+  for (const Child& child : children_) {
+    if (child.type == child_type)
+      ++num_children;
+  }
+  children->resize(num_children);
   typename std::vector<T>::iterator child_itr = children->begin();
-  for (ChildMap::iterator itr = start_itr; itr != end_itr; ++itr) {
-    RCHECK(child_itr->Parse(itr->second.get()));
+  for (Child& child : children_) {
+    if (child.type != child_type)
+      continue;
+    RCHECK(ParseChild(&child, &*child_itr));
     ++child_itr;
   }
-  children_.erase(start_itr, end_itr);
 
   DVLOG(2) << "Found " << children->size() << " " << FourCCToString(child_type)
            << " boxes.";
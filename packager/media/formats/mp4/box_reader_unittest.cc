@@ -167,6 +167,29 @@ TEST_F(BoxReaderTest, ScanChildrenTest) {
   EXPECT_TRUE(reader->TryReadChildren(&kids));
 }
 
+TEST_F(BoxReaderTest, ReadChildInOrderTest) {
+  std::vector<uint8_t> buf = GetBuf();
+  bool err;
+  std::unique_ptr<BoxReader> reader(
+      BoxReader::ReadBox(&buf[0], buf.size(), &err));
+
+  EXPECT_TRUE(reader->SkipBytes(16) && reader->ScanChildren());
+
+  // Children of the same type are read in the order they appear, including
+  // the one with an extended-size header.
+  PsshBox pssh;
+  EXPECT_TRUE(reader->ChildExist(&pssh));
+  EXPECT_TRUE(reader->ReadChild(&pssh));
+  EXPECT_EQ(0xdeadbeef, pssh.val);
+  EXPECT_TRUE(reader->ReadChild(&pssh));
+  EXPECT_EQ(0xfacecafe, pssh.val);
+  EXPECT_FALSE(reader->ChildExist(&pssh));
+
+  std::vector<PsshBox> kids;
+  EXPECT_TRUE(reader->TryReadChildren(&kids));
+  EXPECT_TRUE(kids.empty());
+}
+
 TEST_F(BoxReaderTest, ReadAllChildrenTest) {
   std::vector<uint8_t> buf = GetBuf();
   // Modify buffer to exclude its last 'free' box.
@@ -0,0 +1,319 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/formats/mp4/fragment_scanner.h>
+
+#include <algorithm>
+#include <limits>
+
+#include <absl/log/log.h>
+#include <absl/strings/str_format.h>
+
+#include <packager/macros/status.h>
+#include <packager/media/base/encryption_config.h>
+#include <packager/media/base/protection_system_specific_info.h>
+#include <packager/media/base/stream_info.h>
+#include <packager/media/formats/mp4/box_definitions.h>
+#include <packager/media/formats/mp4/box_reader.h>
+#include <packager/media/formats/mp4/mp4_media_parser.h>
+#include <packager/media/formats/mp4/track_run_iterator.h>
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+// Large enough for a box header with a 64-bit size.
+const size_t kMaxBoxHeaderSize = 16;
+
+const ProtectionSchemeInfo& GetProtectionSchemeInfo(const Track& track) {
+  const SampleDescription& description =
+      track.media.information.sample_table.description;
+  return description.type == kVideo ? description.video_entries[0].sinf
+                                    : description.audio_entries[0].sinf;
+}
+
+bool GetEncryptionConfig(const Movie& moov,
+                         EncryptionConfig* encryption_config) {
+  const ProtectionSchemeInfo& sinf = GetProtectionSchemeInfo(moov.tracks[0]);
+  const TrackEncryption& tenc = sinf.info.track_encryption;
+  encryption_config->protection_scheme = sinf.type.type;
+  encryption_config->crypt_byte_block = tenc.default_crypt_byte_block;
+  encryption_config->skip_byte_block = tenc.default_skip_byte_block;
+  encryption_config->per_sample_iv_size = tenc.default_per_sample_iv_size;
+  encryption_config->constant_iv = tenc.default_constant_iv;
+  encryption_config->key_id = tenc.default_kid;
+
+  std::vector<uint8_t> pssh_boxes;
+  for (const ProtectionSystemSpecificHeader& pssh : moov.pssh) {
+    pssh_boxes.insert(pssh_boxes.end(), pssh.raw_box.begin(),
+                      pssh.raw_box.end());
+  }
+  return pssh_boxes.empty() ||
+         ProtectionSystemSpecificInfo::ParseBoxes(
+             pssh_boxes.data(), pssh_boxes.size(),
+             &encryption_config->key_system_info);
+}
+}  // namespace
+
+FragmentScanner::FragmentScanner() = default;
+
+FragmentScanner::~FragmentScanner() = default;
+
+Status FragmentScanner::Scan(const std::string& file_name) {
+  file_name_ = file_name;
+  file_.reset(File::Open(file_name.c_str(), "r"));
+  if (!file_)
+    return Status(error::FILE_FAILURE, "Cannot open file " + file_name);
+  const int64_t file_size = file_->Size();
+  if (file_size < 0)
+    return Status(error::FILE_FAILURE, "Cannot get the size of " + file_name);
+
+  std::vector<uint8_t> data;
+  uint64_t offset = 0;
+  while (offset < static_cast<uint64_t>(file_size)) {
+    const uint64_t header_size = std::min<uint64_t>(
+        kMaxBoxHeaderSize, static_cast<uint64_t>(file_size) - offset);
+    RETURN_IF_ERROR(ReadBox(offset, header_size, &data));
+    FourCC type = FOURCC_NULL;
+    uint64_t box_size = 0;
+    bool err = false;
+    if (!BoxReader::StartBox(data.data(), data.size(), &type, &box_size,
+                             &err) ||
+        offset + box_size > static_cast<uint64_t>(file_size)) {
+      return Status(error::PARSER_FAILURE,
+                    absl::StrFormat("Invalid box at offset %u of %s.", offset,
+                                    file_name.c_str()));
+    }
+
+    switch (type) {
+      case FOURCC_moov:
+        if (moov_) {
+          return Status(error::PARSER_FAILURE,
+                        "Multiple 'moov' boxes in " + file_name);
+        }
+        // The init segment is read as a whole so that it can be parsed by
+        // MP4MediaParser.
+        RETURN_IF_ERROR(ReadBox(0, offset + box_size, &data));
+        RETURN_IF_ERROR(ParseInit(data, offset));
+        init_range_ = {0, offset + box_size - 1};
+        break;
+      case FOURCC_sidx:
+        // A 'sidx' box after the first fragment only indexes the fragments
+        // following it, so it cannot be used for the whole file.
+        if (moov_ && fragments_.empty() && !index_range_) {
+          RETURN_IF_ERROR(ReadBox(offset, box_size, &data));
+          RETURN_IF_ERROR(ParseIndex(data, offset + box_size));
+          index_range_ = Range{offset, offset + box_size - 1};
+        }
+        break;
+      case FOURCC_moof:
+        if (!moov_) {
+          return Status(error::PARSER_FAILURE,
+                        "'moof' box before the 'moov' box in " + file_name);
+        }
+        RETURN_IF_ERROR(ReadBox(offset, box_size, &data));
+        RETURN_IF_ERROR(ParseFragment(data, offset));
+        break;
+      case FOURCC_mdat:
+        if (!fragments_.empty())
+          fragments_.back().end = offset + box_size;
+        break;
+      default:
+        VLOG(2) << "Skipping top-level box: " << FourCCToString(type);
+        break;
+    }
+    offset += box_size;
+  }
+
+  if (!moov_)
+    return Status(error::PARSER_FAILURE, "No 'moov' box in " + file_name);
+  if (fragments_.empty()) {
+    return Status(error::PARSER_FAILURE,
+                  file_name + " is not a fragmented MP4 file.");
+  }
+  return CreateSegments();
+}
+
+Status FragmentScanner::ReadBox(uint64_t offset,
+                                uint64_t size,
+                                std::vector<uint8_t>* data) {
+  data->resize(size);
+  if (!file_->Seek(offset))
+    return Status(error::FILE_FAILURE, "Cannot seek file " + file_name_);
+  uint64_t bytes_read = 0;
+  while (bytes_read < size) {
+    const int64_t result =
+        file_->Read(data->data() + bytes_read, size - bytes_read);
+    if (result <= 0)
+      return Status(error::FILE_FAILURE, "Cannot read file " + file_name_);
+    bytes_read += result;
+  }
+  return Status::OK;
+}
+
+Status FragmentScanner::ParseInit(const std::vector<uint8_t>& data,
+                                  uint64_t moov_offset) {
+  std::vector<std::shared_ptr<StreamInfo>> streams;
+  MP4MediaParser parser;
+  parser.Init(
+      [&streams](const std::vector<std::shared_ptr<StreamInfo>>& stream_info) {
+        streams = stream_info;
+      },
+      [](uint32_t, std::shared_ptr<MediaSample>) { return true; },
+      [](uint32_t, std::shared_ptr<TextSample>) { return true; }, nullptr);
+  if (!parser.Parse(data.data(), static_cast<int>(data.size())) ||
+      streams.empty()) {
+    return Status(error::PARSER_FAILURE,
+                  "Cannot parse the 'moov' box of " + file_name_);
+  }
+  if (streams.size() > 1) {
+    return Status(error::UNIMPLEMENTED,
+                  "Only files with a single track are supported, but " +
+                      file_name_ + " has " + std::to_string(streams.size()) +
+                      " tracks.");
+  }
+  stream_info_ = streams[0];
+
+  bool err = false;
+  std::unique_ptr<BoxReader> reader(BoxReader::ReadBox(
+      data.data() + moov_offset, data.size() - moov_offset, &err));
+  moov_.reset(new Movie);
+  if (!reader || !moov_->Parse(reader.get())) {
+    return Status(error::PARSER_FAILURE,
+                  "Cannot parse the 'moov' box of " + file_name_);
+  }
+  if (stream_info_->is_encrypted()) {
+    EncryptionConfig encryption_config;
+    if (!GetEncryptionConfig(*moov_, &encryption_config)) {
+      return Status(error::PARSER_FAILURE,
+                    "Cannot parse the 'pssh' boxes of " + file_name_);
+    }
+    stream_info_->set_encryption_config(encryption_config);
+  }
+  runs_.reset(new TrackRunIterator(moov_.get()));
+  return Status::OK;
+}
+
+Status FragmentScanner::ParseIndex(const std::vector<uint8_t>& data,
+                                   uint64_t sidx_end) {
+  bool err = false;
+  std::unique_ptr<BoxReader> reader(
+      BoxReader::ReadBox(data.data(), data.size(), &err));
+  SegmentIndex sidx;
+  if (!reader || !sidx.Parse(reader.get())) {
+    return Status(error::PARSER_FAILURE,
+                  "Cannot parse the 'sidx' box of " + file_name_);
+  }
+  uint64_t offset = sidx_end + sidx.first_offset;
+  for (const SegmentReference& reference : sidx.references) {
+    if (reference.reference_type) {
+      return Status(error::UNIMPLEMENTED,
+                    "Hierarchical 'sidx' boxes are not supported.");
+    }
+    subsegment_ranges_.push_back(
+        {offset, offset + reference.referenced_size - 1});
+    offset += reference.referenced_size;
+  }
+  return Status::OK;
+}
+
+Status FragmentScanner::ParseFragment(const std::vector<uint8_t>& data,
+                                      uint64_t offset) {
+  bool err = false;
+  std::unique_ptr<BoxReader> reader(
+      BoxReader::ReadBox(data.data(), data.size(), &err));
+  MovieFragment moof;
+  if (!reader || !moof.Parse(reader.get()) || !runs_->Init(moof)) {
+    return Status(error::PARSER_FAILURE,
+                  absl::StrFormat("Cannot parse the 'moof' box at offset %u "
+                                  "of %s.",
+                                  offset, file_name_.c_str()));
+  }
+
+  Fragment fragment;
+  fragment.offset = offset;
+  fragment.end = offset + data.size();
+  fragment.start_time = std::numeric_limits<int64_t>::max();
+  const bool is_video = stream_info_->stream_type() == kStreamVideo;
+  for (; runs_->IsRunValid(); runs_->AdvanceRun()) {
+    for (; runs_->IsSampleValid(); runs_->AdvanceSample()) {
+      if (sample_duration_ == 0)
+        sample_duration_ = runs_->duration();
+      // As in Fragmenter, the part of a sample with negative timestamp is not
+      // presented, so it is excluded from the fragment.
+      const int64_t end_pts = runs_->cts() + runs_->duration();
+      if (end_pts <= 0)
+        continue;
+      const int64_t pts = std::max<int64_t>(runs_->cts(), 0);
+      fragment.start_time = std::min(fragment.start_time, pts);
+      fragment.duration += end_pts - pts;
+      // As in Segmenter, the key frame covers the fragment up to the end of
+      // the first key frame sample.
+      if (is_video && runs_->is_keyframe() && !fragment.key_frame) {
+        fragment.key_frame = KeyFrameInfo{
+            runs_->cts(), 0,
+            static_cast<uint64_t>(runs_->sample_offset() +
+                                  runs_->sample_size())};
+      }
+    }
+  }
+  if (fragment.duration == 0) {
+    return Status(error::PARSER_FAILURE,
+                  absl::StrFormat("Empty fragment at offset %u of %s.", offset,
+                                  file_name_.c_str()));
+  }
+  fragments_.push_back(fragment);
+  return Status::OK;
+}
+
+Status FragmentScanner::CreateSegments() {
+  if (subsegment_ranges_.empty()) {
+    // Every fragment is a segment.
+    for (const Fragment& fragment : fragments_)
+      subsegment_ranges_.push_back({fragment.offset, fragment.end - 1});
+  }
+
+  size_t fragment_index = 0;
+  for (const Range& range : subsegment_ranges_) {
+    Segment segment;
+    segment.range = range;
+    segment.start_time = std::numeric_limits<int64_t>::max();
+    for (; fragment_index < fragments_.size() &&
+           fragments_[fragment_index].offset <= range.end;
+         ++fragment_index) {
+      const Fragment& fragment = fragments_[fragment_index];
+      if (fragment.offset < range.start || fragment.end > range.end + 1) {
+        return Status(error::PARSER_FAILURE,
+                      "The 'sidx' box does not match the fragments of " +
+                          file_name_);
+      }
+      segment.start_time = std::min(segment.start_time, fragment.start_time);
+      segment.duration += fragment.duration;
+      if (fragment.key_frame) {
+        KeyFrameInfo key_frame = fragment.key_frame.value();
+        key_frame.start_byte_offset = fragment.offset - range.start;
+        segment.key_frames.push_back(key_frame);
+      }
+    }
+    if (segment.duration == 0) {
+      return Status(error::PARSER_FAILURE,
+                    "The 'sidx' box does not match the fragments of " +
+                        file_name_);
+    }
+    duration_ += segment.duration;
+    segments_.push_back(std::move(segment));
+  }
+  if (fragment_index != fragments_.size()) {
+    return Status(error::PARSER_FAILURE,
+                  "The 'sidx' box does not match the fragments of " +
+                      file_name_);
+  }
+  return Status::OK;
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
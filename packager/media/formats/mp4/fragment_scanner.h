@@ -0,0 +1,114 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_FORMATS_MP4_FRAGMENT_SCANNER_H_
+#define PACKAGER_MEDIA_FORMATS_MP4_FRAGMENT_SCANNER_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <packager/file.h>
+#include <packager/file/file_closer.h>
+#include <packager/media/base/range.h>
+#include <packager/media/formats/mp4/key_frame_info.h>
+#include <packager/status.h>
+
+namespace shaka {
+namespace media {
+
+class StreamInfo;
+
+namespace mp4 {
+
+struct Movie;
+class TrackRunIterator;
+
+/// FragmentScanner reads the layout of a fragmented MP4 file with a single
+/// track, e.g. a CMAF track file, from its 'moov', 'sidx' and 'moof' boxes.
+/// The media data is skipped, so the cost of a scan depends on the number of
+/// fragments and not on the size of the file.
+class FragmentScanner {
+ public:
+  /// A segment of the file. It is a subsegment of the 'sidx' box if the file
+  /// has one, otherwise a 'moof' box and the 'mdat' boxes following it.
+  struct Segment {
+    Range range;
+    /// The earliest presentation time of the segment.
+    int64_t start_time = 0;
+    int64_t duration = 0;
+    /// The first key frame of each fragment of a video segment, with the
+    /// offsets relative to the start of the segment, as reported by the
+    /// segmenters.
+    std::vector<KeyFrameInfo> key_frames;
+  };
+
+  FragmentScanner();
+  ~FragmentScanner();
+
+  /// Scans @a file_name.
+  /// @return OK on success, an error status if the file is not a fragmented
+  ///         MP4 file with a single track.
+  Status Scan(const std::string& file_name);
+
+  /// @return the stream of the file, with its encryption config filled from
+  ///         the 'moov' box if the stream is encrypted.
+  const std::shared_ptr<StreamInfo>& stream_info() const {
+    return stream_info_;
+  }
+  /// @return the range of the 'ftyp' and 'moov' boxes.
+  const Range& init_range() const { return init_range_; }
+  /// @return the range of the 'sidx' box, if the file has one before the
+  ///         first fragment.
+  const std::optional<Range>& index_range() const { return index_range_; }
+  const std::vector<Segment>& segments() const { return segments_; }
+  /// @return the duration of the first sample.
+  int64_t sample_duration() const { return sample_duration_; }
+  /// @return the sum of the durations of the segments.
+  int64_t duration() const { return duration_; }
+
+ private:
+  FragmentScanner(const FragmentScanner&) = delete;
+  FragmentScanner& operator=(const FragmentScanner&) = delete;
+
+  // A 'moof' box and the 'mdat' boxes following it.
+  struct Fragment {
+    uint64_t offset = 0;
+    uint64_t end = 0;
+    int64_t start_time = 0;
+    int64_t duration = 0;
+    std::optional<KeyFrameInfo> key_frame;
+  };
+
+  Status ReadBox(uint64_t offset, uint64_t size, std::vector<uint8_t>* data);
+  Status ParseInit(const std::vector<uint8_t>& data, uint64_t moov_offset);
+  Status ParseIndex(const std::vector<uint8_t>& data, uint64_t sidx_end);
+  Status ParseFragment(const std::vector<uint8_t>& data, uint64_t offset);
+  Status CreateSegments();
+
+  std::string file_name_;
+  std::unique_ptr<File, FileCloser> file_;
+  std::unique_ptr<Movie> moov_;
+  std::unique_ptr<TrackRunIterator> runs_;
+  std::vector<Fragment> fragments_;
+  // The subsegment ranges in the 'sidx' box.
+  std::vector<Range> subsegment_ranges_;
+
+  std::shared_ptr<StreamInfo> stream_info_;
+  Range init_range_ = {0, 0};
+  std::optional<Range> index_range_;
+  std::vector<Segment> segments_;
+  int64_t sample_duration_ = 0;
+  int64_t duration_ = 0;
+};
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_FORMATS_MP4_FRAGMENT_SCANNER_H_
@@ -0,0 +1,142 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/formats/mp4/fragment_scanner.h>
+
+#include <gtest/gtest.h>
+
+#include <packager/file.h>
+#include <packager/media/base/stream_info.h>
+#include <packager/media/test/test_data_util.h>
+#include <packager/status/status_test_util.h>
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+// A single file output of the packager, with a 'sidx' box and three segments.
+const char kVideoFile[] = "audio-video/bear-640x360-video.mp4";
+const uint64_t kInitSize = 870;
+const uint64_t kIndexSize = 68;
+const int32_t kTimeScale = 30000;
+const int64_t kSampleDuration = 1001;
+
+struct ExpectedSegment {
+  uint64_t start;
+  uint64_t size;
+  int64_t start_time;
+  int64_t duration;
+  // The size of the first fragment up to the end of the first key frame.
+  uint64_t key_frame_size;
+};
+
+// The segments of |kVideoFile|, relative to the end of the 'sidx' box.
+const ExpectedSegment kExpectedSegments[] = {
+    {0, 99313, 0, 30030, 460 + 15121},
+    {99313, 121807, 30030, 30030, 460 + 17761},
+    {99313 + 121807, 79662, 60060, 22022, 364 + 19299},
+};
+
+void ExpectSegments(const FragmentScanner& scanner, uint64_t first_offset) {
+  ASSERT_EQ(3u, scanner.segments().size());
+  for (size_t i = 0; i < scanner.segments().size(); ++i) {
+    const FragmentScanner::Segment& segment = scanner.segments()[i];
+    const ExpectedSegment& expected = kExpectedSegments[i];
+    EXPECT_EQ(first_offset + expected.start, segment.range.start);
+    EXPECT_EQ(first_offset + expected.start + expected.size - 1,
+              segment.range.end);
+    EXPECT_EQ(expected.start_time, segment.start_time);
+    EXPECT_EQ(expected.duration, segment.duration);
+    ASSERT_EQ(1u, segment.key_frames.size());
+    EXPECT_EQ(expected.start_time, segment.key_frames[0].timestamp);
+    EXPECT_EQ(0u, segment.key_frames[0].start_byte_offset);
+    EXPECT_EQ(expected.key_frame_size, segment.key_frames[0].size);
+  }
+}
+}  // namespace
+
+TEST(FragmentScannerTest, FileWithIndex) {
+  FragmentScanner scanner;
+  ASSERT_OK(scanner.Scan(GetAppTestDataFilePath(kVideoFile).string()));
+
+  ASSERT_TRUE(scanner.stream_info());
+  EXPECT_EQ(kStreamVideo, scanner.stream_info()->stream_type());
+  EXPECT_EQ(kTimeScale, scanner.stream_info()->time_scale());
+  EXPECT_FALSE(scanner.stream_info()->is_encrypted());
+
+  EXPECT_EQ(0u, scanner.init_range().start);
+  EXPECT_EQ(kInitSize - 1, scanner.init_range().end);
+  ASSERT_TRUE(scanner.index_range());
+  EXPECT_EQ(kInitSize, scanner.index_range()->start);
+  EXPECT_EQ(kInitSize + kIndexSize - 1, scanner.index_range()->end);
+
+  ExpectSegments(scanner, kInitSize + kIndexSize);
+  EXPECT_EQ(kSampleDuration, scanner.sample_duration());
+  EXPECT_EQ(30030 + 30030 + 22022, scanner.duration());
+}
+
+TEST(FragmentScannerTest, FileWithoutIndex) {
+  // Every fragment is a segment if there is no 'sidx' box.
+  std::string content;
+  ASSERT_TRUE(File::ReadFileToString(
+      GetAppTestDataFilePath(kVideoFile).string().c_str(), &content));
+  content.erase(kInitSize, kIndexSize);
+  const char kFileName[] = "memory://test/no_sidx.mp4";
+  ASSERT_TRUE(File::WriteStringToFile(kFileName, content));
+
+  FragmentScanner scanner;
+  ASSERT_OK(scanner.Scan(kFileName));
+  EXPECT_EQ(kInitSize - 1, scanner.init_range().end);
+  EXPECT_FALSE(scanner.index_range());
+  ExpectSegments(scanner, kInitSize);
+}
+
+TEST(FragmentScannerTest, NegativeTimestampsExcluded) {
+  // The first sample of the audio starts before zero after the edit list is
+  // applied. As in the 'sidx' box, that part is not in the first segment.
+  FragmentScanner scanner;
+  ASSERT_OK(scanner.Scan(
+      GetAppTestDataFilePath("audio-video/bear-640x360-audio.mp4").string()));
+
+  ASSERT_EQ(3u, scanner.segments().size());
+  EXPECT_EQ(0, scanner.segments()[0].start_time);
+  EXPECT_EQ(45056, scanner.segments()[0].duration);
+  EXPECT_EQ(45056, scanner.segments()[1].start_time);
+  EXPECT_TRUE(scanner.segments()[0].key_frames.empty());
+  EXPECT_EQ(45056 + 44032 + 31744, scanner.duration());
+}
+
+TEST(FragmentScannerTest, EncryptedFile) {
+  FragmentScanner scanner;
+  ASSERT_OK(scanner.Scan(
+      GetTestDataFilePath("bear-640x360-v_frag-cenc-senc.mp4").string()));
+
+  const StreamInfo& stream_info = *scanner.stream_info();
+  ASSERT_TRUE(stream_info.is_encrypted());
+  EXPECT_EQ(FOURCC_cenc, stream_info.encryption_config().protection_scheme);
+  EXPECT_EQ(16u, stream_info.encryption_config().key_id.size());
+  EXPECT_EQ(1u, scanner.segments().size());
+}
+
+TEST(FragmentScannerTest, MultipleTracks) {
+  FragmentScanner scanner;
+  EXPECT_EQ(error::UNIMPLEMENTED,
+            scanner.Scan(GetTestDataFilePath("bear-640x360-av_frag.mp4")
+                             .string())
+                .error_code());
+}
+
+TEST(FragmentScannerTest, NotFragmented) {
+  FragmentScanner scanner;
+  EXPECT_EQ(
+      error::PARSER_FAILURE,
+      scanner.Scan(GetTestDataFilePath("bear-flac.mp4").string())
+          .error_code());
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
@@ -33,7 +33,7 @@ LowLatencySegmentSegmenter::LowLatencySegmentSegmenter(
     std::unique_ptr<Movie> moov)
     : Segmenter(options, std::move(ftyp), std::move(moov)),
       styp_(new SegmentType),
-      num_segments_(0) {
+      num_segments_(options.num_previous_segments) {
   // Use the same brands for styp as ftyp.
   styp_->major_brand = Segmenter::ftyp()->major_brand;
   styp_->compatible_brands = Segmenter::ftyp()->compatible_brands;
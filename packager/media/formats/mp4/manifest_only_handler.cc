@@ -0,0 +1,96 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/formats/mp4/manifest_only_handler.h>
+
+#include <absl/log/log.h>
+
+#include <packager/macros/status.h>
+#include <packager/media/base/stream_info.h>
+#include <packager/media/formats/mp4/fragment_scanner.h>
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+const bool kInitialEncryptionInfo = true;
+
+bool IsSelected(const std::string& stream_selector, StreamType stream_type) {
+  return stream_selector == "0" ||
+         (stream_selector == "audio" && stream_type == kStreamAudio) ||
+         (stream_selector == "video" && stream_type == kStreamVideo);
+}
+}  // namespace
+
+ManifestOnlyHandler::ManifestOnlyHandler(const std::string& file_name,
+                                         const std::string& stream_selector,
+                                         const MuxerOptions& options)
+    : file_name_(file_name),
+      stream_selector_(stream_selector),
+      options_(options) {}
+
+ManifestOnlyHandler::~ManifestOnlyHandler() = default;
+
+Status ManifestOnlyHandler::Run() {
+  LOG(INFO) << "Scanning the fragments of '" << file_name_ << "'.";
+  FragmentScanner scanner;
+  RETURN_IF_ERROR(scanner.Scan(file_name_));
+
+  StreamInfo& stream_info = *scanner.stream_info();
+  if (!IsSelected(stream_selector_, stream_info.stream_type())) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Stream " + stream_selector_ + " does not select the track "
+                  "of " + file_name_);
+  }
+  if (!language_override_.empty())
+    stream_info.set_language(language_override_);
+  if (!scanner.index_range()) {
+    LOG(WARNING) << file_name_ << " has no 'sidx' box. DASH on-demand "
+                 << "manifests need one unless --dash_force_segment_list is "
+                    "set.";
+  }
+  if (!muxer_listener_)
+    return Status::OK;
+
+  // Notify the listener the same way as Muxer, MP4Muxer and
+  // SingleSegmentSegmenter do.
+  if (stream_info.is_encrypted()) {
+    const EncryptionConfig& encryption_config = stream_info.encryption_config();
+    muxer_listener_->OnEncryptionInfoReady(
+        kInitialEncryptionInfo, encryption_config.protection_scheme,
+        encryption_config.key_id, encryption_config.constant_iv,
+        encryption_config.key_system_info);
+  }
+  muxer_listener_->OnMediaStart(options_, stream_info, stream_info.time_scale(),
+                                MuxerListener::kContainerMp4);
+  if (stream_info.is_encrypted())
+    muxer_listener_->OnEncryptionStart();
+
+  MuxerListener::MediaRanges media_ranges;
+  media_ranges.init_range = scanner.init_range();
+  media_ranges.index_range = scanner.index_range();
+  for (const FragmentScanner::Segment& segment : scanner.segments()) {
+    for (const KeyFrameInfo& key_frame : segment.key_frames) {
+      muxer_listener_->OnKeyFrame(key_frame.timestamp,
+                                  key_frame.start_byte_offset, key_frame.size);
+    }
+    muxer_listener_->OnSampleDurationReady(
+        static_cast<int32_t>(scanner.sample_duration()));
+    muxer_listener_->OnNewSegment(
+        options_.output_file_name, segment.start_time, segment.duration,
+        segment.range.end - segment.range.start + 1);
+    media_ranges.subsegment_ranges.push_back(segment.range);
+  }
+
+  const float duration_seconds =
+      static_cast<float>(scanner.duration()) / stream_info.time_scale();
+  muxer_listener_->OnMediaEnd(media_ranges, duration_seconds);
+  return Status::OK;
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
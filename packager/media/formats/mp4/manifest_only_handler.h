@@ -0,0 +1,71 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_FORMATS_MP4_MANIFEST_ONLY_HANDLER_H_
+#define PACKAGER_MEDIA_FORMATS_MP4_MANIFEST_ONLY_HANDLER_H_
+
+#include <memory>
+#include <string>
+
+#include <packager/media/base/muxer_options.h>
+#include <packager/media/event/muxer_listener.h>
+#include <packager/media/origin/origin_handler.h>
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+
+/// ManifestOnlyHandler generates the manifests of a fragmented MP4 file
+/// without rewriting it. The file is scanned with FragmentScanner and the
+/// MuxerListener is notified of its segments the same way as by MP4Muxer with
+/// a single output file, i.e. with byte range addressing. The handler has no
+/// downstream handlers.
+class ManifestOnlyHandler : public OriginHandler {
+ public:
+  /// @param file_name is the fragmented MP4 file.
+  /// @param stream_selector is 'audio', 'video' or '0'. It must select the
+  ///        only track of the file.
+  /// @param options contains the name of the media file in the manifests,
+  ///        which is usually @a file_name, and the bandwidth.
+  ManifestOnlyHandler(const std::string& file_name,
+                      const std::string& stream_selector,
+                      const MuxerOptions& options);
+  ~ManifestOnlyHandler() override;
+
+  void SetMuxerListener(std::unique_ptr<MuxerListener> muxer_listener) {
+    muxer_listener_ = std::move(muxer_listener);
+  }
+
+  /// Overrides the language of the stream in the manifests.
+  void SetLanguageOverride(const std::string& language) {
+    language_override_ = language;
+  }
+
+  /// @name OriginHandler implementation overrides.
+  /// @{
+  Status Run() override;
+  void Cancel() override {}
+  /// @}
+
+ protected:
+  Status InitializeInternal() override { return Status::OK; }
+
+ private:
+  ManifestOnlyHandler(const ManifestOnlyHandler&) = delete;
+  ManifestOnlyHandler& operator=(const ManifestOnlyHandler&) = delete;
+
+  const std::string file_name_;
+  const std::string stream_selector_;
+  const MuxerOptions options_;
+  std::string language_override_;
+  std::unique_ptr<MuxerListener> muxer_listener_;
+};
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_FORMATS_MP4_MANIFEST_ONLY_HANDLER_H_
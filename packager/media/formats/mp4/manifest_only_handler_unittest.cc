@@ -0,0 +1,104 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/formats/mp4/manifest_only_handler.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <packager/media/base/stream_info.h>
+#include <packager/media/event/mock_muxer_listener.h>
+#include <packager/media/test/test_data_util.h>
+#include <packager/status/status_test_util.h>
+
+using ::testing::_;
+using ::testing::AllOf;
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::Field;
+using ::testing::FloatEq;
+using ::testing::InSequence;
+using ::testing::Property;
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+const char kVideoFile[] = "audio-video/bear-640x360-video.mp4";
+const char kOutputFileName[] = "video.mp4";
+const int32_t kTimeScale = 30000;
+const int32_t kSampleDuration = 1001;
+const bool kHasRange = true;
+
+auto RangeIs(uint64_t start, uint64_t end) {
+  return AllOf(Field(&Range::start, Eq(start)), Field(&Range::end, Eq(end)));
+}
+}  // namespace
+
+class ManifestOnlyHandlerTest : public ::testing::Test {
+ protected:
+  std::shared_ptr<ManifestOnlyHandler> CreateHandler(
+      const std::string& stream_selector) {
+    MuxerOptions options;
+    options.output_file_name = kOutputFileName;
+    auto handler = std::make_shared<ManifestOnlyHandler>(
+        GetAppTestDataFilePath(kVideoFile).string(), stream_selector, options);
+    std::unique_ptr<MockMuxerListener> listener(new MockMuxerListener);
+    listener_ = listener.get();
+    handler->SetMuxerListener(std::move(listener));
+    return handler;
+  }
+
+  MockMuxerListener* listener_ = nullptr;
+};
+
+TEST_F(ManifestOnlyHandlerTest, NotifiesSegments) {
+  std::shared_ptr<ManifestOnlyHandler> handler = CreateHandler("video");
+  {
+    InSequence s;
+    EXPECT_CALL(*listener_,
+                OnMediaStart(Field(&MuxerOptions::output_file_name,
+                                   Eq(kOutputFileName)),
+                             Property(&StreamInfo::stream_type,
+                                      Eq(kStreamVideo)),
+                             kTimeScale, MuxerListener::kContainerMp4));
+    EXPECT_CALL(*listener_, OnKeyFrame(0, 0, 460 + 15121));
+    EXPECT_CALL(*listener_, OnSampleDurationReady(kSampleDuration));
+    EXPECT_CALL(*listener_, OnNewSegment(kOutputFileName, 0, 30030, 99313));
+    EXPECT_CALL(*listener_, OnKeyFrame(30030, 0, 460 + 17761));
+    EXPECT_CALL(*listener_, OnSampleDurationReady(kSampleDuration));
+    EXPECT_CALL(*listener_,
+                OnNewSegment(kOutputFileName, 30030, 30030, 121807));
+    EXPECT_CALL(*listener_, OnKeyFrame(60060, 0, 364 + 19299));
+    EXPECT_CALL(*listener_, OnSampleDurationReady(kSampleDuration));
+    EXPECT_CALL(*listener_,
+                OnNewSegment(kOutputFileName, 60060, 22022, 79662));
+    EXPECT_CALL(*listener_,
+                OnMediaEndMock(kHasRange, 0, 869, kHasRange, 870, 937,
+                               kHasRange,
+                               ElementsAre(RangeIs(938, 100250),
+                                           RangeIs(100251, 222057),
+                                           RangeIs(222058, 301719)),
+                               FloatEq(82082.0f / kTimeScale)));
+  }
+  EXPECT_CALL(*listener_, OnEncryptionInfoReady(_, _, _, _, _)).Times(0);
+  EXPECT_CALL(*listener_, OnEncryptionStart()).Times(0);
+
+  ASSERT_OK(handler->Initialize());
+  ASSERT_OK(handler->Run());
+}
+
+TEST_F(ManifestOnlyHandlerTest, StreamNotSelected) {
+  std::shared_ptr<ManifestOnlyHandler> handler = CreateHandler("audio");
+  EXPECT_CALL(*listener_, OnMediaStart(_, _, _, _)).Times(0);
+
+  ASSERT_OK(handler->Initialize());
+  EXPECT_EQ(error::INVALID_ARGUMENT, handler->Run().error_code());
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,331 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/formats/mp4/movie_fragment_writer.h>
+
+#include <array>
+#include <limits>
+#include <utility>
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <packager/macros/logging.h>
+#include <packager/media/base/buffer_writer.h>
+#include <packager/media/formats/mp4/box_definitions.h>
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+
+namespace {
+
+// Box sizes are written as 32-bit integers.
+const size_t kBoxSizeSize = sizeof(uint32_t);
+
+// Appends a box header with a placeholder size, which is patched by EndBox.
+// Returns the position of the box in |writer|.
+size_t BeginBox(FourCC type, BufferWriter* writer) {
+  const size_t position = writer->Size();
+  writer->AppendInt(static_cast<uint32_t>(0));
+  writer->AppendInt(static_cast<uint32_t>(type));
+  return position;
+}
+
+size_t BeginFullBox(FourCC type,
+                    uint8_t version,
+                    uint32_t flags,
+                    BufferWriter* writer) {
+  const size_t position = BeginBox(type, writer);
+  writer->AppendInt(static_cast<uint32_t>((version << 24) | flags));
+  return position;
+}
+
+// Patches the size of the box starting at |position|. Returns the box size.
+uint32_t EndBox(size_t position, BufferWriter* writer) {
+  const size_t box_size = writer->Size() - position;
+  DCHECK_LE(box_size, std::numeric_limits<uint32_t>::max());
+  writer->OverwriteNBytes(position, box_size, kBoxSizeSize);
+  return static_cast<uint32_t>(box_size);
+}
+
+void WriteTrackFragmentHeader(const TrackFragmentHeader& tfhd,
+                              BufferWriter* writer) {
+  // base-data-offset is not supported in write mode, same as Box::Write.
+  DCHECK_EQ(0u, tfhd.flags & TrackFragmentHeader::kBaseDataOffsetPresentMask);
+  const size_t position =
+      BeginFullBox(FOURCC_tfhd, tfhd.version, tfhd.flags, writer);
+  writer->AppendInt(tfhd.track_id);
+  if (tfhd.flags & TrackFragmentHeader::kSampleDescriptionIndexPresentMask)
+    writer->AppendInt(tfhd.sample_description_index);
+  if (tfhd.flags & TrackFragmentHeader::kDefaultSampleDurationPresentMask)
+    writer->AppendInt(tfhd.default_sample_duration);
+  if (tfhd.flags & TrackFragmentHeader::kDefaultSampleSizePresentMask)
+    writer->AppendInt(tfhd.default_sample_size);
+  if (tfhd.flags & TrackFragmentHeader::kDefaultSampleFlagsPresentMask)
+    writer->AppendInt(tfhd.default_sample_flags);
+  EndBox(position, writer);
+}
+
+void WriteTrackFragmentDecodeTime(TrackFragmentDecodeTime* tfdt,
+                                  BufferWriter* writer) {
+  tfdt->version =
+      tfdt->decode_time <= std::numeric_limits<uint32_t>::max() ? 0 : 1;
+  const size_t position =
+      BeginFullBox(FOURCC_tfdt, tfdt->version, tfdt->flags, writer);
+  if (tfdt->version == 1)
+    writer->AppendInt(tfdt->decode_time);
+  else
+    writer->AppendInt(static_cast<uint32_t>(tfdt->decode_time));
+  EndBox(position, writer);
+}
+
+// Writes the per-sample fields of |trun|. |kFields| is the combination of
+// sample field flags present in the run, so that the per-sample loop does not
+// need to test the flags.
+template <uint32_t kFields>
+void WriteTrackFragmentRunSamples(const TrackFragmentRun& trun,
+                                  BufferWriter* writer) {
+  for (uint32_t i = 0; i < trun.sample_count; ++i) {
+    if constexpr ((kFields & TrackFragmentRun::kSampleDurationPresentMask) != 0)
+      writer->AppendInt(trun.sample_durations[i]);
+    if constexpr ((kFields & TrackFragmentRun::kSampleSizePresentMask) != 0)
+      writer->AppendInt(trun.sample_sizes[i]);
+    if constexpr ((kFields & TrackFragmentRun::kSampleFlagsPresentMask) != 0)
+      writer->AppendInt(trun.sample_flags[i]);
+    if constexpr ((kFields &
+                   TrackFragmentRun::kSampleCompTimeOffsetsPresentMask) != 0) {
+      // Version 0 and version 1 offsets have the same binary representation
+      // once truncated to 32 bits.
+      writer->AppendInt(
+          static_cast<uint32_t>(trun.sample_composition_time_offsets[i]));
+    }
+  }
+}
+
+typedef void (*TrackFragmentRunSamplesWriter)(const TrackFragmentRun& trun,
+                                              BufferWriter* writer);
+
+// The four sample field flags are contiguous, starting from
+// kSampleDurationPresentMask.
+const int kSampleFieldsShift = 8;
+const uint32_t kSampleFieldsMask =
+    TrackFragmentRun::kSampleDurationPresentMask |
+    TrackFragmentRun::kSampleSizePresentMask |
+    TrackFragmentRun::kSampleFlagsPresentMask |
+    TrackFragmentRun::kSampleCompTimeOffsetsPresentMask;
+static_assert(kSampleFieldsMask == (0xFu << kSampleFieldsShift),
+              "Sample field flags are expected to be contiguous.");
+
+template <size_t... kIndices>
+constexpr std::array<TrackFragmentRunSamplesWriter, sizeof...(kIndices)>
+MakeTrackFragmentRunSamplesWriters(std::index_sequence<kIndices...>) {
+  return {&WriteTrackFragmentRunSamples<kIndices << kSampleFieldsShift>...};
+}
+
+constexpr std::array<TrackFragmentRunSamplesWriter, 16>
+    kTrackFragmentRunSamplesWriters =
+        MakeTrackFragmentRunSamplesWriters(std::make_index_sequence<16>());
+
+// Returns the position of the data offset field in |writer|, or 0 if the data
+// offset is not present.
+size_t WriteTrackFragmentRun(TrackFragmentRun* trun, BufferWriter* writer) {
+  const uint32_t flags = trun->flags;
+  // Use version 0 if possible, use version 1 if there is a negative
+  // sample_offset value.
+  trun->version = 0;
+  if (flags & TrackFragmentRun::kSampleCompTimeOffsetsPresentMask) {
+    DCHECK_EQ(trun->sample_composition_time_offsets.size(), trun->sample_count);
+    for (int64_t sample_offset : trun->sample_composition_time_offsets) {
+      if (sample_offset < 0) {
+        trun->version = 1;
+        break;
+      }
+    }
+  }
+  if (flags & TrackFragmentRun::kSampleDurationPresentMask)
+    DCHECK_EQ(trun->sample_durations.size(), trun->sample_count);
+  if (flags & TrackFragmentRun::kSampleSizePresentMask)
+    DCHECK_EQ(trun->sample_sizes.size(), trun->sample_count);
+  if (flags & TrackFragmentRun::kSampleFlagsPresentMask)
+    DCHECK_EQ(trun->sample_flags.size(), trun->sample_count);
+
+  const size_t position =
+      BeginFullBox(FOURCC_trun, trun->version, flags, writer);
+  writer->AppendInt(trun->sample_count);
+
+  size_t data_offset_position = 0;
+  if (flags & TrackFragmentRun::kDataOffsetPresentMask) {
+    data_offset_position = writer->Size();
+    writer->AppendInt(trun->data_offset);
+  } else {
+    NOTIMPLEMENTED();
+  }
+  if (flags & TrackFragmentRun::kFirstSampleFlagsPresentMask) {
+    DCHECK_EQ(trun->sample_flags.size(), 1u);
+    writer->AppendInt(trun->sample_flags[0]);
+  }
+
+  kTrackFragmentRunSamplesWriters[(flags & kSampleFieldsMask) >>
+                                  kSampleFieldsShift](*trun, writer);
+  EndBox(position, writer);
+  return data_offset_position;
+}
+
+void WriteSampleAuxiliaryInformationSize(
+    const SampleAuxiliaryInformationSize& saiz,
+    BufferWriter* writer) {
+  // This box is optional. Skip it if it is empty.
+  if (saiz.sample_count == 0)
+    return;
+  const size_t position =
+      BeginFullBox(FOURCC_saiz, saiz.version, saiz.flags, writer);
+  if (saiz.flags & 1)
+    writer->AppendNBytes(0, 8);  // aux_info_type and parameter.
+  writer->AppendInt(saiz.default_sample_info_size);
+  writer->AppendInt(saiz.sample_count);
+  if (saiz.default_sample_info_size == 0) {
+    DCHECK_EQ(saiz.sample_info_sizes.size(), saiz.sample_count);
+    writer->AppendVector(saiz.sample_info_sizes);
+  }
+  EndBox(position, writer);
+}
+
+// Returns the position of the first offset in |writer|, or 0 if the box is
+// not written.
+size_t WriteSampleAuxiliaryInformationOffset(
+    const SampleAuxiliaryInformationOffset& saio,
+    BufferWriter* writer) {
+  // This box is optional. Skip it if it is empty.
+  if (saio.offsets.empty())
+    return 0;
+  const size_t position =
+      BeginFullBox(FOURCC_saio, saio.version, saio.flags, writer);
+  if (saio.flags & 1)
+    writer->AppendNBytes(0, 8);  // aux_info_type and parameter.
+  writer->AppendInt(static_cast<uint32_t>(saio.offsets.size()));
+  const size_t offsets_position = writer->Size();
+  const size_t num_bytes =
+      (saio.version == 1) ? sizeof(uint64_t) : sizeof(uint32_t);
+  for (uint64_t offset : saio.offsets)
+    writer->AppendNBytes(offset, num_bytes);
+  EndBox(position, writer);
+  return offsets_position;
+}
+
+// Returns the position of the sample data, i.e. the data following the sample
+// count, in |writer|, or 0 if the box is not written.
+size_t WriteSampleEncryption(const SampleEncryption& senc,
+                             BufferWriter* writer) {
+  // Sample encryption box is optional. Skip it if it is empty.
+  if (senc.sample_encryption_entries.empty())
+    return 0;
+  DCHECK(senc.iv_size == 0 || senc.iv_size == 8 || senc.iv_size == 16)
+      << "Unexpected IV size " << static_cast<int>(senc.iv_size);
+
+  const size_t position =
+      BeginFullBox(FOURCC_senc, senc.version, senc.flags, writer);
+  writer->AppendInt(
+      static_cast<uint32_t>(senc.sample_encryption_entries.size()));
+  const size_t sample_data_position = writer->Size();
+
+  const bool has_subsamples =
+      (senc.flags & SampleEncryption::kUseSubsampleEncryption) != 0;
+  for (const SampleEncryptionEntry& entry : senc.sample_encryption_entries) {
+    DCHECK_EQ(entry.initialization_vector.size(), senc.iv_size);
+    writer->AppendVector(entry.initialization_vector);
+    if (!has_subsamples)
+      continue;
+    DCHECK(!entry.subsamples.empty());
+    writer->AppendInt(static_cast<uint16_t>(entry.subsamples.size()));
+    for (const SubsampleEntry& subsample : entry.subsamples) {
+      writer->AppendInt(subsample.clear_bytes);
+      writer->AppendInt(subsample.cipher_bytes);
+    }
+  }
+  EndBox(position, writer);
+  return sample_data_position;
+}
+
+}  // namespace
+
+uint32_t WriteMovieFragment(const std::vector<uint64_t>& data_offsets,
+                            MovieFragment* moof,
+                            BufferWriter* writer) {
+  DCHECK(moof);
+  DCHECK(writer);
+  DCHECK_EQ(data_offsets.size(), moof->tracks.size());
+
+  const size_t moof_position = BeginBox(FOURCC_moof, writer);
+
+  const size_t mfhd_position = BeginFullBox(
+      FOURCC_mfhd, moof->header.version, moof->header.flags, writer);
+  writer->AppendInt(moof->header.sequence_number);
+  EndBox(mfhd_position, writer);
+
+  // Positions of the data offset field of the first run of each track
+  // fragment, which can only be filled in when the 'moof' size is known.
+  std::vector<size_t> data_offset_positions(moof->tracks.size());
+  for (size_t i = 0; i < moof->tracks.size(); ++i) {
+    TrackFragment& traf = moof->tracks[i];
+    const size_t traf_position = BeginBox(FOURCC_traf, writer);
+
+    WriteTrackFragmentHeader(traf.header, writer);
+    if (!traf.decode_time_absent)
+      WriteTrackFragmentDecodeTime(&traf.decode_time, writer);
+    DCHECK(!traf.runs.empty());
+    for (size_t j = 0; j < traf.runs.size(); ++j) {
+      const size_t data_offset_position =
+          WriteTrackFragmentRun(&traf.runs[j], writer);
+      if (j == 0)
+        data_offset_positions[i] = data_offset_position;
+    }
+    // Sample groups are rare and small; use the generic box writer.
+    for (SampleToGroup& sample_to_group : traf.sample_to_groups)
+      sample_to_group.Write(writer);
+    for (SampleGroupDescription& sample_group_description :
+         traf.sample_group_descriptions) {
+      sample_group_description.Write(writer);
+    }
+
+    WriteSampleAuxiliaryInformationSize(traf.auxiliary_size, writer);
+    const size_t saio_offsets_position =
+        WriteSampleAuxiliaryInformationOffset(traf.auxiliary_offset, writer);
+    const size_t senc_data_position =
+        WriteSampleEncryption(traf.sample_encryption, writer);
+    if (saio_offsets_position != 0) {
+      // |auxiliary_offset| should point to the data of SampleEncryption, which
+      // should be the last box in 'traf'.
+      DCHECK_EQ(traf.auxiliary_offset.offsets.size(), 1u);
+      DCHECK_NE(senc_data_position, 0u);
+      traf.auxiliary_offset.offsets[0] = senc_data_position - moof_position;
+      writer->OverwriteNBytes(
+          saio_offsets_position, traf.auxiliary_offset.offsets[0],
+          traf.auxiliary_offset.version == 1 ? sizeof(uint64_t)
+                                             : sizeof(uint32_t));
+    }
+    EndBox(traf_position, writer);
+  }
+
+  for (ProtectionSystemSpecificHeader& pssh : moof->pssh)
+    pssh.Write(writer);
+
+  const uint32_t moof_size = EndBox(moof_position, writer);
+
+  for (size_t i = 0; i < moof->tracks.size(); ++i) {
+    TrackFragmentRun& trun = moof->tracks[i].runs[0];
+    trun.data_offset = static_cast<uint32_t>(moof_size + data_offsets[i]);
+    if (data_offset_positions[i] != 0) {
+      writer->OverwriteNBytes(data_offset_positions[i], trun.data_offset,
+                              sizeof(trun.data_offset));
+    }
+  }
+  return moof_size;
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,50 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_FORMATS_MP4_MOVIE_FRAGMENT_WRITER_H_
+#define PACKAGER_MEDIA_FORMATS_MP4_MOVIE_FRAGMENT_WRITER_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace shaka {
+namespace media {
+
+class BufferWriter;
+
+namespace mp4 {
+
+struct MovieFragment;
+
+/// Writes @a moof to @a writer in a single pass.
+///
+/// Box::Write computes the size of the whole box tree before serializing it,
+/// and the data offsets in 'trun' and 'saio' depend on the 'moof' size, which
+/// would otherwise require yet another size computation. Instead, the hot
+/// fragment boxes ('mfhd', 'traf', 'tfhd', 'tfdt', 'trun', 'saiz', 'saio' and
+/// 'senc') are serialized directly with placeholder sizes and offsets, which
+/// are patched once the layout is known. The output is identical to
+/// Box::Write.
+///
+/// @param data_offsets contains, for each track fragment, the offset of its
+///        sample data relative to the end of the 'moof' box, e.g. the size of
+///        the 'mdat' header plus the size of the preceding tracks' data.
+///        The data offset of the first run of each track fragment is set to
+///        the 'moof' size plus this offset. The 'saio' offset, if any, is set
+///        to point to the 'senc' sample data relative to the 'moof' start.
+/// @param moof is the fragment to write. Data offsets, 'saio' offsets and box
+///        versions are updated to match the written data.
+/// @param writer is the buffer to append the fragment to.
+/// @return the size of the 'moof' box.
+uint32_t WriteMovieFragment(const std::vector<uint64_t>& data_offsets,
+                            MovieFragment* moof,
+                            BufferWriter* writer);
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_FORMATS_MP4_MOVIE_FRAGMENT_WRITER_H_
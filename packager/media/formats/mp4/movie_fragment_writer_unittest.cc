@@ -0,0 +1,232 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/formats/mp4/movie_fragment_writer.h>
+
+#include <iterator>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include <packager/media/base/buffer_writer.h>
+#include <packager/media/formats/mp4/box_definitions.h>
+#include <packager/media/formats/mp4/box_definitions_comparison.h>
+#include <packager/media/formats/mp4/box_reader.h>
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+
+const uint8_t kIv[] = {3, 4, 5, 6, 7, 8, 9, 0};
+const uint8_t kPsshBox[] = {0, 0, 0, 0x22, 'p', 's', 's', 'h', 0,    0,   0, 0,
+                            0, 0, 0, 0,    0,   0,   0,   0,   0,    0,   0, 0,
+                            0, 0, 0, 0,    0,   0,   0,   2,   0xf0, 0x00};
+const uint32_t kSampleFieldFlags[] = {
+    TrackFragmentRun::kSampleDurationPresentMask,
+    TrackFragmentRun::kSampleSizePresentMask,
+    TrackFragmentRun::kSampleFlagsPresentMask,
+    TrackFragmentRun::kSampleCompTimeOffsetsPresentMask,
+};
+const uint32_t kNumSamples = 5;
+const uint32_t kMdatHeaderSize = 8;
+
+void FillTrackFragment(uint32_t track_id, TrackFragment* traf) {
+  traf->header.flags = TrackFragmentHeader::kDefaultSampleDurationPresentMask |
+                       TrackFragmentHeader::kDefaultBaseIsMoofMask;
+  traf->header.track_id = track_id;
+  traf->header.default_sample_duration = 3000;
+  traf->decode_time.decode_time = 90000;
+
+  traf->runs.resize(1);
+  TrackFragmentRun& trun = traf->runs[0];
+  trun.flags = TrackFragmentRun::kDataOffsetPresentMask |
+               TrackFragmentRun::kSampleDurationPresentMask |
+               TrackFragmentRun::kSampleSizePresentMask |
+               TrackFragmentRun::kSampleFlagsPresentMask |
+               TrackFragmentRun::kSampleCompTimeOffsetsPresentMask;
+  trun.sample_count = kNumSamples;
+  for (uint32_t i = 0; i < kNumSamples; ++i) {
+    trun.sample_durations.push_back(3000 + i);
+    trun.sample_sizes.push_back(1000 * (i + 1));
+    trun.sample_flags.push_back(
+        i == 0 ? 0u
+               : static_cast<uint32_t>(TrackFragmentHeader::kNonKeySampleMask));
+    trun.sample_composition_time_offsets.push_back(3000 * i);
+  }
+}
+
+void EncryptTrackFragment(TrackFragment* traf) {
+  SampleEncryption& senc = traf->sample_encryption;
+  senc.iv_size = sizeof(kIv);
+  senc.flags = SampleEncryption::kUseSubsampleEncryption;
+  senc.sample_encryption_entries.resize(kNumSamples);
+  for (uint32_t i = 0; i < kNumSamples; ++i) {
+    SampleEncryptionEntry& entry = senc.sample_encryption_entries[i];
+    entry.initialization_vector.assign(std::begin(kIv), std::end(kIv));
+    entry.subsamples.push_back({static_cast<uint16_t>(10 + i), 990});
+    entry.subsamples.push_back({20, static_cast<uint32_t>(1000 * i)});
+    traf->auxiliary_size.sample_info_sizes.push_back(
+        static_cast<uint8_t>(entry.ComputeSize()));
+  }
+  traf->auxiliary_size.sample_count = kNumSamples;
+  traf->auxiliary_offset.offsets.push_back(0);
+}
+
+// Writes |moof| with Box::Write, after setting the offsets the same way as
+// WriteMovieFragment.
+void WriteWithBoxWrite(const std::vector<uint64_t>& data_offsets,
+                       MovieFragment* moof,
+                       BufferWriter* writer) {
+  const uint32_t moof_size = moof->ComputeSize();
+  uint64_t traf_position = moof->HeaderSize() + moof->header.box_size();
+  for (size_t i = 0; i < moof->tracks.size(); ++i) {
+    TrackFragment& traf = moof->tracks[i];
+    traf_position += traf.box_size();
+    if (!traf.auxiliary_offset.offsets.empty()) {
+      traf.auxiliary_offset.offsets[0] =
+          traf_position - traf.sample_encryption.box_size() +
+          traf.sample_encryption.HeaderSize() + sizeof(uint32_t);
+    }
+    traf.runs[0].data_offset =
+        static_cast<uint32_t>(moof_size + data_offsets[i]);
+  }
+  moof->Write(writer);
+}
+
+std::vector<uint8_t> ToVector(const BufferWriter& writer) {
+  return std::vector<uint8_t>(writer.Buffer(),
+                              writer.Buffer() + writer.Size());
+}
+
+}  // namespace
+
+class MovieFragmentWriterTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    moof_ = MovieFragment();
+    moof_.header.sequence_number = 23;
+    moof_.tracks.resize(2);
+    FillTrackFragment(1, &moof_.tracks[0]);
+    FillTrackFragment(2, &moof_.tracks[1]);
+    data_offsets_ = {kMdatHeaderSize, kMdatHeaderSize + 15000};
+  }
+
+  // Writes |moof_| with WriteMovieFragment and Box::Write and verifies that
+  // the results match.
+  void VerifyWrite() {
+    MovieFragment expected_moof = moof_;
+    BufferWriter expected_writer;
+    WriteWithBoxWrite(data_offsets_, &expected_moof, &expected_writer);
+
+    // Write after some existing data, like fragments written to a segment.
+    BufferWriter writer;
+    writer.AppendInt(static_cast<uint32_t>(12345));
+    const uint32_t moof_size = WriteMovieFragment(data_offsets_, &moof_,
+                                                  &writer);
+    EXPECT_EQ(expected_writer.Size(), moof_size);
+    ASSERT_EQ(expected_writer.Size() + sizeof(uint32_t), writer.Size());
+    EXPECT_EQ(ToVector(expected_writer),
+              std::vector<uint8_t>(writer.Buffer() + sizeof(uint32_t),
+                                   writer.Buffer() + writer.Size()));
+
+    // The offsets and versions in |moof_| are updated.
+    EXPECT_EQ(expected_moof, moof_);
+
+    bool err = false;
+    std::unique_ptr<BoxReader> reader(BoxReader::ReadBox(
+        expected_writer.Buffer(), expected_writer.Size(), &err));
+    ASSERT_TRUE(reader);
+    MovieFragment moof_read;
+    ASSERT_TRUE(moof_read.Parse(reader.get()));
+    for (TrackFragment& traf : moof_read.tracks) {
+      if (traf.sample_encryption.sample_encryption_entries.empty() &&
+          !traf.sample_encryption.sample_encryption_data.empty()) {
+        traf.sample_encryption.iv_size = sizeof(kIv);
+        ASSERT_TRUE(traf.sample_encryption.ParseFromSampleEncryptionData(
+            sizeof(kIv), &traf.sample_encryption.sample_encryption_entries));
+        traf.sample_encryption.sample_encryption_data.clear();
+      }
+    }
+    EXPECT_EQ(moof_, moof_read);
+  }
+
+  MovieFragment moof_;
+  std::vector<uint64_t> data_offsets_;
+};
+
+TEST_F(MovieFragmentWriterTest, Basic) {
+  VerifyWrite();
+  EXPECT_EQ(moof_.tracks[1].runs[0].data_offset,
+            moof_.tracks[0].runs[0].data_offset + 15000);
+}
+
+TEST_F(MovieFragmentWriterTest, Encrypted) {
+  EncryptTrackFragment(&moof_.tracks[0]);
+  EncryptTrackFragment(&moof_.tracks[1]);
+  moof_.pssh.resize(1);
+  moof_.pssh[0].raw_box.assign(std::begin(kPsshBox), std::end(kPsshBox));
+  VerifyWrite();
+}
+
+TEST_F(MovieFragmentWriterTest, OnlySecondTrackEncrypted) {
+  EncryptTrackFragment(&moof_.tracks[1]);
+  VerifyWrite();
+}
+
+TEST_F(MovieFragmentWriterTest, LargeDecodeTimeAndNegativeOffsets) {
+  moof_.tracks[0].decode_time.decode_time = 0x100000000ull;
+  moof_.tracks[1].runs[0].sample_composition_time_offsets[2] = -3000;
+  VerifyWrite();
+  EXPECT_EQ(1u, moof_.tracks[0].decode_time.version);
+  EXPECT_EQ(0u, moof_.tracks[0].runs[0].version);
+  EXPECT_EQ(0u, moof_.tracks[1].decode_time.version);
+  EXPECT_EQ(1u, moof_.tracks[1].runs[0].version);
+}
+
+TEST_F(MovieFragmentWriterTest, SampleGroups) {
+  TrackFragment& traf = moof_.tracks[0];
+  traf.sample_group_descriptions.resize(1);
+  traf.sample_group_descriptions[0].grouping_type = FOURCC_roll;
+  traf.sample_group_descriptions[0].audio_roll_recovery_entries.resize(1);
+  traf.sample_group_descriptions[0]
+      .audio_roll_recovery_entries[0]
+      .roll_distance = -10;
+  traf.sample_to_groups.resize(1);
+  traf.sample_to_groups[0].grouping_type = FOURCC_roll;
+  traf.sample_to_groups[0].entries.resize(1);
+  traf.sample_to_groups[0].entries[0].sample_count = kNumSamples;
+  traf.sample_to_groups[0].entries[0].group_description_index = 1;
+  VerifyWrite();
+}
+
+TEST_F(MovieFragmentWriterTest, AllSampleFieldCombinations) {
+  for (uint32_t combination = 0; combination < 16; ++combination) {
+    SetUp();
+    TrackFragmentRun& trun = moof_.tracks[0].runs[0];
+    trun.flags = TrackFragmentRun::kDataOffsetPresentMask;
+    for (size_t i = 0; i < std::size(kSampleFieldFlags); ++i) {
+      if (combination & (1 << i))
+        trun.flags |= kSampleFieldFlags[i];
+    }
+    if (!(trun.flags & TrackFragmentRun::kSampleDurationPresentMask))
+      trun.sample_durations.clear();
+    if (!(trun.flags & TrackFragmentRun::kSampleSizePresentMask))
+      trun.sample_sizes.clear();
+    if (!(trun.flags & TrackFragmentRun::kSampleCompTimeOffsetsPresentMask))
+      trun.sample_composition_time_offsets.clear();
+    if (!(trun.flags & TrackFragmentRun::kSampleFlagsPresentMask)) {
+      trun.flags |= TrackFragmentRun::kFirstSampleFlagsPresentMask;
+      trun.sample_flags.resize(1);
+    }
+    SCOPED_TRACE(combination);
+    VerifyWrite();
+  }
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
@@ -254,6 +254,17 @@ bool MP4MediaParser::Parse(const uint8_t* buf, int size) {
   return true;
 }
 
+bool MP4MediaParser::GetCurrentHeader(const uint8_t** data,
+                                      size_t* size) const {
+  DCHECK(data);
+  DCHECK(size);
+  if (!current_moov_data_)
+    return false;
+  *data = current_moov_data_;
+  *size = current_moov_size_;
+  return true;
+}
+
 bool MP4MediaParser::LoadMoov(const std::string& file_path) {
   std::unique_ptr<File, FileCloser> file(
       File::OpenWithNoBuffering(file_path.c_str(), "r"));
@@ -363,7 +374,11 @@ bool MP4MediaParser::ParseBox(bool* err) {
   mdat_tail_ = queue_.head() + reader->size();
 
   if (reader->type() == FOURCC_moov) {
+    current_moov_data_ = buf;
+    current_moov_size_ = static_cast<size_t>(reader->size());
     *err = !ParseMoov(reader.get());
+    current_moov_data_ = nullptr;
+    current_moov_size_ = 0;
   } else if (reader->type() == FOURCC_moof) {
     moof_head_ = queue_.head();
     *err = !ParseMoof(reader.get());
@@ -814,8 +829,8 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
   }
 
   if (!runs_->IsSampleValid()) {
-    runs_->AdvanceRun();
-    return true;
+    *err = !runs_->AdvanceRun();
+    return !*err;
   }
 
   DCHECK(!(*err));
@@ -827,8 +842,10 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
     return false;
 
   // Skip this entire track if it is not audio nor video.
-  if (!runs_->is_audio() && !runs_->is_video())
-    runs_->AdvanceRun();
+  if (!runs_->is_audio() && !runs_->is_video() && !runs_->AdvanceRun()) {
+    *err = true;
+    return false;
+  }
 
   // Attempt to cache the auxiliary information first. Aux info is usually
   // placed in a contiguous block before the sample data, rather than being
@@ -906,7 +923,10 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
            << ", cts=" << runs_->cts()
            << ", size=" << runs_->sample_size();
 
-  if (!new_sample_cb_(runs_->track_id(), stream_sample)) {
+  current_sample_offset_ = runs_->is_encrypted() ? -1 : sample_offset;
+  const bool accepted = new_sample_cb_(runs_->track_id(), stream_sample);
+  current_sample_offset_ = -1;
+  if (!accepted) {
     *err = true;
     LOG(ERROR) << "Failed to process the sample.";
     return false;
@@ -39,6 +39,10 @@ class MP4MediaParser : public MediaParser {
             KeySource* decryption_key_source) override;
   [[nodiscard]] bool Flush() override;
   [[nodiscard]] bool Parse(const uint8_t* buf, int size) override;
+  int64_t GetCurrentSampleOffset() const override {
+    return current_sample_offset_;
+  }
+  bool GetCurrentHeader(const uint8_t** data, size_t* size) const override;
   /// @}
 
   /// Handles ISO-BMFF containers which have the 'moov' box trailing the
@@ -98,6 +102,12 @@ class MP4MediaParser : public MediaParser {
   // Valid iff it is greater than the head of the queue.
   int64_t mdat_tail_;
 
+  // Offset of the unencrypted sample being passed to |new_sample_cb_|.
+  int64_t current_sample_offset_ = -1;
+  // The 'moov' box being parsed, while the init callback is called.
+  const uint8_t* current_moov_data_ = nullptr;
+  size_t current_moov_size_ = 0;
+
   std::unique_ptr<Movie> moov_;
   std::unique_ptr<TrackRunIterator> runs_;
 
@@ -196,7 +196,17 @@ Status MP4Muxer::Finalize() {
 
 Status MP4Muxer::AddMediaSample(size_t stream_id, const MediaSample& sample) {
   if (to_be_initialized_) {
-    RETURN_IF_ERROR(UpdateEditListOffsetFromSample(sample));
+    // The first sample of the stream is skipped if only a later segment of
+    // the stream is packaged.
+    const SegmentHistory* segment_history =
+        streams()[stream_id]->segment_history().get();
+    if (segment_history) {
+      RETURN_IF_ERROR(
+          UpdateEditListOffset(segment_history->first_sample_pts,
+                               segment_history->first_sample_dts));
+    } else {
+      RETURN_IF_ERROR(UpdateEditListOffset(sample.pts(), sample.dts()));
+    }
     RETURN_IF_ERROR(DelayInitializeMuxer());
     to_be_initialized_ = false;
   }
@@ -285,7 +295,7 @@ Status MP4Muxer::DelayInitializeMuxer() {
     if (!generate_trak_result)
       return Status(error::MUXER_FAILURE, "Failed to generate trak.");
 
-    // Generate EditList if needed. See UpdateEditListOffsetFromSample() for
+    // Generate EditList if needed. See UpdateEditListOffset() for
     // more information.
     if (edit_list_offset_.value() > 0) {
       EditListEntry entry;
@@ -327,12 +337,13 @@ Status MP4Muxer::DelayInitializeMuxer() {
   return Status::OK;
 }
 
-Status MP4Muxer::UpdateEditListOffsetFromSample(const MediaSample& sample) {
+Status MP4Muxer::UpdateEditListOffset(int64_t first_sample_pts,
+                                      int64_t first_sample_dts) {
   if (edit_list_offset_)
     return Status::OK;
 
-  const int64_t pts = sample.pts();
-  const int64_t dts = sample.dts();
+  const int64_t pts = first_sample_pts;
+  const int64_t dts = first_sample_dts;
   // An EditList entry is inserted if one of the below conditions occur [4]:
   // (1) pts > dts for the first sample. Due to Chrome's dts bug [1], dts is
   //     used in buffered range API, while pts is used elsewhere (players,
@@ -384,7 +395,7 @@ Status MP4Muxer::UpdateEditListOffsetFromSample(const MediaSample& sample) {
                << dts << ").";
     return Status(error::MUXER_FAILURE, "Not expecting pts < dts.");
   }
-  edit_list_offset_ = std::max(-sample.pts(), static_cast<int64_t>(0));
+  edit_list_offset_ = std::max(-pts, static_cast<int64_t>(0));
   return Status::OK;
 }
 
@@ -45,7 +45,8 @@ class MP4Muxer : public Muxer {
                          const SegmentInfo& segment_info) override;
 
   Status DelayInitializeMuxer();
-  Status UpdateEditListOffsetFromSample(const MediaSample& sample);
+  Status UpdateEditListOffset(int64_t first_sample_pts,
+                              int64_t first_sample_dts);
 
   // Generate Audio/Video Track box.
   void InitializeTrak(const StreamInfo* info, Track* trak);
@@ -60,6 +60,10 @@ std::vector<Range> MultiSegmentSegmenter::GetSegmentRanges() {
 }
 
 Status MultiSegmentSegmenter::DoInitialize() {
+  // Continue the segment numbering after the segments of a previous run and
+  // the skipped segments, if any.
+  num_segments_ = options().num_previous_segments +
+                  static_cast<uint32_t>(num_skipped_segments());
   return WriteInitSegment();
 }
 
@@ -22,6 +22,7 @@
 #include <packager/media/formats/mp4/box_definitions.h>
 #include <packager/media/formats/mp4/fragmenter.h>
 #include <packager/media/formats/mp4/key_frame_info.h>
+#include <packager/media/formats/mp4/movie_fragment_writer.h>
 #include <packager/version/version.h>
 
 namespace shaka {
@@ -94,6 +95,23 @@ Status Segmenter::Initialize(
   moov_->header.timescale = sidx_->timescale;
   moof_->header.sequence_number = 1;
 
+  // Restore the state after the segments which are skipped when a single
+  // segment is packaged.
+  for (uint32_t i = 0; i < streams.size(); ++i) {
+    const SegmentHistory* segment_history = streams[i]->segment_history().get();
+    if (!segment_history)
+      continue;
+    moov_->extends.tracks[i].default_sample_duration =
+        segment_history->first_sample_duration;
+    stream_durations_[i] = segment_history->skipped_samples_duration;
+    if (i != GetReferenceStreamId())
+      continue;
+    num_skipped_segments_ = segment_history->segments.size();
+    // A fragment is written for each segment and subsegment.
+    for (const SegmentHistory::Segment& segment : segment_history->segments)
+      moof_->header.sequence_number += segment.num_subsegments + 1;
+  }
+
   // Fill in version information.
   const std::string version = GetPackagerVersion();
   if (!version.empty()) {
@@ -173,40 +191,29 @@ Status Segmenter::FinalizeSegment(size_t stream_id,
   }
 
   MediaData mdat;
-  // Data offset relative to 'moof': moof size + mdat header size.
-  // The code will also update box sizes for moof_ and its child boxes.
-  uint64_t data_offset = moof_->ComputeSize() + mdat.HeaderSize();
-  // 'traf' should follow 'mfhd' moof header box.
-  uint64_t next_traf_position = moof_->HeaderSize() + moof_->header.box_size();
-  for (size_t i = 0; i < moof_->tracks.size(); ++i) {
-    TrackFragment& traf = moof_->tracks[i];
-    if (traf.auxiliary_offset.offsets.size() > 0) {
-      DCHECK_EQ(traf.auxiliary_offset.offsets.size(), 1u);
-      DCHECK(!traf.sample_encryption.sample_encryption_entries.empty());
-
-      next_traf_position += traf.box_size();
-      // SampleEncryption 'senc' box should be the last box in 'traf'.
-      // |auxiliary_offset| should point to the data of SampleEncryption.
-      traf.auxiliary_offset.offsets[0] =
-          next_traf_position - traf.sample_encryption.box_size() +
-          traf.sample_encryption.HeaderSize() +
-          sizeof(uint32_t);  // for sample count field in 'senc'
-    }
-    traf.runs[0].data_offset = data_offset + mdat.data_size;
-    mdat.data_size += static_cast<uint32_t>(fragmenters_[i]->data()->Size());
+  // Offsets of the track data relative to the end of 'moof'. The track data
+  // follow the 'mdat' header in track order.
+  std::vector<uint64_t> data_offsets;
+  data_offsets.reserve(fragmenters_.size());
+  for (const std::unique_ptr<Fragmenter>& fragmenter : fragmenters_) {
+    data_offsets.push_back(mdat.HeaderSize() + mdat.data_size);
+    mdat.data_size += static_cast<uint32_t>(fragmenter->data()->Size());
   }
 
+  const uint64_t moof_start_offset = fragment_buffer_->Size();
+
+  // Write the fragment to buffer. The 'trun' data offsets and 'saio' offsets
+  // are updated by the writer.
+  const uint32_t moof_size =
+      WriteMovieFragment(data_offsets, moof_.get(), fragment_buffer_.get());
+
   // Generate segment reference.
   sidx_->references.resize(sidx_->references.size() + 1);
   fragmenters_[GetReferenceStreamId()]->GenerateSegmentReference(
       &sidx_->references[sidx_->references.size() - 1]);
   sidx_->references[sidx_->references.size() - 1].referenced_size =
-      data_offset + mdat.data_size;
-
-  const uint64_t moof_start_offset = fragment_buffer_->Size();
+      moof_size + mdat.HeaderSize() + mdat.data_size;
 
-  // Write the fragment to buffer.
-  moof_->Write(fragment_buffer_.get());
   mdat.WriteHeader(fragment_buffer_.get());
 
   bool first_key_frame = true;
@@ -119,6 +119,9 @@ class Segmenter {
   const std::vector<KeyFrameInfo>& key_frame_infos() const {
     return key_frame_infos_;
   }
+  /// @return the number of segments before the first segment, which are
+  ///         skipped when a single segment is packaged.
+  size_t num_skipped_segments() const { return num_skipped_segments_; }
 
   void set_progress_target(uint64_t progress_target) {
     progress_target_ = progress_target;
@@ -153,6 +156,7 @@ class Segmenter {
   size_t num_samples_ = 0;
   std::vector<uint64_t> stream_durations_;
   std::vector<KeyFrameInfo> key_frame_infos_;
+  size_t num_skipped_segments_ = 0;
 
   DISALLOW_COPY_AND_ASSIGN(Segmenter);
 };
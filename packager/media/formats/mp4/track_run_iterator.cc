@@ -47,9 +47,47 @@ struct SampleInfo {
   bool is_keyframe;
 };
 
+// Reads the samples of a track in a non-fragmented mp4 from its sample table,
+// one chunk at a time. The tables are walked with the same iterators as in
+// TrackRunIterator::Init(); since the chunks of a track are normally read in
+// order, reading the next chunk continues from where the previous one ended.
+class SampleTableReader {
+ public:
+  explicit SampleTableReader(const SampleTable& sample_table)
+      : sample_table_(sample_table) {
+    Reset();
+  }
+
+  /// Reads @a num_samples samples starting from sample @a first_sample, which
+  /// is 0-based.
+  /// @return true on success, false otherwise.
+  bool ReadSamples(uint32_t first_sample,
+                   uint32_t num_samples,
+                   std::vector<SampleInfo>* samples);
+
+ private:
+  void Reset();
+  bool AdvanceSample();
+
+  const SampleTable& sample_table_;
+  std::unique_ptr<DecodingTimeIterator> decoding_time_;
+  std::unique_ptr<CompositionOffsetIterator> composition_offset_;
+  std::unique_ptr<SyncSampleIterator> sync_sample_;
+  bool has_composition_offset_ = false;
+  // The 0-based index of the sample the iterators point to.
+  uint32_t next_sample_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(SampleTableReader);
+};
+
 struct TrackRunInfo {
   uint32_t track_id;
   std::vector<SampleInfo> samples;
+  // Set for the runs of a non-fragmented mp4, i.e. chunks, whose |samples| are
+  // only populated while the run is the current run.
+  SampleTableReader* sample_table_reader;
+  uint32_t first_sample_index;
+  uint32_t num_samples;
   int64_t timescale;
   int64_t start_dts;
   int64_t sample_start_offset;
@@ -75,6 +113,9 @@ struct TrackRunInfo {
 
 TrackRunInfo::TrackRunInfo()
     : track_id(0),
+      sample_table_reader(NULL),
+      first_sample_index(0),
+      num_samples(0),
       timescale(-1),
       start_dts(-1),
       sample_start_offset(-1),
@@ -86,6 +127,57 @@ TrackRunInfo::TrackRunInfo()
       aux_info_total_size(0) {}
 TrackRunInfo::~TrackRunInfo() {}
 
+bool SampleTableReader::ReadSamples(uint32_t first_sample,
+                                    uint32_t num_samples,
+                                    std::vector<SampleInfo>* samples) {
+  if (first_sample < next_sample_)
+    Reset();
+  while (next_sample_ < first_sample)
+    RCHECK(AdvanceSample());
+
+  const SampleSize& sample_size = sample_table_.sample_size;
+  samples->resize(num_samples);
+  for (SampleInfo& sample : *samples) {
+    RCHECK(decoding_time_->IsValid());
+    if (sample_size.sample_size != 0) {
+      sample.size = sample_size.sample_size;
+    } else {
+      RCHECK(next_sample_ < sample_size.sizes.size());
+      sample.size = sample_size.sizes[next_sample_];
+    }
+    sample.duration = decoding_time_->sample_delta();
+    sample.cts_offset =
+        has_composition_offset_ ? composition_offset_->sample_offset() : 0;
+    sample.is_keyframe = sync_sample_->IsSyncSample();
+    RCHECK(AdvanceSample());
+  }
+  return true;
+}
+
+void SampleTableReader::Reset() {
+  decoding_time_.reset(
+      new DecodingTimeIterator(sample_table_.decoding_time_to_sample));
+  composition_offset_.reset(
+      new CompositionOffsetIterator(sample_table_.composition_time_to_sample));
+  has_composition_offset_ = composition_offset_->IsValid();
+  sync_sample_.reset(new SyncSampleIterator(sample_table_.sync_sample));
+  next_sample_ = 0;
+}
+
+bool SampleTableReader::AdvanceSample() {
+  RCHECK(decoding_time_->IsValid());
+  // The iterators return false when moving past the last sample, which is not
+  // an error here; the table lengths are verified in TrackRunIterator::Init().
+  decoding_time_->AdvanceSample();
+  if (has_composition_offset_) {
+    RCHECK(composition_offset_->IsValid());
+    composition_offset_->AdvanceSample();
+  }
+  sync_sample_->AdvanceSample();
+  ++next_sample_;
+  return true;
+}
+
 TrackRunIterator::TrackRunIterator(const Movie* moov)
     : moov_(moov), sample_dts_(0), sample_offset_(0) {
   CHECK(moov);
@@ -161,6 +253,7 @@ class CompareMinTrackRunDataOffset {
 
 bool TrackRunIterator::Init() {
   runs_.clear();
+  sample_table_readers_.clear();
 
   for (std::vector<Track>::const_iterator trak = moov_->tracks.begin();
        trak != moov_->tracks.end(); ++trak) {
@@ -178,8 +271,6 @@ bool TrackRunIterator::Init() {
     bool has_composition_offset = composition_offset.IsValid();
     ChunkInfoIterator chunk_info(
         trak->media.information.sample_table.sample_to_chunk);
-    SyncSampleIterator sync_sample(
-        trak->media.information.sample_table.sync_sample);
     // Skip processing saiz and saio boxes for non-fragmented mp4 as we
     // don't support encrypted non-fragmented mp4.
 
@@ -210,6 +301,14 @@ bool TrackRunIterator::Init() {
       RCHECK(decoding_time.IsValid());
       RCHECK(chunk_info.IsValid());
     }
+    if (sample_size.sample_size == 0)
+      RCHECK(sample_size.sizes.size() >= num_samples);
+
+    // The samples are read from the sample table when the chunks are reached,
+    // instead of being expanded for the whole track here.
+    sample_table_readers_.emplace_back(
+        new SampleTableReader(trak->media.information.sample_table));
+    SampleTableReader* sample_table_reader = sample_table_readers_.back().get();
 
     uint32_t sample_index = 0;
     for (uint32_t chunk_index = 0; chunk_index < num_chunks; ++chunk_index) {
@@ -245,22 +344,19 @@ bool TrackRunIterator::Init() {
       }
 
       uint32_t samples_per_chunk = chunk_info.samples_per_chunk();
-      tri.samples.resize(samples_per_chunk);
+      tri.sample_table_reader = sample_table_reader;
+      tri.first_sample_index = sample_index;
+      tri.num_samples = samples_per_chunk;
+      // Walk the tables to compute the start dts of the next chunk and to
+      // verify that the tables are consistent, so that reading the samples
+      // later cannot fail.
       for (uint32_t k = 0; k < samples_per_chunk; ++k) {
-        SampleInfo& sample = tri.samples[k];
-        sample.size = sample_size.sample_size != 0
-                          ? sample_size.sample_size
-                          : sample_size.sizes[sample_index];
-        sample.duration = decoding_time.sample_delta();
-        sample.cts_offset =
-            has_composition_offset ? composition_offset.sample_offset() : 0;
-        sample.is_keyframe = sync_sample.IsSyncSample();
-
-        run_start_dts += sample.duration;
+        RCHECK(sample_index < num_samples);
+        run_start_dts += decoding_time.sample_delta();
 
         // Advance to next sample. Should success except for last sample.
         ++sample_index;
-        RCHECK(chunk_info.AdvanceSample() && sync_sample.AdvanceSample());
+        RCHECK(chunk_info.AdvanceSample());
         if (sample_index == num_samples) {
           // We should hit end of tables for decoding time and composition
           // offset.
@@ -280,12 +376,12 @@ bool TrackRunIterator::Init() {
 
   std::sort(runs_.begin(), runs_.end(), CompareMinTrackRunDataOffset());
   run_itr_ = runs_.begin();
-  ResetRun();
-  return true;
+  return ResetRun();
 }
 
 bool TrackRunIterator::Init(const MovieFragment& moof) {
   runs_.clear();
+  sample_table_readers_.clear();
 
   const auto track_count = std::max(moof.tracks.size(), moov_->tracks.size());
   next_fragment_start_dts_.resize(track_count, 0);
@@ -435,21 +531,36 @@ bool TrackRunIterator::Init(const MovieFragment& moof) {
 
   std::sort(runs_.begin(), runs_.end(), CompareMinTrackRunDataOffset());
   run_itr_ = runs_.begin();
-  ResetRun();
-  return true;
+  return ResetRun();
 }
 
-void TrackRunIterator::AdvanceRun() {
+bool TrackRunIterator::AdvanceRun() {
+  if (IsRunValid() && run_itr_->sample_table_reader) {
+    // Release the samples of the chunk. They can be read again from the
+    // sample table if needed.
+    std::vector<SampleInfo>().swap(runs_[run_itr_ - runs_.begin()].samples);
+  }
   ++run_itr_;
-  ResetRun();
+  return ResetRun();
 }
 
-void TrackRunIterator::ResetRun() {
+bool TrackRunIterator::ResetRun() {
   if (!IsRunValid())
-    return;
+    return true;
+  TrackRunInfo& run = runs_[run_itr_ - runs_.begin()];
+  if (run.sample_table_reader && run.samples.size() != run.num_samples) {
+    if (!run.sample_table_reader->ReadSamples(run.first_sample_index,
+                                              run.num_samples, &run.samples)) {
+      LOG(ERROR) << "Failed to read samples of track " << run.track_id
+                 << " from the sample table.";
+      run.samples.clear();
+      return false;
+    }
+  }
   sample_dts_ = run_itr_->start_dts;
   sample_offset_ = run_itr_->sample_start_offset;
   sample_itr_ = run_itr_->samples.begin();
+  return true;
 }
 
 void TrackRunIterator::AdvanceSample() {
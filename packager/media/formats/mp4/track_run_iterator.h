@@ -19,6 +19,7 @@ class DecryptConfig;
 
 namespace mp4 {
 
+class SampleTableReader;
 struct SampleInfo;
 struct TrackRunInfo;
 
@@ -30,7 +31,9 @@ class TrackRunIterator {
   ~TrackRunIterator();
 
   /// For non-fragmented mp4, moov contains all the chunk information; This
-  /// function sets up the iterator to access all the chunks.
+  /// function sets up the iterator to access all the chunks. The samples of a
+  /// chunk are only read from the sample table when the iterator reaches it,
+  /// so memory usage does not grow with the number of samples.
   /// For fragmented mp4, chunk and sample information are generally contained
   /// in moof. This function is a no-op in this case. Init(moof) will be called
   /// later after parsing moof.
@@ -50,7 +53,8 @@ class TrackRunIterator {
 
   /// Advance iterator to the next run. Require that the iterator point to a
   /// valid run.
-  void AdvanceRun();
+  /// @return false if the samples of the next run cannot be read.
+  bool AdvanceRun();
   /// Advance iterator to the next sample. Require that the iterator point to a
   /// valid sample.
   void AdvanceSample();
@@ -103,7 +107,9 @@ class TrackRunIterator {
   std::unique_ptr<DecryptConfig> GetDecryptConfig();
 
  private:
-  void ResetRun();
+  // Reads the samples of the current run if needed and points to its first
+  // sample. Returns false if the samples cannot be read.
+  bool ResetRun();
   const TrackEncryption& track_encryption() const;
   int64_t GetTimestampAdjustment(const Movie& movie,
                                  const Track& track,
@@ -113,6 +119,8 @@ class TrackRunIterator {
 
   std::vector<TrackRunInfo> runs_;
   std::vector<TrackRunInfo>::const_iterator run_itr_;
+  // Sample table readers of the tracks in a non-fragmented mp4.
+  std::vector<std::unique_ptr<SampleTableReader>> sample_table_readers_;
   std::vector<SampleInfo>::const_iterator sample_itr_;
 
   // Track the start dts of the next segment, only useful if decode_time box is
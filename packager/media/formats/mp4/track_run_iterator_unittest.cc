@@ -355,6 +355,114 @@ TEST_F(TrackRunIteratorTest, BasicOperationTest) {
   EXPECT_FALSE(iter_->IsRunValid());
 }
 
+TEST_F(TrackRunIteratorTest, NonFragmentedTest) {
+  // Audio: 4 samples of size 7 in 2 chunks at 2000 and 4000.
+  SampleTable& audio_table = moov_.tracks[0].media.information.sample_table;
+  audio_table.decoding_time_to_sample.decoding_time.push_back({4, 1024});
+  audio_table.sample_to_chunk.chunk_info.push_back({1, 2, 1});
+  audio_table.sample_size.sample_size = 7;
+  audio_table.sample_size.sample_count = 4;
+  audio_table.chunk_large_offset.offsets = {2000, 4000};
+
+  // Video: 6 samples of ascending sizes in 3 chunks at 1000, 3000 and 5000,
+  // with key frames at samples 1 and 5.
+  SampleTable& video_table = moov_.tracks[1].media.information.sample_table;
+  video_table.decoding_time_to_sample.decoding_time.push_back({2, 1});
+  video_table.decoding_time_to_sample.decoding_time.push_back({4, 2});
+  video_table.sample_to_chunk.chunk_info.push_back({1, 2, 1});
+  video_table.sample_size.sample_count = 6;
+  video_table.sample_size.sizes = {1, 2, 3, 4, 5, 6};
+  video_table.chunk_large_offset.offsets = {1000, 3000, 5000};
+  video_table.sync_sample.sample_number = {1, 5};
+
+  iter_.reset(new TrackRunIterator(&moov_));
+  ASSERT_TRUE(iter_->Init());
+
+  const struct {
+    uint32_t track_id;
+    int64_t offset;
+    int size;
+    int64_t dts;
+    int64_t duration;
+    bool is_keyframe;
+  } kExpectedSamples[] = {
+      {2, 1000, 1, 0, 1, true},       {2, 1001, 2, 1, 1, false},
+      {1, 2000, 7, 0, 1024, true},    {1, 2007, 7, 1024, 1024, true},
+      {2, 3000, 3, 2, 2, false},      {2, 3003, 4, 4, 2, false},
+      {1, 4000, 7, 2048, 1024, true}, {1, 4007, 7, 3072, 1024, true},
+      {2, 5000, 5, 6, 2, true},       {2, 5005, 6, 8, 2, false},
+  };
+
+  size_t index = 0;
+  for (; iter_->IsRunValid(); iter_->AdvanceRun()) {
+    for (; iter_->IsSampleValid(); iter_->AdvanceSample()) {
+      ASSERT_LT(index, std::size(kExpectedSamples));
+      const auto& expected = kExpectedSamples[index++];
+      EXPECT_EQ(expected.track_id, iter_->track_id());
+      EXPECT_EQ(expected.offset, iter_->sample_offset());
+      EXPECT_EQ(expected.size, iter_->sample_size());
+      EXPECT_EQ(expected.dts, iter_->dts());
+      EXPECT_EQ(expected.dts, iter_->cts());
+      EXPECT_EQ(expected.duration, iter_->duration());
+      EXPECT_EQ(expected.is_keyframe, iter_->is_keyframe());
+    }
+  }
+  EXPECT_EQ(std::size(kExpectedSamples), index);
+}
+
+TEST_F(TrackRunIteratorTest, NonFragmentedChunksOutOfOrderTest) {
+  SampleTable& video_table = moov_.tracks[1].media.information.sample_table;
+  video_table.decoding_time_to_sample.decoding_time.push_back({4, 1});
+  video_table.sample_to_chunk.chunk_info.push_back({1, 2, 1});
+  video_table.sample_size.sample_count = 4;
+  video_table.sample_size.sizes = {1, 2, 3, 4};
+  // The second chunk is stored before the first one.
+  video_table.chunk_large_offset.offsets = {3000, 1000};
+
+  iter_.reset(new TrackRunIterator(&moov_));
+  ASSERT_TRUE(iter_->Init());
+  EXPECT_EQ(1000, iter_->sample_offset());
+  EXPECT_EQ(3, iter_->sample_size());
+  EXPECT_EQ(2, iter_->dts());
+  iter_->AdvanceRun();
+  EXPECT_EQ(3000, iter_->sample_offset());
+  EXPECT_EQ(1, iter_->sample_size());
+  EXPECT_EQ(0, iter_->dts());
+  iter_->AdvanceSample();
+  EXPECT_EQ(2, iter_->sample_size());
+  EXPECT_EQ(1, iter_->dts());
+  iter_->AdvanceRun();
+  EXPECT_FALSE(iter_->IsRunValid());
+}
+
+TEST_F(TrackRunIteratorTest, NonFragmentedMissingSampleSizesTest) {
+  SampleTable& video_table = moov_.tracks[1].media.information.sample_table;
+  video_table.decoding_time_to_sample.decoding_time.push_back({4, 1});
+  video_table.sample_to_chunk.chunk_info.push_back({1, 2, 1});
+  video_table.sample_size.sample_count = 4;
+  video_table.sample_size.sizes = {1, 2, 3};
+  video_table.chunk_large_offset.offsets = {1000, 3000};
+
+  iter_.reset(new TrackRunIterator(&moov_));
+  EXPECT_FALSE(iter_->Init());
+}
+
+TEST_F(TrackRunIteratorTest, NonFragmentedReadSamplesFailureTest) {
+  SampleTable& video_table = moov_.tracks[1].media.information.sample_table;
+  video_table.decoding_time_to_sample.decoding_time.push_back({4, 1});
+  video_table.sample_to_chunk.chunk_info.push_back({1, 2, 1});
+  video_table.sample_size.sample_count = 4;
+  video_table.sample_size.sizes = {1, 2, 3, 4};
+  video_table.chunk_large_offset.offsets = {1000, 3000};
+
+  iter_.reset(new TrackRunIterator(&moov_));
+  ASSERT_TRUE(iter_->Init());
+  // The samples of a chunk are read from the table when the chunk is reached,
+  // so a failure to read them is reported when advancing to it.
+  video_table.sample_size.sizes.resize(2);
+  EXPECT_FALSE(iter_->AdvanceRun());
+}
+
 TEST_F(TrackRunIteratorTest, TrackExtendsDefaultsTest) {
   moov_.extends.tracks[0].default_sample_duration = 50;
   moov_.extends.tracks[0].default_sample_size = 3;
@@ -20,8 +20,8 @@ PackedAudioWriter::PackedAudioWriter(const MuxerOptions& muxer_options)
       transport_stream_timestamp_offset_(
           muxer_options.transport_stream_timestamp_offset_ms *
           kPackedAudioTimescale / 1000),
-      segmenter_(new PackedAudioSegmenter(transport_stream_timestamp_offset_)) {
-}
+      segmenter_(new PackedAudioSegmenter(transport_stream_timestamp_offset_)),
+      segment_number_(muxer_options.num_previous_segments) {}
 
 PackedAudioWriter::~PackedAudioWriter() = default;
 
@@ -50,6 +50,7 @@ Status PackedAudioWriter::InitializeMuxer() {
 }
 
 Status PackedAudioWriter::Finalize() {
+  RETURN_IF_ERROR(segment_writer_.Flush());
   if (output_file_)
     RETURN_IF_ERROR(CloseFile(std::move(output_file_)));
 
@@ -86,42 +87,35 @@ Status PackedAudioWriter::FinalizeSegment(size_t stream_id,
   // Save |segment_size| as it will be cleared after writing.
   const size_t segment_size = segmenter_->segment_buffer()->Size();
 
-  RETURN_IF_ERROR(WriteSegment(segment_path, segmenter_->segment_buffer()));
-  total_duration_ += segment_info.duration;
-
-  if (muxer_listener()) {
-    muxer_listener()->OnNewSegment(
-        segment_path, segment_timestamp + transport_stream_timestamp_offset_,
-        segment_info.duration * segmenter_->TimescaleScale(), segment_size);
-  }
-  return Status::OK;
-}
-
-Status PackedAudioWriter::WriteSegment(const std::string& segment_path,
-                                       BufferWriter* segment_buffer) {
-  std::unique_ptr<File, FileCloser> file;
   if (output_file_) {
     // This is in single segment mode.
     Range range;
     range.start = media_ranges_.subsegment_ranges.empty()
                       ? 0
                       : (media_ranges_.subsegment_ranges.back().end + 1);
-    range.end = range.start + segment_buffer->Size() - 1;
+    range.end = range.start + segment_size - 1;
     media_ranges_.subsegment_ranges.push_back(range);
-  } else {
-    file.reset(File::Open(segment_path.c_str(), "w"));
-    if (!file) {
-      return Status(error::FILE_FAILURE,
-                    "Cannot open file for write " + segment_path);
-    }
   }
+  total_duration_ += segment_info.duration;
 
-  RETURN_IF_ERROR(segment_buffer->WriteToFile(output_file_ ? output_file_.get()
-                                                           : file.get()));
+  // The listener is notified once the segment is written, while the next
+  // segment is being packetized.
+  const int64_t start_time =
+      segment_timestamp + transport_stream_timestamp_offset_;
+  const int64_t duration =
+      segment_info.duration * segmenter_->TimescaleScale();
+  return segment_writer_.WriteSegment(
+      segment_path, output_file_.get(), segmenter_->segment_buffer(),
+      [this, segment_path, start_time, duration, segment_size]() {
+        if (muxer_listener()) {
+          muxer_listener()->OnNewSegment(segment_path, start_time, duration,
+                                         segment_size);
+        }
+      });
+}
 
-  if (file)
-    RETURN_IF_ERROR(CloseFile(std::move(file)));
-  return Status::OK;
+Status PackedAudioWriter::FlushPendingSegments() {
+  return segment_writer_.Flush();
 }
 
 Status PackedAudioWriter::CloseFile(std::unique_ptr<File, FileCloser> file) {
@@ -8,12 +8,12 @@
 #define PACKAGER_MEDIA_FORMATS_PACKED_AUDIO_PACKED_AUDIO_WRITER_H_
 
 #include <packager/file/file_closer.h>
+#include <packager/media/base/async_segment_writer.h>
 #include <packager/media/base/muxer.h>
 
 namespace shaka {
 namespace media {
 
-class BufferWriter;
 class PackedAudioSegmenter;
 
 /// Implements packed audio writer.
@@ -37,9 +37,7 @@ class PackedAudioWriter : public Muxer {
   Status Finalize() override;
   Status AddMediaSample(size_t stream_id, const MediaSample& sample) override;
   Status FinalizeSegment(size_t stream_id, const SegmentInfo& sample) override;
-
-  Status WriteSegment(const std::string& segment_path,
-                      BufferWriter* segment_buffer);
+  Status FlushPendingSegments() override;
 
   Status CloseFile(std::unique_ptr<File, FileCloser> file);
 
@@ -53,7 +51,11 @@ class PackedAudioWriter : public Muxer {
   int64_t total_duration_ = 0;
 
   // Used in multi-segment mode for segment template.
-  uint64_t segment_number_ = 0;
+  uint64_t segment_number_;
+
+  // Writes the segments while the next one is packetized. Declared last so that
+  // it waits for the segment being written before |output_file_| is closed.
+  AsyncSegmentWriter segment_writer_;
 };
 
 }  // namespace media
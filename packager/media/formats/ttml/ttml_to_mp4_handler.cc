@@ -61,9 +61,9 @@ Status TtmlToMp4Handler::Process(std::unique_ptr<StreamData> stream_data) {
 
 Status TtmlToMp4Handler::OnStreamInfo(std::unique_ptr<StreamData> stream_data) {
   DCHECK(stream_data);
-  DCHECK(stream_data->stream_info);
+  DCHECK(stream_data->stream_info());
 
-  auto clone = stream_data->stream_info->Clone();
+  auto clone = stream_data->stream_info()->Clone();
   clone->set_codec(kCodecTtml);
   clone->set_codec_string("ttml");
 
@@ -79,16 +79,16 @@ Status TtmlToMp4Handler::OnStreamInfo(std::unique_ptr<StreamData> stream_data) {
 
 Status TtmlToMp4Handler::OnCueEvent(std::unique_ptr<StreamData> stream_data) {
   DCHECK(stream_data);
-  DCHECK(stream_data->cue_event);
+  DCHECK(stream_data->cue_event());
   return Dispatch(std::move(stream_data));
 }
 
 Status TtmlToMp4Handler::OnSegmentInfo(
     std::unique_ptr<StreamData> stream_data) {
   DCHECK(stream_data);
-  DCHECK(stream_data->segment_info);
+  DCHECK(stream_data->segment_info());
 
-  const auto& segment = stream_data->segment_info;
+  const auto& segment = stream_data->segment_info();
 
   std::string data;
   if (!generator_.Dump(&data))
@@ -104,9 +104,9 @@ Status TtmlToMp4Handler::OnSegmentInfo(
 
 Status TtmlToMp4Handler::OnTextSample(std::unique_ptr<StreamData> stream_data) {
   DCHECK(stream_data);
-  DCHECK(stream_data->text_sample);
+  DCHECK(stream_data->text_sample());
 
-  auto& sample = stream_data->text_sample;
+  auto& sample = stream_data->text_sample();
 
   // Ignore empty samples. This will create gaps, but we will handle that
   // later.
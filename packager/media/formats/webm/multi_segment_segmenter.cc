@@ -21,7 +21,7 @@ namespace media {
 namespace webm {
 
 MultiSegmentSegmenter::MultiSegmentSegmenter(const MuxerOptions& options)
-    : Segmenter(options), num_segment_(0) {}
+    : Segmenter(options), num_segment_(options.num_previous_segments) {}
 
 MultiSegmentSegmenter::~MultiSegmentSegmenter() {}
 
@@ -43,24 +43,37 @@ Status MultiSegmentSegmenter::FinalizeSegment(int64_t start_timestamp,
     // written before manifest is updated.
     RETURN_IF_ERROR(writer_->Close());
 
-    if (!File::Copy(temp_file_name_.c_str(), segment_name.c_str()))
-      return Status(error::FILE_FAILURE, "Failure to copy memory file.");
-
-    if (!File::Delete(temp_file_name_.c_str()))
-      return Status(error::FILE_FAILURE, "Failure to delete memory file.");
-
     num_segment_++;
 
-    if (muxer_listener()) {
-      const uint64_t size = cluster()->Size();
-      muxer_listener()->OnNewSegment(segment_name, start_timestamp,
-                                     duration_timestamp, size);
-    }
-    VLOG(1) << "WEBM file '" << segment_name << "' finalized.";
+    // The segment is copied to its final location while the next segment is
+    // being written, and the listener is notified once it is copied.
+    const std::string temp_file_name = temp_file_name_;
+    const uint64_t size = cluster()->Size();
+    RETURN_IF_ERROR(segment_writer_.RunTask(
+        segment_name,
+        [temp_file_name, segment_name]() {
+          if (!File::Copy(temp_file_name.c_str(), segment_name.c_str()))
+            return Status(error::FILE_FAILURE, "Failure to copy memory file.");
+          if (!File::Delete(temp_file_name.c_str()))
+            return Status(error::FILE_FAILURE,
+                          "Failure to delete memory file.");
+          return Status::OK;
+        },
+        [this, segment_name, start_timestamp, duration_timestamp, size]() {
+          if (muxer_listener()) {
+            muxer_listener()->OnNewSegment(segment_name, start_timestamp,
+                                           duration_timestamp, size);
+          }
+          VLOG(1) << "WEBM file '" << segment_name << "' finalized.";
+        }));
   }
   return Status::OK;
 }
 
+Status MultiSegmentSegmenter::FlushPendingSegments() {
+  return segment_writer_.Flush();
+}
+
 bool MultiSegmentSegmenter::GetInitRangeStartAndEnd(uint64_t* /*start*/,
                                                     uint64_t* /*end*/) {
   return false;
@@ -85,7 +98,7 @@ Status MultiSegmentSegmenter::DoInitialize() {
 }
 
 Status MultiSegmentSegmenter::DoFinalize() {
-  return Status::OK;
+  return segment_writer_.Flush();
 }
 
 Status MultiSegmentSegmenter::NewSegment(int64_t start_timestamp,
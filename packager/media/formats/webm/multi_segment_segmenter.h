@@ -10,6 +10,7 @@
 #include <memory>
 
 #include <packager/macros/classes.h>
+#include <packager/media/base/async_segment_writer.h>
 #include <packager/media/formats/webm/mkv_writer.h>
 #include <packager/media/formats/webm/segmenter.h>
 #include <packager/status.h>
@@ -33,6 +34,7 @@ class MultiSegmentSegmenter : public Segmenter {
   Status FinalizeSegment(int64_t start_timestamp,
                          int64_t duration_timestamp,
                          bool is_subsegment) override;
+  Status FlushPendingSegments() override;
   bool GetInitRangeStartAndEnd(uint64_t* start, uint64_t* end) override;
   bool GetIndexRangeStartAndEnd(uint64_t* start, uint64_t* end) override;
   std::vector<Range> GetSegmentRanges() override;
@@ -51,6 +53,10 @@ class MultiSegmentSegmenter : public Segmenter {
   uint32_t num_segment_;
   std::string temp_file_name_;
 
+  // Copies the segments to their final location while the next one is being
+  // written.
+  AsyncSegmentWriter segment_writer_;
+
   DISALLOW_COPY_AND_ASSIGN(MultiSegmentSegmenter);
 };
 
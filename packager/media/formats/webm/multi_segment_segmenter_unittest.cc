@@ -141,6 +141,26 @@ TEST_F(MultiSegmentSegmenterTest, BasicSupport) {
   EXPECT_FALSE(File::Open(TemplateFileName(1).c_str(), "r"));
 }
 
+TEST_F(MultiSegmentSegmenterTest, ContinuesNumberingOfPreviousSegments) {
+  MuxerOptions options = CreateMuxerOptions();
+  options.segment_template = segment_template_;
+  // E.g. a live session resumed after 3 segments.
+  options.num_previous_segments = 3;
+  ASSERT_NO_FATAL_FAILURE(InitializeSegmenter(options));
+
+  for (int i = 0; i < 5; i++) {
+    std::shared_ptr<MediaSample> sample =
+        CreateSample(kKeyFrame, kDuration, kNoSideData);
+    ASSERT_OK(segmenter_->AddSample(*sample));
+  }
+  ASSERT_OK(segmenter_->FinalizeSegment(0, 8 * kDuration, !kSubsegment));
+  ASSERT_OK(segmenter_->Finalize());
+
+  // The segment is written as $Number$ 4 instead of overwriting the first one.
+  EXPECT_FALSE(File::Open(TemplateFileName(0).c_str(), "r"));
+  ASSERT_FILE_EQ(TemplateFileName(3).c_str(), kBasicSupportDataSegment);
+}
+
 TEST_F(MultiSegmentSegmenterTest, SplitsFilesOnSegment) {
   MuxerOptions options = CreateMuxerOptions();
   options.segment_template = segment_template_;
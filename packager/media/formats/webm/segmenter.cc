@@ -156,6 +156,10 @@ Status Segmenter::Finalize() {
   return DoFinalize();
 }
 
+Status Segmenter::FlushPendingSegments() {
+  return Status::OK;
+}
+
 Status Segmenter::AddSample(const MediaSample& source_sample) {
   std::shared_ptr<MediaSample> sample(source_sample.Clone());
 
@@ -60,6 +60,11 @@ class Segmenter {
                                  int64_t duration_timestamp,
                                  bool is_subsegment) = 0;
 
+  /// Wait for the segments being written asynchronously, if any, and notify
+  /// the muxer listener about them.
+  /// @return OK on success, an error status otherwise.
+  virtual Status FlushPendingSegments();
+
   /// @return true if there is an initialization range, while setting @a start
   ///         and @a end; or false if initialization range does not apply.
   virtual bool GetInitRangeStartAndEnd(uint64_t* start, uint64_t* end) = 0;
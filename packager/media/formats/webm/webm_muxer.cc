@@ -87,6 +87,10 @@ Status WebMMuxer::FinalizeSegment(size_t stream_id,
                                      segment_info.is_subsegment);
 }
 
+Status WebMMuxer::FlushPendingSegments() {
+  return segmenter_ ? segmenter_->FlushPendingSegments() : Status::OK;
+}
+
 void WebMMuxer::FireOnMediaStartEvent() {
   if (!muxer_listener())
     return;
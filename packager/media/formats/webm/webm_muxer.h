@@ -30,6 +30,7 @@ class WebMMuxer : public Muxer {
   Status AddMediaSample(size_t stream_id, const MediaSample& sample) override;
   Status FinalizeSegment(size_t stream_id,
                          const SegmentInfo& segment_info) override;
+  Status FlushPendingSegments() override;
 
   void FireOnMediaStartEvent();
   void FireOnMediaEndEvent();
@@ -34,7 +34,7 @@ Status TextPadder::Process(std::unique_ptr<StreamData> data) {
 }
 
 Status TextPadder::OnTextSample(std::unique_ptr<StreamData> data) {
-  const TextSample& sample = *data->text_sample;
+  const TextSample& sample = *data->text_sample();
 
   // If this is the first sample we have seen, we need to check if we should
   // start at time zero.
@@ -130,9 +130,9 @@ Status WebVttToMp4Handler::Process(std::unique_ptr<StreamData> stream_data) {
 Status WebVttToMp4Handler::OnStreamInfo(
     std::unique_ptr<StreamData> stream_data) {
   DCHECK(stream_data);
-  DCHECK(stream_data->stream_info);
+  DCHECK(stream_data->stream_info());
 
-  auto clone = stream_data->stream_info->Clone();
+  auto clone = stream_data->stream_info()->Clone();
   clone->set_codec(kCodecWebVtt);
   clone->set_codec_string("wvtt");
 
@@ -146,7 +146,7 @@ Status WebVttToMp4Handler::OnStreamInfo(
 
 Status WebVttToMp4Handler::OnCueEvent(std::unique_ptr<StreamData> stream_data) {
   DCHECK(stream_data);
-  DCHECK(stream_data->cue_event);
+  DCHECK(stream_data->cue_event());
 
   if (current_segment_.size()) {
     return Status(error::INTERNAL_ERROR,
@@ -159,9 +159,9 @@ Status WebVttToMp4Handler::OnCueEvent(std::unique_ptr<StreamData> stream_data) {
 Status WebVttToMp4Handler::OnSegmentInfo(
     std::unique_ptr<StreamData> stream_data) {
   DCHECK(stream_data);
-  DCHECK(stream_data->segment_info);
+  DCHECK(stream_data->segment_info());
 
-  const auto& segment = stream_data->segment_info;
+  const auto& segment = stream_data->segment_info();
 
   int64_t segment_start = segment->start_timestamp;
   int64_t segment_duration = segment->duration;
@@ -176,9 +176,9 @@ Status WebVttToMp4Handler::OnSegmentInfo(
 Status WebVttToMp4Handler::OnTextSample(
     std::unique_ptr<StreamData> stream_data) {
   DCHECK(stream_data);
-  DCHECK(stream_data->text_sample);
+  DCHECK(stream_data->text_sample());
 
-  auto& sample = stream_data->text_sample;
+  auto& sample = stream_data->text_sample();
 
   // Ignore empty samples. This will create gaps, but we will handle that
   // later.
@@ -188,7 +188,7 @@ Status WebVttToMp4Handler::OnTextSample(
 
   // Add the new text sample to the cache of samples that belong in the
   // current segment.
-  current_segment_.push_back(std::move(stream_data->text_sample));
+  current_segment_.push_back(stream_data->Take<TextSample>());
   return Status::OK;
 }
 
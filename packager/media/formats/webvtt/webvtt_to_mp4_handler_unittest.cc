@@ -33,7 +33,7 @@ const char* kEmptyPayload = "";
 }  // namespace
 
 MATCHER_P(MediaSampleContainsId, id, "") {
-  auto& sample = arg->media_sample;
+  auto& sample = arg->media_sample();
 
   if (!sample) {
     return false;
@@ -6,36 +6,198 @@
 
 #include <packager/media/replicator/replicator.h>
 
+#include <deque>
+#include <iterator>
+#include <thread>
+
+#include <absl/base/thread_annotations.h>
 #include <absl/log/check.h>
 #include <absl/log/log.h>
+#include <absl/synchronization/mutex.h>
 
 namespace shaka {
 namespace media {
 
+struct Replicator::Output {
+  Output(size_t stream_index, size_t max_queue_size)
+      : stream_index(stream_index), max_queue_size(max_queue_size) {}
+
+  const size_t stream_index;
+  const size_t max_queue_size;
+  std::thread thread;
+
+  absl::Mutex mutex;
+  std::deque<std::unique_ptr<StreamData>> queue ABSL_GUARDED_BY(mutex);
+  // Set when no more messages will be queued.
+  bool done ABSL_GUARDED_BY(mutex) = false;
+  // Set when the downstream handlers should be flushed once the queue drains.
+  bool flush ABSL_GUARDED_BY(mutex) = false;
+  // The first error returned by the downstream handlers. Nothing is
+  // dispatched after an error.
+  Status status ABSL_GUARDED_BY(mutex);
+};
+
+Replicator::Replicator(size_t max_queued_stream_data)
+    : max_queued_stream_data_(max_queued_stream_data) {}
+
+Replicator::~Replicator() {
+  StopOutputs(false);
+}
+
 Status Replicator::InitializeInternal() {
+  if (max_queued_stream_data_ == 0)
+    return Status::OK;
+
+  for (const auto& out : output_handlers()) {
+    outputs_.emplace_back(new Output(out.first, max_queued_stream_data_));
+    Output* output = outputs_.back().get();
+    output->thread = std::thread(&Replicator::RunOutput, this, output);
+  }
   return Status::OK;
 }
 
 Status Replicator::Process(std::unique_ptr<StreamData> stream_data) {
   Status status;
 
-  for (auto& out : output_handlers()) {
-    std::unique_ptr<StreamData> copy(new StreamData(*stream_data));
-    copy->stream_index = out.first;
+  if (outputs_.empty()) {
+    size_t remaining_outputs = output_handlers().size();
+    for (auto& out : output_handlers()) {
+      // The last output gets the original instead of a copy.
+      std::unique_ptr<StreamData> copy =
+          --remaining_outputs == 0
+              ? std::move(stream_data)
+              : std::unique_ptr<StreamData>(new StreamData(*stream_data));
+      copy->stream_index = out.first;
 
-    status.Update(Dispatch(std::move(copy)));
+      status.Update(Dispatch(std::move(copy)));
+    }
+    return status;
   }
 
+  for (auto& output : outputs_) {
+    absl::MutexLock lock(&output->mutex);
+    status.Update(Enqueue(*stream_data, output.get()));
+  }
+  return status;
+}
+
+Status Replicator::ProcessBatch(StreamDataBatch batch) {
+  Status status;
+
+  if (outputs_.empty()) {
+    size_t remaining_outputs = output_handlers().size();
+    for (auto& out : output_handlers()) {
+      StreamDataBatch copies;
+      if (--remaining_outputs == 0) {
+        // The last output gets the original instead of a copy.
+        copies = std::move(batch);
+      } else {
+        copies.reserve(batch.size());
+        for (const auto& stream_data : batch)
+          copies.emplace_back(new StreamData(*stream_data));
+      }
+      for (auto& stream_data : copies)
+        stream_data->stream_index = out.first;
+
+      status.Update(DispatchBatch(std::move(copies)));
+    }
+    return status;
+  }
+
+  for (auto& output : outputs_) {
+    absl::MutexLock lock(&output->mutex);
+    for (const auto& stream_data : batch) {
+      Status enqueue_status = Enqueue(*stream_data, output.get());
+      if (!enqueue_status.ok()) {
+        status.Update(enqueue_status);
+        break;
+      }
+    }
+  }
   return status;
 }
 
+Status Replicator::Enqueue(const StreamData& stream_data, Output* output) {
+  output->mutex.Await(absl::Condition(
+      +[](Output* output) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+        return output->queue.size() < output->max_queue_size ||
+               !output->status.ok();
+      },
+      output));
+  if (!output->status.ok())
+    return output->status;
+
+  std::unique_ptr<StreamData> copy(new StreamData(stream_data));
+  copy->stream_index = output->stream_index;
+  output->queue.push_back(std::move(copy));
+  return Status::OK;
+}
+
 bool Replicator::ValidateOutputStreamIndex(size_t /* ignored */) const {
   return true;
 }
 
 Status Replicator::OnFlushRequest(size_t input_stream_index) {
   DCHECK_EQ(input_stream_index, 0u);
-  return FlushAllDownstreams();
+  if (outputs_.empty())
+    return FlushAllDownstreams();
+  return StopOutputs(true);
+}
+
+void Replicator::RunOutput(Output* output) {
+  while (true) {
+    // Take everything queued so far, so that it is dispatched in one batch.
+    StreamDataBatch batch;
+    {
+      absl::MutexLock lock(&output->mutex);
+      output->mutex.Await(absl::Condition(
+          +[](Output* output) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+            return !output->queue.empty() || output->done;
+          },
+          output));
+      if (output->queue.empty())
+        break;
+      batch.assign(std::make_move_iterator(output->queue.begin()),
+                   std::make_move_iterator(output->queue.end()));
+      output->queue.clear();
+    }
+
+    Status status = DispatchBatch(std::move(batch));
+    if (!status.ok()) {
+      absl::MutexLock lock(&output->mutex);
+      output->status = status;
+      output->queue.clear();
+      return;
+    }
+  }
+
+  bool flush = false;
+  {
+    absl::MutexLock lock(&output->mutex);
+    flush = output->flush;
+  }
+  if (flush) {
+    Status status = FlushDownstream(output->stream_index);
+    absl::MutexLock lock(&output->mutex);
+    output->status = status;
+  }
+}
+
+Status Replicator::StopOutputs(bool flush) {
+  for (auto& output : outputs_) {
+    absl::MutexLock lock(&output->mutex);
+    output->done = true;
+    output->flush = flush;
+  }
+
+  Status status;
+  for (auto& output : outputs_) {
+    if (output->thread.joinable())
+      output->thread.join();
+    absl::MutexLock lock(&output->mutex);
+    status.Update(output->status);
+  }
+  return status;
 }
 
 }  // namespace media
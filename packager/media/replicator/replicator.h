@@ -7,6 +7,10 @@
 #ifndef PACKAGER_MEDIA_REPLICATOR_HANDLER_H_
 #define PACKAGER_MEDIA_REPLICATOR_HANDLER_H_
 
+#include <memory>
+#include <vector>
+
+#include <packager/macros/classes.h>
 #include <packager/media/base/media_handler.h>
 
 namespace shaka {
@@ -16,12 +20,43 @@ namespace media {
 /// downstream handlers. The messages that are sent downstream are not copies,
 /// they are the original message. It is the responsibility of downstream
 /// handlers to make a copy before modifying the message.
+///
+/// By default, the messages are dispatched to all outputs on the calling
+/// thread. The replicator can instead dispatch to each output on a dedicated
+/// thread, so that the downstream handlers, e.g. muxers for different output
+/// formats, run in parallel.
 class Replicator : public MediaHandler {
+ public:
+  /// @param max_queued_stream_data is the number of messages buffered for
+  ///        each output before Process blocks. If non-zero, each output is
+  ///        dispatched to on a dedicated thread. If zero, all outputs are
+  ///        dispatched to synchronously.
+  explicit Replicator(size_t max_queued_stream_data = 0);
+  ~Replicator() override;
+
  private:
+  struct Output;
+
   Status InitializeInternal() override;
   Status Process(std::unique_ptr<StreamData> stream_data) override;
+  Status ProcessBatch(StreamDataBatch batch) override;
   bool ValidateOutputStreamIndex(size_t stream_index) const override;
   Status OnFlushRequest(size_t input_stream_index) override;
+
+  // Queues a copy of |stream_data| for |output|, waiting for space in the
+  // queue. |output->mutex| must be held.
+  static Status Enqueue(const StreamData& stream_data, Output* output);
+  // Runs on the thread of |output|.
+  void RunOutput(Output* output);
+  // Stops the output threads after they dispatch the queued messages,
+  // flushing the downstream handlers if |flush| is set. Returns the first
+  // error from the outputs.
+  Status StopOutputs(bool flush);
+
+  const size_t max_queued_stream_data_;
+  std::vector<std::unique_ptr<Output>> outputs_;
+
+  DISALLOW_COPY_AND_ASSIGN(Replicator);
 };
 
 }  // namespace media
@@ -0,0 +1,104 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/media/replicator/replicator.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <packager/media/base/media_handler_test_base.h>
+#include <packager/status/status_test_util.h>
+
+using ::testing::_;
+
+namespace shaka {
+namespace media {
+namespace {
+const size_t kInputCount = 1;
+const size_t kOutputCount = 3;
+const size_t kInputIndex = 0;
+const size_t kStreamIndex = 0;
+const int32_t kTimescale = 1000;
+const int64_t kDuration = 1000;
+const int kNumSamples = 200;
+const bool kKeyFrame = true;
+const bool kEncrypted = true;
+
+// Small enough for the input to get ahead of the outputs.
+const size_t kMaxQueuedStreamData = 2;
+}  // namespace
+
+class ReplicatorTest : public MediaHandlerTestBase,
+                       public ::testing::WithParamInterface<size_t> {
+ protected:
+  void SetUp() override {
+    ASSERT_OK(SetUpAndInitializeGraph(std::make_shared<Replicator>(GetParam()),
+                                      kInputCount, kOutputCount));
+  }
+
+  // Expects every output to get a stream info and |kNumSamples| samples, in
+  // order, followed by a flush.
+  void ExpectSamplesInOrder() {
+    sequences_.resize(kOutputCount);
+    for (size_t output = 0; output < kOutputCount; ++output) {
+      EXPECT_CALL(
+          *Output(output),
+          OnProcess(IsStreamInfo(kStreamIndex, kTimescale, !kEncrypted, _)))
+          .InSequence(sequences_[output]);
+      for (int i = 0; i < kNumSamples; ++i) {
+        EXPECT_CALL(*Output(output),
+                    OnProcess(IsMediaSample(kStreamIndex, i * kDuration,
+                                            kDuration, !kEncrypted, kKeyFrame)))
+            .InSequence(sequences_[output]);
+      }
+      EXPECT_CALL(*Output(output), OnFlush(kStreamIndex))
+          .InSequence(sequences_[output]);
+    }
+  }
+
+  std::vector<::testing::Sequence> sequences_;
+};
+
+TEST_P(ReplicatorTest, DispatchesToAllOutputsInOrder) {
+  ExpectSamplesInOrder();
+
+  ASSERT_OK(Input(kInputIndex)
+                ->Dispatch(StreamData::FromStreamInfo(
+                    kStreamIndex, GetVideoStreamInfo(kTimescale))));
+  for (int i = 0; i < kNumSamples; ++i) {
+    ASSERT_OK(Input(kInputIndex)
+                  ->Dispatch(StreamData::FromMediaSample(
+                      kStreamIndex,
+                      GetMediaSample(i * kDuration, kDuration, kKeyFrame))));
+  }
+  ASSERT_OK(Input(kInputIndex)->FlushAllDownstreams());
+}
+
+TEST_P(ReplicatorTest, DispatchesBatchesToAllOutputsInOrder) {
+  ExpectSamplesInOrder();
+
+  const size_t kBatchSize = 30;
+  StreamDataBatch batch;
+  batch.push_back(StreamData::FromStreamInfo(kStreamIndex,
+                                             GetVideoStreamInfo(kTimescale)));
+  for (int i = 0; i < kNumSamples; ++i) {
+    batch.push_back(StreamData::FromMediaSample(
+        kStreamIndex, GetMediaSample(i * kDuration, kDuration, kKeyFrame)));
+    if (batch.size() == kBatchSize) {
+      ASSERT_OK(Input(kInputIndex)->DispatchBatch(std::move(batch)));
+      batch.clear();
+    }
+  }
+  ASSERT_OK(Input(kInputIndex)->DispatchBatch(std::move(batch)));
+  ASSERT_OK(Input(kInputIndex)->FlushAllDownstreams());
+}
+
+INSTANTIATE_TEST_CASE_P(SynchronousAndParallel,
+                        ReplicatorTest,
+                        ::testing::Values(0u, kMaxQueuedStreamData));
+
+}  // namespace media
+}  // namespace shaka
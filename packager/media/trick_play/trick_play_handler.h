@@ -8,6 +8,8 @@
 #define PACKAGER_MEDIA_BASE_TRICK_PLAY_HANDLER_H_
 
 #include <list>
+#include <memory>
+#include <vector>
 
 #include <packager/media/base/media_handler.h>
 
@@ -16,56 +18,72 @@ namespace media {
 
 class VideoStreamInfo;
 
-/// TrickPlayHandler is a single-input single-output media handler. It takes
-/// the input stream and converts it to a trick play stream by limiting which
-/// samples get passed downstream.
+/// TrickPlayHandler is a single-input multiple-output media handler. It takes
+/// the input stream and converts it to trick play streams by limiting which
+/// samples get passed downstream. There is one output per trick play factor,
+/// so that the key frames of a stream are found once for all its trick play
+/// streams.
 // The stream data in trick play streams are not simple duplicates. Some
 // information get changed (e.g. VideoStreamInfo.trick_play_factor).
 class TrickPlayHandler : public MediaHandler {
  public:
+  /// @param factor is the trick play factor of the only output.
   explicit TrickPlayHandler(uint32_t factor);
+  /// @param factors contains the trick play factor of each output, i.e. the
+  ///        output with index i has trick play factor factors[i].
+  explicit TrickPlayHandler(const std::vector<uint32_t>& factors);
+  ~TrickPlayHandler() override;
 
  private:
   TrickPlayHandler(const TrickPlayHandler&) = delete;
   TrickPlayHandler& operator=(const TrickPlayHandler&) = delete;
 
+  // The state of a trick play stream.
+  struct Output {
+    size_t stream_index = 0;
+    uint32_t factor = 0;
+
+    uint64_t total_trick_frames = 0;
+
+    // We cannot just send video info through as we need to calculate the play
+    // rate using the first two trick play frames. This reference should only
+    // be used to update the play back rate before video info is sent
+    // downstream. After getting sent downstream, this should never be used.
+    std::shared_ptr<VideoStreamInfo> video_info;
+
+    // We need to track the segment that most recently finished so that we can
+    // extend its duration if there are empty segments.
+    std::shared_ptr<SegmentInfo> previous_segment;
+
+    // Since we are dropping frames, the time that those frames would have been
+    // on screen need to be added to the frame before them. Keep a reference to
+    // the most recent trick play frame so that we can grow its duration as we
+    // drop other frames.
+    std::shared_ptr<MediaSample> previous_trick_frame;
+
+    // Since we cannot send messages downstream right away, keep a queue of
+    // messages that need to be sent down. At the start, we use this to queue
+    // messages until we can send out |video_info|. To ensure messages are
+    // kept in order, messages are only dispatched through this queue and never
+    // directly.
+    std::list<std::unique_ptr<StreamData>> delayed_messages;
+  };
+
   Status InitializeInternal() override;
   Status Process(std::unique_ptr<StreamData> stream_data) override;
+  bool ValidateOutputStreamIndex(size_t stream_index) const override;
   Status OnFlushRequest(size_t input_stream_index) override;
 
-  Status OnStreamInfo(const StreamInfo& info);
-  Status OnSegmentInfo(std::shared_ptr<const SegmentInfo> info);
+  Status OnStreamInfo(const StreamInfo& info, Output* output);
+  Status OnSegmentInfo(const SegmentInfo& info, Output* output);
   Status OnMediaSample(const MediaSample& sample);
-  Status OnTrickFrame(const MediaSample& sample);
-
-  const uint32_t factor_;
+  Status OnTrickFrame(const MediaSample& sample, Output* output);
 
+  // Shared by all the outputs.
   uint64_t total_frames_ = 0;
   uint64_t total_key_frames_ = 0;
-  uint64_t total_trick_frames_ = 0;
-
-  // We cannot just send video info through as we need to calculate the play
-  // rate using the first two trick play frames. This reference should only be
-  // used to update the play back rate before video info is sent downstream.
-  // After getting sent downstream, this should never be used.
-  std::shared_ptr<VideoStreamInfo> video_info_;
-
-  // We need to track the segment that most recently finished so that we can
-  // extend its duration if there are empty segments.
-  std::shared_ptr<SegmentInfo> previous_segment_;
-
-  // Since we are dropping frames, the time that those frames would have been
-  // on screen need to be added to the frame before them. Keep a reference to
-  // the most recent trick play frame so that we can grow its duration as we
-  // drop other frames.
-  std::shared_ptr<MediaSample> previous_trick_frame_;
-
-  // Since we cannot send messages downstream right away, keep a queue of
-  // messages that need to be sent down. At the start, we use this to queue
-  // messages until we can send out |video_info_|. To ensure messages are
-  // kept in order, messages are only dispatched through this queue and never
-  // directly.
-  std::list<std::unique_ptr<StreamData>> delayed_messages_;
+
+  std::vector<Output> outputs_;
 };
 
 }  // namespace media
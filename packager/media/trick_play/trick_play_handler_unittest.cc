@@ -300,5 +300,61 @@ TEST_F(TrickPlayHandlerTest, TrickTrackWithSamplesAndSegments) {
   ASSERT_OK(Flush());
 }
 
+// This test makes sure that a trick play handler with multiple trick play
+// factors sends each trick play stream to its own output.
+TEST_F(TrickPlayHandlerTest, MultipleTrickPlayFactors) {
+  const std::vector<uint32_t> kTrickPlayFactors = {1u, 2u};
+  const size_t kFactorOneOutputIndex = 0;
+  const size_t kFactorTwoOutputIndex = 1;
+
+  const int64_t kFrameDuration = 100;
+  const int64_t kFrame0 = 0;
+  const int64_t kFrame2 = 200;
+  const int64_t kFrame4 = 400;
+  const int64_t kFrame6 = 600;
+
+  // Key frame every two frames.
+  const int64_t kFactorOnePlayRate = 2;
+  const int64_t kFactorOneDuration = kFrameDuration * 2;
+  const int64_t kFactorTwoPlayRate = 4;
+  const int64_t kFactorTwoDuration = kFrameDuration * 4;
+
+  ASSERT_OK(MediaHandlerTestBase::SetUpAndInitializeGraph(
+      std::make_shared<TrickPlayHandler>(kTrickPlayFactors), kInputCount,
+      kTrickPlayFactors.size()));
+
+  {
+    testing::InSequence s;
+    EXPECT_CALL(*Output(kFactorOneOutputIndex),
+                OnProcess(IsVideoStream(_, kTrickPlayFactors[0],
+                                        kFactorOnePlayRate)));
+    for (int64_t time : {kFrame0, kFrame2, kFrame4, kFrame6}) {
+      EXPECT_CALL(*Output(kFactorOneOutputIndex),
+                  OnProcess(IsMediaSample(_, time, kFactorOneDuration, _,
+                                          kKeyFrame)));
+    }
+    EXPECT_CALL(*Output(kFactorOneOutputIndex), OnFlush(_));
+  }
+  {
+    testing::InSequence s;
+    EXPECT_CALL(*Output(kFactorTwoOutputIndex),
+                OnProcess(IsVideoStream(_, kTrickPlayFactors[1],
+                                        kFactorTwoPlayRate)));
+    for (int64_t time : {kFrame0, kFrame4}) {
+      EXPECT_CALL(*Output(kFactorTwoOutputIndex),
+                  OnProcess(IsMediaSample(_, time, kFactorTwoDuration, _,
+                                          kKeyFrame)));
+    }
+    EXPECT_CALL(*Output(kFactorTwoOutputIndex), OnFlush(_));
+  }
+
+  ASSERT_OK(DispatchVideoInfo());
+  for (int64_t time = 0; time < 8 * kFrameDuration; time += kFrameDuration) {
+    const bool is_key_frame = time % (2 * kFrameDuration) == 0;
+    ASSERT_OK(DispatchSample(time, kFrameDuration, is_key_frame));
+  }
+  ASSERT_OK(Flush());
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -67,6 +67,18 @@ class MpdBuilder {
   static void MakePathsRelativeToMpd(const std::string& mpd_path,
                                      MediaInfo* media_info);
 
+  /// @return MPD@availabilityStartTime. It is empty until the first dynamic
+  ///         MPD is generated, unless set explicitly.
+  const std::string& availability_start_time() const {
+    return availability_start_time_;
+  }
+
+  /// Set MPD@availabilityStartTime, e.g. when resuming a live session. It is
+  /// computed from the earliest segment otherwise.
+  void set_availability_start_time(const std::string& availability_start_time) {
+    availability_start_time_ = availability_start_time;
+  }
+
   // Inject a |clock| that returns the current time.
   /// This is for testing.
   void InjectClockForTesting(std::unique_ptr<Clock> clock) {
@@ -9,6 +9,7 @@
 
 #include <string>
 
+#include <packager/file/file_deleter.h>
 #include <packager/mpd_params.h>
 
 namespace shaka {
@@ -26,6 +27,8 @@ struct MpdOptions {
   DashProfile dash_profile = DashProfile::kOnDemand;
   MpdType mpd_type = MpdType::kStatic;
   MpdParams mpd_params;
+  // The group of the deletions of the segments which left the live window.
+  FileDeleter::Group* file_deletions = nullptr;
 };
 
 }  // namespace shaka
@@ -13,7 +13,7 @@
 #include <absl/log/log.h>
 #include <absl/strings/str_format.h>
 
-#include <packager/file.h>
+#include <packager/file/file_deleter.h>
 #include <packager/macros/logging.h>
 #include <packager/media/base/muxer_util.h>
 #include <packager/mpd/base/mpd_options.h>
@@ -109,9 +109,8 @@ Representation::Representation(
   mime_type_ = representation.mime_type_;
   codecs_ = representation.codecs_;
 
-  start_number_ = representation.start_number_;
-  for (const SegmentInfo& segment_info : representation.segment_infos_)
-    start_number_ += segment_info.repeat + 1;
+  start_number_ = representation.start_number_ +
+                  representation.segment_timeline_.segment_count();
 }
 
 Representation::~Representation() {}
@@ -196,7 +195,7 @@ void Representation::AddNewSegment(int64_t start_time,
   // segment has been written before updating buffer depth and bandwidth
   // estimator.
   if (!mpd_options_.mpd_params.low_latency_dash_mode) {
-    current_buffer_depth_ += segment_infos_.back().duration;
+    current_buffer_depth_ += segment_timeline_.back().duration;
 
     bandwidth_estimator_.AddBlock(size, static_cast<double>(duration) /
                                             media_info_.reference_time_scale());
@@ -212,7 +211,7 @@ void Representation::UpdateCompletedSegment(int64_t duration, uint64_t size) {
 
   UpdateSegmentInfo(duration);
 
-  current_buffer_depth_ += segment_infos_.back().duration;
+  current_buffer_depth_ += segment_timeline_.back().duration;
 
   bandwidth_estimator_.AddBlock(
       size, static_cast<double>(duration) / media_info_.reference_time_scale());
@@ -307,7 +306,7 @@ std::optional<xml::XmlNode> Representation::GetXml() {
 
   if (HasLiveOnlyFields(media_info_) &&
       !representation.AddLiveOnlyInfo(
-          media_info_, segment_infos_, start_number_,
+          media_info_, segment_timeline_, start_number_,
           mpd_options_.mpd_params.low_latency_dash_mode)) {
     LOG(ERROR) << "Failed to add Live info.";
     return std::nullopt;
@@ -351,24 +350,57 @@ void Representation::SetAvailabilityTimeOffset() {
 bool Representation::GetStartAndEndTimestamps(
     double* start_timestamp_seconds,
     double* end_timestamp_seconds) const {
-  if (segment_infos_.empty())
+  if (segment_timeline_.empty())
     return false;
 
   if (start_timestamp_seconds) {
     *start_timestamp_seconds =
-        static_cast<double>(segment_infos_.begin()->start_time) /
+        static_cast<double>(segment_timeline_.front().start_time) /
         GetTimeScale(media_info_);
   }
   if (end_timestamp_seconds) {
     *end_timestamp_seconds =
-        static_cast<double>(segment_infos_.rbegin()->start_time +
-                            segment_infos_.rbegin()->duration *
-                                (segment_infos_.rbegin()->repeat + 1)) /
+        static_cast<double>(segment_timeline_.end_time()) /
         GetTimeScale(media_info_);
   }
   return true;
 }
 
+void Representation::SaveLiveState(
+    LiveSessionState::RepresentationState* state) const {
+  DCHECK(state);
+  state->Clear();
+  state->set_segment_template(media_info_.segment_template());
+  state->set_start_number(start_number_);
+  state->set_current_buffer_depth(current_buffer_depth_);
+  for (const SegmentInfo& segment_info : segment_timeline_) {
+    LiveSessionState::SegmentTimelineEntry* entry = state->add_segments();
+    entry->set_start_time(segment_info.start_time);
+    entry->set_duration(segment_info.duration);
+    entry->set_repeat(segment_info.repeat);
+  }
+  for (const std::string& segment_name : segments_to_delete_)
+    state->add_segments_to_be_removed(segment_name);
+  for (const std::string& segment_name : segments_to_be_removed_)
+    state->add_segments_to_be_removed(segment_name);
+}
+
+void Representation::RestoreLiveState(
+    const LiveSessionState::RepresentationState& state) {
+  LOG_IF(WARNING, !segment_timeline_.empty())
+      << RepresentationAsString()
+      << " Restoring live state overrides existing segments.";
+  segment_timeline_.clear();
+  for (const auto& entry : state.segments()) {
+    segment_timeline_.push_back(
+        {entry.start_time(), entry.duration(), entry.repeat()});
+  }
+  start_number_ = state.start_number();
+  current_buffer_depth_ = state.current_buffer_depth();
+  segments_to_be_removed_.assign(state.segments_to_be_removed().begin(),
+                                 state.segments_to_be_removed().end());
+}
+
 bool Representation::HasRequiredMediaInfoFields() const {
   if (HasVODOnlyFields(media_info_) && HasLiveOnlyFields(media_info_)) {
     LOG(ERROR) << "MediaInfo cannot have both VOD and Live fields.";
@@ -387,11 +419,10 @@ void Representation::AddSegmentInfo(int64_t start_time, int64_t duration) {
   const uint64_t kNoRepeat = 0;
   const int64_t adjusted_duration = AdjustDuration(duration);
 
-  if (!segment_infos_.empty()) {
+  if (!segment_timeline_.empty()) {
     // Contiguous segment.
-    const SegmentInfo& previous = segment_infos_.back();
-    const int64_t previous_segment_end_time =
-        previous.start_time + previous.duration * (previous.repeat + 1);
+    const SegmentInfo& previous = segment_timeline_.back();
+    const int64_t previous_segment_end_time = segment_timeline_.end_time();
     // Make it continuous if the segment start time is close to previous segment
     // end time.
     if (ApproximiatelyEqual(previous_segment_end_time, start_time)) {
@@ -402,9 +433,9 @@ void Representation::AddSegmentInfo(int64_t start_time, int64_t duration) {
       // is close to calculated segment end time by assuming identical duration.
       if (ApproximiatelyEqual(segment_end_time_for_same_duration,
                               actual_segment_end_time)) {
-        ++segment_infos_.back().repeat;
+        segment_timeline_.RepeatLast();
       } else {
-        segment_infos_.push_back(
+        segment_timeline_.push_back(
             {previous_segment_end_time,
              actual_segment_end_time - previous_segment_end_time, kNoRepeat});
       }
@@ -432,13 +463,13 @@ void Representation::AddSegmentInfo(int64_t start_time, int64_t duration) {
     }
   }
 
-  segment_infos_.push_back({start_time, adjusted_duration, kNoRepeat});
+  segment_timeline_.push_back({start_time, adjusted_duration, kNoRepeat});
 }
 
 void Representation::UpdateSegmentInfo(int64_t duration) {
-  if (!segment_infos_.empty()) {
+  if (!segment_timeline_.empty()) {
     // Update the duration in the current segment.
-    segment_infos_.back().duration = duration;
+    segment_timeline_.SetLastDuration(duration);
   }
 }
 
@@ -489,28 +520,20 @@ void Representation::SlideWindow() {
   if (current_buffer_depth_ <= time_shift_buffer_depth)
     return;
 
-  std::list<SegmentInfo>::iterator first = segment_infos_.begin();
-  std::list<SegmentInfo>::iterator last = first;
-  for (; last != segment_infos_.end(); ++last) {
-    // Remove the current segment only if it falls completely out of time shift
-    // buffer range.
-    while (last->repeat >= 0 &&
-           current_buffer_depth_ - last->duration >= time_shift_buffer_depth) {
-      current_buffer_depth_ -= last->duration;
-      RemoveOldSegment(&*last);
-      start_number_++;
-    }
-    if (last->repeat >= 0)
+  // Remove the first segment only if it falls completely out of time shift
+  // buffer range. Each removal is O(1) on the run-length encoded timeline.
+  while (!segment_timeline_.empty()) {
+    const SegmentInfo& first = segment_timeline_.front();
+    if (current_buffer_depth_ - first.duration < time_shift_buffer_depth)
       break;
+    current_buffer_depth_ -= first.duration;
+    RemoveOldSegment(first.start_time);
+    segment_timeline_.PopFrontSegment();
+    start_number_++;
   }
-  segment_infos_.erase(first, last);
 }
 
-void Representation::RemoveOldSegment(SegmentInfo* segment_info) {
-  int64_t segment_start_time = segment_info->start_time;
-  segment_info->start_time += segment_info->duration;
-  segment_info->repeat--;
-
+void Representation::RemoveOldSegment(int64_t segment_start_time) {
   if (mpd_options_.mpd_params.preserved_segments_outside_live_window == 0)
     return;
 
@@ -519,16 +542,17 @@ void Representation::RemoveOldSegment(SegmentInfo* segment_info) {
                             start_number_ - 1, media_info_.bandwidth()));
   while (segments_to_be_removed_.size() >
          mpd_options_.mpd_params.preserved_segments_outside_live_window) {
-    VLOG(2) << "Deleting " << segments_to_be_removed_.front();
-    if (!File::Delete(segments_to_be_removed_.front().c_str())) {
-      LOG(WARNING) << "Failed to delete " << segments_to_be_removed_.front()
-                   << "; Will retry later.";
-      break;
-    }
+    segments_to_delete_.push_back(std::move(segments_to_be_removed_.front()));
     segments_to_be_removed_.pop_front();
   }
 }
 
+void Representation::DeleteRemovedSegments() {
+  for (const std::string& segment_name : segments_to_delete_)
+    FileDeleter::instance.Delete(segment_name, mpd_options_.file_deletions);
+  segments_to_delete_.clear();
+}
+
 std::string Representation::GetVideoMimeType() const {
   return GetMimeType("video", media_info_.container_type());
 }
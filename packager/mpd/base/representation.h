@@ -13,10 +13,13 @@
 #include <list>
 #include <memory>
 #include <optional>
+#include <vector>
 
 #include <packager/mpd/base/bandwidth_estimator.h>
+#include <packager/mpd/base/live_session_state.pb.h>
 #include <packager/mpd/base/media_info.pb.h>
 #include <packager/mpd/base/segment_info.h>
+#include <packager/mpd/base/segment_timeline.h>
 #include <packager/mpd/base/xml/xml_node.h>
 
 namespace shaka {
@@ -158,6 +161,21 @@ class Representation {
   bool GetStartAndEndTimestamps(double* start_timestamp_seconds,
                                 double* end_timestamp_seconds) const;
 
+  /// Saves the live state of the Representation, i.e. its SegmentTimeline and
+  /// segment numbering, so that it can be resumed after a restart.
+  /// @param state is the output state.
+  void SaveLiveState(LiveSessionState::RepresentationState* state) const;
+
+  /// Restores the live state saved by SaveLiveState(). This should be called
+  /// before any segment is added to the Representation.
+  /// @param state is the previously saved state.
+  void RestoreLiveState(const LiveSessionState::RepresentationState& state);
+
+  /// Schedules the deletion of the segments which have been removed from the
+  /// live window, in the background. This should be called once the MPD
+  /// without these segments has been written.
+  void DeleteRemovedSegments();
+
   /// @return ID number for <Representation>.
   uint32_t id() const { return id_; }
 
@@ -214,12 +232,15 @@ class Representation {
   // is set; otherwise duration is returned without adjustment.
   int64_t AdjustDuration(int64_t duration) const;
 
-  // Remove elements from |segment_infos_| for dynamic live profile. Increments
-  // |start_number_| by the number of segments removed.
+  // Remove segments from |segment_timeline_| for dynamic live profile.
+  // Increments |start_number_| by the number of segments removed.
   void SlideWindow();
 
-  // Remove the first segment in |segment_info|.
-  void RemoveOldSegment(SegmentInfo* segment_info);
+  // Schedule the segment starting at |segment_start_time| for removal. The
+  // actual deletion happens once there are more than
+  // |preserved_segments_outside_live_window| segments scheduled, and the MPD
+  // has been written.
+  void RemoveOldSegment(int64_t segment_start_time);
 
   // Note: Because 'mimeType' is a required field for a valid MPD, these return
   // strings.
@@ -237,10 +258,12 @@ class Representation {
 
   int64_t current_buffer_depth_ = 0;
   // TODO(kqyang): Address sliding window issue with multiple periods.
-  std::list<SegmentInfo> segment_infos_;
+  SegmentTimeline segment_timeline_;
   // A list to hold the file names of the segments to be removed temporarily.
   // Once a file is actually removed, it is removed from the list.
   std::list<std::string> segments_to_be_removed_;
+  // Segments to delete once the MPD without them has been written.
+  std::vector<std::string> segments_to_delete_;
 
   const uint32_t id_;
   std::string mime_type_;
@@ -17,6 +17,7 @@
 
 #include <packager/file.h>
 #include <packager/file/file_closer.h>
+#include <packager/file/file_deleter.h>
 #include <packager/flag_saver.h>
 #include <packager/mpd/base/mpd_options.h>
 #include <packager/mpd/test/mpd_builder_test_helper.h>
@@ -595,6 +596,38 @@ TEST_F(SegmentTemplateTest, RepresentationClone) {
   EXPECT_THAT(cloned_representation->GetXml(), XmlNodeEqual(kExpectedXml));
 }
 
+TEST_F(SegmentTemplateTest, SaveAndRestoreLiveState) {
+  const int64_t kStartTime = 0;
+  const int64_t kDuration = 10;
+  const uint64_t kSize = 128;
+  AddSegments(kStartTime, kDuration, kSize, 2);
+  AddSegments(kStartTime + 3 * kDuration, 2 * kDuration, kSize, 0);
+
+  LiveSessionState::RepresentationState state;
+  representation_->SaveLiveState(&state);
+  EXPECT_EQ(2, state.segments_size());
+  EXPECT_EQ(1u, state.start_number());
+
+  auto restored_representation =
+      CreateRepresentation(ConvertToMediaInfo(GetDefaultMediaInfo()),
+                           kAnyRepresentationId, NoListener());
+  ASSERT_TRUE(restored_representation->Init());
+  restored_representation->RestoreLiveState(state);
+
+  LiveSessionState::RepresentationState restored_state;
+  restored_representation->SaveLiveState(&restored_state);
+  EXPECT_EQ(state.SerializeAsString(), restored_state.SerializeAsString());
+
+  double start_time_seconds;
+  double end_time_seconds;
+  ASSERT_TRUE(restored_representation->GetStartAndEndTimestamps(
+      &start_time_seconds, &end_time_seconds));
+  EXPECT_EQ(static_cast<double>(kStartTime) / kDefaultTimeScale,
+            start_time_seconds);
+  EXPECT_EQ(static_cast<double>(kStartTime + 5 * kDuration) / kDefaultTimeScale,
+            end_time_seconds);
+}
+
 TEST_F(SegmentTemplateTest, PresentationTimeOffset) {
   const int64_t kStartTime = 0;
   const int64_t kDuration = 10;
@@ -1343,6 +1376,12 @@ class RepresentationDeleteSegmentsTest : public SegmentTimelineTestBase {
         File::Open(segment_name.c_str(), "r"));
     return file_closer.get() == nullptr;
   }
+
+  // Segments are deleted in the background, after the MPD is written.
+  void DeleteRemovedSegmentsAndWait() {
+    representation_->DeleteRemovedSegments();
+    FileDeleter::instance.Flush();
+  }
 };
 
 // Verify that no segments are deleted initially until there are more than
@@ -1351,6 +1390,7 @@ TEST_F(RepresentationDeleteSegmentsTest, NoSegmentsDeletedInitially) {
   for (int i = 0; i < kMaxNumSegmentsAvailable; ++i) {
     AddSegments(kInitialStartTime + i * kDuration, kDuration, kSize, kNoRepeat);
   }
+  DeleteRemovedSegmentsAndWait();
   for (int i = 0; i < kMaxNumSegmentsAvailable; ++i) {
     EXPECT_FALSE(SegmentDeleted(absl::StrFormat(kStringPrintTemplate, i + 1)));
   }
@@ -1360,10 +1400,22 @@ TEST_F(RepresentationDeleteSegmentsTest, OneSegmentDeleted) {
   for (int i = 0; i <= kMaxNumSegmentsAvailable; ++i) {
     AddSegments(kInitialStartTime + i * kDuration, kDuration, kSize, kNoRepeat);
   }
+  DeleteRemovedSegmentsAndWait();
   EXPECT_FALSE(SegmentDeleted(absl::StrFormat(kStringPrintTemplate, 2)));
   EXPECT_TRUE(SegmentDeleted(absl::StrFormat(kStringPrintTemplate, 1)));
 }
 
+TEST_F(RepresentationDeleteSegmentsTest, NoSegmentsDeletedBeforeMpdIsWritten) {
+  for (int i = 0; i <= kMaxNumSegmentsAvailable; ++i) {
+    AddSegments(kInitialStartTime + i * kDuration, kDuration, kSize, kNoRepeat);
+  }
+  FileDeleter::instance.Flush();
+  EXPECT_FALSE(SegmentDeleted(absl::StrFormat(kStringPrintTemplate, 1)));
+
+  DeleteRemovedSegmentsAndWait();
+  EXPECT_TRUE(SegmentDeleted(absl::StrFormat(kStringPrintTemplate, 1)));
+}
+
 // Verify that segments are deleted as expected with many non-repeating
 // segments.
 TEST_F(RepresentationDeleteSegmentsTest, ManyNonRepeatingSegments) {
@@ -1371,6 +1423,7 @@ TEST_F(RepresentationDeleteSegmentsTest, ManyNonRepeatingSegments) {
   for (int i = 0; i < many_segments; ++i) {
     AddSegments(kInitialStartTime + i * kDuration, kDuration, kSize, kNoRepeat);
   }
+  DeleteRemovedSegmentsAndWait();
   const int last_available_segment_index =
       many_segments - kMaxNumSegmentsAvailable + 1;
   EXPECT_FALSE(SegmentDeleted(
@@ -1387,6 +1440,7 @@ TEST_F(RepresentationDeleteSegmentsTest, ManyRepeatingSegments) {
     AddSegments(kInitialStartTime + i * kDuration * (kRepeat + 1), kDuration,
                 kSize, kRepeat);
   }
+  DeleteRemovedSegmentsAndWait();
   const int kNumSegments = kLoops * (kRepeat + 1);
   const int last_available_segment_index =
       kNumSegments - kMaxNumSegmentsAvailable + 1;
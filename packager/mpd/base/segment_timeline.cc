@@ -0,0 +1,103 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/mpd/base/segment_timeline.h>
+
+#include <utility>
+
+#include <absl/log/check.h>
+
+namespace shaka {
+namespace {
+
+const size_t kInitialCapacity = 8;
+
+// Formats |value| the way XmlNode::SetIntegerAttribute does.
+std::string FormatAttribute(int64_t value) {
+  return std::to_string(static_cast<uint64_t>(value));
+}
+
+std::string FormatRepeat(int64_t repeat) {
+  return repeat > 0 ? FormatAttribute(repeat) : std::string();
+}
+
+}  // namespace
+
+SegmentTimeline::SegmentTimeline() : buffer_(kInitialCapacity) {}
+
+SegmentTimeline::SegmentTimeline(
+    std::initializer_list<SegmentInfo> segment_infos)
+    : SegmentTimeline() {
+  for (const SegmentInfo& segment_info : segment_infos)
+    push_back(segment_info);
+}
+
+SegmentTimeline::~SegmentTimeline() {}
+
+void SegmentTimeline::push_back(const SegmentInfo& segment_info) {
+  DCHECK_GE(segment_info.repeat, 0);
+  if (size_ == buffer_.size())
+    Grow();
+  Entry& entry = mutable_entry_at(size_);
+  entry.segment_info = segment_info;
+  entry.attributes.t = FormatAttribute(segment_info.start_time);
+  entry.attributes.d = FormatAttribute(segment_info.duration);
+  entry.attributes.r = FormatRepeat(segment_info.repeat);
+  ++size_;
+  segment_count_ += segment_info.repeat + 1;
+}
+
+void SegmentTimeline::RepeatLast() {
+  DCHECK(!empty());
+  Entry& last = mutable_entry_at(size_ - 1);
+  ++last.segment_info.repeat;
+  last.attributes.r = FormatRepeat(last.segment_info.repeat);
+  ++segment_count_;
+}
+
+void SegmentTimeline::SetLastDuration(int64_t duration) {
+  DCHECK(!empty());
+  Entry& last = mutable_entry_at(size_ - 1);
+  last.segment_info.duration = duration;
+  last.attributes.d = FormatAttribute(duration);
+}
+
+void SegmentTimeline::PopFrontSegment() {
+  DCHECK(!empty());
+  Entry& first = mutable_entry_at(0);
+  --segment_count_;
+  if (first.segment_info.repeat > 0) {
+    first.segment_info.start_time += first.segment_info.duration;
+    --first.segment_info.repeat;
+    first.attributes.t = FormatAttribute(first.segment_info.start_time);
+    first.attributes.r = FormatRepeat(first.segment_info.repeat);
+    return;
+  }
+  head_ = (head_ + 1) & (buffer_.size() - 1);
+  --size_;
+}
+
+void SegmentTimeline::clear() {
+  head_ = 0;
+  size_ = 0;
+  segment_count_ = 0;
+}
+
+int64_t SegmentTimeline::end_time() const {
+  DCHECK(!empty());
+  const SegmentInfo& last = back();
+  return last.start_time + last.duration * (last.repeat + 1);
+}
+
+void SegmentTimeline::Grow() {
+  std::vector<Entry> buffer(buffer_.size() * 2);
+  for (size_t i = 0; i < size_; ++i)
+    buffer[i] = std::move(mutable_entry_at(i));
+  buffer_.swap(buffer);
+  head_ = 0;
+}
+
+}  // namespace shaka
@@ -0,0 +1,142 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MPD_BASE_SEGMENT_TIMELINE_H_
+#define PACKAGER_MPD_BASE_SEGMENT_TIMELINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <packager/mpd/base/segment_info.h>
+
+namespace shaka {
+
+/// Run-length encoded list of segments, i.e. the S@t, S@d and S@r triplets of
+/// a SegmentTimeline. The entries are kept in a ring buffer so that appending
+/// a segment at the live edge and trimming a segment off the start of the
+/// window are both O(1), and the total number of segments is maintained
+/// incrementally instead of being re-derived from the entries. The attribute
+/// values of each entry are formatted when the entry changes, so writing the
+/// MPD does not format the whole window again.
+class SegmentTimeline {
+ public:
+  /// The S@t, S@d and S@r attribute values of an entry.
+  struct Attributes {
+    std::string t;
+    std::string d;
+    /// Empty if the entry does not repeat, in which case S@r is omitted.
+    std::string r;
+  };
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = SegmentInfo;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const SegmentInfo*;
+    using reference = const SegmentInfo&;
+
+    const_iterator(const SegmentTimeline* timeline, size_t index)
+        : timeline_(timeline), index_(index) {}
+
+    reference operator*() const { return timeline_->at(index_); }
+    pointer operator->() const { return &timeline_->at(index_); }
+    const_iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator copy = *this;
+      ++index_;
+      return copy;
+    }
+    bool operator==(const const_iterator& other) const {
+      return timeline_ == other.timeline_ && index_ == other.index_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    const SegmentTimeline* timeline_;
+    size_t index_;
+  };
+
+  SegmentTimeline();
+  SegmentTimeline(std::initializer_list<SegmentInfo> segment_infos);
+  ~SegmentTimeline();
+
+  /// Appends a new entry at the end of the timeline.
+  void push_back(const SegmentInfo& segment_info);
+
+  /// Extends the last entry by one segment of the same duration, i.e.
+  /// increments its S@r. The timeline must not be empty.
+  void RepeatLast();
+
+  /// Updates the duration of the last entry. The timeline must not be empty.
+  void SetLastDuration(int64_t duration);
+
+  /// Removes the first segment from the timeline. If the first entry repeats,
+  /// the entry is shortened in place; otherwise it is dropped. The timeline
+  /// must not be empty.
+  void PopFrontSegment();
+
+  void clear();
+
+  /// @return true if there are no entries.
+  bool empty() const { return size_ == 0; }
+  /// @return the number of (run-length encoded) entries.
+  size_t size() const { return size_; }
+  /// @return the number of segments, i.e. the sum of S@r + 1 of all entries.
+  uint64_t segment_count() const { return segment_count_; }
+  /// @return the end time of the last segment. The timeline must not be empty.
+  int64_t end_time() const;
+
+  const SegmentInfo& front() const { return at(0); }
+  const SegmentInfo& back() const { return at(size_ - 1); }
+  /// @return the entry at @a index, starting from the oldest entry.
+  const SegmentInfo& at(size_t index) const {
+    return entry_at(index).segment_info;
+  }
+  /// @return the attribute values of the entry at @a index.
+  const Attributes& attributes_at(size_t index) const {
+    return entry_at(index).attributes;
+  }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+
+ private:
+  struct Entry {
+    SegmentInfo segment_info;
+    Attributes attributes;
+  };
+
+  const Entry& entry_at(size_t index) const {
+    return buffer_[(head_ + index) & (buffer_.size() - 1)];
+  }
+  Entry& mutable_entry_at(size_t index) {
+    return buffer_[(head_ + index) & (buffer_.size() - 1)];
+  }
+  // Doubles the capacity of |buffer_|, moving the entries so that the oldest
+  // entry is at index 0.
+  void Grow();
+
+  // Ring buffer storage. The capacity is always a power of two so that
+  // wrapping around is a mask operation.
+  std::vector<Entry> buffer_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+  uint64_t segment_count_ = 0;
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_MPD_BASE_SEGMENT_TIMELINE_H_
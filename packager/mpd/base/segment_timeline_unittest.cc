@@ -0,0 +1,127 @@
+// Copyright 2026 Google LLC. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <packager/mpd/base/segment_timeline.h>
+
+#include <gtest/gtest.h>
+
+namespace shaka {
+
+namespace {
+const int64_t kDuration = 100;
+}  // namespace
+
+TEST(SegmentTimelineTest, Empty) {
+  SegmentTimeline timeline;
+  EXPECT_TRUE(timeline.empty());
+  EXPECT_EQ(0u, timeline.size());
+  EXPECT_EQ(0u, timeline.segment_count());
+  EXPECT_TRUE(timeline.begin() == timeline.end());
+}
+
+TEST(SegmentTimelineTest, RepeatLast) {
+  SegmentTimeline timeline;
+  timeline.push_back({0, kDuration, 0});
+  timeline.RepeatLast();
+  timeline.RepeatLast();
+
+  ASSERT_EQ(1u, timeline.size());
+  EXPECT_EQ(3u, timeline.segment_count());
+  EXPECT_EQ(2, timeline.back().repeat);
+  EXPECT_EQ(3 * kDuration, timeline.end_time());
+}
+
+TEST(SegmentTimelineTest, PopFrontSegment) {
+  SegmentTimeline timeline = {
+      {0, kDuration, 1},
+      {2 * kDuration, 2 * kDuration, 0},
+  };
+  EXPECT_EQ(3u, timeline.segment_count());
+
+  timeline.PopFrontSegment();
+  ASSERT_EQ(2u, timeline.size());
+  EXPECT_EQ(kDuration, timeline.front().start_time);
+  EXPECT_EQ(0, timeline.front().repeat);
+  EXPECT_EQ(2u, timeline.segment_count());
+
+  timeline.PopFrontSegment();
+  ASSERT_EQ(1u, timeline.size());
+  EXPECT_EQ(2 * kDuration, timeline.front().start_time);
+  EXPECT_EQ(2 * kDuration, timeline.front().duration);
+
+  timeline.PopFrontSegment();
+  EXPECT_TRUE(timeline.empty());
+  EXPECT_EQ(0u, timeline.segment_count());
+}
+
+// Appending and trimming continuously should wrap around the ring buffer and
+// grow it without reordering the entries.
+TEST(SegmentTimelineTest, SlidingWindowWrapsAround) {
+  const int kWindowSize = 5;
+  const int kNumSegments = 100;
+
+  SegmentTimeline timeline;
+  for (int i = 0; i < kNumSegments; ++i) {
+    // Alternate durations so that every segment is its own entry.
+    const int64_t duration = kDuration + i % 2;
+    const int64_t start_time = timeline.empty() ? 0 : timeline.end_time();
+    timeline.push_back({start_time, duration, 0});
+    if (timeline.size() > kWindowSize)
+      timeline.PopFrontSegment();
+  }
+
+  ASSERT_EQ(static_cast<size_t>(kWindowSize), timeline.size());
+  int64_t expected_start_time = timeline.front().start_time;
+  for (const SegmentInfo& segment_info : timeline) {
+    EXPECT_EQ(expected_start_time, segment_info.start_time);
+    expected_start_time += segment_info.duration;
+  }
+  EXPECT_EQ(expected_start_time, timeline.end_time());
+
+  // Grow while the ring buffer is wrapped around.
+  for (int i = 0; i < kNumSegments; ++i) {
+    timeline.push_back({timeline.end_time(), kDuration + i % 2, 0});
+  }
+  EXPECT_EQ(static_cast<size_t>(kWindowSize + kNumSegments), timeline.size());
+  expected_start_time = timeline.front().start_time;
+  for (const SegmentInfo& segment_info : timeline) {
+    EXPECT_EQ(expected_start_time, segment_info.start_time);
+    expected_start_time += segment_info.duration;
+  }
+}
+
+TEST(SegmentTimelineTest, SetLastDuration) {
+  SegmentTimeline timeline = {{0, kDuration, 0}};
+  timeline.SetLastDuration(2 * kDuration);
+  EXPECT_EQ(2 * kDuration, timeline.back().duration);
+  EXPECT_EQ(2 * kDuration, timeline.end_time());
+}
+
+// The attribute values follow the updates of the entries.
+TEST(SegmentTimelineTest, Attributes) {
+  SegmentTimeline timeline = {{0, kDuration, 0}};
+  EXPECT_EQ("0", timeline.attributes_at(0).t);
+  EXPECT_EQ("100", timeline.attributes_at(0).d);
+  EXPECT_EQ("", timeline.attributes_at(0).r);
+
+  timeline.RepeatLast();
+  timeline.RepeatLast();
+  EXPECT_EQ("2", timeline.attributes_at(0).r);
+
+  timeline.push_back({3 * kDuration, kDuration, 0});
+  timeline.SetLastDuration(2 * kDuration);
+  EXPECT_EQ("300", timeline.attributes_at(1).t);
+  EXPECT_EQ("200", timeline.attributes_at(1).d);
+
+  timeline.PopFrontSegment();
+  EXPECT_EQ("100", timeline.attributes_at(0).t);
+  EXPECT_EQ("1", timeline.attributes_at(0).r);
+  timeline.PopFrontSegment();
+  EXPECT_EQ("200", timeline.attributes_at(0).t);
+  EXPECT_EQ("", timeline.attributes_at(0).r);
+}
+
+}  // namespace shaka
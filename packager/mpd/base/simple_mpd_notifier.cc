@@ -6,9 +6,12 @@
 
 #include <packager/mpd/base/simple_mpd_notifier.h>
 
+#include <algorithm>
+
 #include <absl/log/check.h>
 #include <absl/log/log.h>
 
+#include <packager/file.h>
 #include <packager/mpd/base/adaptation_set.h>
 #include <packager/mpd/base/mpd_builder.h>
 #include <packager/mpd/base/mpd_notifier_util.h>
@@ -21,6 +24,9 @@ namespace shaka {
 SimpleMpdNotifier::SimpleMpdNotifier(const MpdOptions& mpd_options)
     : MpdNotifier(mpd_options),
       output_path_(mpd_options.mpd_params.mpd_output),
+      live_state_path_(mpd_options.mpd_type == MpdType::kDynamic
+                           ? mpd_options.mpd_params.live_state_file
+                           : ""),
       mpd_builder_(new MpdBuilder(mpd_options)),
       content_protection_in_adaptation_set_(
           mpd_options.mpd_params.generate_dash_if_iop_compliant_mpd) {
@@ -31,6 +37,39 @@ SimpleMpdNotifier::SimpleMpdNotifier(const MpdOptions& mpd_options)
 SimpleMpdNotifier::~SimpleMpdNotifier() {}
 
 bool SimpleMpdNotifier::Init() {
+  if (live_state_path_.empty())
+    return true;
+
+  std::string serialized_state;
+  if (!File::ReadFileToString(live_state_path_.c_str(), &serialized_state)) {
+    // Not an error: there is nothing to resume from on the first run.
+    VLOG(1) << "No live state found at " << live_state_path_;
+    return true;
+  }
+  LiveSessionState state;
+  if (!state.ParseFromString(serialized_state)) {
+    LOG(ERROR) << "Failed to parse live state " << live_state_path_;
+    return false;
+  }
+
+  absl::MutexLock lock(&lock_);
+  if (state.has_availability_start_time())
+    mpd_builder_->set_availability_start_time(state.availability_start_time());
+  for (const auto& representation_state : state.representations()) {
+    saved_representation_states_[representation_state.segment_template()] =
+        representation_state;
+    // The segments before the timeline have been removed from the live
+    // window; |start_number| is the number of the first one in the timeline.
+    uint32_t num_segments =
+        std::max(representation_state.start_number(), 1u) - 1;
+    for (const auto& entry : representation_state.segments())
+      num_segments += entry.repeat() + 1;
+    num_previous_segments_[representation_state.segment_template()] =
+        num_segments;
+  }
+  LOG(INFO) << "Resuming live session with "
+            << saved_representation_states_.size()
+            << " Representation(s) from " << live_state_path_;
   return true;
 }
 
@@ -69,6 +108,7 @@ bool SimpleMpdNotifier::NotifyNewContainer(const MediaInfo& media_info,
     AddContentProtectionElements(media_info, representation);
   }
   representation_map_[representation->id()] = representation;
+  RestoreLiveState(representation);
   return true;
 }
 
@@ -219,7 +259,43 @@ bool SimpleMpdNotifier::NotifyMediaInfoUpdate(uint32_t container_id,
 
 bool SimpleMpdNotifier::Flush() {
   absl::MutexLock lock(&lock_);
-  return WriteMpdToFile(output_path_, mpd_builder_.get());
+  if (!WriteMpdToFile(output_path_, mpd_builder_.get()))
+    return false;
+  for (const auto& entry : representation_map_)
+    entry.second->DeleteRemovedSegments();
+  // The state is written after the MPD so that it never refers to segments
+  // that have not been published yet.
+  return live_state_path_.empty() || WriteLiveState();
+}
+
+void SimpleMpdNotifier::RestoreLiveState(Representation* representation) {
+  if (saved_representation_states_.empty())
+    return;
+  auto it = saved_representation_states_.find(
+      representation->GetMediaInfo().segment_template());
+  if (it == saved_representation_states_.end())
+    return;
+  representation->RestoreLiveState(it->second);
+  saved_representation_states_.erase(it);
+}
+
+bool SimpleMpdNotifier::WriteLiveState() {
+  LiveSessionState state;
+  state.set_availability_start_time(mpd_builder_->availability_start_time());
+  for (const auto& entry : representation_map_)
+    entry.second->SaveLiveState(state.add_representations());
+
+  // Flush() is also called for changes which do not affect the state, e.g.
+  // new content protection, so only write it when it has changed.
+  std::string serialized_state = state.SerializeAsString();
+  if (serialized_state == written_live_state_)
+    return true;
+  if (!File::WriteFileAtomically(live_state_path_.c_str(), serialized_state)) {
+    LOG(ERROR) << "Failed to write live state to: " << live_state_path_;
+    return false;
+  }
+  written_live_state_ = std::move(serialized_state);
+  return true;
 }
 
 }  // namespace shaka
@@ -14,6 +14,7 @@
 
 #include <absl/synchronization/mutex.h>
 
+#include <packager/mpd/base/live_session_state.pb.h>
 #include <packager/mpd/base/mpd_notifier.h>
 #include <packager/mpd/base/mpd_notifier_util.h>
 
@@ -58,6 +59,14 @@ class SimpleMpdNotifier : public MpdNotifier {
   bool Flush() override;
   /// @}
 
+  /// @return the number of segments generated for each segment template by
+  ///         the live session resumed in Init(), see
+  ///         MuxerOptions::num_previous_segments. Empty if no session is
+  ///         resumed.
+  const std::map<std::string, uint32_t>& num_previous_segments() const {
+    return num_previous_segments_;
+  }
+
  private:
   SimpleMpdNotifier(const SimpleMpdNotifier&) = delete;
   SimpleMpdNotifier& operator=(const SimpleMpdNotifier&) = delete;
@@ -72,8 +81,22 @@ class SimpleMpdNotifier : public MpdNotifier {
     mpd_builder_ = std::move(mpd_builder);
   }
 
+  // Restores the saved live state matching |representation|, if any.
+  void RestoreLiveState(Representation* representation);
+  // Writes the live state of all the Representations to |live_state_path_|.
+  bool WriteLiveState();
+
   // MPD output path.
   std::string output_path_;
+  // Live session checkpoint path. Empty if live state is not persisted.
+  std::string live_state_path_;
+  // Last live state written to |live_state_path_|, serialized.
+  std::string written_live_state_;
+  // Live state loaded in Init(), keyed by segment template.
+  std::map<std::string, LiveSessionState::RepresentationState>
+      saved_representation_states_;
+  // Number of segments of the resumed session, keyed by segment template.
+  std::map<std::string, uint32_t> num_previous_segments_;
   std::unique_ptr<MpdBuilder> mpd_builder_;
   bool content_protection_in_adaptation_set_ = true;
   absl::Mutex lock_;
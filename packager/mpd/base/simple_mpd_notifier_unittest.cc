@@ -381,6 +381,73 @@ TEST_F(SimpleMpdNotifierTest,
       container_id, "myuuid", std::vector<uint8_t>(), kBogusNewPsshVector));
 }
 
+// Verify that the segment numbering of a live session is resumed from the
+// live state file after a restart, including the segments which have been
+// removed from the live window.
+TEST_F(SimpleMpdNotifierTest, RestartContinuesSegmentNumbering) {
+  TempFile live_state_file;
+  MpdOptions mpd_options = empty_mpd_option_;
+  mpd_options.mpd_type = MpdType::kDynamic;
+  mpd_options.mpd_params.live_state_file = live_state_file.path();
+  mpd_options.mpd_params.time_shift_buffer_depth = 2.0;
+
+  MediaInfo media_info = valid_media_info1_;
+  const char kSegmentTemplate[] = "segment-$Number$.m4s";
+  media_info.set_init_segment_name("init.mp4");
+  media_info.set_segment_template(kSegmentTemplate);
+
+  const int64_t kSegmentDuration = 10;
+  const uint64_t kSegmentSize = 1000u;
+  int64_t start_time = 0;
+  auto add_segments = [&](SimpleMpdNotifier* notifier, int num_segments) {
+    uint32_t container_id;
+    ASSERT_TRUE(notifier->NotifyNewContainer(media_info, &container_id));
+    for (int i = 0; i < num_segments; ++i) {
+      ASSERT_TRUE(notifier->NotifyNewSegment(container_id, start_time,
+                                             kSegmentDuration, kSegmentSize));
+      start_time += kSegmentDuration;
+      ASSERT_TRUE(notifier->Flush());
+    }
+  };
+
+  {
+    SimpleMpdNotifier notifier(mpd_options);
+    ASSERT_TRUE(notifier.Init());
+    EXPECT_TRUE(notifier.num_previous_segments().empty());
+    ASSERT_NO_FATAL_FAILURE(add_segments(&notifier, 5));
+
+    // The state is not written again if it has not changed.
+    std::string live_state;
+    ASSERT_TRUE(File::ReadFileToString(live_state_file.path().c_str(),
+                                       &live_state));
+    ASSERT_TRUE(File::Delete(live_state_file.path().c_str()));
+    ASSERT_TRUE(notifier.Flush());
+    std::string rewritten_live_state;
+    EXPECT_FALSE(File::ReadFileToString(live_state_file.path().c_str(),
+                                        &rewritten_live_state));
+    ASSERT_TRUE(File::WriteStringToFile(live_state_file.path().c_str(),
+                                        live_state));
+  }
+  {
+    SimpleMpdNotifier notifier(mpd_options);
+    ASSERT_TRUE(notifier.Init());
+    EXPECT_EQ((std::map<std::string, uint32_t>{{kSegmentTemplate, 5}}),
+              notifier.num_previous_segments());
+    // The MPD continues after the 5 segments of the first run.
+    ASSERT_NO_FATAL_FAILURE(add_segments(&notifier, 1));
+    std::string mpd;
+    ASSERT_TRUE(File::ReadFileToString(
+        mpd_options.mpd_params.mpd_output.c_str(), &mpd));
+    EXPECT_THAT(mpd, ::testing::HasSubstr("startNumber=\"4\""));
+  }
+  {
+    SimpleMpdNotifier notifier(mpd_options);
+    ASSERT_TRUE(notifier.Init());
+    EXPECT_EQ((std::map<std::string, uint32_t>{{kSegmentTemplate, 6}}),
+              notifier.num_previous_segments());
+  }
+}
+
 // Test multiple media info with some belongs to the same AdaptationSets.
 TEST_F(SimpleMpdNotifierTest, MultipleMediaInfo) {
   SimpleMpdNotifier notifier(empty_mpd_option_);
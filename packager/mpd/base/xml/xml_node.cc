@@ -25,6 +25,7 @@
 #include <packager/mpd/base/media_info.pb.h>
 #include <packager/mpd/base/mpd_utils.h>
 #include <packager/mpd/base/segment_info.h>
+#include <packager/mpd/base/segment_timeline.h>
 #include <packager/mpd/base/xml/scoped_xml_ptr.h>
 
 ABSL_FLAG(bool,
@@ -59,7 +60,7 @@ std::string RangeToString(const Range& range) {
 
 // Check if segments are continuous and all segments except the last one are of
 // the same duration.
-bool IsTimelineConstantDuration(const std::list<SegmentInfo>& segment_infos,
+bool IsTimelineConstantDuration(const SegmentTimeline& segment_infos,
                                 uint32_t start_number) {
   if (!absl::GetFlag(FLAGS_segment_template_constant_duration))
     return false;
@@ -85,14 +86,17 @@ bool IsTimelineConstantDuration(const std::list<SegmentInfo>& segment_infos,
   return expected_last_segment_start_time == last_segment.start_time;
 }
 
-bool PopulateSegmentTimeline(const std::list<SegmentInfo>& segment_infos,
+bool PopulateSegmentTimeline(const SegmentTimeline& segment_infos,
                              XmlNode* segment_timeline) {
-  for (const SegmentInfo& segment_info : segment_infos) {
+  for (size_t i = 0; i < segment_infos.size(); ++i) {
+    // The attribute values are formatted as the timeline is updated.
+    const SegmentTimeline::Attributes& attributes =
+        segment_infos.attributes_at(i);
     XmlNode s_element("S");
-    RCHECK(s_element.SetIntegerAttribute("t", segment_info.start_time));
-    RCHECK(s_element.SetIntegerAttribute("d", segment_info.duration));
-    if (segment_info.repeat > 0)
-      RCHECK(s_element.SetIntegerAttribute("r", segment_info.repeat));
+    RCHECK(s_element.SetStringAttribute("t", attributes.t));
+    RCHECK(s_element.SetStringAttribute("d", attributes.d));
+    if (!attributes.r.empty())
+      RCHECK(s_element.SetStringAttribute("r", attributes.r));
 
     RCHECK(segment_timeline->AddChild(std::move(s_element)));
   }
@@ -474,7 +478,7 @@ bool RepresentationXmlNode::AddVODOnlyInfo(const MediaInfo& media_info,
 
 bool RepresentationXmlNode::AddLiveOnlyInfo(
     const MediaInfo& media_info,
-    const std::list<SegmentInfo>& segment_infos,
+    const SegmentTimeline& segment_infos,
     uint32_t start_number,
     bool low_latency_dash_mode) {
   XmlNode segment_template("SegmentTemplate");
@@ -521,9 +525,8 @@ bool RepresentationXmlNode::AddLiveOnlyInfo(
       RCHECK(segment_template.SetIntegerAttribute(
           "duration", segment_infos.front().duration));
       if (absl::GetFlag(FLAGS_dash_add_last_segment_number_when_needed)) {
-        uint32_t last_segment_number = start_number - 1;
-        for (const auto& segment_info_element : segment_infos)
-          last_segment_number += segment_info_element.repeat + 1;
+        const uint32_t last_segment_number =
+            start_number - 1 + segment_infos.segment_count();
 
         RCHECK(AddSupplementalProperty(
             "http://dashif.org/guidelines/last-segment-number",
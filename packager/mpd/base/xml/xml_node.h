@@ -25,7 +25,7 @@ typedef struct _xmlNode xmlNode;
 namespace shaka {
 
 class MpdBuilder;
-struct SegmentInfo;
+class SegmentTimeline;
 
 namespace xml {
 class XmlNode;
@@ -219,7 +219,7 @@ class RepresentationXmlNode : public RepresentationBaseXmlNode {
   ///        SegmentInfos are sorted by its start time.
   [[nodiscard]] bool AddLiveOnlyInfo(
       const MediaInfo& media_info,
-      const std::list<SegmentInfo>& segment_infos,
+      const SegmentTimeline& segment_infos,
       uint32_t start_number,
       bool low_latency_dash_mode);
 
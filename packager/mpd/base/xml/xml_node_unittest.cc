@@ -17,6 +17,7 @@
 
 #include <packager/flag_saver.h>
 #include <packager/mpd/base/segment_info.h>
+#include <packager/mpd/base/segment_timeline.h>
 #include <packager/mpd/test/mpd_builder_test_helper.h>
 #include <packager/mpd/test/xml_compare.h>
 
@@ -376,7 +377,7 @@ TEST_F(LiveSegmentTimelineTest, OneSegmentInfo) {
   const uint64_t kRepeat = 9;
   const bool kIsLowLatency = false;
 
-  std::list<SegmentInfo> segment_infos = {
+  SegmentTimeline segment_infos = {
       {kStartTime, kDuration, kRepeat},
   };
   RepresentationXmlNode representation;
@@ -398,7 +399,7 @@ TEST_F(LiveSegmentTimelineTest, OneSegmentInfoNonZeroStartTime) {
   const uint64_t kRepeat = 9;
   const bool kIsLowLatency = false;
 
-  std::list<SegmentInfo> segment_infos = {
+  SegmentTimeline segment_infos = {
       {kNonZeroStartTime, kDuration, kRepeat},
   };
   RepresentationXmlNode representation;
@@ -423,7 +424,7 @@ TEST_F(LiveSegmentTimelineTest, OneSegmentInfoMatchingStartTimeAndNumber) {
   const uint64_t kRepeat = 9;
   const bool kIsLowLatency = false;
 
-  std::list<SegmentInfo> segment_infos = {
+  SegmentTimeline segment_infos = {
       {kNonZeroStartTime, kDuration, kRepeat},
   };
   RepresentationXmlNode representation;
@@ -450,7 +451,7 @@ TEST_F(LiveSegmentTimelineTest, AllSegmentsSameDurationExpectLastOne) {
   const int64_t kDuration2 = 200;
   const uint64_t kRepeat2 = 0;
 
-  std::list<SegmentInfo> segment_infos = {
+  SegmentTimeline segment_infos = {
       {kStartTime1, kDuration1, kRepeat1},
       {kStartTime2, kDuration2, kRepeat2},
   };
@@ -478,7 +479,7 @@ TEST_F(LiveSegmentTimelineTest, SecondSegmentInfoNonZeroRepeat) {
   const int64_t kDuration2 = 200;
   const uint64_t kRepeat2 = 1;
 
-  std::list<SegmentInfo> segment_infos = {
+  SegmentTimeline segment_infos = {
       {kStartTime1, kDuration1, kRepeat1},
       {kStartTime2, kDuration2, kRepeat2},
   };
@@ -511,7 +512,7 @@ TEST_F(LiveSegmentTimelineTest, TwoSegmentInfoWithGap) {
   const int64_t kDuration2 = 200;
   const uint64_t kRepeat2 = 0;
 
-  std::list<SegmentInfo> segment_infos = {
+  SegmentTimeline segment_infos = {
       {kStartTime1, kDuration1, kRepeat1},
       {kStartTime2, kDuration2, kRepeat2},
   };
@@ -538,7 +539,7 @@ TEST_F(LiveSegmentTimelineTest, LastSegmentNumberSupplementalProperty) {
   const uint64_t kRepeat = 9;
   const bool kIsLowLatency = false;
 
-  std::list<SegmentInfo> segment_infos = {
+  SegmentTimeline segment_infos = {
       {kStartTime, kDuration, kRepeat},
   };
   RepresentationXmlNode representation;
@@ -748,7 +749,7 @@ TEST_F(LowLatencySegmentTest, LowLatencySegmentTemplate) {
   const uint64_t kRepeat = 0;
   const bool kIsLowLatency = true;
 
-  std::list<SegmentInfo> segment_infos = {
+  SegmentTimeline segment_infos = {
       {kStartNumber, kDuration, kRepeat},
   };
   RepresentationXmlNode representation;
@@ -8,7 +8,9 @@
 
 #include <algorithm>
 #include <chrono>
+#include <map>
 #include <optional>
+#include <set>
 
 #include <absl/log/check.h>
 #include <absl/log/log.h>
@@ -20,6 +22,7 @@
 #include <packager/app/packager_util.h>
 #include <packager/app/single_thread_job_manager.h>
 #include <packager/file.h>
+#include <packager/file/file_deleter.h>
 #include <packager/hls/base/hls_notifier.h>
 #include <packager/hls/base/simple_hls_notifier.h>
 #include <packager/macros/logging.h>
@@ -35,6 +38,7 @@
 #include <packager/media/demuxer/demuxer.h>
 #include <packager/media/event/muxer_listener_factory.h>
 #include <packager/media/event/vod_media_info_dump_muxer_listener.h>
+#include <packager/media/formats/mp4/manifest_only_handler.h>
 #include <packager/media/formats/ttml/ttml_to_mp4_handler.h>
 #include <packager/media/formats/webvtt/text_padder.h>
 #include <packager/media/formats/webvtt/webvtt_to_mp4_handler.h>
@@ -58,6 +62,9 @@ namespace media {
 namespace {
 
 const char kMediaInfoSuffix[] = ".media_info";
+// Number of messages buffered for each output of a stream when the outputs
+// are generated on separate threads.
+const size_t kMaxQueuedStreamDataPerOutput = 64;
 
 MuxerListenerFactory::StreamData ToMuxerListenerData(
     const StreamDescriptor& stream) {
@@ -266,6 +273,80 @@ Status ValidateStreamDescriptor(bool dump_stream_info,
   return Status::OK;
 }
 
+// Validates the params of single segment packaging, see
+// PackagingParams::segment_number.
+Status ValidateSegmentNumberParams(
+    const PackagingParams& packaging_params,
+    const std::vector<StreamDescriptor>& stream_descriptors) {
+  if (!packaging_params.mpd_params.mpd_output.empty() ||
+      !packaging_params.hls_params.master_playlist_output.empty() ||
+      packaging_params.output_media_info) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Manifests cannot be generated with --segment_number.");
+  }
+  if (!packaging_params.ad_cue_generator_params.cue_points.empty() ||
+      packaging_params.chunking_params.low_latency_dash_mode) {
+    return Status(error::UNIMPLEMENTED,
+                  "Ad cues and low latency DASH are not supported with "
+                  "--segment_number.");
+  }
+  if (packaging_params.decryption_params.key_provider != KeyProvider::kNone) {
+    return Status(error::UNIMPLEMENTED,
+                  "Encrypted inputs are not supported with --segment_number.");
+  }
+  for (const StreamDescriptor& descriptor : stream_descriptors) {
+    if (descriptor.segment_template.empty() ||
+        descriptor.sample_index.empty()) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Every stream requires a segment_template and a "
+                    "sample_index with --segment_number.");
+    }
+    if (GetOutputFormat(descriptor) != CONTAINER_MOV ||
+        IsTextStream(descriptor) || descriptor.trick_play_factor > 0 ||
+        descriptor.cc_index >= 0) {
+      return Status(error::UNIMPLEMENTED,
+                    "Only MP4 audio and video outputs are supported with "
+                    "--segment_number.");
+    }
+  }
+  return Status::OK;
+}
+
+// Validates the params of manifest only packaging, see
+// PackagingParams::manifest_only.
+Status ValidateManifestOnlyParams(
+    const PackagingParams& packaging_params,
+    const std::vector<StreamDescriptor>& stream_descriptors) {
+  if (packaging_params.encryption_params.key_provider != KeyProvider::kNone ||
+      packaging_params.decryption_params.key_provider != KeyProvider::kNone) {
+    return Status(error::INVALID_ARGUMENT,
+                  "The media is not rewritten with --manifest_only, so it "
+                  "cannot be encrypted or decrypted.");
+  }
+  if (packaging_params.segment_number > 0 ||
+      !packaging_params.ad_cue_generator_params.cue_points.empty() ||
+      packaging_params.chunking_params.low_latency_dash_mode) {
+    return Status(error::INVALID_ARGUMENT,
+                  "--segment_number, ad cues and low latency DASH cannot be "
+                  "used with --manifest_only.");
+  }
+  for (const StreamDescriptor& descriptor : stream_descriptors) {
+    if (!descriptor.segment_template.empty()) {
+      return Status(error::INVALID_ARGUMENT,
+                    "The segments are addressed with byte ranges with "
+                    "--manifest_only, so segment_template cannot be set.");
+    }
+    if (GetOutputFormat(descriptor) != CONTAINER_MOV ||
+        IsTextStream(descriptor) || descriptor.trick_play_factor > 0 ||
+        descriptor.cc_index >= 0) {
+      return Status(error::UNIMPLEMENTED,
+                    "Only MP4 audio and video streams are supported with "
+                    "--manifest_only.");
+    }
+  }
+  return Status::OK;
+}
+
 Status ValidateParams(const PackagingParams& packaging_params,
                       const std::vector<StreamDescriptor>& stream_descriptors) {
   if (!packaging_params.chunking_params.segment_sap_aligned &&
@@ -340,7 +421,8 @@ Status ValidateParams(const PackagingParams& packaging_params,
                   "(not using segment_template).");
   }
 
-  if (on_demand_dash_profile &&
+  // The 'sidx' boxes of the inputs are used with --manifest_only.
+  if (on_demand_dash_profile && !packaging_params.manifest_only &&
       !packaging_params.mpd_params.mpd_output.empty() &&
       !packaging_params.mp4_output_params.generate_sidx_in_media_segments &&
       !packaging_params.mpd_params.use_segment_list) {
@@ -370,6 +452,16 @@ Status ValidateParams(const PackagingParams& packaging_params,
                   "if --low_latency_dash_mode is enabled.");
   }
 
+  if (packaging_params.segment_number > 0) {
+    RETURN_IF_ERROR(
+        ValidateSegmentNumberParams(packaging_params, stream_descriptors));
+  }
+
+  if (packaging_params.manifest_only) {
+    RETURN_IF_ERROR(
+        ValidateManifestOnlyParams(packaging_params, stream_descriptors));
+  }
+
   return Status::OK;
 }
 
@@ -446,15 +538,25 @@ bool StreamInfoToTextMediaInfo(const StreamDescriptor& stream_descriptor,
 
 /// Create a new demuxer handler for the given stream. If a demuxer cannot be
 /// created, an error will be returned. If a demuxer can be created, this
-/// |new_demuxer| will be set and Status::OK will be returned.
+/// |new_demuxer| will be set and Status::OK will be returned. Encrypted input
+/// is left encrypted if |transcrypt| is set, for the encryption handlers to
+/// transcrypt it.
 Status CreateDemuxer(const StreamDescriptor& stream,
                      const PackagingParams& packaging_params,
+                     bool transcrypt,
                      std::shared_ptr<Demuxer>* new_demuxer) {
   std::shared_ptr<Demuxer> demuxer = std::make_shared<Demuxer>(stream.input);
   demuxer->set_dump_stream_info(packaging_params.test_params.dump_stream_info);
   demuxer->set_input_format(stream.input_format);
+  demuxer->set_sample_index_file(stream.sample_index);
+  if (packaging_params.segment_number > 0) {
+    demuxer->set_segment_number(packaging_params.segment_number,
+                                packaging_params.chunking_params);
+  }
 
-  if (packaging_params.decryption_params.key_provider != KeyProvider::kNone) {
+  demuxer->set_keep_encrypted(transcrypt);
+  if (packaging_params.decryption_params.key_provider != KeyProvider::kNone &&
+      !transcrypt) {
     std::unique_ptr<KeySource> decryption_key_source(
         CreateDecryptionKeySource(packaging_params.decryption_params));
     if (!decryption_key_source) {
@@ -469,16 +571,45 @@ Status CreateDemuxer(const StreamDescriptor& stream,
   return Status::OK;
 }
 
-std::shared_ptr<MediaHandler> CreateEncryptionHandler(
+/// Returns true if the stream is encrypted by an EncryptionHandler.
+bool IsEncryptedStream(const StreamDescriptor& stream, KeySource* key_source) {
+  return key_source && !stream.skip_encryption;
+}
+
+/// Returns true if the encrypted audio and video streams in |input| can be
+/// transcrypted, i.e. decrypted and re-encrypted in a single pass by the
+/// encryption handlers instead of being decrypted by the demuxer first. This
+/// is the case if all of them are re-encrypted.
+bool CanTranscryptInput(
+    const std::string& input,
+    const std::vector<std::reference_wrapper<const StreamDescriptor>>& streams,
     const PackagingParams& packaging_params,
-    const StreamDescriptor& stream,
-    KeySource* key_source) {
-  if (stream.skip_encryption) {
-    return nullptr;
+    KeySource* encryption_key_source) {
+  if (packaging_params.decryption_params.key_provider == KeyProvider::kNone)
+    return false;
+  for (const StreamDescriptor& stream : streams) {
+    if (stream.input != input || IsTextStream(stream))
+      continue;
+    if (stream.output.empty() && stream.segment_template.empty())
+      continue;
+    if (!IsEncryptedStream(stream, encryption_key_source))
+      return false;
   }
+  return true;
+}
 
-  if (!key_source) {
-    return nullptr;
+/// Creates the encryption handler of |stream|, if it is encrypted. Encrypted
+/// input is transcrypted with keys from |decryption_key_source| if it is set.
+/// The decryption key source is shared by the streams of an input.
+Status CreateEncryptionHandler(
+    const PackagingParams& packaging_params,
+    const StreamDescriptor& stream,
+    KeySource* key_source,
+    std::shared_ptr<KeySource> decryption_key_source,
+    std::shared_ptr<MediaHandler>* handler) {
+  if (!IsEncryptedStream(stream, key_source)) {
+    handler->reset();
+    return Status::OK;
   }
 
   // Make a copy so that we can modify it for this specific stream.
@@ -510,7 +641,14 @@ std::shared_ptr<MediaHandler> CreateEncryptionHandler(
         kDefaultMaxHdPixels, kDefaultMaxUhd1Pixels, std::placeholders::_1);
   }
 
-  return std::make_shared<EncryptionHandler>(encryption_params, key_source);
+  auto encryption_handler =
+      std::make_shared<EncryptionHandler>(encryption_params, key_source);
+  if (decryption_key_source) {
+    encryption_handler->SetDecryptionKeySource(
+        std::move(decryption_key_source));
+  }
+  *handler = std::move(encryption_handler);
+  return Status::OK;
 }
 
 std::unique_ptr<MediaHandler> CreateTextChunker(
@@ -584,6 +722,24 @@ Status CreateTtmlJobs(
   return Status::OK;
 }
 
+// Returns the trick play factors of the streams with outputs, which have the
+// same input and stream selector as |stream|, in order.
+std::vector<uint32_t> GetTrickPlayFactors(
+    const std::vector<std::reference_wrapper<const StreamDescriptor>>& streams,
+    const StreamDescriptor& stream) {
+  std::vector<uint32_t> factors;
+  for (const StreamDescriptor& other : streams) {
+    if (other.input != stream.input ||
+        other.stream_selector != stream.stream_selector ||
+        other.trick_play_factor == 0 ||
+        (other.output.empty() && other.segment_template.empty())) {
+      continue;
+    }
+    factors.push_back(other.trick_play_factor);
+  }
+  return factors;
+}
+
 Status CreateAudioVideoJobs(
     const std::vector<std::reference_wrapper<const StreamDescriptor>>& streams,
     const PackagingParams& packaging_params,
@@ -600,6 +756,8 @@ Status CreateAudioVideoJobs(
   // order.
   std::map<std::string, std::shared_ptr<Demuxer>> sources;
   std::map<std::string, std::shared_ptr<MediaHandler>> cue_aligners;
+  // The decryption key sources of the inputs that are transcrypted.
+  std::map<std::string, std::shared_ptr<KeySource>> decryption_key_sources;
 
   for (const StreamDescriptor& stream : streams) {
     bool seen_input_before = sources.find(stream.input) != sources.end();
@@ -607,8 +765,20 @@ Status CreateAudioVideoJobs(
       continue;
     }
 
-    RETURN_IF_ERROR(
-        CreateDemuxer(stream, packaging_params, &sources[stream.input]));
+    const bool transcrypt = CanTranscryptInput(
+        stream.input, streams, packaging_params, encryption_key_source);
+    if (transcrypt) {
+      std::shared_ptr<KeySource> decryption_key_source(
+          CreateDecryptionKeySource(packaging_params.decryption_params));
+      if (!decryption_key_source) {
+        return Status(
+            error::INVALID_ARGUMENT,
+            "Must define decryption key source when defining key provider");
+      }
+      decryption_key_sources[stream.input] = std::move(decryption_key_source);
+    }
+    RETURN_IF_ERROR(CreateDemuxer(stream, packaging_params, transcrypt,
+                                  &sources[stream.input]));
     cue_aligners[stream.input] =
         sync_points ? std::make_shared<CueAlignmentHandler>(sync_points)
                     : nullptr;
@@ -619,8 +789,10 @@ Status CreateAudioVideoJobs(
   }
 
   // Replicators are shared among all streams with the same input and stream
-  // selector.
+  // selector. So are trick play handlers, which have an output per trick play
+  // stream, so that the key frames are found once.
   std::shared_ptr<MediaHandler> replicator;
+  std::shared_ptr<MediaHandler> trick_play_handler;
 
   std::string previous_input;
   std::string previous_selector;
@@ -662,12 +834,23 @@ Status CreateAudioVideoJobs(
       if (!is_text) {
         handlers.emplace_back(std::make_shared<ChunkingHandler>(
             packaging_params.chunking_params));
-        handlers.emplace_back(CreateEncryptionHandler(packaging_params, stream,
-                                                      encryption_key_source));
+        std::shared_ptr<MediaHandler> encryption_handler;
+        auto decryption_key_source = decryption_key_sources.find(stream.input);
+        RETURN_IF_ERROR(CreateEncryptionHandler(
+            packaging_params, stream, encryption_key_source,
+            decryption_key_source != decryption_key_sources.end()
+                ? decryption_key_source->second
+                : nullptr,
+            &encryption_handler));
+        handlers.emplace_back(std::move(encryption_handler));
       }
 
-      replicator = std::make_shared<Replicator>();
+      replicator = std::make_shared<Replicator>(
+          packaging_params.parallel_outputs && !packaging_params.single_threaded
+              ? kMaxQueuedStreamDataPerOutput
+              : 0);
       handlers.emplace_back(replicator);
+      trick_play_handler.reset();
 
       RETURN_IF_ERROR(MediaHandler::Chain(handlers));
       RETURN_IF_ERROR(demuxer->SetHandler(stream.stream_selector, handlers[0]));
@@ -688,12 +871,18 @@ Status CreateAudioVideoJobs(
     muxer->SetMuxerListener(std::move(muxer_listener));
 
     std::vector<std::shared_ptr<MediaHandler>> handlers;
-    handlers.emplace_back(replicator);
 
-    // Trick play is optional.
+    // Trick play is optional. The trick play handler is created with the first
+    // trick play stream, which comes after the main stream.
     if (stream.trick_play_factor) {
-      handlers.emplace_back(
-          std::make_shared<TrickPlayHandler>(stream.trick_play_factor));
+      if (!trick_play_handler) {
+        trick_play_handler = std::make_shared<TrickPlayHandler>(
+            GetTrickPlayFactors(streams, stream));
+        RETURN_IF_ERROR(replicator->AddHandler(trick_play_handler));
+      }
+      handlers.emplace_back(trick_play_handler);
+    } else {
+      handlers.emplace_back(replicator);
     }
 
     if (stream.cc_index >= 0) {
@@ -723,6 +912,35 @@ Status CreateAudioVideoJobs(
   return Status::OK;
 }
 
+// Creates a job per stream which generates the manifests from the fragments of
+// the input, see PackagingParams::manifest_only.
+Status CreateManifestOnlyJobs(
+    const std::vector<StreamDescriptor>& stream_descriptors,
+    const PackagingParams& packaging_params,
+    MuxerListenerFactory* muxer_listener_factory,
+    JobManager* job_manager) {
+  DCHECK(muxer_listener_factory);
+  DCHECK(job_manager);
+
+  for (const StreamDescriptor& stream : stream_descriptors) {
+    if (stream.output.empty())
+      continue;
+
+    MuxerOptions options;
+    options.mp4_params = packaging_params.mp4_output_params;
+    options.output_file_name = stream.output;
+    options.bandwidth = stream.bandwidth;
+    auto handler = std::make_shared<mp4::ManifestOnlyHandler>(
+        stream.input, stream.stream_selector, options);
+    if (!stream.language.empty())
+      handler->SetLanguageOverride(stream.language);
+    handler->SetMuxerListener(
+        muxer_listener_factory->CreateListener(ToMuxerListenerData(stream)));
+    job_manager->Add("ManifestOnlyJob", handler);
+  }
+  return job_manager->InitializeJobs();
+}
+
 Status CreateAllJobs(const std::vector<StreamDescriptor>& stream_descriptors,
                      const PackagingParams& packaging_params,
                      MpdNotifier* mpd_notifier,
@@ -735,6 +953,11 @@ Status CreateAllJobs(const std::vector<StreamDescriptor>& stream_descriptors,
   DCHECK(muxer_listener_factory);
   DCHECK(job_manager);
 
+  if (packaging_params.manifest_only) {
+    return CreateManifestOnlyJobs(stream_descriptors, packaging_params,
+                                  muxer_listener_factory, job_manager);
+  }
+
   // Group all streams based on which pipeline they will use.
   std::vector<std::reference_wrapper<const StreamDescriptor>> ttml_streams;
   std::vector<std::reference_wrapper<const StreamDescriptor>>
@@ -802,6 +1025,8 @@ Status CreateAllJobs(const std::vector<StreamDescriptor>& stream_descriptors,
 struct Packager::PackagerInternal {
   std::shared_ptr<media::FakeClock> fake_clock;
   std::unique_ptr<KeySource> encryption_key_source;
+  // Declared before the notifiers, which schedule deletions with it.
+  FileDeleter::Group file_deletions;
   std::unique_ptr<MpdNotifier> mpd_notifier;
   std::unique_ptr<hls::HlsNotifier> hls_notifier;
   BufferCallbackParams buffer_callback_params;
@@ -871,21 +1096,29 @@ Status Packager::Initialize(
   hls_params.is_independent_segments =
       packaging_params.chunking_params.segment_sap_aligned;
 
+  // Segments generated by a resumed live session, keyed by segment template.
+  std::map<std::string, uint32_t> num_previous_segments;
   if (!mpd_params.mpd_output.empty()) {
     const bool on_demand_dash_profile =
         stream_descriptors.begin()->segment_template.empty();
-    const MpdOptions mpd_options =
+    MpdOptions mpd_options =
         media::GetMpdOptions(on_demand_dash_profile, mpd_params);
-    internal->mpd_notifier.reset(new SimpleMpdNotifier(mpd_options));
-    if (!internal->mpd_notifier->Init()) {
+    mpd_options.file_deletions = &internal->file_deletions;
+    SimpleMpdNotifier* mpd_notifier = new SimpleMpdNotifier(mpd_options);
+    internal->mpd_notifier.reset(mpd_notifier);
+    if (!mpd_notifier->Init()) {
       LOG(ERROR) << "MpdNotifier failed to initialize.";
       return Status(error::INVALID_ARGUMENT,
                     "Failed to initialize MpdNotifier.");
     }
+    num_previous_segments = mpd_notifier->num_previous_segments();
   }
 
   if (!hls_params.master_playlist_output.empty()) {
-    internal->hls_notifier.reset(new hls::SimpleHlsNotifier(hls_params));
+    hls::SimpleHlsNotifier* hls_notifier =
+        new hls::SimpleHlsNotifier(hls_params);
+    hls_notifier->set_file_deletions(&internal->file_deletions);
+    internal->hls_notifier.reset(hls_notifier);
   }
 
   std::unique_ptr<SyncPointQueue> sync_points;
@@ -932,6 +1165,7 @@ Status Packager::Initialize(
   }
 
   media::MuxerFactory muxer_factory(packaging_params);
+  muxer_factory.SetNumPreviousSegments(num_previous_segments);
   if (packaging_params.test_params.inject_fake_clock) {
     internal->fake_clock.reset(new media::FakeClock());
     muxer_factory.OverrideClock(internal->fake_clock);
@@ -966,6 +1200,9 @@ Status Packager::Run() {
     if (!internal_->mpd_notifier->Flush())
       return Status(error::INVALID_ARGUMENT, "Failed to flush Mpd.");
   }
+  // Complete the deletion of the segments which left the live window. Only
+  // the deletions of this instance are waited for.
+  internal_->file_deletions.Flush();
   return Status::OK;
 }
 
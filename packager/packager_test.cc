@@ -7,6 +7,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <packager/file.h>
 #include <packager/packager.h>
 
 using testing::_;
@@ -38,6 +39,9 @@ const uint8_t kKey[]{
     0x6f, 0xc9, 0x6f, 0xe6, 0x28, 0xa2, 0x65, 0xb1,
     0x3a, 0xed, 0xde, 0xc0, 0xbc, 0x42, 0x1f, 0x4d,
 };
+const uint8_t kIv[]{
+    0x3b, 0x61, 0x4d, 0x02, 0x8f, 0x1e, 0x50, 0xc4,
+};
 const double kClearLeadInSeconds = 1.0;
 const double kFragmentDurationInSeconds = 5.0;
 
@@ -288,6 +292,82 @@ TEST_F(PackagerTest, LowLatencyDashEnabledAndUtcTimingNotSet) {
   EXPECT_THAT(status.error_message(),
               HasSubstr("--utc_timings must be be set"));
 }
+
+TEST_F(PackagerTest, SegmentNumber) {
+  auto packaging_params = SetupPackagingParams();
+  packaging_params.mpd_params.mpd_output.clear();
+  // The output is only deterministic with a fixed IV and clock.
+  packaging_params.test_params.inject_fake_clock = true;
+  packaging_params.encryption_params.raw_key.iv.assign(std::begin(kIv),
+                                                       std::end(kIv));
+
+  auto get_stream_descriptors = [this](const std::string& directory) {
+    std::vector<StreamDescriptor> stream_descriptors = SetupStreamDescriptors();
+    for (StreamDescriptor& stream_descriptor : stream_descriptors) {
+      const bool is_video = stream_descriptor.stream_selector == "video";
+      stream_descriptor.output =
+          GetFullPath(directory + (is_video ? kOutputVideo : kOutputAudio));
+      stream_descriptor.segment_template = GetFullPath(
+          directory +
+          (is_video ? kOutputVideoTemplate : kOutputAudioTemplate));
+      stream_descriptor.sample_index = GetFullPath("bear-640x360.index");
+    }
+    return stream_descriptors;
+  };
+
+  // The sample index is built in the full run.
+  {
+    Packager packager;
+    ASSERT_EQ(Status::OK, packager.Initialize(packaging_params,
+                                              get_stream_descriptors("full/")));
+    ASSERT_EQ(Status::OK, packager.Run());
+  }
+
+  // Segment 1 is in the clear lead and the other segments are encrypted.
+  for (uint32_t segment_number = 1; segment_number <= 3; ++segment_number) {
+    SCOPED_TRACE(segment_number);
+    const std::string directory =
+        "segment_" + std::to_string(segment_number) + "/";
+    packaging_params.segment_number = segment_number;
+    Packager packager;
+    ASSERT_EQ(Status::OK, packager.Initialize(
+                              packaging_params,
+                              get_stream_descriptors(directory)));
+    ASSERT_EQ(Status::OK, packager.Run());
+
+    const std::string segment = std::to_string(segment_number);
+    for (const std::string& file_name :
+         {std::string(kOutputVideo), std::string(kOutputAudio),
+          "output_video_" + segment + ".m4s",
+          "output_audio_" + segment + ".m4s"}) {
+      SCOPED_TRACE(file_name);
+      std::string expected;
+      ASSERT_TRUE(File::ReadFileToString(
+          GetFullPath("full/" + file_name).c_str(), &expected));
+      std::string actual;
+      ASSERT_TRUE(File::ReadFileToString(
+          GetFullPath(directory + file_name).c_str(), &actual));
+      EXPECT_EQ(expected, actual);
+    }
+  }
+}
+
+TEST_F(PackagerTest, SegmentNumberWithManifest) {
+  auto packaging_params = SetupPackagingParams();
+  packaging_params.segment_number = 1;
+  std::vector<StreamDescriptor> stream_descriptors = SetupStreamDescriptors();
+  for (StreamDescriptor& stream_descriptor : stream_descriptors) {
+    stream_descriptor.segment_template = GetFullPath(
+        stream_descriptor.stream_selector == "video" ? kOutputVideoTemplate
+                                                     : kOutputAudioTemplate);
+    stream_descriptor.sample_index = GetFullPath("bear-640x360.index");
+  }
+  Packager packager;
+  auto status = packager.Initialize(packaging_params, stream_descriptors);
+  ASSERT_EQ(error::INVALID_ARGUMENT, status.error_code());
+  EXPECT_THAT(status.error_message(), HasSubstr("Manifests"));
+}
+
 // TODO(kqyang): Add more tests.
 
 }  // namespace shaka